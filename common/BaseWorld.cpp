@@ -32,7 +32,7 @@ BaseWorld * BaseWorld::m_instance = 0;
 /// This constructor registers the instance created as the singleton, and
 /// in debug mode ensures that an instance has not already been created.
 /// @param gw the top level in-game entity in the world.
-BaseWorld::BaseWorld(LocatedEntity & gw) : m_isSuspended(false), m_gameWorld(gw), m_defaultLocation(&gw), m_limboLocation(nullptr)
+BaseWorld::BaseWorld(LocatedEntity & gw) : m_simulatedTime(-1.), m_isSuspended(false), m_gameWorld(gw), m_defaultLocation(&gw), m_limboLocation(nullptr)
 {
     assert(m_instance == 0);
     m_instance = this;
@@ -133,6 +133,9 @@ void BaseWorld::setIsSuspended(bool suspended)
 }
 
 double BaseWorld::getTime() const {
+    if (m_simulatedTime >= 0.) {
+        return m_simulatedTime;
+    }
     SystemTime time;
     time.update();
     return (double)(time.seconds() + timeoffset - m_initTime) + (double)time.microseconds()/1000000.;
@@ -54,6 +54,10 @@ class BaseWorld {
     /// The system time when the server was started.
     std::time_t m_initTime;
 
+    /// \brief In-game time set by setSimulatedTime(), or negative if the
+    /// system clock is used.
+    double m_simulatedTime;
+
     /// \brief Dictionary of all the objects in the world.
     ///
     /// Pointers to all in-game entities in the world are stored keyed to
@@ -147,6 +151,15 @@ class BaseWorld {
     /// \brief Read only accessor for the in-game time.
     double getTime() const;
 
+    /// \brief Set the in-game time, instead of taking it from the system clock.
+    ///
+    /// This lets the world be run faster than real time, and the same way
+    /// each time, as the benchmarks do. A negative time goes back to
+    /// using the system clock.
+    void setSimulatedTime(double time) {
+        m_simulatedTime = time;
+    }
+
     /// \brief Get the time the world has been running since the server started.
     double upTime() const {
         return getTime() - timeoffset;
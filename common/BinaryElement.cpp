@@ -0,0 +1,391 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2015 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#include "BinaryElement.h"
+
+#include <map>
+#include <vector>
+
+#include <cstdint>
+#include <cstring>
+
+using Atlas::Message::Element;
+using Atlas::Message::ListType;
+using Atlas::Message::MapType;
+
+/// Marks the data as binary encoded, version 1. XML always starts with '<'.
+static const char binary_marker[] = "!1";
+static const std::size_t binary_marker_len = 2;
+
+static const char tag_none = 'N';
+static const char tag_int = 'I';
+static const char tag_float = 'F';
+static const char tag_string = 'S';
+static const char tag_list = 'L';
+static const char tag_map = 'M';
+
+static const char base64_chars[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+namespace {
+
+/// \brief Writes elements to a byte string
+class Writer {
+  protected:
+    std::string & m_out;
+    /// Number given to each map key already written.
+    std::map<std::string, std::uint64_t> m_keys;
+  public:
+    explicit Writer(std::string & out) : m_out(out) { }
+
+    void number(std::uint64_t n) {
+        while (n >= 0x80) {
+            m_out.push_back((char)((n & 0x7f) | 0x80));
+            n >>= 7;
+        }
+        m_out.push_back((char)n);
+    }
+
+    void string(const std::string & s) {
+        number(s.size());
+        m_out.append(s);
+    }
+
+    void key(const std::string & k) {
+        auto I = m_keys.find(k);
+        if (I != m_keys.end()) {
+            number(I->second);
+            return;
+        }
+        // Zero introduces a new key, which later uses refer to by number.
+        number(0);
+        string(k);
+        m_keys.insert(std::make_pair(k, m_keys.size() + 1));
+    }
+
+    void map(const MapType & m) {
+        m_out.push_back(tag_map);
+        number(m.size());
+        for (auto & entry : m) {
+            key(entry.first);
+            element(entry.second);
+        }
+    }
+
+    void element(const Element & e) {
+        switch (e.getType()) {
+            case Element::TYPE_INT:
+                {
+                    // Zigzag, so small negative numbers stay short
+                    std::int64_t i = e.Int();
+                    m_out.push_back(tag_int);
+                    number(((std::uint64_t)i << 1) ^ (std::uint64_t)(i >> 63));
+                }
+                break;
+            case Element::TYPE_FLOAT:
+                {
+                    double f = e.Float();
+                    std::uint64_t bits;
+                    std::memcpy(&bits, &f, sizeof(bits));
+                    m_out.push_back(tag_float);
+                    for (int i = 0; i < 8; ++i) {
+                        m_out.push_back((char)(bits >> (i * 8)));
+                    }
+                }
+                break;
+            case Element::TYPE_STRING:
+                m_out.push_back(tag_string);
+                string(e.String());
+                break;
+            case Element::TYPE_LIST:
+                m_out.push_back(tag_list);
+                number(e.List().size());
+                for (auto & item : e.List()) {
+                    element(item);
+                }
+                break;
+            case Element::TYPE_MAP:
+                map(e.Map());
+                break;
+            case Element::TYPE_PTR:
+            case Element::TYPE_NONE:
+            default:
+                m_out.push_back(tag_none);
+                break;
+        }
+    }
+};
+
+/// \brief Reads elements from a byte string
+class Reader {
+  protected:
+    const std::string & m_in;
+    std::size_t m_pos;
+    std::vector<std::string> m_keys;
+  public:
+    explicit Reader(const std::string & in) : m_in(in), m_pos(0) { }
+
+    bool done() const {
+        return m_pos == m_in.size();
+    }
+
+    bool number(std::uint64_t & n) {
+        n = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (m_pos >= m_in.size()) {
+                return false;
+            }
+            unsigned char c = m_in[m_pos++];
+            n |= (std::uint64_t)(c & 0x7f) << shift;
+            if ((c & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool string(std::string & s) {
+        std::uint64_t len;
+        if (!number(len) || len > m_in.size() - m_pos) {
+            return false;
+        }
+        s.assign(m_in, m_pos, len);
+        m_pos += len;
+        return true;
+    }
+
+    bool key(std::string & k) {
+        std::uint64_t n;
+        if (!number(n)) {
+            return false;
+        }
+        if (n == 0) {
+            if (!string(k)) {
+                return false;
+            }
+            m_keys.push_back(k);
+            return true;
+        }
+        if (n > m_keys.size()) {
+            return false;
+        }
+        k = m_keys[n - 1];
+        return true;
+    }
+
+    bool map(MapType & m) {
+        std::uint64_t count;
+        if (!number(count)) {
+            return false;
+        }
+        std::string k;
+        for (std::uint64_t i = 0; i < count; ++i) {
+            if (!key(k) || !element(m[k])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool element(Element & e) {
+        if (m_pos >= m_in.size()) {
+            return false;
+        }
+        char tag = m_in[m_pos++];
+        switch (tag) {
+            case tag_none:
+                e = Element();
+                return true;
+            case tag_int:
+                {
+                    std::uint64_t n;
+                    if (!number(n)) {
+                        return false;
+                    }
+                    e = (Atlas::Message::IntType)((n >> 1) ^ (~(n & 1) + 1));
+                    return true;
+                }
+            case tag_float:
+                {
+                    if (m_in.size() - m_pos < 8) {
+                        return false;
+                    }
+                    std::uint64_t bits = 0;
+                    for (int i = 0; i < 8; ++i) {
+                        bits |= (std::uint64_t)(unsigned char)m_in[m_pos++] << (i * 8);
+                    }
+                    double f;
+                    std::memcpy(&f, &bits, sizeof(f));
+                    e = f;
+                    return true;
+                }
+            case tag_string:
+                {
+                    std::string s;
+                    if (!string(s)) {
+                        return false;
+                    }
+                    e = s;
+                    return true;
+                }
+            case tag_list:
+                {
+                    std::uint64_t count;
+                    // Each item takes at least one byte
+                    if (!number(count) || count > m_in.size() - m_pos) {
+                        return false;
+                    }
+                    e = ListType(count);
+                    ListType & list = e.List();
+                    for (auto & item : list) {
+                        if (!element(item)) {
+                            return false;
+                        }
+                    }
+                    return true;
+                }
+            case tag_map:
+                e = MapType();
+                return map(e.Map());
+            default:
+                return false;
+        }
+    }
+};
+
+}
+
+static void base64Encode(const std::string & in, std::string & out)
+{
+    std::size_t i = 0;
+    for (; i + 2 < in.size(); i += 3) {
+        std::uint32_t n = ((unsigned char)in[i] << 16) |
+                          ((unsigned char)in[i + 1] << 8) |
+                          (unsigned char)in[i + 2];
+        out.push_back(base64_chars[(n >> 18) & 0x3f]);
+        out.push_back(base64_chars[(n >> 12) & 0x3f]);
+        out.push_back(base64_chars[(n >> 6) & 0x3f]);
+        out.push_back(base64_chars[n & 0x3f]);
+    }
+    if (i < in.size()) {
+        std::uint32_t n = (unsigned char)in[i] << 16;
+        if (i + 1 < in.size()) {
+            n |= (unsigned char)in[i + 1] << 8;
+        }
+        out.push_back(base64_chars[(n >> 18) & 0x3f]);
+        out.push_back(base64_chars[(n >> 12) & 0x3f]);
+        if (i + 1 < in.size()) {
+            out.push_back(base64_chars[(n >> 6) & 0x3f]);
+        } else {
+            out.push_back('=');
+        }
+        out.push_back('=');
+    }
+}
+
+static int base64Value(char c)
+{
+    if (c >= 'A' && c <= 'Z') {
+        return c - 'A';
+    }
+    if (c >= 'a' && c <= 'z') {
+        return c - 'a' + 26;
+    }
+    if (c >= '0' && c <= '9') {
+        return c - '0' + 52;
+    }
+    if (c == '+') {
+        return 62;
+    }
+    if (c == '/') {
+        return 63;
+    }
+    return -1;
+}
+
+static bool base64Decode(const std::string & in, std::size_t start,
+                         std::string & out)
+{
+    if ((in.size() - start) % 4 != 0) {
+        return false;
+    }
+    for (std::size_t i = start; i < in.size(); i += 4) {
+        std::uint32_t n = 0;
+        int pad = 0;
+        for (std::size_t j = 0; j < 4; ++j) {
+            char c = in[i + j];
+            if (c == '=' && i + 4 == in.size() && j >= 2) {
+                ++pad;
+                n <<= 6;
+                continue;
+            }
+            int v = base64Value(c);
+            if (v < 0 || pad != 0) {
+                return false;
+            }
+            n = (n << 6) | v;
+        }
+        out.push_back((char)(n >> 16));
+        if (pad < 2) {
+            out.push_back((char)(n >> 8));
+        }
+        if (pad < 1) {
+            out.push_back((char)n);
+        }
+    }
+    return true;
+}
+
+/// \brief Encode a map in the binary format.
+void encodeBinaryElement(const MapType & map, std::string & data)
+{
+    std::string raw;
+    Writer writer(raw);
+    writer.map(map);
+
+    data = binary_marker;
+    data.reserve(binary_marker_len + (raw.size() + 2) / 3 * 4);
+    base64Encode(raw, data);
+}
+
+/// \brief Decode a map encoded with encodeBinaryElement().
+///
+/// @return 0 on success, or -1 if the data is not a valid encoding.
+int decodeBinaryElement(const std::string & data, MapType & map)
+{
+    if (!isBinaryElement(data)) {
+        return -1;
+    }
+    std::string raw;
+    if (!base64Decode(data, binary_marker_len, raw)) {
+        return -1;
+    }
+    Reader reader(raw);
+    Element e;
+    if (!reader.element(e) || !reader.done() || !e.isMap()) {
+        return -1;
+    }
+    map = std::move(e.Map());
+    return 0;
+}
+
+/// \brief Check if data is in the binary format, rather than XML.
+bool isBinaryElement(const std::string & data)
+{
+    return data.compare(0, binary_marker_len, binary_marker) == 0;
+}
@@ -0,0 +1,45 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2015 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifndef COMMON_BINARY_ELEMENT_H
+#define COMMON_BINARY_ELEMENT_H
+
+#include <Atlas/Message/Element.h>
+
+#include <string>
+
+/// \brief Compact encoding of Atlas message data for database storage
+///
+/// Each element is written as a type tag followed by its value. Integers
+/// and lengths are variable length, floats are written as their eight
+/// bytes, and each distinct map key is only written out in full the first
+/// time it appears, with later uses referring back to it by number.
+///
+/// The bytes are then base64 encoded behind a short marker, so the result
+/// can be stored in the existing text columns and put in a query without
+/// escaping, and can be told apart from the XML used before.
+
+void encodeBinaryElement(const Atlas::Message::MapType & map,
+                         std::string & data);
+
+int decodeBinaryElement(const std::string & data,
+                        Atlas::Message::MapType & map);
+
+bool isBinaryElement(const std::string & data);
+
+#endif // COMMON_BINARY_ELEMENT_H
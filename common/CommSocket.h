@@ -19,6 +19,10 @@
 #ifndef COMMON_COMM_SOCKET_H
 #define COMMON_COMM_SOCKET_H
 
+#include "common/OperationRouter.h"
+
+class OpBroadcast;
+
 namespace boost {
 namespace asio {
 class io_service;
@@ -47,6 +51,25 @@ class CommSocket {
 
     /// \brief Flush the socket
     virtual int flush() = 0;
+
+    /// \brief Send an operation which is being broadcast to many sockets
+    ///
+    /// Sockets which can send the shared encoded form of the operation
+    /// should override this. The default does nothing, which means the
+    /// operation is encoded and sent normally by the caller.
+    /// @return 0 if the operation was sent, -1 otherwise.
+    virtual int sendBroadcast(const Operation &, OpBroadcast &) {
+        return -1;
+    }
+
+    /// \brief Check if an operation should be sent given the outgoing backlog
+    ///
+    /// Sockets which queue outgoing data should override this to keep
+    /// slow clients from making the queue grow without bound.
+    /// @return 0 if the operation should be sent, -1 if it should be dropped.
+    virtual int checkBacklog(const Operation &) {
+        return 0;
+    }
 };
 
 #endif // COMMON_COMM_SOCKET_H
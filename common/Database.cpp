@@ -18,6 +18,8 @@
 
 #include "Database.h"
 
+#include "BinaryElement.h"
+#include "DatabaseBatch.h"
 #include "id.h"
 #include "log.h"
 #include "debug.h"
@@ -57,6 +59,11 @@ static void databaseNotice(void *, const char * message)
 
 Database::Database() : m_rule_db("rules"),
                        m_queryInProgress(false),
+                       m_idBlockSize(100),
+                       m_nextId(0),
+                       m_idBlockEnd(0),
+                       m_spareIdBlock(-1),
+                       m_idBlockPending(false),
                        m_connection(NULL)
 {
 }
@@ -304,6 +311,14 @@ int Database::decodeMessage(const std::string & data,
         return 0;
     }
 
+    if (isBinaryElement(data)) {
+        if (decodeBinaryElement(data, o) != 0) {
+            log(WARNING, "Database entry does not appear to be decodable");
+            return -1;
+        }
+        return 0;
+    }
+
     std::stringstream str(data, std::ios::in);
 
     Serialiser codec(str, m_d);
@@ -350,6 +365,17 @@ int Database::encodeObject(const MapType & o,
     return 0;
 }
 
+/// \brief Encode message data in the compact binary format.
+///
+/// Unlike encodeObject() the result never needs escaping. decodeMessage()
+/// reads both this and the XML from encodeObject().
+int Database::encodeMessage(const MapType & o,
+                            std::string & data)
+{
+    encodeBinaryElement(o, data);
+    return 0;
+}
+
 int Database::getObject(const std::string & table,
                         const std::string & key,
                         MapType & o)
@@ -905,6 +931,11 @@ int Database::registerEntityIdGenerator()
 {
     assert(m_connection != 0);
 
+    readConfigItem(::instance, "dbidblock", m_idBlockSize);
+    if (m_idBlockSize < 1) {
+        m_idBlockSize = 1;
+    }
+
     clearPendingQuery();
     int status = PQsendQuery(m_connection, "SELECT * FROM entity_ent_id_seq");
     if (!status) {
@@ -923,13 +954,27 @@ int Database::registerEntityIdGenerator()
     return runCommandQuery("CREATE SEQUENCE entity_ent_id_seq");
 }
 
-long Database::newId(std::string & id)
+/// \brief SQL which reserves a block of ids, returning the last one.
+///
+/// The sequence is moved to the end of the block before any of it is
+/// used, so ids are never handed out twice, even if the server stops
+/// before using them all. Unused ids are just skipped.
+static std::string reserveIdsQuery(int count)
+{
+    return compose("SELECT setval('entity_ent_id_seq', "
+                   "nextval('entity_ent_id_seq') + %1)", count - 1);
+}
+
+/// \brief Reserve a block of ids, waiting for the result.
+///
+/// @return the first id of the block, or -1 on error
+long Database::reserveIdBlock()
 {
     assert(m_connection != 0);
 
     clearPendingQuery();
     int status = PQsendQuery(m_connection,
-                             "SELECT nextval('entity_ent_id_seq')");
+                             reserveIdsQuery(m_idBlockSize).c_str());
     if (!status) {
         log(ERROR, "newId(): Database query error.");
         reportError();
@@ -941,18 +986,73 @@ long Database::newId(std::string & id)
         reportError();
         return -1;
     }
-    const char * cid = PQgetvalue(res, 0, 0);
-    id = cid;
+    std::string last;
+    if (PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) == 1) {
+        last = PQgetvalue(res, 0, 0);
+    }
     PQclear(res);
     while ((res = PQgetResult(m_connection)) != NULL) {
         PQclear(res);
         log(ERROR, "Extra database result to simple query.");
     };
-    if (id.empty()) {
+    if (last.empty()) {
         log(ERROR, "Unknown error getting ID from database.");
         return -1;
     }
-    return forceIntegerId(id);
+    return forceIntegerId(last) - m_idBlockSize + 1;
+}
+
+/// \brief Reserve the next block of ids in the background.
+void Database::scheduleIdBlock()
+{
+    m_idBlockPending = true;
+    int count = m_idBlockSize;
+    pendingQueries.push_back(DatabaseQuery(reserveIdsQuery(count),
+                                           PGRES_TUPLES_OK));
+    pendingQueries.back().result = [this, count](PGresult * res) {
+        if (PQntuples(res) == 1) {
+            m_spareIdBlock = forceIntegerId(PQgetvalue(res, 0, 0)) - count + 1;
+        }
+    };
+    pendingQueries.back().done = [this]() {
+        m_idBlockPending = false;
+    };
+    pendingQueries.back().error = pendingQueries.back().done;
+    if (!m_queryInProgress) {
+        launchNewQuery();
+    }
+}
+
+long Database::newId(std::string & id)
+{
+    if (m_nextId >= m_idBlockEnd) {
+        if (m_spareIdBlock == -1 && m_idBlockPending) {
+            // The block reserved in advance may be the query in progress,
+            // which has to finish before another can be sent anyway.
+            clearPendingQuery();
+        }
+        long start = m_spareIdBlock;
+        m_spareIdBlock = -1;
+        if (start == -1) {
+            // Nothing was reserved in advance, or it hasn't arrived yet,
+            // in which case it will be kept for later.
+            start = reserveIdBlock();
+            if (start == -1) {
+                return -1;
+            }
+        }
+        m_nextId = start;
+        m_idBlockEnd = start + m_idBlockSize;
+    }
+    // Reserve the next block once half of this one is used, so it's
+    // normally there before it's needed.
+    if (m_spareIdBlock == -1 && !m_idBlockPending &&
+        m_idBlockEnd - m_nextId <= m_idBlockSize / 2) {
+        scheduleIdBlock();
+    }
+    long new_id = m_nextId++;
+    id = compose("%1", new_id);
+    return new_id;
 }
 
 int Database::registerEntityTable(const std::map<std::string, int> & chunks)
@@ -1047,6 +1147,15 @@ const DatabaseResult Database::selectEntities(const std::string & loc)
     return runSimpleSelectQuery(query);
 }
 
+/// \brief Select every entity, for restoring the whole world at once.
+///
+/// The columns are id, loc, type, seq and location, in that order.
+const DatabaseResult Database::selectAllEntities()
+{
+    return runSimpleSelectQuery("SELECT id, loc, type, seq, location "
+                                "FROM entities");
+}
+
 int Database::dropEntity(long id)
 {
     std::string query = compose("DELETE FROM properties WHERE id = '%1'", id);
@@ -1131,6 +1240,14 @@ const DatabaseResult Database::selectProperties(const std::string & id)
     return runSimpleSelectQuery(query);
 }
 
+/// \brief Select every property, for restoring the whole world at once.
+///
+/// The columns are id, name and value, in that order.
+const DatabaseResult Database::selectAllProperties()
+{
+    return runSimpleSelectQuery("SELECT id, name, value FROM properties");
+}
+
 int Database::updateProperties(const std::string & id,
                                const KeyValues & tuples)
 {
@@ -1188,6 +1305,14 @@ const DatabaseResult Database::selectThoughts(const std::string & loc)
     return runSimpleSelectQuery(query);
 }
 
+/// \brief Select every thought, for restoring the whole world at once.
+///
+/// The columns are id and thought, in that order.
+const DatabaseResult Database::selectAllThoughts()
+{
+    return runSimpleSelectQuery("SELECT id, thought FROM thoughts");
+}
+
 int Database::replaceThoughts(const std::string & id,
                          const std::vector<std::string>& thoughts)
 {
@@ -1440,26 +1565,34 @@ int Database::removeArrayRow(const std::string & name,
 
 // General functions for handling queries at the low level.
 
-void Database::queryResult(ExecStatusType status)
+void Database::queryResult(PGresult * res)
 {
     if (!m_queryInProgress || pendingQueries.empty()) {
         log(ERROR, "Got database result when no query was pending.");
         return;
     }
     DatabaseQuery & q = pendingQueries.front();
-    if (q.second == PGRES_EMPTY_QUERY) {
+    if (q.results <= 0) {
         log(ERROR, "Got database result which is already done.");
         return;
     }
-    if (q.second == status) {
+    if (q.status == PQresultStatus(res)) {
         debug(std::cout << "Query status ok" << std::endl << std::flush;);
-        // Mark this query as done
-        q.second = PGRES_EMPTY_QUERY;
+        if (q.result) {
+            q.result(res);
+        }
+        // Mark this statement as done
+        --q.results;
     } else {
-        log(ERROR, "Database error from async query");
-        std::cerr << "Query error in : " << q.first << std::endl << std::flush;
+        // Batches can be very large, so only say how the query starts
+        std::string start = q.query.substr(0, q.query.find_first_of("(;\n"));
+        log(ERROR, compose("Database error from async query of %1 bytes "
+                           "starting \"%2\"", q.query.size(),
+                           start.substr(0, 64)));
         reportError();
-        q.second = PGRES_EMPTY_QUERY;
+        // The database skips any statements after the one which failed
+        q.results = 0;
+        q.failed = true;
     }
 }
 
@@ -1470,14 +1603,18 @@ void Database::queryComplete()
         return;
     }
     DatabaseQuery & q = pendingQueries.front();
-    if (q.second != PGRES_EMPTY_QUERY) {
+    if (q.results != 0) {
         abort();
         log(ERROR, "Got database query complete when query was not done");
         return;
     }
     debug(std::cout << "Query complete" << std::endl << std::flush;);
+    std::function<void()> done = q.failed ? q.error : q.done;
     pendingQueries.pop_front();
     m_queryInProgress = false;
+    if (done) {
+        done();
+    }
 }
 
 int Database::launchNewQuery()
@@ -1497,9 +1634,9 @@ int Database::launchNewQuery()
     debug(std::cout << pendingQueries.size() << " queries pending"
                     << std::endl << std::flush;);
     DatabaseQuery & q = pendingQueries.front();
-    debug(std::cout << "Launching async query: " << q.first
+    debug(std::cout << "Launching async query: " << q.query
                     << std::endl << std::flush;);
-    int status = PQsendQuery(m_connection, q.first.c_str());
+    int status = PQsendQuery(m_connection, q.query.c_str());
     if (!status) {
         log(ERROR, "Database query error when launching.");
         reportError();
@@ -1513,7 +1650,7 @@ int Database::launchNewQuery()
 
 int Database::scheduleCommand(const std::string & query)
 {
-    pendingQueries.push_back(std::make_pair(query, PGRES_COMMAND_OK));
+    pendingQueries.push_back(DatabaseQuery(query, PGRES_COMMAND_OK));
     if (!m_queryInProgress) {
         debug(std::cout << "Query: " << query << " launched"
                         << std::endl << std::flush;);
@@ -1525,6 +1662,35 @@ int Database::scheduleCommand(const std::string & query)
     }
 }
 
+/// \brief Schedule all the rows in a batch to be written in one transaction.
+///
+/// The batch is sent as a single query, so it only costs one round
+/// trip, and the query queue only grows by one however big the batch is.
+/// @param done called once the transaction is complete
+/// @param error called before done if the transaction failed, in which
+/// case none of the rows were written
+int Database::scheduleBatch(const DatabaseBatch & batch,
+                            const std::function<void()> & done,
+                            const std::function<void()> & error)
+{
+    if (batch.empty()) {
+        return 0;
+    }
+    pendingQueries.push_back(DatabaseQuery(batch.query(), PGRES_COMMAND_OK,
+                                           batch.statementCount()));
+    pendingQueries.back().done = done;
+    pendingQueries.back().error = error;
+    if (!m_queryInProgress) {
+        debug(std::cout << "Batch of " << batch.rows() << " rows launched"
+                        << std::endl << std::flush;);
+        return launchNewQuery();
+    } else {
+        debug(std::cout << "Batch of " << batch.rows() << " rows scheduled"
+                        << std::endl << std::flush;);
+        return 0;
+    }
+}
+
 int Database::clearPendingQuery()
 {
     if (!m_queryInProgress) {
@@ -1534,15 +1700,32 @@ int Database::clearPendingQuery()
     assert(!pendingQueries.empty());
     debug(std::cout << "Clearing a pending query" << std::endl << std::flush;);
 
-    DatabaseQuery & q = pendingQueries.front();
-    if (q.second == PGRES_COMMAND_OK) {
-        m_queryInProgress = false;
-        pendingQueries.pop_front();
-        return commandOk();
-    } else {
-        log(ERROR, "Pending query wants unknown status");
-        return -1;
+    DatabaseQuery q = pendingQueries.front();
+    m_queryInProgress = false;
+    pendingQueries.pop_front();
+
+    int status = -1;
+    PGresult * res;
+    while ((res = PQgetResult(m_connection)) != NULL) {
+        if (PQresultStatus(res) == q.status) {
+            if (q.result) {
+                q.result(res);
+            }
+            status = 0;
+        } else {
+            reportError();
+            q.failed = true;
+        }
+        PQclear(res);
+    };
+    if (q.failed) {
+        if (q.error) {
+            q.error();
+        }
+    } else if (q.done) {
+        q.done();
     }
+    return status;
 }
 
 int Database::runMaintainance(int command)
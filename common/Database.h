@@ -27,8 +27,13 @@
 
 #include <libpq-fe.h>
 
+#include <deque>
+#include <functional>
+#include <map>
 #include <set>
 #include <memory>
+#include <string>
+#include <vector>
 
 /// \brief Class to handle decoding Atlas encoded database records
 class Decoder : public Atlas::Message::DecoderBase {
@@ -82,9 +87,32 @@ class DatabaseResult;
 
 typedef std::vector<std::string> StringVector;
 typedef std::set<std::string> TableSet;
-typedef std::pair<std::string, ExecStatusType> DatabaseQuery;
+
+/// \brief A query waiting to be sent to the database, or in progress
+struct DatabaseQuery {
+    /// \brief The SQL, which may be several statements.
+    std::string query;
+    /// \brief The status expected from each statement.
+    ExecStatusType status;
+    /// \brief The number of statement results still to come.
+    int results;
+    /// \brief Set if any statement failed.
+    bool failed;
+    /// \brief Called once the query is complete if it succeeded, if set.
+    std::function<void()> done;
+    /// \brief Called instead of done if any statement failed, if set.
+    std::function<void()> error;
+    /// \brief Called with each result of the expected status, if set.
+    std::function<void(PGresult *)> result;
+
+    DatabaseQuery(const std::string & q, ExecStatusType s, int r = 1) :
+        query(q), status(s), results(r), failed(false) { }
+};
+
 typedef std::deque<DatabaseQuery> QueryQue;
 
+class DatabaseBatch;
+
 /// \brief Class to provide interface to Database connection
 ///
 /// Most SQL is generated from here, including queries for handling all
@@ -99,6 +127,17 @@ class Database {
     QueryQue pendingQueries;
     bool m_queryInProgress;
 
+    /// \brief Number of ids reserved from the sequence at a time.
+    int m_idBlockSize;
+    /// \brief Next id to hand out.
+    long m_nextId;
+    /// \brief End of the block of ids m_nextId is from.
+    long m_idBlockEnd;
+    /// \brief Start of a block reserved in advance, or -1.
+    long m_spareIdBlock;
+    /// \brief Set while a block is being reserved in advance.
+    bool m_idBlockPending;
+
     Decoder m_d;
     ObjectDecoder m_od;
 
@@ -112,6 +151,9 @@ class Database {
     bool tuplesOk();
     int commandOk();
 
+    long reserveIdBlock();
+    void scheduleIdBlock();
+
   public:
     static const int MAINTAIN_VACUUM = 0x0100;
     static const int MAINTAIN_VACUUM_FULL = 0x0001;
@@ -137,6 +179,8 @@ class Database {
                       Atlas::Message::MapType &);
     int encodeObject(const Atlas::Message::MapType &,
                      std::string &);
+    int encodeMessage(const Atlas::Message::MapType &,
+                      std::string &);
     int putObject(const std::string & table,
                   const std::string &,
                   const Atlas::Message::MapType &,
@@ -208,7 +252,8 @@ class Database {
     int registerEntityIdGenerator();
 
     /// Creates a new unique id for the database.
-    /// Note that this method will access the database, so it's a fairly expensive method.
+    /// Ids are reserved from the database in blocks, so this only has to
+    /// wait for the database if the ids reserved in advance have run out.
     long newId(std::string & id);
 
     // Interface for Entity and Property tables.
@@ -227,26 +272,32 @@ class Database {
                      const std::string & location_data,
                      const std::string & location_entity_id);
     const DatabaseResult selectEntities(const std::string & loc);
+    const DatabaseResult selectAllEntities();
     int dropEntity(long id);
 
     int registerPropertyTable();
     int insertProperties(const std::string & id,
                          const KeyValues & tuples);
     const DatabaseResult selectProperties(const std::string & loc);
+    const DatabaseResult selectAllProperties();
     int updateProperties(const std::string & id,
                          const KeyValues & tuples);
 
     int registerThoughtsTable();
     const DatabaseResult selectThoughts(const std::string & loc);
+    const DatabaseResult selectAllThoughts();
     int replaceThoughts(const std::string & id,
                          const std::vector<std::string>& thoughts);
 
     // Interface for CommPSQLSocket, so it can give us feedback
     
-    void queryResult(ExecStatusType);
+    void queryResult(PGresult *);
     void queryComplete();
     int launchNewQuery();
     int scheduleCommand(const std::string & query);
+    int scheduleBatch(const DatabaseBatch & batch,
+                      const std::function<void()> & done = nullptr,
+                      const std::function<void()> & error = nullptr);
     int clearPendingQuery();
     int runMaintainance(int command = MAINTAIN_VACUUM);
 
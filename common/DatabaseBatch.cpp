@@ -0,0 +1,159 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2015 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#include "DatabaseBatch.h"
+
+#include "compose.hpp"
+
+using String::compose;
+
+void DatabaseBatch::insertEntity(const std::string & id,
+                                 const std::string & loc,
+                                 const std::string & type,
+                                 int seq,
+                                 const std::string & value)
+{
+    m_entityInserts.push_back(EntityRow{id, loc, type, seq, value});
+}
+
+void DatabaseBatch::updateEntity(const std::string & id,
+                                 int seq,
+                                 const std::string & location_data,
+                                 const std::string & location_entity_id)
+{
+    m_entityUpdates.push_back(EntityRow{id, location_entity_id, "",
+                                        seq, location_data});
+}
+
+void DatabaseBatch::updateEntityWithoutLoc(const std::string & id,
+                                           int seq,
+                                           const std::string & location_data)
+{
+    m_entityUpdates.push_back(EntityRow{id, "", "", seq, location_data});
+}
+
+void DatabaseBatch::insertProperties(const std::string & id,
+                                     const KeyValues & tuples)
+{
+    KeyValues::const_iterator I = tuples.begin();
+    KeyValues::const_iterator Iend = tuples.end();
+    for (; I != Iend; ++I) {
+        m_propertyInserts.push_back(PropertyRow{id, I->first, I->second});
+    }
+}
+
+void DatabaseBatch::updateProperties(const std::string & id,
+                                     const KeyValues & tuples)
+{
+    KeyValues::const_iterator I = tuples.begin();
+    KeyValues::const_iterator Iend = tuples.end();
+    for (; I != Iend; ++I) {
+        m_propertyUpdates.push_back(PropertyRow{id, I->first, I->second});
+    }
+}
+
+void DatabaseBatch::clear()
+{
+    m_entityInserts.clear();
+    m_entityUpdates.clear();
+    m_propertyInserts.clear();
+    m_propertyUpdates.clear();
+}
+
+/// \brief The number of statements in query(), each of which gives a result.
+int DatabaseBatch::statementCount() const
+{
+    // One statement for each kind of row
+    return !m_entityInserts.empty() + !m_entityUpdates.empty() +
+           !m_propertyInserts.empty() + !m_propertyUpdates.empty();
+}
+
+static void joinRows(const std::vector<DatabaseBatch::EntityRow> & rows,
+                     bool insert,
+                     std::string & query)
+{
+    std::vector<DatabaseBatch::EntityRow>::const_iterator I = rows.begin();
+    std::vector<DatabaseBatch::EntityRow>::const_iterator Iend = rows.end();
+    for (; I != Iend; ++I) {
+        if (I != rows.begin()) {
+            query += ", ";
+        }
+        if (insert) {
+            query += compose("(%1, %2, '%3', %4, '%5')",
+                             I->id, I->loc, I->type, I->seq, I->location);
+        } else if (!I->loc.empty()) {
+            query += compose("(%1, %2, '%3', %4)",
+                             I->id, I->seq, I->location, I->loc);
+        } else {
+            // A null loc leaves the existing one in place. The cast makes
+            // sure the column has the right type even if no row in the
+            // batch has a loc.
+            query += compose("(%1, %2, '%3', NULL::integer)",
+                             I->id, I->seq, I->location);
+        }
+    }
+}
+
+static void joinRows(const std::vector<DatabaseBatch::PropertyRow> & rows,
+                     std::string & query)
+{
+    std::vector<DatabaseBatch::PropertyRow>::const_iterator I = rows.begin();
+    std::vector<DatabaseBatch::PropertyRow>::const_iterator Iend = rows.end();
+    for (; I != Iend; ++I) {
+        if (I != rows.begin()) {
+            query += ", ";
+        }
+        query += compose("(%1, '%2', '%3')", I->id, I->name, I->value);
+    }
+}
+
+/// \brief Build the query which writes all the rows in the batch.
+///
+/// Entities are inserted before properties, as properties refer to their
+/// entity. The statements are not wrapped in BEGIN and COMMIT, as several
+/// statements sent as one query are already run as a single transaction,
+/// which is rolled back if any of them fail. An explicit transaction would
+/// instead be left open and aborted on the connection.
+std::string DatabaseBatch::query() const
+{
+    std::string query;
+    if (!m_entityInserts.empty()) {
+        query += "INSERT INTO entities VALUES ";
+        joinRows(m_entityInserts, true, query);
+        query += "; ";
+    }
+    if (!m_entityUpdates.empty()) {
+        query += "UPDATE entities AS e SET seq = v.seq, "
+                 "location = v.location, loc = COALESCE(v.loc, e.loc) "
+                 "FROM (VALUES ";
+        joinRows(m_entityUpdates, false, query);
+        query += ") AS v(id, seq, location, loc) WHERE e.id = v.id; ";
+    }
+    if (!m_propertyInserts.empty()) {
+        query += "INSERT INTO properties VALUES ";
+        joinRows(m_propertyInserts, query);
+        query += "; ";
+    }
+    if (!m_propertyUpdates.empty()) {
+        query += "UPDATE properties AS p SET value = v.value FROM (VALUES ";
+        joinRows(m_propertyUpdates, query);
+        query += ") AS v(id, name, value) "
+                 "WHERE p.id = v.id AND p.name = v.name; ";
+    }
+    return query;
+}
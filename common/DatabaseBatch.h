@@ -0,0 +1,111 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2015 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifndef COMMON_DATABASE_BATCH_H
+#define COMMON_DATABASE_BATCH_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+/// \brief Rows to be written to the entities and properties tables in
+/// a single transaction
+///
+/// Rows of each kind are collected, and written with one multi-row
+/// statement per kind, so a whole batch is written with one round trip
+/// to the database rather than one round trip per entity or property.
+///
+/// The rows are kept as they were given, so storage other than the
+/// database can write the same batch.
+class DatabaseBatch {
+  public:
+    typedef std::map<std::string, std::string> KeyValues;
+
+    /// \brief A row of the entities table
+    struct EntityRow {
+        std::string id;
+        /// \brief Id of the entity's location, or empty to leave it as is.
+        std::string loc;
+        /// \brief Type of the entity. Only set for new entities.
+        std::string type;
+        int seq;
+        std::string location;
+    };
+
+    /// \brief A row of the properties table
+    struct PropertyRow {
+        std::string id;
+        std::string name;
+        std::string value;
+    };
+  protected:
+    std::vector<EntityRow> m_entityInserts;
+    std::vector<EntityRow> m_entityUpdates;
+    std::vector<PropertyRow> m_propertyInserts;
+    std::vector<PropertyRow> m_propertyUpdates;
+  public:
+    void insertEntity(const std::string & id,
+                      const std::string & loc,
+                      const std::string & type,
+                      int seq,
+                      const std::string & value);
+    void updateEntity(const std::string & id,
+                      int seq,
+                      const std::string & location_data,
+                      const std::string & location_entity_id);
+    void updateEntityWithoutLoc(const std::string & id,
+                                int seq,
+                                const std::string & location_data);
+    void insertProperties(const std::string & id,
+                          const KeyValues & tuples);
+    void updateProperties(const std::string & id,
+                          const KeyValues & tuples);
+
+    const std::vector<EntityRow> & entityInserts() const {
+        return m_entityInserts;
+    }
+
+    const std::vector<EntityRow> & entityUpdates() const {
+        return m_entityUpdates;
+    }
+
+    const std::vector<PropertyRow> & propertyInserts() const {
+        return m_propertyInserts;
+    }
+
+    const std::vector<PropertyRow> & propertyUpdates() const {
+        return m_propertyUpdates;
+    }
+
+    /// \brief The number of rows in the batch.
+    std::size_t rows() const {
+        return m_entityInserts.size() + m_entityUpdates.size() +
+               m_propertyInserts.size() + m_propertyUpdates.size();
+    }
+
+    bool empty() const {
+        return rows() == 0;
+    }
+
+    void clear();
+
+    int statementCount() const;
+    std::string query() const;
+};
+
+#endif // COMMON_DATABASE_BATCH_H
@@ -0,0 +1,101 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2015 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#include "Histogram.h"
+
+#include <algorithm>
+#include <iostream>
+
+void Histogram::observe(double value)
+{
+    // Bounds are inclusive, so the bucket is the first with a bound which
+    // is not less than the value.
+    std::size_t bucket = std::lower_bound(m_bounds.begin(), m_bounds.end(),
+                                          value) - m_bounds.begin();
+    ++m_counts[bucket];
+    m_sum += value;
+    ++m_count;
+}
+
+/// \brief Write the histogram to a stream.
+///
+/// @param name the name of the histogram, which can include labels
+/// in braces
+void Histogram::send(const std::string & name, std::ostream & io) const
+{
+    // The bucket bound is added as another label
+    std::string base = name;
+    std::string labels;
+    std::string::size_type brace = name.find('{');
+    if (brace != std::string::npos && name.back() == '}') {
+        base = name.substr(0, brace);
+        labels = name.substr(brace + 1, name.size() - brace - 2);
+    }
+    std::string separator = labels.empty() ? "" : ",";
+    std::string suffix = labels.empty() ? "" : "{" + labels + "}";
+
+    long cumulative = 0;
+    for (std::size_t i = 0; i < m_bounds.size(); ++i) {
+        cumulative += m_counts[i];
+        io << base << "_bucket{" << labels << separator << "le=\""
+           << m_bounds[i] << "\"} " << cumulative << std::endl;
+    }
+    io << base << "_bucket{" << labels << separator << "le=\"+Inf\"} "
+       << m_count << std::endl;
+    io << base << "_sum" << suffix << " " << m_sum << std::endl;
+    io << base << "_count" << suffix << " " << m_count << std::endl;
+}
+
+/// \brief Make bucket bounds which increase by a constant factor.
+///
+/// @param start the upper bound of the first bucket
+/// @param factor the ratio between the bounds of adjacent buckets
+/// @param count the number of buckets
+std::vector<double> Histogram::exponentialBounds(double start, double factor,
+                                                 int count)
+{
+    std::vector<double> bounds;
+    double bound = start;
+    for (int i = 0; i < count; ++i) {
+        bounds.push_back(bound);
+        bound *= factor;
+    }
+    return bounds;
+}
+
+/// \brief Make bucket bounds which step linearly within each power of ten.
+///
+/// Gives the bounds 1, 2, ... 9 times start, then 10, 20, ... 90 times
+/// start, and so on, finishing at start times ten to the power of decades.
+/// This keeps the relative error of each bucket small across a range of
+/// values too wide for linear buckets.
+/// @param start the upper bound of the first bucket
+/// @param decades the number of powers of ten covered
+std::vector<double> Histogram::logLinearBounds(double start, int decades)
+{
+    std::vector<double> bounds;
+    double decade = start;
+    for (int i = 0; i < decades; ++i) {
+        for (int step = 1; step < 10; ++step) {
+            bounds.push_back(decade * step);
+        }
+        decade *= 10;
+    }
+    bounds.push_back(decade);
+    return bounds;
+}
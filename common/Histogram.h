@@ -0,0 +1,70 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2015 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifndef COMMON_HISTOGRAM_H
+#define COMMON_HISTOGRAM_H
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/// \brief Distribution of observed values, for the monitoring subsystem
+///
+/// Values are counted in buckets with fixed upper bounds, and the output
+/// is in the format Prometheus expects for a histogram, with a line for
+/// the cumulative count of each bucket, followed by the sum and count of
+/// all values.
+class Histogram {
+  protected:
+    /// \brief Upper bound of each bucket, in increasing order.
+    std::vector<double> m_bounds;
+    /// \brief Number of values in each bucket, and values above the last bound.
+    std::vector<long> m_counts;
+    double m_sum;
+    long m_count;
+  public:
+    /// \brief Constructor
+    ///
+    /// @param bounds upper bound of each bucket, in increasing order
+    explicit Histogram(const std::vector<double> & bounds) :
+        m_bounds(bounds), m_counts(bounds.size() + 1, 0),
+        m_sum(0.), m_count(0) { }
+
+    void observe(double value);
+
+    long count() const {
+        return m_count;
+    }
+
+    double sum() const {
+        return m_sum;
+    }
+
+    /// \brief Get the number of values in a bucket, not including lower ones.
+    long bucketCount(std::size_t bucket) const {
+        return m_counts[bucket];
+    }
+
+    void send(const std::string & name, std::ostream &) const;
+
+    static std::vector<double> exponentialBounds(double start, double factor,
+                                                 int count);
+    static std::vector<double> logLinearBounds(double start, int decades);
+};
+
+#endif // COMMON_HISTOGRAM_H
@@ -19,6 +19,7 @@
 #include "Link.h"
 
 #include "common/CommSocket.h"
+#include "common/OpBroadcast.h"
 
 #include <Atlas/Objects/Encoder.h>
 #include <Atlas/Objects/Operation.h>
@@ -39,6 +40,13 @@ Link::~Link()
 void Link::send(const Operation & op) const
 {
     if (m_encoder != 0) {
+        if (m_commSocket.checkBacklog(op) != 0) {
+            return;
+        }
+        OpBroadcast * broadcast = OpBroadcast::active(op);
+        if (broadcast != 0 && m_commSocket.sendBroadcast(op, *broadcast) == 0) {
+            return;
+        }
         m_encoder->streamObjectsMessage(op);
         m_commSocket.flush();
     }
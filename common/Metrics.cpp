@@ -0,0 +1,42 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2015 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#include "Metrics.h"
+
+static std::atomic<unsigned int> next_shard(0);
+
+/// \brief Get the shard used by the calling thread.
+///
+/// Threads are numbered in the order they first update a sharded
+/// counter, so the threads of a pool each get their own slot as long as
+/// the counter has at least as many shards as there are threads.
+unsigned int metricThreadShard()
+{
+    static thread_local unsigned int shard = next_shard++;
+    return shard;
+}
+
+/// \brief Get the value of the counter, adding up all its shards.
+long Counter::value() const
+{
+    long total = 0;
+    for (unsigned int i = 0; i <= m_shardMask; ++i) {
+        total += m_slots[i].value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
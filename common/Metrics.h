@@ -0,0 +1,84 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2015 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifndef COMMON_METRICS_H
+#define COMMON_METRICS_H
+
+#include <atomic>
+
+/// \brief Storage for the value of a metric, or one shard of it
+///
+/// Padded to the size of a cache line, so that threads updating
+/// neighbouring slots do not contend for the same line.
+struct MetricSlot {
+    std::atomic<long> value;
+    char padding[64 - sizeof(std::atomic<long>)];
+
+    MetricSlot() : value(0) { }
+};
+
+unsigned int metricThreadShard();
+
+/// \brief Handle to a counter registered with the monitoring subsystem
+///
+/// The handle is cheap to copy, and refers to slots allocated when the
+/// counter was registered, which last as long as the Monitors instance.
+/// Updates are relaxed atomic additions, so can be made from any thread
+/// without locking or allocating. A sharded counter has a slot for each
+/// of several threads, which are added together when it is read.
+class Counter {
+  protected:
+    MetricSlot * m_slots;
+    unsigned int m_shardMask;
+  public:
+    Counter(MetricSlot * slots, unsigned int shards) :
+        m_slots(slots), m_shardMask(shards - 1) { }
+
+    void increment(long amount = 1) {
+        MetricSlot & slot = m_shardMask == 0 ? m_slots[0] :
+                            m_slots[metricThreadShard() & m_shardMask];
+        slot.value.fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    long value() const;
+};
+
+/// \brief Handle to a gauge registered with the monitoring subsystem
+///
+/// A gauge has a single slot, which is set to the current value of
+/// whatever it measures.
+class Gauge {
+  protected:
+    MetricSlot * m_slot;
+  public:
+    explicit Gauge(MetricSlot * slot) : m_slot(slot) { }
+
+    void set(long value) {
+        m_slot->value.store(value, std::memory_order_relaxed);
+    }
+
+    void add(long amount) {
+        m_slot->value.fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    long value() const {
+        return m_slot->value.load(std::memory_order_relaxed);
+    }
+};
+
+#endif // COMMON_METRICS_H
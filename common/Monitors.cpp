@@ -18,6 +18,7 @@
 
 #include "Monitors.h"
 
+#include "Histogram.h"
 #include "Variable.h"
 
 #include <iostream>
@@ -38,6 +39,16 @@ Monitors::~Monitors()
     for (; I != Iend; ++I) {
         delete I->second;
     }
+    MetricDict::const_iterator J = m_metrics.begin();
+    MetricDict::const_iterator Jend = m_metrics.end();
+    for (; J != Jend; ++J) {
+        delete [] J->second.slots;
+    }
+    HistogramDict::const_iterator K = m_histograms.begin();
+    HistogramDict::const_iterator Kend = m_histograms.end();
+    for (; K != Kend; ++K) {
+        delete K->second;
+    }
 }
 
 Monitors * Monitors::instance()
@@ -65,6 +76,59 @@ void Monitors::watch(const::std::string & name, VariableBase * monitor)
     m_variableMonitors[name] = monitor;
 }
 
+/// \brief Get the slots of a metric, allocating them if it is new.
+///
+/// @param name the name of the metric, which can include labels in braces
+/// @param shards the number of slots a new metric should have, which is
+/// rounded up to a power of two
+Monitors::MetricSlots & Monitors::metricSlots(const std::string & name,
+                                              unsigned int shards)
+{
+    MetricDict::iterator I = m_metrics.find(name);
+    if (I == m_metrics.end()) {
+        unsigned int count = 1;
+        while (count < shards) {
+            count <<= 1;
+        }
+        MetricSlots metric = { new MetricSlot[count], count };
+        I = m_metrics.insert(std::make_pair(name, metric)).first;
+    }
+    return I->second;
+}
+
+/// \brief Register a counter, or get the existing counter with this name.
+///
+/// @param name the name of the counter, which can include labels in braces
+/// @param shards the number of threads expected to update the counter
+/// at the same time
+Counter Monitors::counter(const std::string & name, unsigned int shards)
+{
+    MetricSlots & metric = metricSlots(name, shards);
+    return Counter(metric.slots, metric.count);
+}
+
+/// \brief Register a gauge, or get the existing gauge with this name.
+Gauge Monitors::gauge(const std::string & name)
+{
+    return Gauge(metricSlots(name, 1).slots);
+}
+
+/// \brief Register a histogram, or get the existing histogram with this name.
+///
+/// The histogram is owned by this object, and lasts as long as it does,
+/// like the slots behind counters and gauges.
+/// @param name the name of the histogram, which can include labels in braces
+/// @param bounds upper bound of each bucket of a new histogram
+Histogram * Monitors::histogram(const std::string & name,
+                                const std::vector<double> & bounds)
+{
+    Histogram *& histogram = m_histograms[name];
+    if (histogram == 0) {
+        histogram = new Histogram(bounds);
+    }
+    return histogram;
+}
+
 static std::ostream & operator<<(std::ostream & s, const Element & e)
 {
     switch (e.getType()) {
@@ -98,6 +162,9 @@ void Monitors::send(std::ostream & io)
         J->second->send(io);
         io << std::endl;
     }
+
+    sendMetrics(io);
+    sendHistograms(io);
 }
 
 void Monitors::sendNumerics(std::ostream & io)
@@ -120,7 +187,27 @@ void Monitors::sendNumerics(std::ostream & io)
         }
     }
 
+    sendMetrics(io);
+    sendHistograms(io);
+}
 
+void Monitors::sendMetrics(std::ostream & io)
+{
+    MetricDict::const_iterator I = m_metrics.begin();
+    MetricDict::const_iterator Iend = m_metrics.end();
+    for (; I != Iend; ++I) {
+        io << I->first << " "
+           << Counter(I->second.slots, I->second.count).value() << std::endl;
+    }
+}
+
+void Monitors::sendHistograms(std::ostream & io)
+{
+    HistogramDict::const_iterator I = m_histograms.begin();
+    HistogramDict::const_iterator Iend = m_histograms.end();
+    for (; I != Iend; ++I) {
+        I->second->send(I->first, io);
+    }
 }
 
 int Monitors::readVariable(const std::string& key, std::ostream& out_stream) const
@@ -132,5 +219,11 @@ int Monitors::readVariable(const std::string& key, std::ostream& out_stream) con
         return 0;
     }
 
+    MetricDict::const_iterator K = m_metrics.find(key);
+    if (K != m_metrics.end()) {
+        out_stream << Counter(K->second.slots, K->second.count).value();
+        return 0;
+    }
+
     return 1;
 }
@@ -19,31 +19,56 @@
 #ifndef COMMON_MONITORS_H
 #define COMMON_MONITORS_H
 
+#include "Metrics.h"
+
 #include <Atlas/Message/Element.h>
 
+#include <vector>
+
+class Histogram;
 class VariableBase;
 
 /// \brief Storage for monitor values to be exported
 ///
 /// Any code can insert or update key value pairs here, and subsystems like
 /// the http interface can access it.
+///
+/// Counters, gauges and histograms are registered once, from the main
+/// thread, and the handle returned is used to update them from then on.
 class Monitors {
   protected:
+    /// \brief The slots holding the value of a counter or gauge.
+    struct MetricSlots {
+        MetricSlot * slots;
+        unsigned int count;
+    };
+
     typedef std::map<std::string, VariableBase *> MonitorDict;
+    typedef std::map<std::string, Histogram *> HistogramDict;
+    typedef std::map<std::string, MetricSlots> MetricDict;
 
     static Monitors * m_instance;
 
     Monitors();
     ~Monitors();
 
+    void sendHistograms(std::ostream &);
+    void sendMetrics(std::ostream &);
+    MetricSlots & metricSlots(const std::string &, unsigned int shards);
+
     Atlas::Message::MapType m_pairs;
     MonitorDict m_variableMonitors;
+    HistogramDict m_histograms;
+    MetricDict m_metrics;
   public:
     static Monitors * instance();
     static void cleanup();
 
     void insert(const std::string &, const Atlas::Message::Element &);
     void watch(const std::string &, VariableBase *);
+    Counter counter(const std::string &, unsigned int shards = 1);
+    Gauge gauge(const std::string &);
+    Histogram * histogram(const std::string &, const std::vector<double> &);
     void send(std::ostream &);
     void sendNumerics(std::ostream &);
     int readVariable(const std::string& key, std::ostream& out_stream) const;
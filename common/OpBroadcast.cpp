@@ -0,0 +1,125 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2015 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#include "OpBroadcast.h"
+
+#include "common/compose.hpp"
+
+#include <Atlas/Objects/RootOperation.h>
+
+OpBroadcast * OpBroadcast::s_active = 0;
+long OpBroadcast::s_serial = 0;
+
+/// \brief Constructor, making this the active broadcast.
+///
+/// @param op the operation which is about to be broadcast
+OpBroadcast::OpBroadcast(const Operation & op) : m_op(op.get()),
+                                                 m_previous(s_active)
+{
+    // Only characters which codecs never escape are used, and the serial
+    // makes it unlikely that the placeholder occurs anywhere else in the
+    // operation. If it does splitting fails, and the op is sent normally.
+    m_placeholder = String::compose("broadcastTo%1x", ++s_serial);
+    s_active = this;
+}
+
+OpBroadcast::~OpBroadcast()
+{
+    s_active = m_previous;
+}
+
+/// \brief Get the shared data for a codec, if it has been encoded yet.
+///
+/// @param codec the type of the codec
+/// @return the shared data, or null if nothing has been encoded.
+OpBroadcast::EncodingPtr OpBroadcast::getEncoding(const std::type_index & codec) const
+{
+    auto I = m_encodings.find(codec);
+    if (I == m_encodings.end()) {
+        return EncodingPtr();
+    }
+    return I->second;
+}
+
+/// \brief Store the encoded operation for a codec.
+///
+/// @param codec the type of the codec
+/// @param encoded the operation as encoded with TO set to the placeholder
+/// @return the shared data, which will be marked invalid if the data could
+/// not be split around the placeholder.
+OpBroadcast::EncodingPtr OpBroadcast::addEncoding(const std::type_index & codec,
+                                                  const std::string & encoded)
+{
+    std::shared_ptr<Encoding> encoding = std::make_shared<Encoding>();
+    split(encoded, m_placeholder, *encoding);
+    m_encodings[codec] = encoding;
+    return encoding;
+}
+
+/// \brief Get the active broadcast for an operation.
+///
+/// @param op the operation being sent
+/// @return the active broadcast if op is being broadcast, null otherwise.
+OpBroadcast * OpBroadcast::active(const Operation & op)
+{
+    if (s_active != 0 && s_active->m_op == op.get()) {
+        return s_active;
+    }
+    return 0;
+}
+
+/// \brief Check if a value is written unchanged by all codecs.
+///
+/// Only values for which this is true can be put in place of the
+/// placeholder.
+bool OpBroadcast::isVerbatim(const std::string & value)
+{
+    if (value.empty()) {
+        return false;
+    }
+    for (char c : value) {
+        if (!((c >= '0' && c <= '9') ||
+              (c >= 'a' && c <= 'z') ||
+              (c >= 'A' && c <= 'Z') ||
+              c == '_')) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// \brief Split encoded data around the placeholder.
+///
+/// The data is only valid if the placeholder occurs exactly once.
+void OpBroadcast::split(const std::string & encoded,
+                        const std::string & placeholder,
+                        Encoding & encoding)
+{
+    encoding.m_valid = false;
+    std::string::size_type pos = encoded.find(placeholder);
+    if (pos == std::string::npos) {
+        return;
+    }
+    std::string::size_type end = pos + placeholder.size();
+    if (encoded.find(placeholder, end) != std::string::npos) {
+        return;
+    }
+    encoding.m_prefix = encoded.substr(0, pos);
+    encoding.m_suffix = encoded.substr(end);
+    encoding.m_valid = true;
+}
@@ -0,0 +1,90 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2015 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifndef COMMON_OP_BROADCAST_H
+#define COMMON_OP_BROADCAST_H
+
+#include "common/OperationRouter.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <typeindex>
+
+/// \brief Shares the encoded form of an operation broadcast to many clients.
+///
+/// While an instance exists the operation it was created for is considered
+/// to be in the process of being broadcast. The only thing which differs
+/// between the copies sent to each recipient is the TO attribute, so
+/// the first connection using a given codec encodes the operation once
+/// with a placeholder in place of TO, and the encoded data is split around
+/// the placeholder. Each connection then only needs to send the shared
+/// data with its own TO value in between.
+///
+/// Instances are expected to be created on the stack around the loop which
+/// delivers the operation, and the operation must not be modified in any
+/// other way than setting TO while the instance exists.
+class OpBroadcast {
+  public:
+    /// \brief The shared encoded data for one codec.
+    struct Encoding {
+        /// \brief Encoded data up to the TO value.
+        std::string m_prefix;
+        /// \brief Encoded data after the TO value.
+        std::string m_suffix;
+        /// \brief False if the data couldn't be split around the TO value.
+        bool m_valid;
+    };
+
+    typedef std::shared_ptr<const Encoding> EncodingPtr;
+  protected:
+    /// \brief The operation being broadcast.
+    const Atlas::Objects::Operation::RootOperationData * m_op;
+    /// \brief The broadcast which was active when this one was created.
+    OpBroadcast * m_previous;
+    /// \brief Value written in place of TO when encoding.
+    std::string m_placeholder;
+    /// \brief Encoded data, keyed by the type of the codec used.
+    std::map<std::type_index, EncodingPtr> m_encodings;
+
+    static OpBroadcast * s_active;
+    static long s_serial;
+
+    OpBroadcast(const OpBroadcast &) = delete;
+    OpBroadcast & operator=(const OpBroadcast &) = delete;
+  public:
+    explicit OpBroadcast(const Operation & op);
+    ~OpBroadcast();
+
+    /// \brief Value to be written in place of TO when encoding.
+    const std::string & placeholder() const {
+        return m_placeholder;
+    }
+
+    EncodingPtr getEncoding(const std::type_index & codec) const;
+    EncodingPtr addEncoding(const std::type_index & codec,
+                            const std::string & encoded);
+
+    static OpBroadcast * active(const Operation & op);
+    static bool isVerbatim(const std::string & value);
+    static void split(const std::string & encoded,
+                      const std::string & placeholder,
+                      Encoding & encoding);
+};
+
+#endif // COMMON_OP_BROADCAST_H
@@ -0,0 +1,181 @@
+/*
+ Copyright (C) 2015 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "OpTimingWheel.h"
+
+#include <algorithm>
+#include <functional>
+
+#include <cassert>
+#include <cmath>
+
+static int levelShift(int level)
+{
+    if (level == 0) {
+        return 0;
+    }
+    return OpTimingWheel::level0_bits + (level - 1) * OpTimingWheel::level_bits;
+}
+
+static int levelWidth(int level)
+{
+    if (level == 0) {
+        return OpTimingWheel::level0_bits;
+    }
+    return OpTimingWheel::level_bits;
+}
+
+/// \brief Number of bits of the tick which are covered by the wheel.
+static const int wheel_bits = OpTimingWheel::level0_bits +
+                              (OpTimingWheel::levels - 1) * OpTimingWheel::level_bits;
+
+OpTimingWheel::Entry::Entry(const OpQueEntry & entry, std::uint64_t sequence) :
+    m_seconds(entry->getSeconds()), m_sequence(sequence), m_entry(entry)
+{
+}
+
+OpTimingWheel::OpTimingWheel(double resolution) :
+    m_resolution(resolution), m_cursor(0), m_sequence(0), m_size(0)
+{
+    for (int level = 0; level < levels; ++level) {
+        m_slots[level].resize(1 << levelWidth(level));
+    }
+}
+
+std::int64_t OpTimingWheel::toTick(double seconds) const
+{
+    return (std::int64_t)std::floor(seconds / m_resolution);
+}
+
+/// \brief Put an entry in the place where it belongs given the cursor.
+///
+/// The level is the lowest one in which the tick of the entry is in the
+/// same range as the cursor, so that it will be reached by cascading.
+void OpTimingWheel::insert(Entry && entry, std::int64_t tick)
+{
+    if (tick <= m_cursor) {
+        m_ready.push_back(std::move(entry));
+        std::push_heap(m_ready.begin(), m_ready.end(), std::greater<Entry>());
+        return;
+    }
+    std::uint64_t diff = (std::uint64_t)(tick ^ m_cursor);
+    for (int level = 0; level < levels; ++level) {
+        int shift = levelShift(level);
+        int width = levelWidth(level);
+        if ((diff >> (shift + width)) == 0) {
+            int slot = (int)((tick >> shift) & ((1 << width) - 1));
+            m_slots[level][slot].push_back(std::move(entry));
+            return;
+        }
+    }
+    m_overflow.push_back(std::move(entry));
+    std::push_heap(m_overflow.begin(), m_overflow.end(), std::greater<Entry>());
+}
+
+/// \brief Move the cursor to the next non-empty slot of a level.
+///
+/// The cursor is moved to the start of the slot, and the entries in it are
+/// spread out over the lower levels.
+/// @return true if a slot was found, false if the rest of the level is empty.
+bool OpTimingWheel::cascade(int level)
+{
+    int shift = levelShift(level);
+    int width = levelWidth(level);
+    int mask = (1 << width) - 1;
+    int current = (int)((m_cursor >> shift) & mask);
+    for (int i = current + 1; i <= mask; ++i) {
+        Slot & slot = m_slots[level][i];
+        if (slot.empty()) {
+            continue;
+        }
+        std::int64_t span = ((std::int64_t)1 << (shift + width)) - 1;
+        m_cursor = (m_cursor & ~span) | ((std::int64_t)i << shift);
+        // Entries can never end up back in the same slot, as they now
+        // share it with the cursor.
+        for (Entry & entry : slot) {
+            insert(std::move(entry), toTick(entry.m_seconds));
+        }
+        slot.clear();
+        return true;
+    }
+    return false;
+}
+
+/// \brief Advance the cursor until there are entries ready.
+void OpTimingWheel::advance()
+{
+    while (m_ready.empty() && m_size != 0) {
+        bool cascaded = false;
+        for (int level = 0; level < levels && !cascaded; ++level) {
+            cascaded = cascade(level);
+        }
+        if (cascaded) {
+            continue;
+        }
+        // The wheel is empty, so move it on to the first entry which
+        // didn't fit, and take all the entries which now fit.
+        assert(!m_overflow.empty());
+        m_cursor = toTick(m_overflow.front().m_seconds);
+        while (!m_overflow.empty()) {
+            std::int64_t tick = toTick(m_overflow.front().m_seconds);
+            if (((std::uint64_t)(tick ^ m_cursor) >> wheel_bits) != 0) {
+                break;
+            }
+            std::pop_heap(m_overflow.begin(), m_overflow.end(), std::greater<Entry>());
+            insert(std::move(m_overflow.back()), tick);
+            m_overflow.pop_back();
+        }
+    }
+}
+
+void OpTimingWheel::push(const OpQueEntry & entry)
+{
+    Entry e(entry, m_sequence++);
+    std::int64_t tick = toTick(e.m_seconds);
+    if (m_size == 0) {
+        // Nothing is queued, so the wheel can be started anywhere.
+        m_cursor = tick;
+    }
+    ++m_size;
+    insert(std::move(e), tick);
+}
+
+void OpTimingWheel::pop()
+{
+    assert(!m_ready.empty());
+    std::pop_heap(m_ready.begin(), m_ready.end(), std::greater<Entry>());
+    m_ready.pop_back();
+    --m_size;
+    advance();
+}
+
+void OpTimingWheel::clear()
+{
+    for (int level = 0; level < levels; ++level) {
+        for (Slot & slot : m_slots[level]) {
+            slot.clear();
+        }
+    }
+    m_ready.clear();
+    m_overflow.clear();
+    m_size = 0;
+}
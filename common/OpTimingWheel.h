@@ -0,0 +1,147 @@
+/*
+ Copyright (C) 2015 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef OPTIMINGWHEEL_H_
+#define OPTIMINGWHEEL_H_
+
+#include "OperationsDispatcher.h"
+
+#include <cstdint>
+#include <vector>
+
+/// \brief Queue of future operations, ordered by the time they are due.
+///
+/// Operations are sorted into slots of a hierarchical timing wheel, so
+/// adding an operation takes constant time. Each level of the wheel
+/// covers a range of time which is a fixed number of slots of the level
+/// below. As time advances the slots of the higher levels are cascaded
+/// down to the lower ones, and once a slot of the lowest level is reached
+/// its operations are moved to a small heap, from which they are taken in
+/// order. Operations too far in the future to fit in the wheel are kept in
+/// a separate heap until the wheel gets close enough to them.
+///
+/// Operations which are due at the same time are taken in the order they
+/// were added. The time an operation is due is read once when it's added,
+/// so it must not be changed while it's queued.
+///
+/// The interface is the same as that of the std::priority_queue it
+/// replaces.
+class OpTimingWheel
+{
+    public:
+        /// \brief An operation in the queue, and the time it is due.
+        struct Entry {
+            double m_seconds;
+            std::uint64_t m_sequence;
+            OpQueEntry m_entry;
+
+            Entry(const OpQueEntry & entry, std::uint64_t sequence);
+
+            bool operator>(const Entry & right) const {
+                if (m_seconds != right.m_seconds) {
+                    return m_seconds > right.m_seconds;
+                }
+                return m_sequence > right.m_sequence;
+            }
+        };
+
+        /// \brief Bits of the slot number in the lowest level of the wheel.
+        static const int level0_bits = 8;
+        /// \brief Bits of the slot number in each of the higher levels.
+        static const int level_bits = 6;
+        /// \brief Number of levels in the wheel.
+        static const int levels = 3;
+
+        /**
+         * @brief Ctor.
+         * @param resolution Length of time in seconds covered by a slot of the lowest level.
+         */
+        explicit OpTimingWheel(double resolution = 1. / 32.);
+
+        /**
+         * @brief Adds an operation.
+         */
+        void push(const OpQueEntry & entry);
+
+        /**
+         * @brief Gets the operation which is due first.
+         *
+         * The queue must not be empty.
+         */
+        const OpQueEntry & top() const {
+            return m_ready.front().m_entry;
+        }
+
+        /**
+         * @brief Gets the time the first operation is due.
+         *
+         * This avoids looking at the operation itself. The queue must not
+         * be empty.
+         */
+        double topSeconds() const {
+            return m_ready.front().m_seconds;
+        }
+
+        /**
+         * @brief Removes the operation which is due first.
+         */
+        void pop();
+
+        bool empty() const {
+            return m_size == 0;
+        }
+
+        std::size_t size() const {
+            return m_size;
+        }
+
+        /**
+         * @brief Removes all operations.
+         */
+        void clear();
+
+    protected:
+        typedef std::vector<Entry> Slot;
+
+        /// \brief Length of time covered by a slot of the lowest level.
+        const double m_resolution;
+        /// \brief The slots of each level, lowest level first.
+        std::vector<Slot> m_slots[levels];
+        /// \brief Operations in the current slot, as a heap.
+        ///
+        /// Operations added for a time before the current slot are also put
+        /// here. If the queue is not empty, the first of these is always the
+        /// operation which is due first.
+        Slot m_ready;
+        /// \brief Operations due after the range covered by the wheel, as a heap.
+        Slot m_overflow;
+        /// \brief The current slot of the lowest level.
+        std::int64_t m_cursor;
+        /// \brief The number of operations added so far.
+        std::uint64_t m_sequence;
+        std::size_t m_size;
+
+        std::int64_t toTick(double seconds) const;
+        void insert(Entry && entry, std::int64_t tick);
+        bool cascade(int level);
+        void advance();
+
+        friend class OpTimingWheeltest;
+};
+
+#endif /* OPTIMINGWHEEL_H_ */
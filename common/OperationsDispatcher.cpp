@@ -21,16 +21,38 @@
 #endif
 
 #include "OperationsDispatcher.h"
+#include "OpTimingWheel.h"
 #include "rulesets/LocatedEntity.h"
 #include "BaseWorld.h"
 #include "const.h"
 #include "debug.h"
+#include "Histogram.h"
 #include "Monitors.h"
+#include "Variable.h"
+#include "Update.h"
 
+#include <chrono>
 #include <iostream>
 
 static const bool debug_flag = false;
 
+/// Wall clock time in seconds idle() spends dispatching, unless configured.
+static const double default_time_budget = 0.002;
+/// Largest number of ops dispatched without checking the clock.
+static const unsigned int max_batch_size = 1024;
+
+/// \brief Work out how many ops can be dispatched in a given time.
+static unsigned int batchSizeFor(double seconds, double per_op)
+{
+    if (per_op <= 0. || seconds >= per_op * max_batch_size) {
+        return max_batch_size;
+    }
+    if (seconds <= per_op) {
+        return 1;
+    }
+    return (unsigned int)(seconds / per_op);
+}
+
 OpQueEntry::OpQueEntry(const Operation & o, LocatedEntity & f) : op(o),
                                                                         from(&f)
 {
@@ -44,24 +66,39 @@ OpQueEntry::OpQueEntry(const OpQueEntry & o) : op(o.op), from(o.from)
 
 OpQueEntry::~OpQueEntry()
 {
-    from->decRef();
+    if (from != nullptr) {
+        from->decRef();
+    }
 }
 
 
 OperationsDispatcher::OperationsDispatcher(const std::function<void(const Operation&, LocatedEntity&)>& operationProcessor, const std::function<double()>& timeProviderFn)
-: m_operationProcessor(operationProcessor), m_timeProviderFn(timeProviderFn), m_operation_queues_dirty(false)
+: m_operationProcessor(operationProcessor), m_timeProviderFn(timeProviderFn),
+  m_operationQueue(new OpTimingWheel), m_operation_queues_dirty(false),
+  m_supersededUpdates(Monitors::instance()->counter("superseded_updates")),
+  m_immediateQueueSize(Monitors::instance()->gauge("immediate_operations_queue")),
+  m_operationQueueSize(Monitors::instance()->gauge("operations_queue")),
+  m_timeBudget(default_time_budget), m_batchSize(1),
+  m_sliceOps(Monitors::instance()->histogram("dispatch_slice_ops",
+        Histogram::exponentialBounds(1., 2., 13))),
+  m_sliceTime(Monitors::instance()->histogram("dispatch_slice_seconds",
+        Histogram::exponentialBounds(0.00001, 2., 12))),
+  m_backlogAge(Monitors::instance()->histogram("dispatch_backlog_age_seconds",
+        Histogram::exponentialBounds(0.001, 2., 14)))
 {
 }
 
 OperationsDispatcher::~OperationsDispatcher()
 {
     clearQueues();
+    delete m_operationQueue;
 }
 
 void OperationsDispatcher::clearQueues()
 {
     m_immediateQueue = OpQueue();
-    m_operationQueue = OpPriorityQueue();
+    m_operationQueue->clear();
+    m_movementUpdates.clear();
 }
 
 void OperationsDispatcher::dispatchOperation(const OpQueEntry& oqe)
@@ -83,6 +120,31 @@ void OperationsDispatcher::dispatchOperation(const OpQueEntry& oqe)
     }
 }
 
+/// \brief Check if an Update operation is for the movement of the entity
+/// sending it.
+static bool isMovementUpdate(const Operation & op, const LocatedEntity & ent)
+{
+    return op->getClassNo() == Atlas::Objects::Operation::UPDATE_NO &&
+           !op->isDefaultRefno() && op->getTo() == ent.getId();
+}
+
+bool OperationsDispatcher::isSupersededUpdate(const OpQueEntry& oqe)
+{
+    if (!isMovementUpdate(oqe.op, *oqe.from)) {
+        return false;
+    }
+    auto I = m_movementUpdates.find(oqe.from);
+    if (I == m_movementUpdates.end()) {
+        return false;
+    }
+    if (I->second != oqe->getRefno()) {
+        return true;
+    }
+    // This is the latest one, so nothing else can supersede it now.
+    m_movementUpdates.erase(I);
+    return false;
+}
+
 /// \brief Add an operation to the ordered op queue.
 ///
 /// Any time adjustment required is made to the operation, and it
@@ -99,13 +161,23 @@ void OperationsDispatcher::addOperationToQueue(const Operation & op, LocatedEnti
     op->setFrom(ent.getId());
     if (!op->hasAttrFlag(Atlas::Objects::Operation::FUTURE_SECONDS_FLAG)) {
         op->setSeconds(getTime());
+        if (isMovementUpdate(op, ent)) {
+            // Not tracked in this queue, so let the entity sort out
+            // which Updates are current.
+            m_movementUpdates.erase(&ent);
+        }
         m_immediateQueue.push(OpQueEntry(op, ent));
         return;
     }
     double t = getTime() + (op->getFutureSeconds() * consts::time_multiplier);
     op->setSeconds(t);
     op->setFutureSeconds(0.);
-    m_operationQueue.push(OpQueEntry(op, ent));
+    if (isMovementUpdate(op, ent)) {
+        // The entry stays in the map only while the op is queued, which
+        // keeps the entity referenced.
+        m_movementUpdates[&ent] = op->getRefno();
+    }
+    m_operationQueue->push(OpQueEntry(op, ent));
     if (debug_flag) {
         std::cout << "WorldRouter::addOperationToQueue {" << std::endl;
         debug_dump(op, std::cout);
@@ -113,51 +185,85 @@ void OperationsDispatcher::addOperationToQueue(const Operation & op, LocatedEnti
     }
 }
 
+bool OperationsDispatcher::dispatchNextOp(double realtime)
+{
+    if (!m_immediateQueue.empty()) {
+        auto opQueueEntry = std::move(m_immediateQueue.front());
+        m_immediateQueue.pop();
+        dispatchOperation(opQueueEntry);
+        return true;
+    }
+    while (!m_operationQueue->empty() && m_operationQueue->topSeconds() <= realtime) {
+        auto opQueueEntry = m_operationQueue->top();
+        //Pop it before we dispatch it, since dispatching might alter the queue.
+        m_operationQueue->pop();
+        if (isSupersededUpdate(opQueueEntry)) {
+            m_supersededUpdates.increment();
+            continue;
+        }
+        dispatchOperation(opQueueEntry);
+        return true;
+    }
+    //There were neither any immediate ops to dispatch, or any regular ops that were ready for dispatch.
+    return false;
+}
+
+bool OperationsDispatcher::hasDueOps(double realtime) const
+{
+    return !m_immediateQueue.empty() || (!m_operationQueue->empty() && m_operationQueue->topSeconds() <= realtime);
+}
+
 bool OperationsDispatcher::idle()
 {
+    typedef std::chrono::steady_clock clock;
+
     unsigned int op_count = 0;
 
     double realtime = getTime();
     bool result = false;
 
-    while (true) {
-        if (!m_immediateQueue.empty()) {
-            ++op_count;
-            auto opQueueEntry = std::move(m_immediateQueue.front());
-            m_immediateQueue.pop();
-            dispatchOperation(opQueueEntry);
-        } else if (!m_operationQueue.empty() && m_operationQueue.top()->getSeconds() <= realtime) {
-            ++op_count;
-            auto opQueueEntry = m_operationQueue.top();
-            //Pop it before we dispatch it, since dispatching might alter the queue.
-            m_operationQueue.pop();
-            dispatchOperation(opQueueEntry);
-        } else {
-            //There were neither any immediate ops to dispatch, or any regular ops that were ready for dispatch.
-            //We should return and signal that it's ok to sleep until any op is ready for dispatch.
-            result = false;
-            break;
-        }
-
-        if (op_count >= 10) {
-            //we've processed 10 ops, we should return to allow for IO to interleave. Check if there are more
-            //ops that should be processed now.
+    clock::time_point start = clock::now();
+    clock::time_point deadline = start +
+          std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(m_timeBudget));
+    double backlog = 0.;
+    if (!m_immediateQueue.empty()) {
+        backlog = realtime - m_immediateQueue.front()->getSeconds();
+    }
 
+    // Reading the clock isn't free, so it's only checked after a batch of
+    // ops, with the size of the batch based on how long ops have taken.
+    unsigned int batch = m_batchSize;
+    while (dispatchNextOp(realtime)) {
+        ++op_count;
+        if (--batch != 0) {
+            continue;
+        }
+        clock::time_point now = clock::now();
+        if (now >= deadline) {
             // If there are still immediate or regular ops to deliver return true
             // to tell the server not to sleep when polling clients. This ensures
             // that we keep processing ops at a the maximum rate without leaving
             // clients unattended.
-            if (!m_immediateQueue.empty() || (!m_operationQueue.empty() && m_operationQueue.top()->getSeconds() <= realtime)) {
-                result = true;
-                break;
-            } else {
-                result = false;
-                break;
-            }
+            result = hasDueOps(realtime);
+            break;
         }
+        // Aim for the next check to be half way to the deadline.
+        double per_op = std::chrono::duration<double>(now - start).count() / op_count;
+        double remaining = std::chrono::duration<double>(deadline - now).count();
+        batch = batchSizeFor(remaining / 2., per_op);
+    }
+
+    if (op_count != 0) {
+        double elapsed = std::chrono::duration<double>(clock::now() - start).count();
+        // The first check of the next call should be at a quarter of the budget.
+        m_batchSize = batchSizeFor(m_timeBudget / 4., elapsed / op_count);
+        m_sliceOps->observe(op_count);
+        m_sliceTime->observe(elapsed);
+        m_backlogAge->observe(backlog);
     }
-    Monitors::instance()->insert("immediate_operations_queue", (Atlas::Message::IntType) m_immediateQueue.size());
-    Monitors::instance()->insert("operations_queue", (Atlas::Message::IntType) m_operationQueue.size());
+
+    m_immediateQueueSize.set(m_immediateQueue.size());
+    m_operationQueueSize.set(m_operationQueue->size());
     return result;
 }
 
@@ -180,10 +286,10 @@ double OperationsDispatcher::getTime() const
 }
 
 double OperationsDispatcher::secondsUntilNextOp() const {
-    if (m_operationQueue.empty()) {
+    if (m_operationQueue->empty()) {
         //600 is a fairly large number of seconds
         return 600.0;
     }
-    return m_operationQueue.top()->getSeconds() - getTime();
+    return m_operationQueue->topSeconds() - getTime();
 }
 
@@ -19,6 +19,7 @@
 #ifndef OPERATIONSDISPATCHER_H_
 #define OPERATIONSDISPATCHER_H_
 
+#include "Metrics.h"
 #include "OperationRouter.h"
 
 #include <Atlas/Objects/RootOperation.h>
@@ -27,6 +28,8 @@
 #include <set>
 #include <queue>
 #include <functional>
+#include <unordered_map>
+#include <utility>
 
 class LocatedEntity;
 
@@ -38,8 +41,18 @@ struct OpQueEntry {
 
     explicit OpQueEntry(const Operation & o, LocatedEntity & f);
     OpQueEntry(const OpQueEntry & o);
+    /// Moving an entry leaves the reference count of the entity untouched.
+    OpQueEntry(OpQueEntry && o) : op(std::move(o.op)), from(o.from) {
+        o.from = nullptr;
+    }
     ~OpQueEntry();
 
+    OpQueEntry & operator=(OpQueEntry o) {
+        std::swap(op, o.op);
+        std::swap(from, o.from);
+        return *this;
+    }
+
     const Operation & operator*() const {
         return op;
     }
@@ -60,6 +73,9 @@ struct OpQueEntry {
 typedef std::queue<OpQueEntry> OpQueue;
 typedef std::priority_queue<OpQueEntry, std::vector<OpQueEntry>, std::greater<OpQueEntry> > OpPriorityQueue;
 
+class Histogram;
+class OpTimingWheel;
+
 /// \brief Handles dispatching of operations at suitable time.
 ///
 class OperationsDispatcher
@@ -76,15 +92,25 @@ class OperationsDispatcher
         /// \brief Main world loop function.
         /// This function is called whenever the communications code is idle.
         /// It updates the in-game time, and dispatches operations that are
-        /// now due for dispatch. The number of operations dispatched is limited
-        /// to 10 to ensure that client communications are always handled in a timely
-        /// manner. If the maximum number of operations are dispatched, the return
+        /// now due for dispatch. Operations are dispatched until the time budget
+        /// runs out, to ensure that client communications are always handled in a timely
+        /// manner. If the budget runs out with operations still due, the return
         /// value indicates that this is the case, and the communications code
         /// will call this function again as soon as possible rather than sleeping.
         /// This ensures that the maximum possible number of operations are dispatched
         /// without becoming unresponsive to client communications traffic.
         bool idle();
 
+        /**
+         * @brief Sets the wall clock time each call to idle() may spend dispatching.
+         *
+         * At least one operation is always dispatched, if any are due.
+         * @param seconds The time budget.
+         */
+        void setTimeBudget(double seconds) {
+            m_timeBudget = seconds;
+        }
+
         /**
          * Gets the number of seconds until the next operation needs to be dispatched.
          * @return Seconds.
@@ -125,11 +151,33 @@ class OperationsDispatcher
         const std::function<double()> m_timeProviderFn;
 
         /// An ordered queue of operations to be dispatched in the future
-        OpPriorityQueue m_operationQueue;
+        OpTimingWheel * m_operationQueue;
         /// An ordered queue of operations to be dispatched now
         OpQueue m_immediateQueue;
         /// Keeps track of if the operation queues are dirty.
         bool m_operation_queues_dirty;
+        /// The refno of the latest movement Update queued for each entity.
+        std::unordered_map<const LocatedEntity *, long> m_movementUpdates;
+        /// The number of superseded movement Updates which have been dropped.
+        Counter m_supersededUpdates;
+        /// Length of the immediate queue at the end of the last call to idle().
+        Gauge m_immediateQueueSize;
+        /// Length of the future queue at the end of the last call to idle().
+        Gauge m_operationQueueSize;
+        /// Wall clock time in seconds each call to idle() may spend dispatching.
+        double m_timeBudget;
+        /// Number of operations to dispatch before first checking the clock.
+        ///
+        /// This is adjusted after each call to idle() according to how long
+        /// operations took to dispatch.
+        unsigned int m_batchSize;
+        /// Number of operations dispatched in each call to idle().
+        Histogram * m_sliceOps;
+        /// Wall clock time spent in each call to idle().
+        Histogram * m_sliceTime;
+        /// In-game time the first immediate operation has been queued for
+        /// at the start of each call to idle().
+        Histogram * m_backlogAge;
 
         /**
          * @brief Dispatches the operation contained in the OpQueueEntry.
@@ -137,6 +185,29 @@ class OperationsDispatcher
          */
         void dispatchOperation(const OpQueEntry& opQueueEntry);
 
+        /**
+         * @brief Checks if an operation is a movement Update which has been superseded.
+         *
+         * Movement Updates carry the serial number of the movement they
+         * belong to as refno, and any earlier Update for the same entity
+         * is ignored by the entity once a new one has been sent.
+         * @param opQueueEntry An entry from the future op queue.
+         */
+        bool isSupersededUpdate(const OpQueEntry& opQueueEntry);
+
+        /**
+         * @brief Dispatches the next operation, if any is due.
+         * @param realtime The current time.
+         * @return True if an operation was dispatched.
+         */
+        bool dispatchNextOp(double realtime);
+
+        /**
+         * @brief Checks if there are operations which are due.
+         * @param realtime The current time.
+         */
+        bool hasDueOps(double realtime) const;
+
         double getTime() const;
 
 };
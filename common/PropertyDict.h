@@ -0,0 +1,256 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2015 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifndef COMMON_PROPERTY_DICT_H
+#define COMMON_PROPERTY_DICT_H
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <iterator>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class PropertyBase;
+
+/// \brief Collection of properties, keyed by interned property name
+///
+/// Each property name is given a small integer id the first time it is
+/// stored, and the properties are kept in a vector sorted by that id, so
+/// a lookup is a single hash of the name followed by a binary search over
+/// integers, and callers which already have the id skip the hash. Only
+/// the id and the property are stored for each entry; the name is looked
+/// up in the table of interned names when an entry is read. The
+/// interface otherwise follows the std::map which was used before, except
+/// that iteration is in order of id rather than name, that adding or
+/// removing a property invalidates iterators, and that the entries are
+/// returned by value as a pair of references, so a range-for needs
+/// "auto" or "const auto &" rather than "auto &".
+///
+/// New names are only interned from the main thread. Looking up a name
+/// never interns it, so lookups are safe from other threads as long as
+/// no properties are being added at the same time.
+class PropertyDict {
+  public:
+    /// \brief An entry, as seen through an iterator.
+    template <typename P>
+    struct Entry {
+        const std::string & first;
+        P & second;
+
+        const Entry * operator->() const {
+            return this;
+        }
+    };
+
+    /// \brief Iterator over the entries, with P const for a
+    /// const_iterator.
+    template <typename P>
+    class Iterator {
+      protected:
+        const int * m_id;
+        P * m_property;
+
+        Iterator(const int * id, P * property) : m_id(id),
+                                                 m_property(property) { }
+      public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef Entry<P> value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef Entry<P> pointer;
+        typedef Entry<P> reference;
+
+        Iterator() : m_id(0), m_property(0) { }
+
+        /// \brief Convert an iterator to a const_iterator.
+        template <typename Q, typename = typename std::enable_if<
+                  std::is_convertible<Q *, P *>::value>::type>
+        Iterator(const Iterator<Q> & other) : m_id(other.m_id),
+                                              m_property(other.m_property) { }
+
+        Entry<P> operator*() const {
+            return Entry<P>{PropertyDict::name(*m_id), *m_property};
+        }
+
+        Entry<P> operator->() const {
+            return **this;
+        }
+
+        Iterator & operator++() {
+            ++m_id;
+            ++m_property;
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator old(*this);
+            ++*this;
+            return old;
+        }
+
+        friend bool operator==(const Iterator & lhs, const Iterator & rhs) {
+            return lhs.m_property == rhs.m_property;
+        }
+
+        friend bool operator!=(const Iterator & lhs, const Iterator & rhs) {
+            return lhs.m_property != rhs.m_property;
+        }
+
+        template <typename Q> friend class Iterator;
+        friend class PropertyDict;
+    };
+
+    typedef Iterator<PropertyBase *> iterator;
+    typedef Iterator<PropertyBase * const> const_iterator;
+  private:
+    struct Names {
+        std::unordered_map<std::string, int> ids;
+        std::deque<std::string> names;
+    };
+
+    static Names & names() {
+        static Names s_names;
+        return s_names;
+    }
+  protected:
+    /// \brief Interned id of each property, in increasing order.
+    std::vector<int> m_ids;
+    /// \brief Property for each entry of m_ids.
+    std::vector<PropertyBase *> m_properties;
+
+    std::size_t position(int id) const {
+        return std::lower_bound(m_ids.begin(), m_ids.end(), id) -
+               m_ids.begin();
+    }
+
+    iterator at(std::size_t i) {
+        return iterator(m_ids.data() + i, m_properties.data() + i);
+    }
+
+    const_iterator at(std::size_t i) const {
+        return const_iterator(m_ids.data() + i, m_properties.data() + i);
+    }
+  public:
+    /// \brief Get the id of a property name, creating it if required.
+    static int intern(const std::string & name) {
+        Names & n = names();
+        auto I = n.ids.find(name);
+        if (I != n.ids.end()) {
+            return I->second;
+        }
+        int id = (int)n.names.size();
+        n.names.push_back(name);
+        n.ids.insert(std::make_pair(name, id));
+        return id;
+    }
+
+    /// \brief Get the id of a property name, or -1 if it has never been
+    /// interned, in which case no PropertyDict contains it.
+    static int lookup(const std::string & name) {
+        const Names & n = names();
+        auto I = n.ids.find(name);
+        if (I != n.ids.end()) {
+            return I->second;
+        }
+        return -1;
+    }
+
+    /// \brief Get the property name for an id.
+    static const std::string & name(int id) {
+        return names().names[id];
+    }
+
+    iterator begin() {
+        return at(0);
+    }
+
+    iterator end() {
+        return at(m_ids.size());
+    }
+
+    const_iterator begin() const {
+        return at(0);
+    }
+
+    const_iterator end() const {
+        return at(m_ids.size());
+    }
+
+    std::size_t size() const {
+        return m_ids.size();
+    }
+
+    bool empty() const {
+        return m_ids.empty();
+    }
+
+    iterator find(int id) {
+        std::size_t i = position(id);
+        if (i < m_ids.size() && m_ids[i] == id) {
+            return at(i);
+        }
+        return end();
+    }
+
+    const_iterator find(int id) const {
+        std::size_t i = position(id);
+        if (i < m_ids.size() && m_ids[i] == id) {
+            return at(i);
+        }
+        return end();
+    }
+
+    iterator find(const std::string & name) {
+        int id = lookup(name);
+        return id < 0 ? end() : find(id);
+    }
+
+    const_iterator find(const std::string & name) const {
+        int id = lookup(name);
+        return id < 0 ? end() : find(id);
+    }
+
+    /// \brief Get the property stored for a name, adding a null entry
+    /// if there is none.
+    PropertyBase *& operator[](const std::string & name) {
+        int id = intern(name);
+        std::size_t i = position(id);
+        if (i == m_ids.size() || m_ids[i] != id) {
+            m_ids.insert(m_ids.begin() + i, id);
+            m_properties.insert(m_properties.begin() + i, (PropertyBase *)0);
+        }
+        return m_properties[i];
+    }
+
+    iterator erase(iterator I) {
+        std::size_t i = I.m_property - m_properties.data();
+        m_ids.erase(m_ids.begin() + i);
+        m_properties.erase(m_properties.begin() + i);
+        return at(i);
+    }
+
+    void clear() {
+        m_ids.clear();
+        m_properties.clear();
+    }
+};
+
+#endif // COMMON_PROPERTY_DICT_H
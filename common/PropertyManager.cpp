@@ -18,6 +18,7 @@
 
 #include "PropertyManager.h"
 
+#include "PropertyDict.h"
 #include "PropertyFactory.h"
 
 #include <cassert>
@@ -60,6 +61,9 @@ void PropertyManager::installFactory(const std::string & name,
                                      PropertyKit * factory)
 {
     m_propertyFactories.insert(std::make_pair(name, factory));
+    // Give the name its id up front, so the ids of the properties the
+    // server knows about are allocated together at startup.
+    PropertyDict::intern(name);
 }
 
 int PropertyManager::installFactory(const std::string & type_name,
@@ -0,0 +1,117 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2015 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#include "ScriptProfiler.h"
+
+#include "Monitors.h"
+#include "Variable.h"
+#include "compose.hpp"
+
+#include <algorithm>
+
+#include <ctime>
+
+using String::compose;
+
+ScriptProfiler * ScriptProfiler::m_instance = 0;
+
+ScriptProfiler::ScriptProfiler() : m_enabled(false)
+{
+}
+
+ScriptProfiler * ScriptProfiler::instance()
+{
+    if (m_instance == 0) {
+        m_instance = new ScriptProfiler;
+    }
+    return m_instance;
+}
+
+/// \brief Delete the instance.
+///
+/// The monitoring subsystem references the totals, so it must be
+/// cleaned up first.
+void ScriptProfiler::cleanup()
+{
+    delete m_instance;
+    m_instance = 0;
+}
+
+/// \brief Add the time taken by a call to a handler to its totals.
+///
+/// @param script_class name of the class of the script
+/// @param handler name of the handler which was called
+/// @param wall_time wall clock time taken by the call in seconds
+/// @param cpu_time CPU time taken by the call in seconds
+void ScriptProfiler::record(const char * script_class,
+                            const std::string & handler,
+                            double wall_time, double cpu_time)
+{
+    Key key(script_class, handler);
+    TotalsDict::iterator I = m_totals.find(key);
+    if (I == m_totals.end()) {
+        I = m_totals.insert(std::make_pair(key, Totals{0, 0., 0.})).first;
+        // Entries in the map never move, so the monitors can refer to them
+        Totals & totals = I->second;
+        std::string labels = compose("{class=\"%1\",handler=\"%2\"}",
+                                     script_class, handler);
+        Monitors * monitors = Monitors::instance();
+        monitors->watch("script_calls" + labels,
+                        new Variable<int>(totals.calls));
+        monitors->watch("script_wall_seconds" + labels,
+                        new Variable<double>(totals.wallTime));
+        monitors->watch("script_cpu_seconds" + labels,
+                        new Variable<double>(totals.cpuTime));
+    }
+    Totals & totals = I->second;
+    ++totals.calls;
+    totals.wallTime += wall_time;
+    totals.cpuTime += cpu_time;
+}
+
+/// \brief Get the handlers which have used the most CPU time.
+///
+/// @param count the largest number of handlers to get
+/// @param list the handlers are added here, most expensive first
+void ScriptProfiler::top(std::size_t count, TotalsList & list) const
+{
+    list.assign(m_totals.begin(), m_totals.end());
+    auto more_cpu = [](const TotalsList::value_type & a,
+                       const TotalsList::value_type & b) {
+        return a.second.cpuTime > b.second.cpuTime;
+    };
+    if (list.size() > count) {
+        std::partial_sort(list.begin(), list.begin() + count, list.end(),
+                          more_cpu);
+        list.resize(count);
+    } else {
+        std::sort(list.begin(), list.end(), more_cpu);
+    }
+}
+
+/// \brief Get the CPU time used by the calling thread, in seconds.
+double ScriptProfiler::cpuTime()
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+    struct timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0) {
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+    }
+#endif // CLOCK_THREAD_CPUTIME_ID
+    return (double)std::clock() / CLOCKS_PER_SEC;
+}
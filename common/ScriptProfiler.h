@@ -0,0 +1,110 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2015 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifndef COMMON_SCRIPT_PROFILER_H
+#define COMMON_SCRIPT_PROFILER_H
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+/// \brief Time spent in script handlers, by script class and handler
+///
+/// Profiling is off until enabled, and while it is off timing a call
+/// costs a test of one flag. While it is on, each call reads the wall
+/// clock and the CPU clock of the thread before and after, and adds to
+/// the totals for its class and handler. The totals of each class and
+/// handler are watched by the monitoring subsystem from when they are
+/// first seen.
+class ScriptProfiler {
+  public:
+    /// \brief Totals for the calls to one handler of one script class
+    struct Totals {
+        int calls;
+        double wallTime;
+        double cpuTime;
+    };
+    /// \brief Script class name and handler name.
+    typedef std::pair<std::string, std::string> Key;
+    typedef std::map<Key, Totals> TotalsDict;
+    typedef std::vector<std::pair<Key, Totals> > TotalsList;
+  protected:
+    static ScriptProfiler * m_instance;
+
+    ScriptProfiler();
+
+    bool m_enabled;
+    TotalsDict m_totals;
+  public:
+    static ScriptProfiler * instance();
+    static void cleanup();
+
+    bool enabled() const {
+        return m_enabled;
+    }
+
+    void setEnabled(bool enabled) {
+        m_enabled = enabled;
+    }
+
+    const TotalsDict & totals() const {
+        return m_totals;
+    }
+
+    void record(const char * script_class, const std::string & handler,
+                double wall_time, double cpu_time);
+    void top(std::size_t count, TotalsList & list) const;
+
+    static double cpuTime();
+};
+
+/// \brief Times one call to a script handler, if profiling is enabled
+///
+/// Construct one on the stack around the call. The handler name is
+/// referenced rather than copied, so must outlive this object.
+class ScriptProfile {
+  protected:
+    const char * m_class;
+    const std::string & m_handler;
+    bool m_active;
+    std::chrono::steady_clock::time_point m_wallStart;
+    double m_cpuStart;
+  public:
+    ScriptProfile(const char * script_class, const std::string & handler) :
+        m_class(script_class), m_handler(handler),
+        m_active(ScriptProfiler::instance()->enabled()), m_cpuStart(0.)
+    {
+        if (m_active) {
+            m_wallStart = std::chrono::steady_clock::now();
+            m_cpuStart = ScriptProfiler::cpuTime();
+        }
+    }
+
+    ~ScriptProfile()
+    {
+        if (m_active) {
+            double cpu = ScriptProfiler::cpuTime() - m_cpuStart;
+            double wall = std::chrono::duration<double>(
+                  std::chrono::steady_clock::now() - m_wallStart).count();
+            ScriptProfiler::instance()->record(m_class, m_handler, wall, cpu);
+        }
+    }
+};
+
+#endif // COMMON_SCRIPT_PROFILER_H
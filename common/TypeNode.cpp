@@ -51,6 +51,7 @@ TypeNode::~TypeNode()
 void TypeNode::addProperty(const std::string & name,
                            PropertyBase * p)
 {
+    removeDelegates(PropertyDict::lookup(name));
     m_defaults[name] = p;
 }
 
@@ -65,6 +66,7 @@ void TypeNode::addProperties(const MapType & attributes)
         assert(p != 0);
         p->set(J->second);
         p->setFlags(flag_class);
+        removeDelegates(PropertyDict::lookup(J->first));
         m_defaults[J->first] = p;
     }
 }
@@ -90,6 +92,7 @@ void TypeNode::updateProperties(const MapType & attributes)
     std::set<std::string>::const_iterator Lend = removed_properties.end();
     for (; L != Lend; ++L) {
         PropertyDict::iterator M = m_defaults.find(*L);
+        removeDelegates(PropertyDict::lookup(*L));
         delete M->second;
         m_defaults.erase(M);
     }
@@ -100,7 +103,9 @@ void TypeNode::updateProperties(const MapType & attributes)
     PropertyBase * p;
     for (; J != Jend; ++J) {
         PropertyDict::const_iterator I = m_defaults.find(J->first);
-        if (I == Iend) {
+        // Removing and adding properties invalidates iterators, so end()
+        // has to be checked each time.
+        if (I == m_defaults.end()) {
             p = PropertyManager::instance()->addProperty(J->first,
                                                          J->second.getType());
             assert(p != 0);
@@ -113,6 +118,25 @@ void TypeNode::updateProperties(const MapType & attributes)
     }
 }
 
+void TypeNode::removeDelegates(int property)
+{
+    PropertyDict::const_iterator I = m_defaults.find(property);
+    if (I == m_defaults.end()) {
+        return;
+    }
+    auto J = m_delegateNames.begin();
+    while (J != m_delegateNames.end()) {
+        if (J->second == property) {
+            std::vector<PropertyBase *> & props = m_delegates[J->first];
+            props.erase(std::remove(props.begin(), props.end(), I->second),
+                        props.end());
+            J = m_delegateNames.erase(J);
+        } else {
+            ++J;
+        }
+    }
+}
+
 bool TypeNode::isTypeOf(const std::string & base_type) const
 {
     const TypeNode * node = this;
@@ -19,14 +19,17 @@
 #ifndef COMMON_TYPE_NODE_H
 #define COMMON_TYPE_NODE_H
 
+#include "PropertyDict.h"
+
 #include <Atlas/Objects/Root.h>
 #include <Atlas/Objects/SmartPtr.h>
 
+#include <algorithm>
 #include <iostream>
+#include <vector>
 
 class PropertyBase;
 
-typedef std::map<std::string, PropertyBase *> PropertyDict;
 
 /// \brief Entry in the type hierarchy for in-game entity classes.
 class TypeNode {
@@ -42,6 +45,14 @@ class TypeNode {
 
     /// \brief parent node
     const TypeNode * m_parent;
+
+    /// \brief class properties known to handle operations, as pairs of
+    /// operation class number and interned property name
+    mutable std::vector<std::pair<int, int> > m_delegateNames;
+
+    /// \brief class properties which handle each class of operation,
+    /// indexed by operation class number
+    mutable std::vector<std::vector<PropertyBase *> > m_delegates;
   public:
     TypeNode(const std::string &);
     TypeNode(const std::string &, const Atlas::Objects::Root &);
@@ -81,6 +92,48 @@ class TypeNode {
         return m_description;
     }
 
+    /// \brief record that a class property handles a class of operation
+    ///
+    /// The table is filled in as the class properties install their
+    /// delegates on entities of this type, as only the property knows
+    /// which operations it handles.
+    void addDelegate(int class_no, int property) const {
+        std::pair<int, int> entry(class_no, property);
+        if (class_no < 0 ||
+            std::find(m_delegateNames.begin(), m_delegateNames.end(),
+                      entry) != m_delegateNames.end()) {
+            return;
+        }
+        PropertyDict::const_iterator I = m_defaults.find(property);
+        if (I == m_defaults.end()) {
+            return;
+        }
+        m_delegateNames.push_back(entry);
+        if ((std::size_t)class_no >= m_delegates.size()) {
+            m_delegates.resize(class_no + 1);
+        }
+        m_delegates[class_no].push_back(I->second);
+    }
+
+    /// \brief remove a class property from the delegate table
+    void removeDelegates(int property);
+
+    /// \brief the number of operation and property pairs in the delegate
+    /// table
+    std::size_t delegateCount() const {
+        return m_delegateNames.size();
+    }
+
+    /// \brief the class properties which handle a class of operation
+    ///
+    /// @return the properties, or null if there are none
+    const std::vector<PropertyBase *> * delegates(int class_no) const {
+        if (class_no < 0 || (std::size_t)class_no >= m_delegates.size()) {
+            return 0;
+        }
+        return &m_delegates[class_no];
+    }
+
     /// \brief const accessor for parent node
     const TypeNode * parent() const {
         return m_parent;
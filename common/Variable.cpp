@@ -47,6 +47,12 @@ bool Variable<int>::isNumeric() const
     return true;
 }
 
+template <>
+bool Variable<double>::isNumeric() const
+{
+    return true;
+}
+
 template <>
 bool Variable<std::string>::isNumeric() const
 {
@@ -60,6 +66,7 @@ bool Variable<const char *>::isNumeric() const
 }
 
 template class Variable<int>;
+template class Variable<double>;
 template class Variable<std::string>;
 template class Variable<const char *>;
 
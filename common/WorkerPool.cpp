@@ -0,0 +1,122 @@
+/*
+ Copyright (C) 2015 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "WorkerPool.h"
+
+#include "Monitors.h"
+#include "log.h"
+#include "compose.hpp"
+
+#include <chrono>
+#include <exception>
+
+/// \brief Run a job, logging anything it throws.
+///
+/// An exception escaping a worker thread would terminate the server.
+static void runJob(const std::function<void()> & job)
+{
+    try {
+        job();
+    }
+    catch (const std::exception& ex) {
+        log(ERROR, String::compose("Exception caught in WorkerPool "
+                                   "thrown while running a job: %1",
+                                   ex.what()));
+    }
+    catch (...) {
+        log(ERROR, "Unspecified exception caught in WorkerPool "
+                   "thrown while running a job");
+    }
+}
+
+WorkerPool::WorkerPool(int threads) :
+        m_jobs(nullptr), m_nextJob(0), m_unfinishedJobs(0), m_stopping(false),
+        m_busyTime(Monitors::instance()->counter("worker_busy_microseconds",
+                                                 threads + 1))
+{
+    for (int i = 0; i < threads; ++i) {
+        m_threads.emplace_back([this]() { work(); });
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_batchStarted.notify_all();
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+}
+
+void WorkerPool::run(const std::vector<std::function<void()>> & jobs)
+{
+    if (m_threads.empty() || jobs.size() < 2) {
+        for (auto& job : jobs) {
+            runJob(job);
+        }
+        return;
+    }
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_jobs = &jobs;
+    m_nextJob = 0;
+    m_unfinishedJobs = jobs.size();
+    m_batchStarted.notify_all();
+
+    //Help out, rather than just wait.
+    runJobs(lock);
+
+    m_batchDone.wait(lock, [this]() { return m_unfinishedJobs == 0; });
+    m_jobs = nullptr;
+}
+
+void WorkerPool::runJobs(std::unique_lock<std::mutex> & lock)
+{
+    while (m_jobs != nullptr && m_nextJob < m_jobs->size()) {
+        const std::function<void()> & job = (*m_jobs)[m_nextJob++];
+        lock.unlock();
+        auto start = std::chrono::steady_clock::now();
+        runJob(job);
+        m_busyTime.increment(std::chrono::duration_cast<std::chrono::microseconds>(
+              std::chrono::steady_clock::now() - start).count());
+        lock.lock();
+        if (--m_unfinishedJobs == 0) {
+            m_batchDone.notify_all();
+        }
+    }
+}
+
+void WorkerPool::work()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_batchStarted.wait(lock, [this]() {
+            return m_stopping || (m_jobs != nullptr && m_nextJob < m_jobs->size());
+        });
+        if (m_stopping) {
+            return;
+        }
+        runJobs(lock);
+    }
+}
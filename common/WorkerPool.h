@@ -0,0 +1,89 @@
+/*
+ Copyright (C) 2015 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef WORKERPOOL_H_
+#define WORKERPOOL_H_
+
+#include "Metrics.h"
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// \brief A fixed set of threads which run batches of jobs.
+///
+/// run() hands the jobs of a batch out to the threads, and to the calling
+/// thread, and returns once all of them are done. There is no ordering
+/// between the jobs of a batch, so they must not touch the same data.
+/// Jobs must not throw.
+class WorkerPool
+{
+    public:
+        /**
+         * @brief Ctor.
+         * @param threads The number of threads to start. With none, jobs are run by the calling thread.
+         */
+        explicit WorkerPool(int threads);
+
+        ~WorkerPool();
+
+        /**
+         * @brief Runs a batch of jobs, and waits for them to finish.
+         */
+        void run(const std::vector<std::function<void()>> & jobs);
+
+        std::size_t threadCount() const {
+            return m_threads.size();
+        }
+
+    protected:
+        std::vector<std::thread> m_threads;
+        std::mutex m_mutex;
+        /// \brief Signalled when a batch is started, or the pool is stopped.
+        std::condition_variable m_batchStarted;
+        /// \brief Signalled when the last job of a batch is done.
+        std::condition_variable m_batchDone;
+
+        /// \brief The batch being run, or null.
+        const std::vector<std::function<void()>> * m_jobs;
+        /// \brief The index of the next job to be taken.
+        std::size_t m_nextJob;
+        /// \brief The number of jobs not yet done.
+        std::size_t m_unfinishedJobs;
+        bool m_stopping;
+        /// \brief Time spent running jobs, sharded by thread.
+        Counter m_busyTime;
+
+        /**
+         * @brief Takes jobs of the current batch until there are none left.
+         *
+         * Must be called with the mutex held, which is released while jobs
+         * are run.
+         */
+        void runJobs(std::unique_lock<std::mutex> & lock);
+
+        void work();
+
+    private:
+        WorkerPool(const WorkerPool &) = delete;
+        WorkerPool & operator=(const WorkerPool &) = delete;
+};
+
+#endif /* WORKERPOOL_H_ */
@@ -103,13 +103,20 @@ static const usage_data usage[] = {
     { CYPHESIS, "dynamic_port_start", "<portnumber>", "6800", "Lowest port to try and used for dyanmic ports", S },
     { CYPHESIS, "dynamic_port_end", "<portnumber>", "6899", "Highest port to try and used for dyanmic ports", S },
     { CYPHESIS, "usedatabase", "true|false", "true", "Flag to control whether to use a database for persistent storage", S },
+    { CYPHESIS, "storage", "database|log", "database", "Where the world is stored. log keeps it in local files without a database, and does not store accounts", S },
+    { CYPHESIS, "storagefile", "<path>", "<vardir>/<instance>_world", "Path, without extension, of the files the world is stored in when storage is log", S },
     { CYPHESIS, "daemon", "true|false", "false", "Flag to control running the server in daemon mode", S },
     { CYPHESIS, "nice", "<level>", "1", "Reduce the priority level of the server", S },
+    { CYPHESIS, "client_highwater", "<bytes>", "4194304", "Amount of outgoing data which can be queued for a client before the overflow policy is applied. 0 means no limit", S },
+    { CYPHESIS, "client_overflow", "drop|disconnect", "drop", "What to do with clients which don't keep up with outgoing data; drop movement updates, or disconnect", S },
+    { CYPHESIS, "dispatch_budget", "<microseconds>", "2000", "Time spent dispatching operations before handling network traffic, when the world is busy. Lower values reduce network latency, higher values increase throughput", S },
+    { CYPHESIS, "domain_threads", "<threads>", "0", "Number of threads moving entities in separate domains at the same time. 0 means each domain moves its entities on the main thread", S },
     { CYPHESIS, "useaiclient", "true|false", "false", "Flag to control whether AI is to be driven by a client", S },
     { CYPHESIS, "dbserver", "<hostname>", "", "Hostname for the PostgreSQL RDBMS", S|D },
     { CYPHESIS, "dbname", "<name>", "\"cyphesis\"", "Name of the database to use", S|D },
     { CYPHESIS, "dbuser", "<dbusername>", "<username>", "Database user name for access", S|D },
     { CYPHESIS, "dbpasswd", "<dbusername>", "", "Database password for access", S|D },
+    { CYPHESIS, "dbidblock", "<ids>", "100", "Number of entity ids reserved from the database at a time. Unused ids are skipped when the server restarts", S },
     { SLAVE, "tcpport", "<portnumber>", "6768", "Network listen port for client connections to the AI slave server", M },
     { SLAVE, "server", "<hostname>", "localhost", "Master server to connect the slave to", M },
     { 0, 0, 0, 0 }
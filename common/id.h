@@ -22,6 +22,7 @@
 #include <string>
 
 long newId(std::string & id);
+void skipIds(long id);
 long integerId(const std::string & id);
 long forceIntegerId(const std::string & id);
 int integerIdCheck(const std::string & id);
@@ -37,3 +37,11 @@ long newId(std::string & id)
         return new_id;
     }
 }
+
+/// \brief Make sure ids created without a database are greater than id.
+void skipIds(long id)
+{
+    if (idGenerator < id) {
+        idGenerator = id;
+    }
+}
@@ -19,6 +19,7 @@
 #include "BBoxProperty.h"
 
 #include "rulesets/LocatedEntity.h"
+#include "rulesets/Domain.h"
 
 #include "common/log.h"
 
@@ -38,6 +39,15 @@ BBoxProperty::BBoxProperty()
 void BBoxProperty::apply(LocatedEntity * ent)
 {
     ent->m_location.setBBox(m_data);
+    // The size of an entity affects the distance at which it can be seen,
+    // so the domain it's in needs to know.
+    LocatedEntity * parent = ent->m_location.m_loc;
+    if (parent != 0 && (parent->getFlags() & entity_domain)) {
+        Domain * domain = parent->getMovementDomain();
+        if (domain) {
+            domain->updatePosition(*ent);
+        }
+    }
 }
 
 int BBoxProperty::get(Element & val) const
@@ -134,7 +134,7 @@ void Character::metabolise(OpVector & res, double ammount)
         // FIXME Probably don't do enough here to set up the property.
         status_prop = new StatusProperty;
         assert(status_prop != 0);
-        m_properties[STATUS] = status_prop;
+        setProperty(STATUS, status_prop);
         status_prop->set(1.f);
         status_changed = true;
     }
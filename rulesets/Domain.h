@@ -25,6 +25,7 @@
 #include <wfmath/vector.h>
 
 #include <string>
+#include <vector>
 
 class LocatedEntity;
 class Location;
@@ -113,6 +114,85 @@ class Domain {
      */
     virtual float checkCollision(LocatedEntity& entity, CollisionData& collisionData) = 0;
 
+    /**
+     * @brief Adds an entity to the domain.
+     *
+     * This is called when a child is added to the domain entity.
+     * @param entity The entity which was added.
+     */
+    virtual void addEntity(LocatedEntity& entity);
+
+    /**
+     * @brief Removes an entity from the domain.
+     *
+     * This is called when a child is removed from the domain entity.
+     * @param entity The entity which was removed.
+     */
+    virtual void removeEntity(LocatedEntity& entity);
+
+    /**
+     * @brief Notifies the domain that the location data (position, velocity or bbox) of an entity has changed.
+     * @param entity The entity which was changed.
+     */
+    virtual void updatePosition(LocatedEntity& entity);
+
+    /**
+     * @brief Finds the direct children of the domain entity which might be able to see an entity.
+     *
+     * This is used to avoid checking visibility for every perceptive entity in the world
+     * whenever an entity broadcasts a perception. Any direct child of the domain entity
+     * which can see the observed entity is guaranteed to be included, but others might
+     * be as well, so isEntityVisibleFor() must still be used on the result.
+     *
+     * The default implementation can't narrow the search and returns false.
+     *
+     * @param observedEntity The entity being observed; must be a descendant of the domain entity.
+     * @param candidates A vector to which the candidates are appended, sorted by pointer.
+     * @return True if the candidates were found; false if all direct children must be considered.
+     */
+    virtual bool findObserverCandidates(const LocatedEntity& observedEntity, std::vector<LocatedEntity*>& candidates);
+
+    /**
+     * @brief Asks the domain to integrate the movement of an entity in its tick().
+     *
+     * Domains which simulate movement in bulk take over from the per entity Update
+     * operations, until the entity stops, leaves the domain, or a collision is due.
+     * In the latter case the domain hands the entity back by sending it an immediate
+     * Update operation with the supplied refno.
+     *
+     * The default implementation doesn't simulate movement and returns false.
+     *
+     * @param entity The moving entity.
+     * @param refno The refno to use for any Update operation sent to the entity.
+     * @return True if the domain will move the entity.
+     */
+    virtual bool addMovingEntity(LocatedEntity& entity, long refno);
+
+    /**
+     * @brief Stops the domain from integrating the movement of an entity.
+     * @param entity The entity, which doesn't have to be moved by the domain.
+     */
+    virtual void removeMovingEntity(LocatedEntity& entity);
+
+    /**
+     * @brief Hands all entities moved by the domain back to their own Update operations.
+     *
+     * Called when the domain is removed from an entity which stays in the world. It must
+     * not be called while the domain entity is being destroyed, as the operations would
+     * refer to entities which are going away.
+     *
+     * The default implementation doesn't move entities, so does nothing.
+     */
+    virtual void releaseMovingEntities();
+
+    /**
+     * @brief Gets the entity to which this domain belongs.
+     * @return The domain entity.
+     */
+    LocatedEntity& getEntity() const {
+        return m_entity;
+    }
+
 };
 
 #endif // RULESETS_DOMAIN_H
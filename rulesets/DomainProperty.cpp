@@ -25,6 +25,9 @@
 #include "VoidDomain.h"
 #include "LocatedEntity.h"
 
+#include "common/BaseWorld.h"
+#include "common/Tick.h"
+
 PropertyInstanceState<Domain> DomainProperty::sInstanceState;
 
 DomainProperty::DomainProperty()
@@ -36,14 +39,17 @@ DomainProperty::DomainProperty(const DomainProperty& rhs)
 {
 }
 
-void DomainProperty::install(LocatedEntity *entity, const std::string &)
+void DomainProperty::install(LocatedEntity *entity, const std::string & name)
 {
     sInstanceState.addState(entity, nullptr);
+    //The domain moves its children on Tick operations.
+    entity->installDelegate(Atlas::Objects::Operation::TICK_NO, name);
 }
 
 
-void DomainProperty::remove(LocatedEntity * entity, const std::string &)
+void DomainProperty::remove(LocatedEntity * entity, const std::string & name)
 {
+    entity->removeDelegate(Atlas::Objects::Operation::TICK_NO, name);
     sInstanceState.removeState(entity);
     entity->setFlags(~entity_domain);
 }
@@ -64,6 +70,12 @@ void DomainProperty::apply(LocatedEntity * entity)
             }
         }
     } else {
+        //The entity stays in the world, so anything the domain was moving
+        //has to be handed back before it goes.
+        Domain* domain = sInstanceState.getState(entity);
+        if (domain) {
+            domain->releaseMovingEntities();
+        }
         sInstanceState.replaceState(entity, nullptr);
         entity->setFlags(~entity_domain);
     }
@@ -74,6 +86,22 @@ DomainProperty * DomainProperty::copy() const
     return new DomainProperty(*this);
 }
 
+HandlerResult DomainProperty::operation(LocatedEntity * entity,
+        const Operation & op, OpVector & res)
+{
+    if (!op->getArgs().empty()) {
+        auto& arg = op->getArgs().front();
+        if (arg->getName() == "movement") {
+            Domain* domain = sInstanceState.getState(entity);
+            if (domain) {
+                domain->tick(BaseWorld::instance().getTime());
+            }
+            return OPERATION_BLOCKED;
+        }
+    }
+    return OPERATION_IGNORED;
+}
+
 Domain* DomainProperty::getDomain(const LocatedEntity *entity) const {
     return sInstanceState.getState(entity);
 }
@@ -44,6 +44,9 @@ class DomainProperty : public Property<std::string>
         virtual void install(LocatedEntity *, const std::string &);
         virtual void remove(LocatedEntity *, const std::string &);
         virtual DomainProperty * copy() const;
+        virtual HandlerResult operation(LocatedEntity *,
+                                        const Operation &,
+                                        OpVector &);
 
         virtual void apply(LocatedEntity *);
 
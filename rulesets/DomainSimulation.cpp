@@ -0,0 +1,160 @@
+/*
+ Copyright (C) 2015 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "DomainSimulation.h"
+
+#include "PhysicalDomain.h"
+#include "LocatedEntity.h"
+
+#include "common/const.h"
+#include "common/debug.h"
+#include "common/WorkerPool.h"
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+#include <cassert>
+
+static const bool debug_flag = false;
+
+DomainSimulation * DomainSimulation::m_instance = nullptr;
+
+DomainSimulation::DomainSimulation(int threads) :
+        m_pool(new WorkerPool(threads)), m_nextTick(0.)
+{
+    assert(m_instance == nullptr);
+    m_instance = this;
+}
+
+DomainSimulation::~DomainSimulation()
+{
+    delete m_pool;
+    m_instance = nullptr;
+}
+
+void DomainSimulation::addDomain(PhysicalDomain& domain)
+{
+    m_domains.insert(std::make_pair(domain.getEntity().getIntId(), &domain));
+}
+
+void DomainSimulation::removeDomain(PhysicalDomain& domain)
+{
+    auto I = m_domains.find(domain.getEntity().getIntId());
+    if (I != m_domains.end() && I->second == &domain) {
+        m_domains.erase(I);
+    }
+}
+
+double DomainSimulation::secondsUntilTick(double time) const
+{
+    if (m_domains.empty()) {
+        return std::numeric_limits<double>::infinity();
+    }
+    return std::max(0., m_nextTick - time);
+}
+
+void DomainSimulation::idle(double time)
+{
+    if (m_domains.empty()) {
+        //Start ticking as soon as a domain is added.
+        m_nextTick = time;
+        return;
+    }
+    if (time < m_nextTick) {
+        return;
+    }
+    m_nextTick = time + consts::move_tick;
+    tick(time);
+}
+
+bool DomainSimulation::isInsideSimulatedDomain(const PhysicalDomain& domain) const
+{
+    for (const LocatedEntity* ancestor = domain.getEntity().m_location.m_loc;
+         ancestor != nullptr; ancestor = ancestor->m_location.m_loc) {
+        auto I = m_domains.find(ancestor->getIntId());
+        if (I != m_domains.end() && &I->second->getEntity() == ancestor) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Gets the number of entities the domain entity is inside.
+ */
+static int domainDepth(const PhysicalDomain* domain)
+{
+    int depth = 0;
+    for (const LocatedEntity* ancestor = domain->getEntity().m_location.m_loc;
+         ancestor != nullptr; ancestor = ancestor->m_location.m_loc) {
+        ++depth;
+    }
+    return depth;
+}
+
+void DomainSimulation::tick(double time)
+{
+    //Copied, as the domains might change while operations are sent.
+    std::vector<PhysicalDomain*> domains;
+    domains.reserve(m_domains.size());
+    std::vector<std::function<void()>> jobs;
+    std::vector<PhysicalDomain*> dependent;
+    for (auto& entry : m_domains) {
+        PhysicalDomain* domain = entry.second;
+        domains.push_back(domain);
+        //A domain inside another one being moved can't run at the same time, as moving the
+        //outer domain looks at the entity of the inner one and its children.
+        if (domain->isIsolated() && !isInsideSimulatedDomain(*domain)) {
+            jobs.push_back([domain, time]() { domain->simulateMovement(time); });
+        } else {
+            dependent.push_back(domain);
+        }
+    }
+
+    m_pool->run(jobs);
+
+    //Domains which look outside themselves are moved once the others are done, outer ones
+    //first, so each is moved after the domain it is in.
+    std::stable_sort(dependent.begin(), dependent.end(),
+                     [](const PhysicalDomain* lhs, const PhysicalDomain* rhs) {
+                         return domainDepth(lhs) < domainDepth(rhs);
+                     });
+    for (PhysicalDomain* domain : dependent) {
+        domain->simulateMovement(time);
+    }
+
+    debug(std::cout << "Simulated " << domains.size() << " domains, "
+                    << dependent.size() << " on the main thread"
+                    << std::endl << std::flush;);
+
+    for (PhysicalDomain* domain : domains) {
+        domain->sendMovement();
+    }
+
+    for (PhysicalDomain* domain : domains) {
+        if (!domain->hasMovingEntities()) {
+            removeDomain(*domain);
+        }
+    }
+}
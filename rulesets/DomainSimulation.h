@@ -0,0 +1,116 @@
+/*
+ Copyright (C) 2015 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+#ifndef DOMAINSIMULATION_H_
+#define DOMAINSIMULATION_H_
+
+#include <map>
+
+class PhysicalDomain;
+class WorkerPool;
+
+/**
+ * @brief Moves the entities of all physical domains together, using a pool of threads.
+ *
+ * Normally each domain moves its entities when a Tick operation arrives at its entity.
+ * If an instance of this class exists the domains instead register with it once they have
+ * moving entities, and it moves the entities of all of them every consts::move_tick seconds.
+ *
+ * The movement and collision checks of domains which are isolated from each other are run
+ * on the worker threads. A domain inside another one which is being moved is moved on the
+ * calling thread after it instead. The resulting operations are then sent from the calling thread,
+ * one domain at a time ordered by the id of the domain entity, so that the operations are
+ * the same, and queued in the same order, regardless of the number of threads.
+ */
+class DomainSimulation
+{
+    public:
+        /**
+         * @brief Ctor.
+         * @param threads The number of worker threads to use.
+         */
+        explicit DomainSimulation(int threads);
+        ~DomainSimulation();
+
+        /**
+         * @brief Gets the instance, if there is one.
+         * @return The instance, or null if domains move their own entities.
+         */
+        static DomainSimulation * instance() {
+            return m_instance;
+        }
+
+        /**
+         * @brief Adds a domain with moving entities.
+         *
+         * The domain is removed again once it has no more moving entities.
+         */
+        void addDomain(PhysicalDomain& domain);
+
+        /**
+         * @brief Removes a domain, which must be done before it's destroyed.
+         */
+        void removeDomain(PhysicalDomain& domain);
+
+        /**
+         * @brief Gets the number of seconds until idle() will move any entities.
+         *
+         * This is infinite if there are no moving entities.
+         * @param time The current world time.
+         */
+        double secondsUntilTick(double time) const;
+
+        /**
+         * @brief Moves the entities, if it's time to do so.
+         * @param time The current world time.
+         */
+        void idle(double time);
+
+        /**
+         * @brief Moves the entities of all registered domains.
+         * @param time The current world time.
+         */
+        void tick(double time);
+
+    private:
+
+        /**
+         * @brief Checks if the entity of a domain is inside the entity of another registered domain.
+         */
+        bool isInsideSimulatedDomain(const PhysicalDomain& domain) const;
+
+        static DomainSimulation * m_instance;
+
+        WorkerPool * m_pool;
+
+        /**
+         * @brief The domains with moving entities, keyed by the integer id of the domain entity.
+         */
+        std::map<long, PhysicalDomain*> m_domains;
+
+        /**
+         * @brief The world time at which entities will next be moved.
+         */
+        double m_nextTick;
+
+        DomainSimulation(const DomainSimulation &) = delete;
+        DomainSimulation & operator=(const DomainSimulation &) = delete;
+
+        friend class DomainSimulationtest;
+};
+
+#endif /* DOMAINSIMULATION_H_ */
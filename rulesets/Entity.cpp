@@ -66,6 +66,7 @@ using Atlas::Objects::smart_dynamic_cast;
 static const bool debug_flag = false;
 
 std::unordered_map<const TypeNode*, std::unique_ptr<int>> Entity::s_monitorsMap;
+std::unordered_map<const TypeNode*, Entity::PropertyGauges> Entity::s_propertyGauges;
 
 /// \brief Flags used to control entities
 ///
@@ -79,7 +80,8 @@ std::unordered_map<const TypeNode*, std::unique_ptr<int>> Entity::s_monitorsMap;
 
 /// \brief Entity constructor
 Entity::Entity(const std::string & id, long intId) :
-        LocatedEntity(id, intId), m_motion(nullptr)
+        LocatedEntity(id, intId), m_motion(nullptr), m_classDelegates(0),
+        m_classPropertyCopies(0)
 {
 }
 
@@ -91,6 +93,12 @@ Entity::~Entity()
             int* ptr = I->second.get();
             *ptr = *ptr - 1;
         }
+        // The type may already have been deleted, so only the pointer is
+        // used to find the gauges.
+        auto J = s_propertyGauges.find(m_type);
+        if (J != s_propertyGauges.end()) {
+            J->second.classPropertyCopies.add(-m_classPropertyCopies);
+        }
     }
 
     delete m_motion;
@@ -111,24 +119,68 @@ void Entity::setType(const TypeNode * t) {
             int* ptr = I->second.get();
             *ptr = *ptr + 1;
         }
+
+        PropertyGauges & gauges = propertyGauges(t);
+        gauges.classProperties.set(t->defaults().size());
+        // Properties set before the type was known may replace defaults.
+        int copies = 0;
+        for (const auto & entry : m_properties) {
+            if (t->defaults().find(entry.first) != t->defaults().end()) {
+                ++copies;
+            }
+        }
+        addClassPropertyCopies(copies);
     }
 }
 
+/// \brief Get the class property monitors for a type, creating them
+/// if required.
+Entity::PropertyGauges & Entity::propertyGauges(const TypeNode * type)
+{
+    auto I = s_propertyGauges.find(type);
+    if (I == s_propertyGauges.end()) {
+        Monitors * monitors = Monitors::instance();
+        PropertyGauges gauges = {
+            monitors->gauge(String::compose("class_properties{type=\"%1\"}",
+                                            type->name())),
+            monitors->gauge(String::compose("class_property_copies{type=\"%1\"}",
+                                            type->name()))
+        };
+        I = s_propertyGauges.insert(std::make_pair(type, gauges)).first;
+    }
+    return I->second;
+}
+
+/// \brief Record that this entity has made its own copy of some of its
+/// class properties.
+void Entity::addClassPropertyCopies(int count)
+{
+    if (count == 0) {
+        return;
+    }
+    m_classPropertyCopies += count;
+    propertyGauges(m_type).classPropertyCopies.add(count);
+}
+
 
 PropertyBase * Entity::setAttr(const std::string & name, const Element & attr)
 {
     PropertyBase * prop;
+    int id = PropertyDict::intern(name);
     // If it is an existing property, just update the value.
-    PropertyDict::const_iterator I = m_properties.find(name);
+    PropertyDict::const_iterator I = m_properties.find(id);
     if (I != m_properties.end()) {
         prop = I->second;
         // Mark it as unclean
         prop->resetFlags(per_clean);
+        markPropertyDirty(id);
     } else {
         PropertyDict::const_iterator I;
         if (m_type != 0 &&
-            (I = m_type->defaults().find(name)) != m_type->defaults().end()) {
+            (I = m_type->defaults().find(id)) != m_type->defaults().end()) {
             prop = I->second->copy();
+            detachClassDelegates(id);
+            addClassPropertyCopies(1);
         } else {
             // This is an entirely new property, not just a modification of
             // one in defaults, so we need to install it to this Entity.
@@ -138,6 +190,7 @@ PropertyBase * Entity::setAttr(const std::string & name, const Element & attr)
         }
         assert(prop != 0);
         m_properties[name] = prop;
+        markPropertyDirty(id);
     }
 
     prop->set(attr);
@@ -150,12 +203,21 @@ PropertyBase * Entity::setAttr(const std::string & name, const Element & attr)
 
 const PropertyBase * Entity::getProperty(const std::string & name) const
 {
-    PropertyDict::const_iterator I = m_properties.find(name);
+    int id = PropertyDict::lookup(name);
+    if (id < 0) {
+        return 0;
+    }
+    return getPropertyById(id);
+}
+
+const PropertyBase * Entity::getPropertyById(int id) const
+{
+    PropertyDict::const_iterator I = m_properties.find(id);
     if (I != m_properties.end()) {
         return I->second;
     }
     if (m_type != 0) {
-        I = m_type->defaults().find(name);
+        I = m_type->defaults().find(id);
         if (I != m_type->defaults().end()) {
             return I->second;
         }
@@ -165,12 +227,16 @@ const PropertyBase * Entity::getProperty(const std::string & name) const
 
 PropertyBase * Entity::modProperty(const std::string & name)
 {
-    PropertyDict::const_iterator I = m_properties.find(name);
+    int id = PropertyDict::lookup(name);
+    if (id < 0) {
+        return 0;
+    }
+    PropertyDict::const_iterator I = m_properties.find(id);
     if (I != m_properties.end()) {
         return I->second;
     }
     if (m_type != 0) {
-        I = m_type->defaults().find(name);
+        I = m_type->defaults().find(id);
         if (I != m_type->defaults().end()) {
             // We have a default for this property. Create a new instance
             // property with the same value.
@@ -178,8 +244,11 @@ PropertyBase * Entity::modProperty(const std::string & name)
             I->second->remove(this, name);
             new_prop->flags() &= ~flag_class;
             m_properties[name] = new_prop;
+            markPropertyDirty(id);
+            detachClassDelegates(id);
             new_prop->apply(this);
             new_prop->install(this, name);
+            addClassPropertyCopies(1);
             return new_prop;
         }
     }
@@ -194,6 +263,13 @@ PropertyBase * Entity::modProperty(const std::string & name)
 PropertyBase * Entity::setProperty(const std::string & name,
                                    PropertyBase * prop)
 {
+    int id = PropertyDict::intern(name);
+    detachClassDelegates(id);
+    markPropertyDirty(id);
+    if (m_type != 0 && m_properties.find(id) == m_properties.end() &&
+        m_type->defaults().find(id) != m_type->defaults().end()) {
+        addClassPropertyCopies(1);
+    }
     return m_properties[name] = prop;
 }
 
@@ -247,14 +323,54 @@ void Entity::addToEntity(const RootEntity & ent) const
 /// @param delegate The name of the property to delegate it to.
 void Entity::installDelegate(int class_no, const std::string & delegate)
 {
-    m_delegates.insert(std::make_pair(class_no, delegate));
+    int id = PropertyDict::intern(delegate);
+    auto J = m_delegates.equal_range(class_no);
+    for (; J.first != J.second; ++J.first) {
+        if (J.first->second.property == id) {
+            return;
+        }
+    }
+    Delegate d;
+    d.property = id;
+    d.fromClass = false;
+    // The class property is being installed, rather than a copy of our own,
+    // so it can be reached through the table in the type.
+    if (m_type != 0 && m_properties.find(id) == m_properties.end() &&
+        m_type->defaults().find(id) != m_type->defaults().end()) {
+        m_type->addDelegate(class_no, id);
+        d.fromClass = true;
+        ++m_classDelegates;
+    }
+    m_delegates.insert(std::make_pair(class_no, d));
 }
 
 void Entity::removeDelegate(int class_no, const std::string & delegate)
 {
-    auto I = m_delegates.find(class_no);
-    if (I != m_delegates.end() && I->second == delegate) {
-        m_delegates.erase(I);
+    int id = PropertyDict::lookup(delegate);
+    auto J = m_delegates.equal_range(class_no);
+    for (; J.first != J.second; ++J.first) {
+        if (J.first->second.property == id) {
+            if (J.first->second.fromClass) {
+                --m_classDelegates;
+            }
+            m_delegates.erase(J.first);
+            return;
+        }
+    }
+}
+
+/// \brief Stop using the class property for any delegates of a property
+///
+/// Called when the entity gets its own copy of a class property without
+/// it being installed, so that operations are passed to the copy.
+/// @param property the interned name of the property
+void Entity::detachClassDelegates(int property)
+{
+    for (auto & entry : m_delegates) {
+        if (entry.second.property == property && entry.second.fromClass) {
+            entry.second.fromClass = false;
+            --m_classDelegates;
+        }
     }
 }
 
@@ -504,10 +620,35 @@ void Entity::operation(const Operation & op, OpVector & res)
         return;
     }
 
-    auto J = m_delegates.equal_range(op->getClassNo());
+    auto op_no = op->getClassNo();
     HandlerResult hr = OPERATION_IGNORED;
+    // If all the delegates are the class properties, which is the usual
+    // case, the type has a table of them ready to call.
+    if (m_type != 0 && m_classDelegates == m_delegates.size() &&
+        m_classDelegates == m_type->delegateCount()) {
+        // The table is fetched each time, as entities created by a
+        // delegate can add to it.
+        for (std::size_t i = 0; ; ++i) {
+            const std::vector<PropertyBase *> * delegates = m_type->delegates(op_no);
+            if (delegates == 0 || i >= delegates->size()) {
+                break;
+            }
+            HandlerResult hr_call = (*delegates)[i]->operation(this, op, res);
+            if (hr != OPERATION_BLOCKED) {
+                if (hr_call != OPERATION_IGNORED) {
+                    hr = hr_call;
+                }
+            }
+        }
+        if (hr == OPERATION_BLOCKED) {
+            return;
+        }
+        return callOperation(op, res);
+    }
+
+    auto J = m_delegates.equal_range(op_no);
     for (;J.first != J.second; ++J.first) {
-        HandlerResult hr_call = callDelegate(J.first->second, op, res);
+        HandlerResult hr_call = callDelegate(J.first->second.property, op, res);
         //We'll record the most blocking of the different results only.
         if (hr != OPERATION_BLOCKED) {
             if (hr_call != OPERATION_IGNORED) {
@@ -536,13 +677,25 @@ void Entity::operation(const Operation & op, OpVector & res)
 HandlerResult Entity::callDelegate(const std::string & name,
                                    const Operation & op,
                                    OpVector & res)
+{
+    int id = PropertyDict::lookup(name);
+    if (id < 0) {
+        return OPERATION_IGNORED;
+    }
+    return callDelegate(id, op, res);
+}
+
+/// \brief Pass an operation to the property with the given interned id
+HandlerResult Entity::callDelegate(int id,
+                                   const Operation & op,
+                                   OpVector & res)
 {
     PropertyBase * p = 0;
-    PropertyDict::const_iterator I = m_properties.find(name);
+    PropertyDict::const_iterator I = m_properties.find(id);
     if (I != m_properties.end()) {
         p = I->second;
     } else if (m_type != 0) {
-        I = m_type->defaults().find(name); 
+        I = m_type->defaults().find(id);
         if (I != m_type->defaults().end()) {
             p = I->second;
         }
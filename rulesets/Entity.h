@@ -21,6 +21,8 @@
 
 #include "LocatedEntity.h"
 
+#include "common/Metrics.h"
+
 #include <iostream>
 #include <unordered_map>
 
@@ -39,14 +41,42 @@ class Entity : public LocatedEntity {
   protected:
     /// Motion behavior of this entity
     Motion * m_motion;
+    /// \brief A property which handles a class of operation.
+    struct Delegate {
+        /// Interned name of the property.
+        int property;
+        /// True if it's the class property, dispatched to through the
+        /// table in the TypeNode.
+        bool fromClass;
+    };
+
     /// Map of delegate properties.
-    std::multimap<int, std::string> m_delegates;
+    std::multimap<int, Delegate> m_delegates;
+    /// Number of delegates which are class properties.
+    std::size_t m_classDelegates;
 
     /// A static map tracking the number of existing entities per type.
     /// A monitor by the name of "entity_count{type=*}" will be created
     /// per type.
     static std::unordered_map<const TypeNode*, std::unique_ptr<int>> s_monitorsMap;
 
+    /// \brief Monitors of how the class properties of a type are used.
+    struct PropertyGauges {
+        /// "class_properties{type=*}", the number of class properties.
+        Gauge classProperties;
+        /// "class_property_copies{type=*}", the number of class properties
+        /// which entities of the type have their own copy of.
+        Gauge classPropertyCopies;
+    };
+    static std::unordered_map<const TypeNode*, PropertyGauges> s_propertyGauges;
+    static PropertyGauges & propertyGauges(const TypeNode * type);
+
+    /// Number of class properties this entity has its own copy of.
+    int m_classPropertyCopies;
+
+    void detachClassDelegates(int property);
+    void addClassPropertyCopies(int count);
+
   public:
     explicit Entity(const std::string & id, long intId);
     virtual ~Entity();
@@ -62,6 +92,7 @@ class Entity : public LocatedEntity {
     virtual PropertyBase * setAttr(const std::string & name,
                                    const Atlas::Message::Element &);
     virtual const PropertyBase * getProperty(const std::string & name) const;
+    virtual const PropertyBase * getPropertyById(int id) const;
 
     virtual PropertyBase * modProperty(const std::string & name);
     virtual PropertyBase * setProperty(const std::string & name, PropertyBase * prop);
@@ -101,6 +132,9 @@ class Entity : public LocatedEntity {
     HandlerResult callDelegate(const std::string &,
                                const Operation &,
                                OpVector &);
+    HandlerResult callDelegate(int,
+                               const Operation &,
+                               OpVector &);
     void callOperation(const Operation &, OpVector &);
 
     virtual void installDelegate(int, const std::string &);
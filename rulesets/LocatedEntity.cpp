@@ -20,6 +20,7 @@
 
 #include "Script.h"
 #include "AtlasProperties.h"
+#include "Domain.h"
 
 #include "common/Property.h"
 #include "common/TypeNode.h"
@@ -85,12 +86,16 @@ void LocatedEntity::setType(const TypeNode * t) {
 /// false otherwise
 bool LocatedEntity::hasAttr(const std::string & name) const
 {
-    PropertyDict::const_iterator I = m_properties.find(name);
+    int id = PropertyDict::lookup(name);
+    if (id < 0) {
+        return false;
+    }
+    PropertyDict::const_iterator I = m_properties.find(id);
     if (I != m_properties.end()) {
         return true;
     }
     if (m_type != 0) {
-        I = m_type->defaults().find(name);
+        I = m_type->defaults().find(id);
         if (I != m_type->defaults().end()) {
             return true;
         }
@@ -107,12 +112,16 @@ bool LocatedEntity::hasAttr(const std::string & name) const
 int LocatedEntity::getAttr(const std::string & name,
                            Element & attr) const
 {
-    PropertyDict::const_iterator I = m_properties.find(name);
+    int id = PropertyDict::lookup(name);
+    if (id < 0) {
+        return -1;
+    }
+    PropertyDict::const_iterator I = m_properties.find(id);
     if (I != m_properties.end()) {
         return I->second->get(attr);
     }
     if (m_type != 0) {
-        I = m_type->defaults().find(name);
+        I = m_type->defaults().find(id);
         if (I != m_type->defaults().end()) {
             return I->second->get(attr);
         }
@@ -130,12 +139,16 @@ int LocatedEntity::getAttrType(const std::string & name,
                                Element & attr,
                                int type) const
 {
-    PropertyDict::const_iterator I = m_properties.find(name);
+    int id = PropertyDict::lookup(name);
+    if (id < 0) {
+        return -1;
+    }
+    PropertyDict::const_iterator I = m_properties.find(id);
     if (I != m_properties.end()) {
         return I->second->get(attr) || (attr.getType() == type ? 0 : 1);
     }
     if (m_type != 0) {
-        I = m_type->defaults().find(name);
+        I = m_type->defaults().find(id);
         if (I != m_type->defaults().end()) {
             return I->second->get(attr) || (attr.getType() == type ? 0 : 1);
         }
@@ -172,6 +185,23 @@ const PropertyBase * LocatedEntity::getProperty(const std::string & name) const
     return 0;
 }
 
+/// \brief Get the property object for an interned attribute name
+///
+/// Finds the same property as getProperty() does for the name, without
+/// hashing the name. Used by callers which look up the same attribute on
+/// many entities.
+/// @param id interned name of the attribute, from PropertyDict::intern().
+/// @return a pointer to the property, or zero if the attributes does
+/// not exist, or is not stored using a property object.
+const PropertyBase * LocatedEntity::getPropertyById(int id) const
+{
+    PropertyDict::const_iterator I = m_properties.find(id);
+    if (I != m_properties.end()) {
+        return I->second;
+    }
+    return 0;
+}
+
 PropertyBase * LocatedEntity::modProperty(const std::string & name)
 {
     PropertyDict::const_iterator I = m_properties.find(name);
@@ -281,6 +311,13 @@ void LocatedEntity::addChild(LocatedEntity& childEntity)
     }
 
     childEntity.m_location.m_loc = this;
+
+    if (m_flags & entity_domain) {
+        Domain* domain = getMovementDomain();
+        if (domain) {
+            domain->addEntity(childEntity);
+        }
+    }
 }
 
 void LocatedEntity::removeChild(LocatedEntity& childEntity)
@@ -288,6 +325,12 @@ void LocatedEntity::removeChild(LocatedEntity& childEntity)
     assert(checkRef() > 0);
     assert(m_contains != 0);
     assert(m_contains->count(&childEntity));
+    if (m_flags & entity_domain) {
+        Domain* domain = getMovementDomain();
+        if (domain) {
+            domain->removeEntity(childEntity);
+        }
+    }
     m_contains->erase(&childEntity);
     if (m_contains->empty()) {
         onUpdated();
@@ -22,13 +22,16 @@
 #include "modules/Location.h"
 
 #include "common/Property.h"
+#include "common/PropertyDict.h"
 #include "common/Router.h"
 #include "common/log.h"
 #include "common/compose.hpp"
 
 #include <sigc++/signal.h>
 
+#include <algorithm>
 #include <set>
+#include <vector>
 
 #include <cassert>
 
@@ -42,7 +45,6 @@ template <typename T>
 class Property;
 
 typedef std::set<LocatedEntity *> LocatedEntitySet;
-typedef std::map<std::string, PropertyBase *> PropertyDict;
 
 /// \brief Flag indicating entity has been written to permanent store
 /// \ingroup EntityFlags
@@ -58,6 +60,11 @@ static const unsigned int entity_clean_mask = entity_clean |
                                               entity_pos_clean |
                                               entity_orient_clean;
 
+/// \brief Flag mask indicating entity location has been written to store
+/// \ingroup EntityFlags
+static const unsigned int entity_location_clean = entity_pos_clean |
+                                                  entity_orient_clean;
+
 /// \brief Flag indicating entity is perceptive
 /// \ingroup EntityFlags
 static const unsigned int entity_perceptive = 1 << 3;
@@ -116,6 +123,8 @@ class LocatedEntity : public Router {
     const TypeNode * m_type;
     /// Flags indicating changes to attributes
     unsigned int m_flags;
+    /// Interned ids of properties changed since they were last stored
+    std::vector<int> m_dirtyProperties;
 
   public:
     /// Full details of location
@@ -159,6 +168,24 @@ class LocatedEntity : public Router {
 
     void resetFlags(unsigned int flags) { m_flags &= ~flags; }
 
+    /// \brief Record that a property needs to be written to store.
+    ///
+    /// This is kept alongside the per_clean flag of the property, so
+    /// storage can find the changed properties without checking them all.
+    void markPropertyDirty(int id) {
+        if (std::find(m_dirtyProperties.begin(), m_dirtyProperties.end(),
+                      id) == m_dirtyProperties.end()) {
+            m_dirtyProperties.push_back(id);
+        }
+    }
+
+    /// \brief Accessor for ids of properties which need to be stored
+    const std::vector<int> & getDirtyProperties() const {
+        return m_dirtyProperties;
+    }
+
+    void clearDirtyProperties() { m_dirtyProperties.clear(); }
+
     /// \brief Accessor for pointer to script object
     Script * script() const {
         return m_script;
@@ -183,6 +210,7 @@ class LocatedEntity : public Router {
     virtual PropertyBase* setAttr(const std::string & name,
                                   const Atlas::Message::Element &);
     virtual const PropertyBase * getProperty(const std::string & name) const;
+    virtual const PropertyBase * getPropertyById(int id) const;
     // FIXME These should be de-visrtualised and, and implementations moved
     // from Entity to here.
     virtual PropertyBase * modProperty(const std::string & name);
@@ -290,6 +318,7 @@ class LocatedEntity : public Router {
             // If it is not of the right type, delete it and a new
             // one of the right type will be inserted.
             m_properties[name] = sp = new PropertyT;
+            markPropertyDirty(PropertyDict::intern(name));
             sp->install(this, name);
             if (p != 0) {
                 log(WARNING, String::compose("Property %1 on entity with id %2 "
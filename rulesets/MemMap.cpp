@@ -31,10 +31,16 @@
 #include <Atlas/Objects/Operation.h>
 #include <Atlas/Objects/Anonymous.h>
 
+#include <algorithm>
 #include <sstream>
 
+#include <cmath>
+
 static const bool debug_flag = false;
 
+/// \brief Width of the cells of the grid used to find entities near a point.
+static const WFMath::CoordType grid_cell_size = 16.f;
+
 using Atlas::Message::Element;
 using Atlas::Message::MapType;
 using Atlas::Objects::Operation::Look;
@@ -45,6 +51,78 @@ using String::compose;
 
 const TypeNode * MemMap::m_entity_type = 0;
 
+/// \brief Remove an entity from one of the buckets of an index, and the
+/// bucket from the index if it is now empty.
+template <typename Key>
+static void removeFromIndex(std::map<Key, MemEntityDict> & index,
+                            const Key & key,
+                            long id)
+{
+    auto I = index.find(key);
+    if (I == index.end()) {
+        return;
+    }
+    I->second.erase(id);
+    if (I->second.empty()) {
+        index.erase(I);
+    }
+}
+
+/// \brief Record the type and position of an entity in the indexes, moving
+/// it from where it was recorded before if they have changed.
+void MemMap::index(MemEntity * entity)
+{
+    long id = entity->getIntId();
+    auto I = m_indexed.find(id);
+    if (I == m_indexed.end()) {
+        IndexEntry entry{0, GridCell(), false};
+        I = m_indexed.insert(std::make_pair(id, entry)).first;
+    }
+    IndexEntry & entry = I->second;
+
+    const TypeNode * type = entity->getType();
+    if (entry.type != type) {
+        if (entry.type != 0) {
+            removeFromIndex(m_typeIndex, entry.type, id);
+        }
+        m_typeIndex[type][id] = entity;
+        entry.type = type;
+    }
+
+    const Location & location = entity->m_location;
+    bool placed = location.m_loc != 0 && location.pos().isValid();
+    GridCell cell;
+    if (placed) {
+        cell = GridCell(location.m_loc,
+                        (int)std::floor(location.pos().x() / grid_cell_size),
+                        (int)std::floor(location.pos().y() / grid_cell_size));
+    }
+    if (entry.inGrid && (!placed || entry.cell != cell)) {
+        removeFromIndex(m_grid, entry.cell, id);
+        entry.inGrid = false;
+    }
+    if (placed && !entry.inGrid) {
+        m_grid[cell][id] = entity;
+        entry.cell = cell;
+        entry.inGrid = true;
+    }
+}
+
+/// \brief Remove an entity from the indexes.
+void MemMap::unindex(MemEntity * entity)
+{
+    long id = entity->getIntId();
+    auto I = m_indexed.find(id);
+    if (I == m_indexed.end()) {
+        return;
+    }
+    removeFromIndex(m_typeIndex, I->second.type, id);
+    if (I->second.inGrid) {
+        removeFromIndex(m_grid, I->second.cell, id);
+    }
+    m_indexed.erase(I);
+}
+
 MemEntity * MemMap::addEntity(MemEntity * entity)
 {
     assert(entity != 0);
@@ -59,6 +137,7 @@ MemEntity * MemMap::addEntity(MemEntity * entity)
     }
     m_entities[entity->getIntId()] = entity;
     m_checkIterator = m_entities.find(next);
+    index(entity);
 
     if (m_script != 0) {
         debug( std::cout << this << std::endl << std::flush;);
@@ -120,6 +199,7 @@ void MemMap::updateEntity(MemEntity * entity, const RootEntity & ent)
     debug( std::cout << " got " << entity << std::endl << std::flush;);
 
     readEntity(entity, ent);
+    index(entity);
 
     if (m_script != 0) {
         std::vector<std::string>::const_iterator K = m_updateHooks.begin();
@@ -206,9 +286,20 @@ void MemMap::del(const std::string & id)
             next = m_checkIterator->first;
         }
         m_entities.erase(I);
+        unindex(ent);
 
         ent->destroy(); // should probably go here, but maybe earlier
 
+        // Its contents have been moved to its location
+        if (ent->m_contains != 0) {
+            for (LocatedEntity * child : *ent->m_contains) {
+                MemEntityDict::const_iterator J = m_entities.find(child->getIntId());
+                if (J != m_entities.end()) {
+                    index(J->second);
+                }
+            }
+        }
+
         if (next != -1) {
             m_checkIterator = m_entities.find(next);
         } else {
@@ -357,13 +448,38 @@ EntityVector MemMap::findByType(const std::string & what)
 // Find an entity in our memory of a certain type
 {
     EntityVector res;
-    
-    MemEntityDict::const_iterator Iend = m_entities.end();
-    for (MemEntityDict::const_iterator I = m_entities.begin(); I != Iend; ++I) {
-        MemEntity * item = I->second;
-        debug( std::cout << "F" << what << ":" << item->getType() << ":" << item->getId() << std::endl << std::flush;);
-        if (item->isVisible() && item->getType()->name() == what) {
-            res.push_back(I->second);
+
+    for (auto & entry : m_typeIndex) {
+        if (entry.first->name() != what) {
+            continue;
+        }
+        for (auto & item : entry.second) {
+            if (item.second->isVisible()) {
+                res.push_back(item.second);
+            }
+        }
+    }
+    return res;
+}
+
+/// \brief Find the visible entities in memory of a type.
+///
+/// @param type the type to look for
+/// @param subtypes if true, entities of types which inherit from it are
+/// included as well
+EntityVector MemMap::findByType(const TypeNode * type, bool subtypes)
+{
+    EntityVector res;
+
+    for (auto & entry : m_typeIndex) {
+        if (entry.first != type &&
+            !(subtypes && entry.first->isTypeOf(type))) {
+            continue;
+        }
+        for (auto & item : entry.second) {
+            if (item.second->isVisible()) {
+                res.push_back(item.second);
+            }
         }
     }
     return res;
@@ -390,24 +506,70 @@ EntityVector MemMap::findByLocation(const Location & loc,
         return res;
     }
 #endif // NDEBUG
-    LocatedEntitySet::const_iterator I = place->m_contains->begin();
-    LocatedEntitySet::const_iterator Iend = place->m_contains->end();
+    findNear(loc, radius, res);
+    res.erase(std::remove_if(res.begin(), res.end(), [&](LocatedEntity * item) {
+        return item->getType()->name() != what;
+    }), res.end());
+    return res;
+}
+
+/// \brief Find the visible entities in memory within a distance of a point.
+///
+/// Only the cells of the grid over the place which overlap the range are
+/// checked. If that is more cells than there are entities in the place,
+/// or the point isn't known, the entities in the place are checked instead.
+/// Positions are indexed when entities are updated through the map, so
+/// changes made to an entity's location directly are not seen until the
+/// entity is next updated.
+///
+/// @param where the place and point to search around
+/// @param radius the distance to search within
+/// @param res the entities found are added to this
+void MemMap::findNear(const Location & where,
+                      WFMath::CoordType radius,
+                      EntityVector & res) const
+{
+    LocatedEntity * place = where.m_loc;
+    if (place == 0 || place->m_contains == 0) {
+        return;
+    }
+    const Point3D & pos = where.pos();
     float square_range = radius * radius;
-    for (; I != Iend; ++I) {
-        assert(*I != 0);
-        LocatedEntity * item = *I;
-        if (item == 0) {
-            log(ERROR, "Weird entity in memory");
-            continue;
-        }
-        if (!item->isVisible() || item->getType()->name() != what) {
-            continue;
+
+    double min_x = std::floor((pos.x() - radius) / grid_cell_size);
+    double max_x = std::floor((pos.x() + radius) / grid_cell_size);
+    double min_y = std::floor((pos.y() - radius) / grid_cell_size);
+    double max_y = std::floor((pos.y() + radius) / grid_cell_size);
+    if (!pos.isValid() ||
+        (max_x - min_x + 1) * (max_y - min_y + 1) > place->m_contains->size()) {
+        for (LocatedEntity * item : *place->m_contains) {
+            if (item == 0) {
+                log(ERROR, "Weird entity in memory");
+                continue;
+            }
+            if (item->isVisible() &&
+                squareDistance(pos, item->m_location.pos()) < square_range) {
+                res.push_back(item);
+            }
         }
-        if (squareDistance(loc.pos(), item->m_location.pos()) < square_range) {
-            res.push_back(item);
+        return;
+    }
+
+    for (int x = (int)min_x; x <= (int)max_x; ++x) {
+        for (int y = (int)min_y; y <= (int)max_y; ++y) {
+            auto I = m_grid.find(GridCell(place, x, y));
+            if (I == m_grid.end()) {
+                continue;
+            }
+            for (auto & entry : I->second) {
+                MemEntity * item = entry.second;
+                if (item->isVisible() &&
+                    squareDistance(pos, item->m_location.pos()) < square_range) {
+                    res.push_back(item);
+                }
+            }
         }
     }
-    return res;
 }
 
 void MemMap::check(const double & time)
@@ -429,6 +591,7 @@ void MemMap::check(const double & time)
                 next = J->first;
             }
             m_entities.erase(m_checkIterator);
+            unindex(me);
             // Remove deleted entity from its parents contains attribute
             if (me->m_location.m_loc != 0) {
                 assert(me->m_location.m_loc->m_contains != 0);
@@ -472,4 +635,7 @@ void MemMap::flush()
         I->second->m_location.m_loc = 0;
         I->second->decRef();
     }
+    m_typeIndex.clear();
+    m_grid.clear();
+    m_indexed.clear();
 }
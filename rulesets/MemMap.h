@@ -29,6 +29,7 @@
 #include <list>
 #include <map>
 #include <string>
+#include <tuple>
 
 class LocatedEntity;
 class Location;
@@ -44,9 +45,29 @@ class MemMap {
   protected:
     friend class BaseMind;
 
+    /// \brief A cell of the grid over a place, by the place and the
+    /// horizontal coordinates of the cell.
+    typedef std::tuple<const LocatedEntity *, int, int> GridCell;
+
+    /// \brief Where an entity has been put in the indexes.
+    struct IndexEntry {
+        const TypeNode * type;
+        GridCell cell;
+        bool inGrid;
+    };
+
     static const TypeNode * m_entity_type;
 
     MemEntityDict m_entities;
+    /// \brief Entities in memory by type, so they can be found without
+    /// checking all of them.
+    std::map<const TypeNode *, MemEntityDict> m_typeIndex;
+    /// \brief Entities with a position by the cell of the grid over their
+    /// location they are in, so those near a point can be found without
+    /// checking everything in the same place.
+    std::map<GridCell, MemEntityDict> m_grid;
+    /// \brief Where each entity is in the indexes, by id.
+    std::map<long, IndexEntry> m_indexed;
     MemEntityDict::iterator m_checkIterator;
     std::list<std::string> m_additionsById;
     std::vector<std::string> m_addHooks;
@@ -67,6 +88,8 @@ class MemMap {
                           const Atlas::Objects::Entity::RootEntity &);
     void addContents(const Atlas::Objects::Entity::RootEntity &);
     MemEntity * addId(const std::string &, long);
+    void index(MemEntity *);
+    void unindex(MemEntity *);
   public:
     explicit MemMap(Script *& s);
 
@@ -107,9 +130,13 @@ class MemMap {
                 std::map<std::string, Atlas::Message::Element>>& getEntityRelatedMemory() const;
 
     EntityVector findByType(const std::string & what);
+    EntityVector findByType(const TypeNode * type, bool subtypes = false);
     EntityVector findByLocation(const Location & where,
                                 WFMath::CoordType radius,
                                 const std::string & what);
+    void findNear(const Location & where,
+                  WFMath::CoordType radius,
+                  EntityVector & res) const;
 
     void check(const double &);
     void flush();
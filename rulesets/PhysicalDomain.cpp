@@ -22,6 +22,7 @@
 
 #include "PhysicalDomain.h"
 
+#include "DomainSimulation.h"
 #include "TerrainProperty.h"
 #include "LocatedEntity.h"
 #include "OutfitProperty.h"
@@ -29,18 +30,24 @@
 
 #include "physics/Collision.h"
 
+#include "common/BaseWorld.h"
 #include "common/debug.h"
 #include "common/const.h"
+#include "common/Tick.h"
 #include "common/Unseen.h"
+#include "common/Update.h"
 
 #include <Atlas/Objects/Operation.h>
 #include <Atlas/Objects/Anonymous.h>
 
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
 #include <unordered_set>
 
 #include <cassert>
+#include <cmath>
 
 static const bool debug_flag = false;
 
@@ -49,19 +56,43 @@ using Atlas::Message::MapType;
 using Atlas::Objects::Root;
 using Atlas::Objects::Entity::RootEntity;
 using Atlas::Objects::Entity::Anonymous;
+using Atlas::Objects::Operation::Move;
 using Atlas::Objects::Operation::Set;
 using Atlas::Objects::Operation::Sight;
+using Atlas::Objects::Operation::Tick;
+using Atlas::Objects::Operation::Update;
 using Atlas::Objects::Operation::Appearance;
 using Atlas::Objects::Operation::Disappearance;
 using Atlas::Objects::Operation::Unseen;
 
+/**
+ * @brief The size of each cell in the spatial index.
+ */
+static const float grid_cell_size = 32.f;
+
+/**
+ * @brief Entities which reach further than this are always considered in queries.
+ *
+ * With the default sight factor this covers entities up to about 7.5 meters
+ * across; larger entities are few enough to be checked every time.
+ */
+static const float grid_max_reach = grid_cell_size * 4;
+
 PhysicalDomain::PhysicalDomain(LocatedEntity& entity)
-: Domain(entity)
+: Domain(entity), m_grid(grid_cell_size, grid_max_reach),
+  m_movementTickPending(false)
 {
+    syncIndex();
 }
 
 PhysicalDomain::~PhysicalDomain()
 {
+    if (DomainSimulation::instance() != nullptr) {
+        DomainSimulation::instance()->removeDomain(*this);
+    }
+    //No operations are sent to the moving entities, as the domain is destroyed along with
+    //its entity, and the entities may be going away too. If the domain is removed from an
+    //entity which stays, releaseMovingEntities() has already handed them back.
 }
 
 float PhysicalDomain::constrainHeight(LocatedEntity * parent,
@@ -106,7 +137,150 @@ float PhysicalDomain::constrainHeight(LocatedEntity * parent,
 
 void PhysicalDomain::tick(double t)
 {
+    m_movementTickPending = false;
+    simulateMovement(t);
+    sendMovement();
+    if (!m_movers.empty()) {
+        scheduleMovementTick();
+    }
+}
+
+bool PhysicalDomain::isIsolated() const
+{
+    //Without terrain of its own, the height of entities is found through the parent of the domain entity.
+    return m_entity.m_location.m_loc == nullptr ||
+           m_entity.getPropertyClass<TerrainProperty>("terrain") != nullptr;
+}
+
+void PhysicalDomain::simulateMovement(double t)
+{
+    m_moverColliding.clear();
+    m_movedPerceptive.clear();
+    m_movedOldLocations.clear();
+    if (m_movers.empty()) {
+        return;
+    }
+    syncIndex();
+
+    std::size_t count = m_movers.size();
+
+    //Integrate the movement of all entities in one pass over the arrays.
+    for (std::size_t i = 0; i < count; ++i) {
+        float time_diff = (float)(t - m_moverTimeStamp[i]);
+        m_moverPos[i] += m_moverVelocity[i] * time_diff;
+        m_moverTimeStamp[i] = t;
+    }
+
+    //Write the new positions back, fitted to the terrain. The old locations of perceptive
+    //entities are kept, as visibility changes are calculated for them.
+    for (std::size_t i = 0; i < count; ++i) {
+        LocatedEntity& entity = *m_movers[i];
+        if (entity.isPerceptive()) {
+            m_movedPerceptive.push_back(i);
+            m_movedOldLocations.push_back(entity.m_location);
+        }
+        m_moverPos[i].z() = constrainHeight(&m_entity, m_moverPos[i], "standing");
+        entity.m_location.m_pos = m_moverPos[i];
+        entity.m_location.update(t);
+        entity.resetFlags(entity_pos_clean | entity_clean);
+        indexEntity(entity);
+    }
+
+    //Check for collisions once all entities have been moved.
+    m_moverColliding.assign(count, false);
+    std::vector<LocatedEntity*> nearby;
+    for (std::size_t i = 0; i < count; ++i) {
+        if (m_moverExtent[i] == 0.f) {
+            continue;
+        }
+        nearby.clear();
+        findNearbyChildren(m_moverPos[i], m_moverExtent[i], nearby);
+        CollisionData collisionData;
+        findCollision(*m_movers[i], nearby, collisionData);
+        m_moverColliding[i] = collisionData.isCollision;
+    }
+}
+
+void PhysicalDomain::sendMovement()
+{
+    std::size_t count = m_moverColliding.size();
+    if (count == 0) {
+        return;
+    }
+    assert(count <= m_movers.size());
+
+    //Entities which will collide before the next tick are handed back to their own Update
+    //operations, which deal with the collision at the right time. Copies are taken, as
+    //sending the operations might change the arrays.
+    std::vector<bool> colliding;
+    colliding.swap(m_moverColliding);
+    std::vector<LocatedEntity*> movers(m_movers.begin(), m_movers.begin() + count);
+    std::vector<long> refnos(m_moverRefno.begin(), m_moverRefno.begin() + count);
+    for (std::size_t i = count; i > 0; --i) {
+        if (colliding[i - 1]) {
+            removeMovingEntity(*movers[i - 1]);
+        }
+    }
+
+    debug(std::cout << "Moved " << count << " entities in domain "
+                    << m_entity.getId() << std::endl << std::flush;);
+
+    auto perceptive_iter = m_movedPerceptive.begin();
+    for (std::size_t i = 0; i < count; ++i) {
+        LocatedEntity& entity = *movers[i];
+        bool perceptive = perceptive_iter != m_movedPerceptive.end() && *perceptive_iter == i;
+        if (colliding[i]) {
+            //The Update operation will send the Move instead.
+            Update u;
+            u->setTo(entity.getId());
+            u->setRefno(refnos[i]);
+            BaseWorld::instance().message(u, entity);
+            if (perceptive) {
+                ++perceptive_iter;
+            }
+            continue;
+        }
+
+        Move m;
+        Anonymous move_arg;
+        move_arg->setId(entity.getId());
+        entity.m_location.addToEntity(move_arg);
+        m->setArgs1(move_arg);
+        m->setFrom(entity.getId());
+        m->setTo(entity.getId());
+
+        Sight s;
+        s->setArgs1(m);
+        BaseWorld::instance().message(s, entity);
+
+        if (perceptive) {
+            OpVector res;
+            processVisibilityForMovedEntity(entity,
+                    m_movedOldLocations[perceptive_iter - m_movedPerceptive.begin()], res);
+            for (auto& op : res) {
+                BaseWorld::instance().message(op, entity);
+            }
+            ++perceptive_iter;
+        }
+        entity.onUpdated();
+    }
+    m_movedPerceptive.clear();
+    m_movedOldLocations.clear();
+}
 
+void PhysicalDomain::scheduleMovementTick()
+{
+    if (m_movementTickPending) {
+        return;
+    }
+    Anonymous tick_arg;
+    tick_arg->setName("movement");
+    Tick tick;
+    tick->setArgs1(tick_arg);
+    tick->setFutureSeconds(consts::move_tick);
+    tick->setTo(m_entity.getId());
+    BaseWorld::instance().message(tick, m_entity);
+    m_movementTickPending = true;
 }
 
 void PhysicalDomain::lookAtEntity(const LocatedEntity& observingEntity, const LocatedEntity& observedEntity, const Operation & originalLookOp, OpVector& res) const
@@ -216,23 +390,28 @@ bool PhysicalDomain::isEntityVisibleFor(const LocatedEntity& observingEntity, co
         return true;
     }
     //The entity couldn't be seen just from its size; now check if it's outfitted or wielded.
-    if (observedEntity.m_location.m_loc != nullptr) {
+    return isOutfittedOrWielded(observedEntity);
+}
+
+bool PhysicalDomain::isOutfittedOrWielded(const LocatedEntity& entity)
+{
+    if (entity.m_location.m_loc != nullptr) {
         const OutfitProperty* outfitProperty =
-                observedEntity.m_location.m_loc->getPropertyClass<OutfitProperty>(
+                entity.m_location.m_loc->getPropertyClass<OutfitProperty>(
                         "outfit");
         if (outfitProperty) {
             for (auto& entry : outfitProperty->data()) {
                 auto outfittedEntity = entry.second.get();
-                if (outfittedEntity && outfittedEntity == &observedEntity) {
+                if (outfittedEntity && outfittedEntity == &entity) {
                     return true;
                 }
             }
         }
-        //If the entity isn't large enough, and isn't outfitted, perhaps it's wielded?
-        const EntityProperty* rightHandWieldProperty = observedEntity.m_location.m_loc->getPropertyClass<EntityProperty>("right_hand_wield");
+        //If the entity isn't outfitted, perhaps it's wielded?
+        const EntityProperty* rightHandWieldProperty = entity.m_location.m_loc->getPropertyClass<EntityProperty>("right_hand_wield");
         if (rightHandWieldProperty) {
-            auto entity = rightHandWieldProperty->data().get();
-            if (entity && entity == &observedEntity) {
+            auto wielded = rightHandWieldProperty->data().get();
+            if (wielded && wielded == &entity) {
                 return true;
             }
         }
@@ -240,6 +419,89 @@ bool PhysicalDomain::isEntityVisibleFor(const LocatedEntity& observingEntity, co
     return false;
 }
 
+bool PhysicalDomain::findObserverCandidates(const LocatedEntity& observedEntity, std::vector<LocatedEntity*>& candidates)
+{
+    if (&observedEntity == &m_entity) {
+        //Everything in the domain can see the domain entity.
+        return false;
+    }
+    //Outfitted and wielded entities can be seen regardless of their size, so we can't limit the search by range.
+    if (isOutfittedOrWielded(observedEntity)) {
+        return false;
+    }
+    //Make sure that the observed entity really is within this domain, and that its position is known.
+    const LocatedEntity* ancestor = observedEntity.m_location.m_loc;
+    while (ancestor != &m_entity) {
+        if (ancestor == nullptr) {
+            return false;
+        }
+        ancestor = ancestor->m_location.m_loc;
+    }
+    if (!observedEntity.m_location.pos().isValid()) {
+        return false;
+    }
+    const Point3D pos = relativePos(m_entity.m_location, observedEntity.m_location);
+    if (!pos.isValid()) {
+        return false;
+    }
+
+    syncIndex();
+    findNearbyChildren(pos, observedEntity.m_location.boxSize() / consts::sight_factor, candidates);
+    return true;
+}
+
+void PhysicalDomain::calculateVisibilityForEntity(std::vector<Root>& appear, std::vector<Root>& disappear, Anonymous& this_ent, const LocatedEntity& other,
+        const LocatedEntity& moved_entity, float fromSquSize, const Point3D& new_pos, const Point3D& old_pos, const Location& old_loc, OpVector & res) const {
+
+    float old_dist = squareDistance(other.m_location.pos(), old_pos),
+          new_dist = squareDistance(other.m_location.pos(), new_pos),
+          squ_size = other.m_location.squareBoxSize();
+
+    // Build appear and disappear lists, and send disappear operations
+    // to perceptive entities saying that we are disappearing
+    if (other.isPerceptive()) {
+        bool was_in_range = ((fromSquSize / old_dist) > consts::square_sight_factor),
+             is_in_range = ((fromSquSize / new_dist) > consts::square_sight_factor);
+        if (was_in_range != is_in_range) {
+            if (was_in_range) {
+                // Send operation to the entity in question so it
+                // knows it is losing sight of us.
+                Disappearance d;
+                d->setArgs1(this_ent);
+                d->setTo(other.getId());
+                res.push_back(d);
+            }
+            //Note that we don't send any Appear ops for those entities that we now move within sight range of.
+            //This is because these will receive a Move op anyway as part of the broadcast, which informs them
+            //that an entity has moved within sight range anyway.
+        }
+    }
+
+    bool could_see = ((squ_size / old_dist) > consts::square_sight_factor),
+         can_see = ((squ_size / new_dist) > consts::square_sight_factor);
+    if (could_see ^ can_see) {
+        Anonymous that_ent;
+        that_ent->setId(other.getId());
+        that_ent->setStamp(other.getSeq());
+        if (could_see) {
+            // We are losing sight of that object
+            disappear.push_back(that_ent);
+            debug(std::cout << moved_entity.getId() << ": losing sight of "
+                            << other.getId() << std::endl;);
+        } else /*if (can_see)*/ {
+            // We are gaining sight of that object
+            appear.push_back(that_ent);
+            debug(std::cout << moved_entity.getId() << ": gaining sight of "
+                            << other.getId() << std::endl;);
+        }
+    } else if (could_see) {
+        //We've seen this entity before, and we're still seeing it. Check if there are any children that's now changing visibility.
+        if (other.m_contains && !other.m_contains->empty()) {
+            calculateVisibility(appear, disappear, this_ent, other, moved_entity, old_loc, res);
+        }
+    }
+}
+
 void PhysicalDomain::calculateVisibility(std::vector<Root>& appear, std::vector<Root>& disappear, Anonymous& this_ent, const LocatedEntity& parent,
         const LocatedEntity& moved_entity, const Location& old_loc, OpVector & res) const {
 
@@ -251,58 +513,29 @@ void PhysicalDomain::calculateVisibility(std::vector<Root>& appear, std::vector<
 
     //For now we'll only consider movement within the same loc. This should change as we extend the domain code.
     assert(parent.m_contains != nullptr);
-    for (const LocatedEntity* other: *parent.m_contains) {
-        if (other == &moved_entity) {
-            continue;
-        }
-
-        assert(other != nullptr);
-        float old_dist = squareDistance(other->m_location.pos(), old_pos),
-              new_dist = squareDistance(other->m_location.pos(), new_pos),
-              squ_size = other->m_location.squareBoxSize();
-
-        // Build appear and disappear lists, and send disappear operations
-        // to perceptive entities saying that we are disappearing
-        if (other->isPerceptive()) {
-            bool was_in_range = ((fromSquSize / old_dist) > consts::square_sight_factor),
-                 is_in_range = ((fromSquSize / new_dist) > consts::square_sight_factor);
-            if (was_in_range != is_in_range) {
-                if (was_in_range) {
-                    // Send operation to the entity in question so it
-                    // knows it is losing sight of us.
-                    Disappearance d;
-                    d->setArgs1(this_ent);
-                    d->setTo(other->getId());
-                    res.push_back(d);
-                }
-                //Note that we don't send any Appear ops for those entities that we now move within sight range of.
-                //This is because these will receive a Move op anyway as part of the broadcast, which informs them
-                //that an entity has moved within sight range anyway.
+    if (&parent == &m_entity) {
+        //The direct children of the domain entity are indexed, so we only need to look at those near either the old or
+        //the new position. Anything further away could neither see nor be seen by the moved entity.
+        float sight_range = moved_entity.m_location.boxSize() / consts::sight_factor;
+        std::vector<LocatedEntity*> nearby;
+        findNearbyChildren(old_pos, sight_range, nearby);
+        findNearbyChildren(new_pos, sight_range, nearby);
+        std::sort(nearby.begin(), nearby.end());
+        nearby.erase(std::unique(nearby.begin(), nearby.end()), nearby.end());
+        for (const LocatedEntity* other: nearby) {
+            if (other == &moved_entity) {
+                continue;
             }
+            assert(other != nullptr);
+            calculateVisibilityForEntity(appear, disappear, this_ent, *other, moved_entity, fromSquSize, new_pos, old_pos, old_loc, res);
         }
-
-        bool could_see = ((squ_size / old_dist) > consts::square_sight_factor),
-             can_see = ((squ_size / new_dist) > consts::square_sight_factor);
-        if (could_see ^ can_see) {
-            Anonymous that_ent;
-            that_ent->setId(other->getId());
-            that_ent->setStamp(other->getSeq());
-            if (could_see) {
-                // We are losing sight of that object
-                disappear.push_back(that_ent);
-                debug(std::cout << moved_entity.getId() << ": losing sight of "
-                                << other->getId() << std::endl;);
-            } else /*if (can_see)*/ {
-                // We are gaining sight of that object
-                appear.push_back(that_ent);
-                debug(std::cout << moved_entity.getId() << ": gaining sight of "
-                                << other->getId() << std::endl;);
-            }
-        } else {
-            //We've seen this entity before, and we're still seeing it. Check if there are any children that's now changing visibility.
-            if (other->m_contains && !other->m_contains->empty()) {
-                calculateVisibility(appear, disappear, this_ent, *other, moved_entity, old_loc, res);
+    } else {
+        for (const LocatedEntity* other: *parent.m_contains) {
+            if (other == &moved_entity) {
+                continue;
             }
+            assert(other != nullptr);
+            calculateVisibilityForEntity(appear, disappear, this_ent, *other, moved_entity, fromSquSize, new_pos, old_pos, old_loc, res);
         }
     }
 }
@@ -316,6 +549,7 @@ void PhysicalDomain::processVisibilityForMovedEntity(const LocatedEntity& moved_
     this_ent->setId(moved_entity.getId());
     this_ent->setStamp(moved_entity.getSeq());
 
+    syncIndex();
     calculateVisibility(appear, disappear, this_ent, m_entity, moved_entity, old_loc, res);
 
     if (!appear.empty()) {
@@ -347,7 +581,11 @@ void PhysicalDomain::processDisappearanceOfEntity(const LocatedEntity& moved_ent
     const Point3D old_pos = relativePos(m_entity.m_location, old_loc);
 
     assert(m_entity.m_contains != nullptr);
-    for (const LocatedEntity* other: *m_entity.m_contains) {
+    syncIndex();
+    //Only those entities within sight range of the old position need to be told.
+    std::vector<LocatedEntity*> nearby;
+    findNearbyChildren(old_pos, old_loc.boxSize() / consts::sight_factor, nearby);
+    for (const LocatedEntity* other: nearby) {
         //No need to check if we iterate over ourselved; that won't happen if we've disappeared
 
         assert(other != nullptr);
@@ -390,7 +628,24 @@ float PhysicalDomain::checkCollision(LocatedEntity& entity, CollisionData& colli
     if (!entity.m_location.bBox().isValid()) {
         return coll_time;
     }
-    for (LocatedEntity* other_entity : *entity.m_location.m_loc->m_contains) {
+    std::vector<LocatedEntity*> nearby;
+    if (entity.m_location.m_loc == &m_entity) {
+        //Only look at the children which we could reach before the next tick.
+        syncIndex();
+        updatePosition(entity);
+        findNearbyChildren(entity.m_location.pos(), collisionExtent(entity.m_location), nearby);
+    } else {
+        nearby.assign(entity.m_location.m_loc->m_contains->begin(), entity.m_location.m_loc->m_contains->end());
+    }
+    return findCollision(entity, nearby, collisionData);
+}
+
+float PhysicalDomain::findCollision(LocatedEntity& entity, const std::vector<LocatedEntity*>& nearby, CollisionData& collisionData) const
+{
+    float coll_time = consts::move_tick;
+    collisionData.collEntity = nullptr;
+    collisionData.isCollision = false;
+    for (LocatedEntity* other_entity : nearby) {
         // Don't check for collisions with ourselves
         if (&entity == other_entity) {
             continue;
@@ -469,3 +724,180 @@ float PhysicalDomain::checkCollision(LocatedEntity& entity, CollisionData& colli
                      << entity.m_location.velocity() << "*" << coll_time;);
     return coll_time;
 }
+
+float PhysicalDomain::collisionExtent(const Location& location)
+{
+    const BBox& bbox = location.bBox();
+    if (!bbox.isValid()) {
+        return 0.f;
+    }
+    //The radius of a sphere centered on the position which encloses the bbox, regardless of orientation.
+    float x = std::max(std::abs(bbox.lowCorner().x()), std::abs(bbox.highCorner().x())),
+          y = std::max(std::abs(bbox.lowCorner().y()), std::abs(bbox.highCorner().y())),
+          z = std::max(std::abs(bbox.lowCorner().z()), std::abs(bbox.highCorner().z()));
+    float extent = std::sqrt(x * x + y * y + z * z);
+    if (location.velocity().isValid()) {
+        extent += location.velocity().mag() * consts::move_tick;
+    }
+    return extent;
+}
+
+float PhysicalDomain::reach(const Location& location)
+{
+    if (!location.pos().isValid()) {
+        return std::numeric_limits<float>::infinity();
+    }
+    //The distance at which the entity can be seen.
+    float sight_range = location.boxSize() / consts::sight_factor;
+    return std::max(sight_range, collisionExtent(location));
+}
+
+void PhysicalDomain::indexEntity(LocatedEntity& entity)
+{
+    const Point3D& pos = entity.m_location.pos();
+    if (pos.isValid()) {
+        m_grid.insert(&entity, pos.x(), pos.y(), reach(entity.m_location));
+    } else {
+        m_grid.insert(&entity, 0, 0, std::numeric_limits<float>::infinity());
+    }
+}
+
+void PhysicalDomain::syncIndex()
+{
+    if (m_entity.m_contains == nullptr) {
+        if (m_grid.size() != 0) {
+            m_grid.clear();
+        }
+        return;
+    }
+    if (m_grid.size() == m_entity.m_contains->size()) {
+        return;
+    }
+    debug(std::cout << "Rebuilding spatial index for domain " << m_entity.getId() << std::endl;);
+    m_grid.clear();
+    for (LocatedEntity* child : *m_entity.m_contains) {
+        indexEntity(*child);
+    }
+}
+
+void PhysicalDomain::findNearbyChildren(const Point3D& pos, float radius, std::vector<LocatedEntity*>& result) const
+{
+    if (!pos.isValid()) {
+        m_grid.query(0, 0, std::numeric_limits<float>::infinity(), result);
+    } else {
+        m_grid.query(pos.x(), pos.y(), radius, result);
+    }
+    //Keep the same order as when iterating over the "contains" set, so that the resulting operations are the same.
+    std::sort(result.begin(), result.end());
+}
+
+void PhysicalDomain::addEntity(LocatedEntity& entity)
+{
+    if (entity.m_location.m_loc == &m_entity) {
+        indexEntity(entity);
+    }
+}
+
+void PhysicalDomain::removeEntity(LocatedEntity& entity)
+{
+    m_grid.remove(&entity);
+    removeMovingEntity(entity);
+}
+
+void PhysicalDomain::updatePosition(LocatedEntity& entity)
+{
+    if (entity.m_location.m_loc == &m_entity) {
+        indexEntity(entity);
+        auto I = m_moverIndex.find(&entity);
+        if (I != m_moverIndex.end()) {
+            storeMover(I->second);
+        }
+    }
+}
+
+bool PhysicalDomain::addMovingEntity(LocatedEntity& entity, long refno)
+{
+    //Only direct children are moved; anything further down is handled by its own Update operations.
+    if (entity.m_location.m_loc != &m_entity || !entity.m_location.pos().isValid() ||
+        !entity.m_location.velocity().isValid()) {
+        return false;
+    }
+    auto I = m_moverIndex.find(&entity);
+    std::size_t index;
+    if (I != m_moverIndex.end()) {
+        index = I->second;
+    } else {
+        index = m_movers.size();
+        m_moverIndex.insert(std::make_pair(&entity, index));
+        m_movers.push_back(&entity);
+        m_moverPos.push_back(Point3D());
+        m_moverVelocity.push_back(Vector3D());
+        m_moverTimeStamp.push_back(0.);
+        m_moverExtent.push_back(0.f);
+        m_moverRefno.push_back(0);
+    }
+    m_moverRefno[index] = refno;
+    storeMover(index);
+    if (DomainSimulation::instance() != nullptr) {
+        DomainSimulation::instance()->addDomain(*this);
+    } else {
+        scheduleMovementTick();
+    }
+    return true;
+}
+
+void PhysicalDomain::removeMovingEntity(LocatedEntity& entity)
+{
+    auto I = m_moverIndex.find(&entity);
+    if (I == m_moverIndex.end()) {
+        return;
+    }
+    //Move the last entity into the freed slot.
+    std::size_t index = I->second;
+    std::size_t last = m_movers.size() - 1;
+    m_moverIndex.erase(I);
+    if (index != last) {
+        m_movers[index] = m_movers[last];
+        m_moverPos[index] = m_moverPos[last];
+        m_moverVelocity[index] = m_moverVelocity[last];
+        m_moverTimeStamp[index] = m_moverTimeStamp[last];
+        m_moverExtent[index] = m_moverExtent[last];
+        m_moverRefno[index] = m_moverRefno[last];
+        m_moverIndex[m_movers[index]] = index;
+    }
+    m_movers.pop_back();
+    m_moverPos.pop_back();
+    m_moverVelocity.pop_back();
+    m_moverTimeStamp.pop_back();
+    m_moverExtent.pop_back();
+    m_moverRefno.pop_back();
+}
+
+void PhysicalDomain::releaseMovingEntities()
+{
+    //Hand the moving entities back to their own Update operations, so they don't stop dead.
+    std::vector<LocatedEntity*> movers;
+    movers.swap(m_movers);
+    std::vector<long> refnos;
+    refnos.swap(m_moverRefno);
+    m_moverIndex.clear();
+    m_moverPos.clear();
+    m_moverVelocity.clear();
+    m_moverTimeStamp.clear();
+    m_moverExtent.clear();
+    for (std::size_t i = 0; i < movers.size(); ++i) {
+        Update u;
+        u->setTo(movers[i]->getId());
+        u->setRefno(refnos[i]);
+        BaseWorld::instance().message(u, *movers[i]);
+    }
+}
+
+void PhysicalDomain::storeMover(std::size_t index)
+{
+    const Location& location = m_movers[index]->m_location;
+    m_moverPos[index] = location.pos();
+    m_moverVelocity[index] = location.velocity();
+    m_moverTimeStamp[index] = location.timeStamp();
+    m_moverExtent[index] = collisionExtent(location);
+}
@@ -19,6 +19,12 @@
 #define PHYSICALDOMAIN_H_
 
 #include "Domain.h"
+#include "SpatialGrid.h"
+
+#include "modules/Location.h"
+
+#include <unordered_map>
+#include <vector>
 
 /**
  * @brief A regular physical domain, behaving very much like the real world.
@@ -35,6 +41,14 @@ class PhysicalDomain: public Domain
         virtual float constrainHeight(LocatedEntity *, const Point3D &,
                 const std::string &);
 
+        /**
+         * @brief Moves all entities added through addMovingEntity() to where they are at time "t".
+         *
+         * Sight(Move) operations are sent for the entities, and visibility changes
+         * are calculated for perceptive ones. It's called every consts::move_tick
+         * seconds while there are moving entities.
+         * @param t The current world time.
+         */
         virtual void tick(double t);
 
         virtual void lookAtEntity(const LocatedEntity& observingEntity,
@@ -55,8 +69,175 @@ class PhysicalDomain: public Domain
         virtual float checkCollision(LocatedEntity& entity,
                 CollisionData& collisionData);
 
+        virtual void addEntity(LocatedEntity& entity);
+
+        virtual void removeEntity(LocatedEntity& entity);
+
+        virtual void updatePosition(LocatedEntity& entity);
+
+        virtual bool findObserverCandidates(const LocatedEntity& observedEntity,
+                std::vector<LocatedEntity*>& candidates);
+
+        virtual bool addMovingEntity(LocatedEntity& entity, long refno);
+
+        virtual void removeMovingEntity(LocatedEntity& entity);
+
+        virtual void releaseMovingEntities();
+
+        /**
+         * @brief Checks if moving the entities of this domain only touches the domain and its children.
+         *
+         * If so simulateMovement() can be run for this domain at the same time as for other
+         * such domains, as long as it isn't inside another domain which is being moved.
+         * @return True if the domain is isolated.
+         */
+        bool isIsolated() const;
+
+        /**
+         * @brief Moves the entities and checks for collisions; the first half of tick().
+         *
+         * No operations are sent, so that this can be run on a worker thread.
+         * @param t The current world time.
+         */
+        void simulateMovement(double t);
+
+        /**
+         * @brief Sends the results of simulateMovement(); the second half of tick().
+         */
+        void sendMovement();
+
+        /**
+         * @brief Checks if there are any entities for tick() to move.
+         */
+        bool hasMovingEntities() const {
+            return !m_movers.empty();
+        }
+
     private:
 
+        /**
+         * @brief Spatial index of the direct children of the domain entity.
+         *
+         * This allows visibility and collision calculations to only look at
+         * children which are near the moved entity, instead of all of them.
+         */
+        SpatialGrid m_grid;
+
+        /**
+         * @name Moving entities
+         *
+         * The direct children which are moved by tick(), kept as a structure of
+         * arrays so that their movement can be integrated in one pass. Each
+         * vector has one element per entity, in the same order.
+         */
+        ///@{
+        std::vector<LocatedEntity*> m_movers;
+        std::vector<Point3D> m_moverPos;
+        std::vector<Vector3D> m_moverVelocity;
+        std::vector<double> m_moverTimeStamp;
+        /// The collision extent of each entity, or zero if it can't collide.
+        std::vector<float> m_moverExtent;
+        /// The refno to use when handing each entity back to its Update operations.
+        std::vector<long> m_moverRefno;
+        ///@}
+
+        /**
+         * @name Results of simulateMovement()
+         */
+        ///@{
+        /// Whether a collision is due for each moving entity.
+        std::vector<bool> m_moverColliding;
+        /// The indices of the moved entities which are perceptive.
+        std::vector<std::size_t> m_movedPerceptive;
+        /// The locations of the perceptive entities before they were moved.
+        std::vector<Location> m_movedOldLocations;
+        ///@}
+
+        /**
+         * @brief Index of each moving entity in the arrays above.
+         */
+        std::unordered_map<const LocatedEntity*, std::size_t> m_moverIndex;
+
+        /**
+         * @brief True if a movement Tick operation has been sent to the domain entity, and not yet handled.
+         */
+        bool m_movementTickPending;
+
+        /**
+         * @brief Calculates how far from its position an entity might collide with others during the next movement tick.
+         * @param location The location of the entity.
+         * @return The collision extent, or zero if the entity has no bbox.
+         */
+        static float collisionExtent(const Location& location);
+
+        /**
+         * @brief Calculates how far from its position an entity can affect others.
+         *
+         * This is the largest of the distance at which the entity can be seen,
+         * and the distance within which it might collide with something during
+         * the next movement tick.
+         * @param location The location of the entity.
+         * @return The reach of the entity.
+         */
+        static float reach(const Location& location);
+
+        /**
+         * @brief Checks if an entity is outfitted or wielded by its parent.
+         *
+         * Such entities can be seen regardless of their size.
+         * @param entity The entity.
+         * @return True if the entity is outfitted or wielded.
+         */
+        static bool isOutfittedOrWielded(const LocatedEntity& entity);
+
+        /**
+         * @brief Sends a Tick operation to the domain entity, which calls tick() when it arrives.
+         *
+         * Nothing is sent if such an operation is already pending.
+         */
+        void scheduleMovementTick();
+
+        /**
+         * @brief Copies the location data of a moving entity into the arrays.
+         * @param index The index of the entity in the arrays.
+         */
+        void storeMover(std::size_t index);
+
+        /**
+         * @brief Checks for a collision between an entity and others.
+         *
+         * See checkCollision() for the parameters.
+         * @param nearby The entities to check against.
+         */
+        float findCollision(LocatedEntity& entity,
+                const std::vector<LocatedEntity*>& nearby,
+                CollisionData& collisionData) const;
+
+        /**
+         * @brief Inserts or updates an entity in the spatial index.
+         * @param entity A direct child of the domain entity.
+         */
+        void indexEntity(LocatedEntity& entity);
+
+        /**
+         * @brief Makes sure that the spatial index covers all children of the domain entity.
+         *
+         * Children can be added without the domain being notified (for example when the
+         * domain itself is created after the children); if so the index is rebuilt.
+         */
+        void syncIndex();
+
+        /**
+         * @brief Finds the children of the domain entity which might be within a distance of a point.
+         *
+         * The result is sorted in the same order as the "contains" set of the domain entity.
+         * @param pos The point, in the coordinate system of the domain entity.
+         * @param radius The distance.
+         * @param result A vector to which the children are added.
+         */
+        void findNearbyChildren(const Point3D& pos, float radius,
+                std::vector<LocatedEntity*>& result) const;
+
         /**
          * @brief Calculates visibility changes for the moved entity, processing the children of the "parent" parameter.
          * @param appear A list of appear ops, to be filled.
@@ -73,6 +254,18 @@ class PhysicalDomain: public Domain
                 const LocatedEntity& parent, const LocatedEntity& moved_entity,
                 const Location& old_loc, OpVector & res) const;
 
+        /**
+         * @brief Calculates visibility changes between the moved entity and one other entity.
+         *
+         * See calculateVisibility() for the parameters.
+         */
+        void calculateVisibilityForEntity(std::vector<Atlas::Objects::Root>& appear,
+                std::vector<Atlas::Objects::Root>& disappear,
+                Atlas::Objects::Entity::Anonymous& this_ent,
+                const LocatedEntity& other, const LocatedEntity& moved_entity,
+                float fromSquSize, const Point3D& new_pos, const Point3D& old_pos,
+                const Location& old_loc, OpVector & res) const;
+
 };
 
 #endif /* PHYSICALDOMAIN_H_ */
@@ -39,10 +39,14 @@ static PyObject * match_entity(PyFilter * self, PyObject * py_entity)
 
     //Not sure if this is safest or the most correct way to get an entity pointer
     LocatedEntity* entity = ((PyEntity*)py_entity)->m_entity.l;
+    if (entity == NULL) {
+        PyErr_SetString(PyExc_RuntimeError, "entity has been destroyed");
+        return NULL;
+    }
 
     EntityFilter::Filter* filter = self->m_filter;
 
-    if (entity && filter->match(*entity)) {
+    if (filter->match(*entity)) {
         Py_INCREF(Py_True);
         return Py_True;
     } else {
@@ -73,6 +77,10 @@ PyObject* search_contains(PyFilter* self, PyEntity* py_entity){
         return NULL;
     }
     LocatedEntity* ent = py_entity->m_entity.l;
+    if (ent == NULL) {
+        PyErr_SetString(PyExc_RuntimeError, "entity has been destroyed");
+        return NULL;
+    }
 
     if(!ent->m_contains){
         return PyList_New(0);
@@ -347,27 +347,9 @@ static PyObject * Map_find_by_location_query(PyMap* self, PyObject* args){
     }
 
     //Create a vector and fill it with entities that match the given filter and are in range
-    float square_range = radius * radius;
     EntityVector res;
-    LocatedEntity* place = where->location->m_loc;
-    if (place != 0) {
-
-        auto iter = place->m_contains->begin();
-        auto iter_end = place->m_contains->end();
-
-        for (; iter != iter_end; ++iter) {
-            LocatedEntity* item = *iter;
-            if (item == 0) {
-                continue;
-            }
-            if (!item->isVisible() || !f->m_filter->match(*item)) {
-                continue;
-            }
-            if (squareDistance(where->location->pos(), item->m_location.pos()) < square_range) {
-                res.push_back(item);
-            }
-        }
-    }
+    self->m_map->findNear(*where->location, radius, res);
+    f->m_filter->filter(res);
 
     //Create a python list an fill it with the entities we got
     PyObject * list = PyList_New(res.size());
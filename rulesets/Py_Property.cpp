@@ -27,47 +27,83 @@
 
 #include <iostream>
 
-PyObject * Property_asPyObject(PropertyBase * property, Entity * owner)
+static PyObject * wrapStatisticsProperty(PropertyBase * property,
+                                         Entity * owner)
+{
+    StatisticsProperty * sp = static_cast<StatisticsProperty *>(property);
+    PythonArithmeticScript * script = dynamic_cast<PythonArithmeticScript *>(sp->script());
+    if (script != 0) {
+        PyObject * o = script->script();
+        Py_INCREF(o);
+        return o;
+    } else {
+        log(ERROR, "Unexpected non-python Statistics script");
+        // FIXME Do we need PyStatisticsProperty for this kind of thing?
+        // PyStatistics * ps = newPyStatistics();
+        // if (ps == NULL) {
+            // return NULL;
+        // }
+        // ps->m_entity = owner;
+        // return (PyObject*)ps;
+        Py_INCREF(Py_None);
+        return Py_None;
+    }
+}
+
+static PyObject * wrapTerrainProperty(PropertyBase * property, Entity * owner)
+{
+    // Create a new python wrapper for this property.
+    PyProperty * prop = newPyTerrainProperty();
+    if (prop != NULL) {
+        prop->m_entity = owner;
+        prop->m_p.terrain = static_cast<TerrainProperty *>(property);
+    }
+    return (PyObject*)prop;
+}
+
+static PyObject * wrapTerrainModProperty(PropertyBase * property,
+                                         Entity * owner)
+{
+    // Create a new python wrapper for this property
+    PyProperty * prop = newPyTerrainModProperty();
+    if (prop != NULL) {
+        prop->m_entity = owner;
+        prop->m_p.terrainmod = static_cast<TerrainModProperty *>(property);
+    }
+    return (PyObject*)prop;
+}
+
+typedef PyObject * (*PropertyWrapper)(PropertyBase *, Entity *);
+
+/// \brief Get the function which gives a python wrapper for a property,
+/// or null if scripts should be given its value instead.
+static PropertyWrapper propertyWrapper(const PropertyBase * property)
 {
-    StatisticsProperty * sp = dynamic_cast<StatisticsProperty *>(property);
-    if (sp != 0) {
-        PythonArithmeticScript * script = dynamic_cast<PythonArithmeticScript *>(sp->script());
-        if (script != 0) {
-            PyObject * o = script->script();
-            Py_INCREF(o);
-            return o;
-        } else {
-            log(ERROR, "Unexpected non-python Statistics script");
-            // FIXME Do we need PyStatisticsProperty for this kind of thing?
-            // PyStatistics * ps = newPyStatistics();
-            // if (ps == NULL) {
-                // return NULL;
-            // }
-            // ps->m_entity = owner;
-            // return (PyObject*)ps;
-            Py_INCREF(Py_None);
-            return Py_None;
-        }
+    if (dynamic_cast<const StatisticsProperty *>(property) != 0) {
+        return &wrapStatisticsProperty;
     }
-    TerrainProperty * tp = dynamic_cast<TerrainProperty *>(property);
-    if (tp != 0) {
-        // Create a new python wrapper for this property.
-        PyProperty * prop = newPyTerrainProperty();
-        if (prop != NULL) {
-            prop->m_entity = owner;
-            prop->m_p.terrain = tp;
-        }
-        return (PyObject*)prop;
+    if (dynamic_cast<const TerrainProperty *>(property) != 0) {
+        return &wrapTerrainProperty;
     }
-    TerrainModProperty * tm = dynamic_cast<TerrainModProperty *>(property);
-    if (tm != 0) {
-        // Create a new python wrapper for this property
-        PyProperty * prop = newPyTerrainModProperty();
-        if (prop != NULL) {
-            prop->m_entity = owner;
-            prop->m_p.terrainmod = tm;
-        }
-        return (PyObject*)prop;
+    if (dynamic_cast<const TerrainModProperty *>(property) != 0) {
+        return &wrapTerrainModProperty;
     }
     return 0;
 }
+
+/// \brief Check whether Property_asPyObject() gives a wrapper for a
+/// property, through which scripts can modify it, rather than leaving
+/// the caller to convert its value.
+bool Property_hasPyObject(const PropertyBase * property)
+{
+    return propertyWrapper(property) != 0;
+}
+
+PyObject * Property_asPyObject(PropertyBase * property, Entity * owner)
+{
+    PropertyWrapper wrapper = propertyWrapper(property);
+    if (wrapper == 0) {
+        return 0;
+    }
+    return wrapper(property, owner);
+}
@@ -55,6 +55,7 @@ extern PyTypeObject PyTerrainModProperty_Type;
 #define PyTerrainModProperty_CheckExact(_o) (Py_Type(_o) == &PyTerrainModProperty_Type)
 
 PyObject * Property_asPyObject(PropertyBase * property, Entity * owner);
+bool Property_hasPyObject(const PropertyBase * property);
 
 PyProperty * newPyTerrainProperty();
 PyProperty * newPyTerrainModProperty();
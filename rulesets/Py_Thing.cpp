@@ -40,17 +40,18 @@
 #include "common/TypeNode.h"
 #include "common/Inheritance.h"
 
+#include <map>
+#include <typeinfo>
+
 using Atlas::Message::Element;
 using Atlas::Message::MapType;
 
 static PyObject * Entity_as_entity(PyEntity * self)
 {
-#ifndef NDEBUG
     if (self->m_entity.l == NULL) {
-        PyErr_SetString(PyExc_AssertionError, "NULL entity in Entity.as_entity");
+        PyErr_SetString(PyExc_RuntimeError, "entity has been destroyed");
         return NULL;
     }
-#endif // NDEBUG
     PyMessage * ret = newPyMessage();
     if (ret != NULL) {
         ret->m_obj = new Element(MapType());
@@ -66,12 +67,10 @@ static PyMethodDef LocatedEntity_methods[] = {
 
 static PyObject * Entity_send_world(PyEntity * self, PyOperation * op)
 {
-#ifndef NDEBUG
     if (self->m_entity.e == NULL) {
-        PyErr_SetString(PyExc_AssertionError, "NULL entity in Entity.send_world");
+        PyErr_SetString(PyExc_RuntimeError, "entity has been destroyed");
         return NULL;
     }
-#endif // NDEBUG
     if (PyOperation_Check(op)) {
         self->m_entity.e->sendWorld(op->operation);
     } else {
@@ -89,12 +88,10 @@ static PyMethodDef Entity_methods[] = {
 
 static PyObject * Character_start_task(PyEntity * self, PyObject * args)
 {
-#ifndef NDEBUG
     if (self->m_entity.l == NULL) {
-        PyErr_SetString(PyExc_AssertionError, "NULL entity in Entity.start_task");
+        PyErr_SetString(PyExc_RuntimeError, "entity has been destroyed");
         return NULL;
     }
-#endif // NDEBUG
     PyObject * task;
     PyObject * op;
     PyObject * res;
@@ -122,12 +119,10 @@ static PyObject * Character_start_task(PyEntity * self, PyObject * args)
 
 static PyObject * Character_mind2body(PyEntity * self, PyOperation * op)
 {
-#ifndef NDEBUG
     if (self->m_entity.l == NULL) {
-        PyErr_SetString(PyExc_AssertionError, "NULL entity in Entity.mind2body");
+        PyErr_SetString(PyExc_RuntimeError, "entity has been destroyed");
         return NULL;
     }
-#endif // NDEBUG
     if (!PyOperation_Check(op)) {
          PyErr_SetString(PyExc_TypeError, "Entity.mind2body must be an operation");
          return NULL;
@@ -180,12 +175,10 @@ static void Entity_dealloc(PyEntity *self)
 
 static PyObject * Entity_getattro(PyEntity *self, PyObject *oname)
 {
-#ifndef NDEBUG
     if (self->m_entity.e == NULL) {
-        PyErr_SetString(PyExc_AssertionError, "NULL entity in Entity.getattr");
+        PyErr_SetString(PyExc_RuntimeError, "entity has been destroyed");
         return NULL;
     }
-#endif // NDEBUG
     char * name = PyString_AsString(oname);
     // If operation search gets to here, it goes no further
     if (strcmp(name, "type") == 0) {
@@ -240,11 +233,17 @@ static PyObject * Entity_getattro(PyEntity *self, PyObject *oname)
         Py_RETURN_FALSE;
     }
     Entity * entity = self->m_entity.e;
-    PropertyBase * prop = entity->modProperty(name);
+    // Reading a value must not give the entity its own copy of a class
+    // property. Only wrapped properties, which scripts can modify through
+    // the wrapper, are copied, as setting an attribute would.
+    const PropertyBase * prop = entity->getProperty(name);
     if (prop != 0) {
-        PyObject * ret = Property_asPyObject(prop, entity);
-        if (ret != 0) {
-            return ret;
+        if (Property_hasPyObject(prop)) {
+            PyObject * ret = Property_asPyObject(entity->modProperty(name),
+                                                 entity);
+            if (ret != 0) {
+                return ret;
+            }
         }
         Element attr;
         // If this property is not set with a value, return none.
@@ -260,12 +259,10 @@ static PyObject * Entity_getattro(PyEntity *self, PyObject *oname)
 
 static int Entity_setattro(PyEntity *self, PyObject *oname, PyObject *v)
 {
-#ifndef NDEBUG
     if (self->m_entity.e == NULL) {
-        PyErr_SetString(PyExc_AssertionError, "NULL entity in Entity.setattr");
+        PyErr_SetString(PyExc_RuntimeError, "entity has been destroyed");
         return -1;
     }
-#endif // NDEBUG
     char * name = PyString_AsString(oname);
     if (strcmp(name, "map") == 0) {
         PyErr_SetString(PyExc_AttributeError, "map attribute forbidden");
@@ -308,7 +305,7 @@ static int Entity_setattro(PyEntity *self, PyObject *oname, PyObject *v)
 static int Entity_compare(PyEntity *self, PyEntity *other)
 {
     if (self->m_entity.e == NULL || other->m_entity.e == NULL) {
-        PyErr_SetString(PyExc_AssertionError, "NULL Entity in Entity.compare");
+        PyErr_SetString(PyExc_RuntimeError, "entity has been destroyed");
         return -1;
     }
     return (self->m_entity.e == other->m_entity.e) ? 0 : 1;
@@ -348,12 +345,10 @@ static int Entity_init(PyEntity * self, PyObject * args, PyObject * kwds)
     }
     if (PyEntity_Check(arg)) {
         PyEntity * character = (PyEntity *)arg;
-#ifndef NDEBUG
         if (character->m_entity.c == NULL) {
-            PyErr_SetString(PyExc_AssertionError, "NULL character Task.__init__");
+            PyErr_SetString(PyExc_RuntimeError, "entity has been destroyed");
             return -1;
         }
-#endif // NDEBUG
         self->m_entity.c = character->m_entity.c;
         return 0;
     }
@@ -380,12 +375,10 @@ static int Character_init(PyEntity * self, PyObject * args, PyObject * kwds)
     }
     if (PyCharacter_Check(arg)) {
         PyEntity * character = (PyEntity *)arg;
-#ifndef NDEBUG
         if (character->m_entity.c == NULL) {
-            PyErr_SetString(PyExc_AssertionError, "NULL character Task.__init__");
+            PyErr_SetString(PyExc_RuntimeError, "entity has been destroyed");
             return -1;
         }
-#endif // NDEBUG
         self->m_entity.c = character->m_entity.c;
         return 0;
     }
@@ -396,12 +389,10 @@ static int Character_init(PyEntity * self, PyObject * args, PyObject * kwds)
 
 static PyObject * Mind_getattro(PyEntity *self, PyObject *oname)
 {
-#ifndef NDEBUG
     if (self->m_entity.m == NULL) {
-        PyErr_SetString(PyExc_AssertionError, "NULL mind in Mind.getattr");
+        PyErr_SetString(PyExc_RuntimeError, "entity has been destroyed");
         return NULL;
     }
-#endif // NDEBUG
     char * name = PyString_AsString(oname);
     if (strcmp(name, "id") == 0) {
         return (PyObject *)PyString_FromString(self->m_entity.m->getId().c_str());
@@ -484,12 +475,10 @@ static int Mind_setattro(PyEntity *self, PyObject *oname, PyObject *v)
         self->m_entity.m = ((PyEntity*)v)->m_entity.m;
         return 0;
     }
-#ifndef NDEBUG
     if (self->m_entity.m == NULL) {
-        PyErr_SetString(PyExc_AssertionError, "NULL mind in Mind.setattr");
+        PyErr_SetString(PyExc_RuntimeError, "entity has been destroyed");
         return -1;
     }
-#endif // NDEBUG
     if (strcmp(name, "map") == 0) {
         PyErr_SetString(PyExc_AttributeError, "Setting map on mind is forbidden");
         return -1;
@@ -515,7 +504,7 @@ static int Mind_setattro(PyEntity *self, PyObject *oname, PyObject *v)
 static int Mind_compare(PyEntity *self, PyEntity *other)
 {
     if (self->m_entity.m == NULL || other->m_entity.m == NULL) {
-        PyErr_SetString(PyExc_AssertionError, "NULL mind in Mind.compare");
+        PyErr_SetString(PyExc_RuntimeError, "entity has been destroyed");
         return -1;
     }
     return (self->m_entity.m == other->m_entity.m) ? 0 : 1;
@@ -709,26 +698,48 @@ PyTypeObject PyMind_Type = {
         (newfunc)Entity_new,            // tp_new
 };
 
+/// \brief Python type used to wrap each C++ class of entity
+///
+/// The class of an entity is only checked with dynamic_cast the first time
+/// an entity of that class is wrapped.
+typedef std::map<const std::type_info *, PyTypeObject *> WrapperTypeMap;
+
+static WrapperTypeMap wrapper_types;
+
+static PyTypeObject * wrapperType(LocatedEntity * le)
+{
+    const std::type_info * cls = &typeid(*le);
+    WrapperTypeMap::const_iterator I = wrapper_types.find(cls);
+    if (I != wrapper_types.end()) {
+        return I->second;
+    }
+    PyTypeObject * type = &PyLocatedEntity_Type;
+    if (dynamic_cast<Character *>(le) != 0) {
+        type = &PyCharacter_Type;
+    } else if (dynamic_cast<Entity *>(le) != 0) {
+        type = &PyEntity_Type;
+    }
+    wrapper_types.insert(std::make_pair(cls, type));
+    return type;
+}
+
 template<>
 PyObject * wrapPython<LocatedEntity>(LocatedEntity * le)
 {
     PyEntity * pe;
-    Entity * entity = dynamic_cast<Entity *>(le);
-    if (entity != 0) {
-        Character * ch_entity = dynamic_cast<Character *>(entity);
-        if (ch_entity != 0) {
-            pe = newPyCharacter();
-            if (pe == NULL) {
-                return NULL;
-            }
-            pe->m_entity.c = ch_entity;
-        } else {
-            pe = newPyEntity();
-            if (pe == NULL) {
-                return NULL;
-            }
-            pe->m_entity.e = entity;
+    PyTypeObject * type = wrapperType(le);
+    if (type == &PyCharacter_Type) {
+        pe = newPyCharacter();
+        if (pe == NULL) {
+            return NULL;
+        }
+        pe->m_entity.c = static_cast<Character *>(le);
+    } else if (type == &PyEntity_Type) {
+        pe = newPyEntity();
+        if (pe == NULL) {
+            return NULL;
         }
+        pe->m_entity.e = static_cast<Entity *>(le);
     } else {
         pe = newPyLocatedEntity();
         if (pe == NULL) {
@@ -22,6 +22,7 @@
 
 #include "common/log.h"
 #include "common/compose.hpp"
+#include "common/ScriptProfiler.h"
 
 #include <iostream>
 
@@ -44,7 +45,12 @@ PythonArithmeticScript::~PythonArithmeticScript()
 int PythonArithmeticScript::attribute(const std::string & name, float & val)
 {
     PyObject * pn = PyString_FromString(name.c_str());
-    PyObject * ret = PyObject_GenericGetAttr(m_script, pn);
+    PyObject * ret;
+    {
+        // Attributes may be properties which run script code
+        ScriptProfile profile(Py_TYPE(m_script)->tp_name, name);
+        ret = PyObject_GenericGetAttr(m_script, pn);
+    }
     Py_DECREF(pn);
     if (ret == NULL) {
         if (PyErr_Occurred() == NULL) {
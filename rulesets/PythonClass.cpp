@@ -19,6 +19,7 @@
 #include <Python.h>
 
 #include "PythonClass.h"
+#include "PythonEntityScript.h"
 
 #include "rulesets/Python_Script_Utils.h"
 
@@ -117,5 +118,8 @@ int PythonClass::refresh()
                                      m_package, m_type));
         m_module = new_module;
     }
+    // Scripts created from now on use the new class, and its handlers may
+    // differ from those looked up on the old one.
+    PythonEntityScript::flushHandlers();
     return 0;
 }
@@ -30,6 +30,7 @@
 #include "common/debug.h"
 #include "common/compose.hpp"
 #include "common/OperationRouter.h"
+#include "common/ScriptProfiler.h"
 
 #include <Atlas/Objects/RootOperation.h>
 
@@ -47,30 +48,144 @@ PythonEntityScript::~PythonEntityScript()
 {
 }
 
+std::map<PyTypeObject *, PythonEntityScript::HandlerMap>
+PythonEntityScript::s_handlers;
+
+/// \brief Check if a class finds attributes with the generic lookup
+///
+/// The entity wrappers look up a few fixed names and the entity's
+/// properties before the generic lookup, none of which are handlers. A
+/// class which defines __getattr__ or __getattribute__ has a different
+/// lookup, so is not generic.
+static bool hasGenericGetAttr(PyTypeObject * type)
+{
+    getattrofunc getattro = type->tp_getattro;
+    return getattro == PyObject_GenericGetAttr ||
+           getattro == PyLocatedEntity_Type.tp_getattro ||
+           getattro == PyMind_Type.tp_getattro;
+}
+
+/// \brief Check if a class has not changed since it was looked up
+static bool versionValid(PyTypeObject * type, unsigned int version)
+{
+    return version != 0 &&
+           PyType_HasFeature(type, Py_TPFLAGS_VALID_VERSION_TAG) &&
+           type->tp_version_tag == version;
+}
+
+/// \brief Find the attribute of the script class which handles an operation
+///
+/// The result is kept, so the class is only searched the first time each
+/// operation is handled by a script of that class, and again only if the
+/// class is changed. Only the class is searched, so handlers set on the
+/// script itself, or provided by __getattr__, are not found here.
+/// @param op_type name of the operation
+/// @return the handler, whose function is NULL if the class has none
+const PythonEntityScript::Handler &
+PythonEntityScript::findHandler(const std::string & op_type)
+{
+    PyTypeObject * type = Py_TYPE(m_wrapper);
+    auto I = s_handlers.find(type);
+    if (I == s_handlers.end()) {
+        // Keep the class alive, so another can't reuse its address while
+        // its handlers are kept.
+        Py_INCREF(type);
+        I = s_handlers.insert(std::make_pair(type, HandlerMap())).first;
+    }
+    HandlerMap & handlers = I->second;
+    auto J = handlers.find(op_type);
+    if (J == handlers.end()) {
+        std::string op_name = op_type + "_operation";
+        Handler handler{op_name,
+                        PyString_InternFromString(op_name.c_str()),
+                        NULL, 0, false};
+        J = handlers.insert(std::make_pair(op_type, handler)).first;
+    } else if (versionValid(type, J->second.version)) {
+        return J->second;
+    }
+    Handler & handler = J->second;
+    Py_XDECREF(handler.function);
+    handler.function = _PyType_Lookup(type, handler.name);
+    Py_XINCREF(handler.function);
+    // The lookup gives the class a version tag if it can, which changes
+    // when an attribute of the class or its bases is set.
+    handler.version = PyType_HasFeature(type, Py_TPFLAGS_VALID_VERSION_TAG) ?
+                      type->tp_version_tag : 0;
+    handler.generic = hasGenericGetAttr(type);
+    return handler;
+}
+
+/// \brief Forget the handlers looked up for all script classes
+///
+/// Called when script classes have been reloaded.
+void PythonEntityScript::flushHandlers()
+{
+    for (auto & entry : s_handlers) {
+        for (auto & handler : entry.second) {
+            Py_XDECREF(handler.second.function);
+            Py_DECREF(handler.second.name);
+        }
+        Py_DECREF(entry.first);
+    }
+    s_handlers.clear();
+}
+
+/// \brief Check if an attribute is set on a Python object itself
+static bool hasInstanceAttr(PyObject * o, PyObject * name)
+{
+    PyObject ** dictptr = _PyObject_GetDictPtr(o);
+    return dictptr != NULL && *dictptr != NULL &&
+           PyDict_GetItem(*dictptr, name) != NULL;
+}
+
 bool PythonEntityScript::operation(const std::string & op_type,
                                    const Operation & op,
                                    OpVector & res)
 {
     assert(m_wrapper != NULL);
-    std::string op_name = op_type + "_operation";
-    debug( std::cout << "Got script object for " << op_name << std::endl
-                                                            << std::flush;);
-    // This check isn't really necessary, except it saves the conversion
-    // time.
-    if (!PyObject_HasAttrString(m_wrapper, (char *)(op_name.c_str()))) {
-        debug( std::cout << "No method to be found for " << op_name
+    const Handler & h = findHandler(op_type);
+    bool own = hasInstanceAttr(m_wrapper, h.name);
+    if (h.function == NULL && !own && h.generic) {
+        // Nothing else could provide the handler.
+        return false;
+    }
+    // A function on the class can be called directly, unless the script
+    // has its own attribute of the same name. Anything else, including
+    // handlers the class lookup can't see, is found by name.
+    bool direct = !own && h.function != NULL && PyFunction_Check(h.function);
+    if (!direct && !PyObject_HasAttr(m_wrapper, h.name)) {
+        debug( std::cout << "No method to be found for " << h.opName
                          << std::endl << std::flush;);
         return false;
     }
+    // Rules may be reloaded while the handler runs, which forgets the
+    // handler, so keep what is needed from it.
+    std::string op_name = h.opName;
+    PyObject * handler = direct ? h.function : h.name;
+    Py_INCREF(handler);
+    debug( std::cout << "Got script object for " << op_name << std::endl
+                                                            << std::flush;);
     // Construct apropriate python object thingies from op
     PyOperation * py_op = newPyConstOperation();
     if (py_op == 0) {
+        Py_DECREF(handler);
         return false;
     }
     py_op->operation = op;
     PyObject * ret;
-    ret = PyObject_CallMethod(m_wrapper, (char *)(op_name.c_str()),
-                                            (char *)"(O)", py_op);
+    {
+        ScriptProfile profile(Py_TYPE(m_wrapper)->tp_name, op_name);
+        if (direct) {
+            // Call the function directly, rather than binding a method
+            // to the script each time.
+            ret = PyObject_CallFunctionObjArgs(handler, m_wrapper, py_op,
+                                               NULL);
+        } else {
+            ret = PyObject_CallMethodObjArgs(m_wrapper, handler, py_op,
+                                             NULL);
+        }
+    }
+    Py_DECREF(handler);
     Py_DECREF(py_op);
     if (ret == NULL) {
         if (PyErr_Occurred() == NULL) {
@@ -122,10 +237,14 @@ void PythonEntityScript::hook(const std::string & function,
         return;
     }
 
-    PyObject * ret = PyObject_CallMethod(m_wrapper,
-                                         (char *)(function.c_str()),
-                                         (char *)"(O)",
-                                         wrapper);
+    PyObject * ret;
+    {
+        ScriptProfile profile(Py_TYPE(m_wrapper)->tp_name, function);
+        ret = PyObject_CallMethod(m_wrapper,
+                                  (char *)(function.c_str()),
+                                  (char *)"(O)",
+                                  wrapper);
+    }
     Py_DECREF(wrapper);
     if (ret == NULL) {
         if (PyErr_Occurred() == NULL) {
@@ -21,9 +21,37 @@
 
 #include "PythonWrapper.h"
 
+#include <map>
+#include <string>
+#include <unordered_map>
+
 /// \brief Script class for Python scripts attached to an Entity
 /// \ingroup Scripts
 class PythonEntityScript : public PythonWrapper {
+  protected:
+    /// \brief An operation handler looked up on a script class
+    struct Handler {
+        /// \brief Name of the handler, such as "sight_operation"
+        std::string opName;
+        /// \brief Interned Python string of the name
+        struct _object * name;
+        /// \brief The class attribute, or NULL if the class has none
+        struct _object * function;
+        /// \brief Version tag of the class when it was looked up, or 0
+        unsigned int version;
+        /// \brief Set if the class finds attributes only on the class and
+        /// the instance dictionary, so a missing handler really is missing
+        bool generic;
+    };
+
+    /// \brief Operation handlers looked up on a script class, by the name
+    /// of the operation
+    typedef std::unordered_map<std::string, Handler> HandlerMap;
+
+    /// \brief Handlers looked up so far for each script class
+    static std::map<struct _typeobject *, HandlerMap> s_handlers;
+
+    const Handler & findHandler(const std::string & op_type);
   public:
     explicit PythonEntityScript(PyObject *);
     virtual ~PythonEntityScript();
@@ -32,6 +60,8 @@ class PythonEntityScript : public PythonWrapper {
                            const Atlas::Objects::Operation::RootOperation & op,
                            OpVector & res);
     virtual void hook(const std::string & function, LocatedEntity * entity);
+
+    static void flushHandlers();
 };
 
 #endif // RULESETS_PYTHON_ENTITY_SCRIPT_H
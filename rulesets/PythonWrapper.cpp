@@ -19,6 +19,7 @@
 #include <Python.h>
 
 #include "PythonWrapper.h"
+#include "Py_Thing.h"
 
 #include "common/compose.hpp"
 #include "common/log.h"
@@ -34,5 +35,10 @@ PythonWrapper::~PythonWrapper()
     if (m_wrapper->ob_refcnt != 1) {
         log(WARNING, String::compose("Deleting Python object of type '%1' with %2 > 1 refs to its wrapper/script", m_wrapper->ob_type->tp_name, m_wrapper->ob_refcnt));
     }
+    // Scripts may still hold references to the wrapper, so make sure
+    // they can't reach the entity once it has gone.
+    if (PyLocatedEntity_Check(m_wrapper)) {
+        ((PyEntity *)m_wrapper)->m_entity.l = NULL;
+    }
     Py_DECREF(m_wrapper);
 }
@@ -22,6 +22,10 @@
 #include "Script.h"
 
 /// \brief Wrapper class for entities without scripts but with wrappers
+///
+/// The entity owns the wrapper, so the same Python object is used each time
+/// the entity is passed to Python. When the entity is destroyed the wrapper
+/// is left pointing at no entity.
 /// \ingroup Scripts
 class PythonWrapper : public Script {
   protected:
@@ -0,0 +1,158 @@
+/*
+ Copyright (C) 2015 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "SpatialGrid.h"
+
+#include <algorithm>
+
+#include <cassert>
+#include <cmath>
+
+/// \brief Cell coordinates are clamped to this, so that keys never overflow.
+static const int max_cell_coord = 1 << 30;
+
+SpatialGrid::SpatialGrid(float cellSize, float maxReach)
+: m_cellSize(cellSize), m_maxReach(maxReach)
+{
+    assert(cellSize > 0.f);
+}
+
+int SpatialGrid::cellCoord(float c) const
+{
+    float cell = std::floor(c / m_cellSize);
+    if (cell > max_cell_coord) {
+        return max_cell_coord;
+    }
+    if (cell < -max_cell_coord) {
+        return -max_cell_coord;
+    }
+    return (int)cell;
+}
+
+SpatialGrid::EntityList & SpatialGrid::listFor(const Entry & entry)
+{
+    if (entry.unbounded) {
+        return m_unbounded;
+    }
+    return m_cells[entry.cell];
+}
+
+void SpatialGrid::removeEntry(LocatedEntity * entity, const Entry & entry)
+{
+    EntityList & list = listFor(entry);
+    assert(entry.index < list.size());
+    assert(list[entry.index] == entity);
+    // Swap the last entity into the vacated slot, and update its index.
+    LocatedEntity * last = list.back();
+    if (last != entity) {
+        list[entry.index] = last;
+        m_entries[last].index = entry.index;
+    }
+    list.pop_back();
+    if (list.empty() && !entry.unbounded) {
+        m_cells.erase(entry.cell);
+    }
+}
+
+void SpatialGrid::insert(LocatedEntity * entity, float x, float y, float reach)
+{
+    Entry entry;
+    // The negated comparison makes sure that NaN ends up as unbounded.
+    entry.unbounded = !(reach <= m_maxReach) ||
+                      !std::isfinite(x) || !std::isfinite(y);
+    entry.cell = entry.unbounded ? 0 : cellKey(cellCoord(x), cellCoord(y));
+
+    auto I = m_entries.find(entity);
+    if (I != m_entries.end()) {
+        if (I->second.unbounded == entry.unbounded &&
+            I->second.cell == entry.cell) {
+            return;
+        }
+        removeEntry(entity, I->second);
+    }
+
+    EntityList & list = listFor(entry);
+    entry.index = list.size();
+    list.push_back(entity);
+    m_entries[entity] = entry;
+}
+
+void SpatialGrid::remove(LocatedEntity * entity)
+{
+    auto I = m_entries.find(entity);
+    if (I == m_entries.end()) {
+        return;
+    }
+    removeEntry(entity, I->second);
+    m_entries.erase(entity);
+}
+
+void SpatialGrid::clear()
+{
+    m_cells.clear();
+    m_entries.clear();
+    m_unbounded.clear();
+}
+
+void SpatialGrid::query(float x, float y, float radius,
+        std::vector<LocatedEntity *> & result) const
+{
+    result.insert(result.end(), m_unbounded.begin(), m_unbounded.end());
+
+    if (m_cells.empty()) {
+        return;
+    }
+
+    float range = radius + m_maxReach;
+    if (!std::isfinite(range) || !std::isfinite(x) || !std::isfinite(y)) {
+        for (auto& cell : m_cells) {
+            result.insert(result.end(), cell.second.begin(), cell.second.end());
+        }
+        return;
+    }
+
+    int x0 = cellCoord(x - range), x1 = cellCoord(x + range);
+    int y0 = cellCoord(y - range), y1 = cellCoord(y + range);
+
+    // If the area covers more cells than are occupied it's cheaper to
+    // walk the occupied cells than to look up every cell in the area.
+    double area = ((double)x1 - x0 + 1) * ((double)y1 - y0 + 1);
+    if (area > m_cells.size()) {
+        for (auto& cell : m_cells) {
+            int cx = (int)(cell.first >> 32);
+            int cy = (int)(unsigned int)(cell.first & 0xffffffff);
+            if (cx >= x0 && cx <= x1 && cy >= y0 && cy <= y1) {
+                result.insert(result.end(), cell.second.begin(), cell.second.end());
+            }
+        }
+        return;
+    }
+
+    for (int cx = x0; cx <= x1; ++cx) {
+        for (int cy = y0; cy <= y1; ++cy) {
+            auto I = m_cells.find(cellKey(cx, cy));
+            if (I != m_cells.end()) {
+                result.insert(result.end(), I->second.begin(), I->second.end());
+            }
+        }
+    }
+}
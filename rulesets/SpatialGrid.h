@@ -0,0 +1,151 @@
+/*
+ Copyright (C) 2015 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+#ifndef RULESETS_SPATIALGRID_H_
+#define RULESETS_SPATIALGRID_H_
+
+#include <unordered_map>
+#include <vector>
+
+#include <cstddef>
+
+class LocatedEntity;
+
+/**
+ * @brief A uniform grid over the horizontal plane, used to find entities near a point.
+ *
+ * Each entity is stored in the cell containing its position, together with a
+ * "reach", which is the distance from its position within which it can
+ * affect other entities (by being seen, or by colliding with them).
+ *
+ * Entities with a reach larger than the max reach of the grid, or without
+ * a valid position, are kept in a separate list which is always included
+ * in query results. This keeps queries correct for large entities while
+ * keeping the number of cells examined for each query low.
+ *
+ * The grid doesn't look at the entities themselves; the owner is responsible
+ * for supplying the coordinates and reach, and for updating them whenever
+ * they change.
+ */
+class SpatialGrid
+{
+    public:
+        /**
+         * @brief Ctor.
+         * @param cellSize The length of the side of each cell.
+         * @param maxReach The largest reach an entity can have and still be placed in a cell.
+         */
+        SpatialGrid(float cellSize, float maxReach);
+
+        /**
+         * @brief Inserts an entity into the grid, or moves it if it already is indexed.
+         * @param entity The entity.
+         * @param x The x coordinate of the entity.
+         * @param y The y coordinate of the entity.
+         * @param reach The reach of the entity. Any non finite value will put the entity in the list of unbounded entities.
+         */
+        void insert(LocatedEntity * entity, float x, float y, float reach);
+
+        /**
+         * @brief Removes an entity from the grid.
+         *
+         * Nothing happens if the entity isn't indexed.
+         * @param entity The entity.
+         */
+        void remove(LocatedEntity * entity);
+
+        /**
+         * @brief Removes all entities from the grid.
+         */
+        void clear();
+
+        /**
+         * @brief Finds all entities which might be within a certain distance of a point.
+         *
+         * Any entity which is within the radius, or whose reach extends to
+         * the point, is guaranteed to be returned. Entities further away
+         * might also be returned, so the caller must still do a precise check.
+         * Results are appended to the supplied vector, in no particular order.
+         *
+         * @param x The x coordinate of the point.
+         * @param y The y coordinate of the point.
+         * @param radius The radius around the point.
+         * @param result A vector to which the entities will be appended.
+         */
+        void query(float x, float y, float radius,
+                std::vector<LocatedEntity *> & result) const;
+
+        /**
+         * @brief Checks if an entity is indexed.
+         * @param entity The entity.
+         * @return True if the entity is in the grid.
+         */
+        bool contains(LocatedEntity * entity) const {
+            return m_entries.find(entity) != m_entries.end();
+        }
+
+        /**
+         * @brief Gets the number of indexed entities.
+         * @return The number of indexed entities.
+         */
+        std::size_t size() const {
+            return m_entries.size();
+        }
+
+        /**
+         * @brief Gets the number of cells which currently hold entities.
+         * @return The number of occupied cells.
+         */
+        std::size_t cellCount() const {
+            return m_cells.size();
+        }
+
+    private:
+
+        typedef std::vector<LocatedEntity *> EntityList;
+
+        /**
+         * @brief Where in the grid an entity is stored.
+         */
+        struct Entry {
+            /// True if the entity is stored in the unbounded list.
+            bool unbounded;
+            /// The key of the cell, if not unbounded.
+            long long cell;
+            /// The index of the entity in the list it's stored in.
+            std::size_t index;
+        };
+
+        const float m_cellSize;
+        const float m_maxReach;
+
+        std::unordered_map<long long, EntityList> m_cells;
+        std::unordered_map<LocatedEntity *, Entry> m_entries;
+        EntityList m_unbounded;
+
+        int cellCoord(float c) const;
+
+        static long long cellKey(int x, int y) {
+            return ((long long)x << 32) | (unsigned int)y;
+        }
+
+        EntityList & listFor(const Entry & entry);
+
+        void removeEntry(LocatedEntity * entity, const Entry & entry);
+};
+
+#endif /* RULESETS_SPATIALGRID_H_ */
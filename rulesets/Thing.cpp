@@ -285,6 +285,7 @@ void Thing::MoveOperation(const Operation & op, OpVector & res)
         }
 
         // At this point the Location data for this entity has been updated.
+        updatePositionInDomain();
 
         bool moving = false;
 
@@ -320,20 +321,28 @@ void Thing::MoveOperation(const Operation & op, OpVector & res)
             // Serial number must be changed regardless of whether we will use it
             ++m_motion->serialno();
 
-            // If we are moving, schedule an update to track the movement
-            debug(std::cout << "Move Update in " << update_time << std::endl << std::flush;);
+            // Unless a collision is due the domain can move us along with
+            // everything else that's moving, otherwise schedule an update
+            // to track the movement
+            if (m_motion->collision() ||
+                !domain->addMovingEntity(*this, m_motion->serialno())) {
+                domain->removeMovingEntity(*this);
 
-            Update u;
-            u->setFutureSeconds(update_time);
-            u->setTo(getId());
+                debug(std::cout << "Move Update in " << update_time << std::endl << std::flush;);
 
-            u->setRefno(m_motion->serialno());
+                Update u;
+                u->setFutureSeconds(update_time);
+                u->setTo(getId());
 
-            res.push_back(u);
+                u->setRefno(m_motion->serialno());
+
+                res.push_back(u);
+            }
 
         } else {
             if (m_motion) {
                 //We moved previously, but have now stopped.
+                domain->removeMovingEntity(*this);
 
                 delete m_motion;
                 m_motion = nullptr;
@@ -381,6 +390,21 @@ void Thing::checkVisibility(const Location & old_loc, OpVector & res)
     }
 }
 
+/// \brief Notify the domain of our container that our location has changed
+///
+/// The domain of the container keeps track of the positions of its
+/// children, so it needs to know about any movement.
+void Thing::updatePositionInDomain()
+{
+    if (m_location.m_loc != 0 &&
+        (m_location.m_loc->getFlags() & entity_domain)) {
+        Domain * domain = m_location.m_loc->getMovementDomain();
+        if (domain) {
+            domain->updatePosition(*this);
+        }
+    }
+}
+
 void Thing::SetOperation(const Operation & op, OpVector & res)
 {
     const std::vector<Root> & args = op->getArgs();
@@ -431,6 +455,7 @@ void Thing::updateProperties(const Operation & op, OpVector & res)
 
             prop->add(J->first, set_arg);
             prop->resetFlags(flag_unsent | per_clean);
+            markPropertyDirty(PropertyDict::lookup(J->first));
             resetFlags(entity_clean);
             // FIXME Make sure we handle separately for private properties
         }
@@ -541,6 +566,7 @@ void Thing::UpdateOperation(const Operation & op, OpVector & res)
     }
     m_location.update(current_time);
     m_flags &= ~(entity_pos_clean | entity_clean);
+    updatePositionInDomain();
 
     float update_time = consts::move_tick;
 
@@ -570,7 +596,11 @@ void Thing::UpdateOperation(const Operation & op, OpVector & res)
 
     res.push_back(s);
 
-    if (moving) {
+    if (moving && domain && !m_motion->collision() &&
+        domain->addMovingEntity(*this, ++m_motion->serialno())) {
+        // The domain moves us from now on, until a collision is due.
+        debug(std::cout << "Movement handed to domain" << std::endl << std::flush;);
+    } else if (moving) {
         debug(std::cout << "New Update in " << update_time << std::endl << std::flush;);
 
         Update u;
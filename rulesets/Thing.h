@@ -31,6 +31,7 @@
 class Thing : public Entity {
   protected:
     void checkVisibility(const Location &, OpVector &);
+    void updatePositionInDomain();
     void updateProperties(const Operation & op, OpVector & res);
   public:
 
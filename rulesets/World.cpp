@@ -65,7 +65,7 @@ World::World(const std::string & id, long intId) : Thing(id, intId), m_serialNum
 
     CalendarProperty* calProp = new CalendarProperty();
     calProp->install(this, "calendar");
-    m_properties["calendar"] = calProp;
+    setProperty("calendar", calProp);
 }
 
 World::~World()
@@ -176,7 +176,7 @@ void World::clearWorld(OpVector & res) {
             auto prop = propIter->second;
             prop->remove(this, propIter->first);
             delete prop;
-            m_properties.erase(propIter++);
+            propIter = m_properties.erase(propIter);
         } else {
             ++propIter;
         }
@@ -184,7 +184,7 @@ void World::clearWorld(OpVector & res) {
 
     CalendarProperty* calProp = new CalendarProperty();
     calProp->install(this, "calendar");
-    m_properties["calendar"] = calProp;
+    setProperty("calendar", calProp);
 
     delete m_contains;
     m_contains = nullptr;
@@ -2,6 +2,8 @@
 #include "ParserDefinitions.h"
 #include "Providers.h"
 
+#include <algorithm>
+
 using namespace boost;
 namespace qi = boost::spirit::qi;
 using qi::no_case;
@@ -9,6 +11,7 @@ using qi::no_case;
 namespace EntityFilter
 {
 Filter::Filter(const std::string &what, ProviderFactory* factory)
+: m_predicate(nullptr), m_constant(false), m_result(false)
 {
     parser::query_parser<std::string::const_iterator> grammar(factory);
     auto iter_begin = what.begin();
@@ -20,6 +23,7 @@ Filter::Filter(const std::string &what, ProviderFactory* factory)
     if (!(parse_success && iter_begin == iter_end)) {
         throw std::invalid_argument(String::compose("Attempted creating entity filter with invalid query. Query was '%1'", what));
     }
+    m_constant = m_predicate->isConstant(m_result);
 }
 
 Filter::~Filter(){
@@ -28,11 +32,31 @@ Filter::~Filter(){
 
 bool Filter::match(LocatedEntity& entity)
 {
+    if (m_constant) {
+        return m_result;
+    }
     return m_predicate->isMatch(QueryContext{entity});
 }
 
 bool Filter::match(const QueryContext& context){
 
+    if (m_constant) {
+        return m_result;
+    }
     return m_predicate->isMatch(context);
 }
+
+void Filter::filter(std::vector<LocatedEntity*>& entities)
+{
+    if (m_constant) {
+        if (!m_result) {
+            entities.clear();
+        }
+        return;
+    }
+    entities.erase(std::remove_if(entities.begin(), entities.end(),
+                                  [this](LocatedEntity* entity) {
+        return !m_predicate->isMatch(QueryContext{*entity});
+    }), entities.end());
+}
 }
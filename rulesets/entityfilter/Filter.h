@@ -3,6 +3,8 @@
 
 #include "ParserDefinitions.h"
 
+#include <vector>
+
 ///\brief This class is used to search entities in NPC's memory
 ///using a query as a filter
 namespace EntityFilter
@@ -21,9 +23,17 @@ class Filter {
         bool match(LocatedEntity& entity);
         ///\brief test given QueryContext for a match
         bool match(const QueryContext& context);
+        ///\brief remove the entities which don't match from a vector,
+        ///keeping the order of the rest
+        ///@param entities - entities to be tested
+        void filter(std::vector<LocatedEntity*>& entities);
     private:
         //The top predicate node used for testing
         Predicate* m_predicate;
+        //Set if the query gives the same result for every entity, in
+        //which case m_result is the result
+        bool m_constant;
+        bool m_result;
 };
 }
 #endif
@@ -5,13 +5,21 @@
 
 #include <algorithm>
 #include <stdexcept>
+#include <utility>
 
 namespace EntityFilter
 {
+bool Predicate::isConstant(bool& result) const
+{
+    return false;
+}
+
 ComparePredicate::ComparePredicate(const Consumer<QueryContext>* lhs,
                                    const Consumer<QueryContext>* rhs,
                                    Comparator comparator) :
-        m_lhs(lhs), m_rhs(rhs), m_comparator(comparator)
+        m_lhs(lhs), m_rhs(rhs), m_comparator(comparator),
+        m_lhs_fixed(nullptr), m_rhs_fixed(nullptr), m_folded(false),
+        m_result(false)
 {
     //make sure rhs and lhs exist
     if (!m_lhs || !m_rhs) {
@@ -27,164 +35,194 @@ ComparePredicate::ComparePredicate(const Consumer<QueryContext>* lhs,
         }
     }
 
+    auto lhs_fixed = dynamic_cast<const FixedElementProvider*>(m_lhs);
+    if (lhs_fixed) {
+        m_lhs_fixed = &lhs_fixed->element();
+    }
+    auto rhs_fixed = dynamic_cast<const FixedElementProvider*>(m_rhs);
+    if (rhs_fixed) {
+        m_rhs_fixed = &rhs_fixed->element();
+    }
+    if (m_lhs_fixed && m_rhs_fixed) {
+        m_folded = true;
+        m_result = compare(*m_lhs_fixed, *m_rhs_fixed);
+    }
 }
 
 bool ComparePredicate::isMatch(const QueryContext& context) const
+{
+    if (m_folded) {
+        return m_result;
+    }
+
+    Atlas::Message::Element left_value;
+    if (!m_lhs_fixed) {
+        m_lhs->value(left_value, context);
+    }
+    const Atlas::Message::Element& left = m_lhs_fixed ? *m_lhs_fixed : left_value;
+    //No comparison can succeed without a left hand value, so don't
+    //bother getting the right hand one.
+    if (left.isNone()) {
+        return m_comparator == Comparator::NOT_EQUALS;
+    }
+
+    Atlas::Message::Element right_value;
+    if (!m_rhs_fixed) {
+        m_rhs->value(right_value, context);
+    }
+    const Atlas::Message::Element& right = m_rhs_fixed ? *m_rhs_fixed : right_value;
+    return compare(left, right);
+}
+
+bool ComparePredicate::compare(const Atlas::Message::Element& left,
+                               const Atlas::Message::Element& right) const
 {
     switch (m_comparator) {
     case Comparator::EQUALS:
-    {
-        Atlas::Message::Element left, right;
-        m_lhs->value(left, context);
-        if (!left.isNone()) {
-            m_rhs->value(right, context);
-            if (!right.isNone()) {
-                return left == right;
-            }
+        if (!left.isNone() && !right.isNone()) {
+            return left == right;
         }
-
         return false;
-    }
-        break;
     case Comparator::NOT_EQUALS:
-    {
-        Atlas::Message::Element left, right;
-        m_lhs->value(left, context);
-        if (!left.isNone()) {
-            m_rhs->value(right, context);
-            if (!right.isNone()) {
-                return left != right;
-            }
+        if (!left.isNone() && !right.isNone()) {
+            return left != right;
         }
-
         return true;
-    }
-        break;
     case Comparator::LESS:
-    {
-        Atlas::Message::Element left, right;
-        m_lhs->value(left, context);
-        if (left.isNum()) {
-            m_rhs->value(right, context);
-            if (right.isNum()) {
-                return left.asNum() < right.asNum();
-            }
+        if (left.isNum() && right.isNum()) {
+            return left.asNum() < right.asNum();
         }
         return false;
-    }
-        break;
     case Comparator::LESS_EQUAL:
-    {
-        Atlas::Message::Element left, right;
-        m_lhs->value(left, context);
-        if (left.isNum()) {
-            m_rhs->value(right, context);
-            if (right.isNum()) {
-                return left.asNum() <= right.asNum();
-            }
+        if (left.isNum() && right.isNum()) {
+            return left.asNum() <= right.asNum();
         }
         return false;
-    }
-        break;
     case Comparator::GREATER:
-    {
-        Atlas::Message::Element left, right;
-        m_lhs->value(left, context);
-        if (left.isNum()) {
-            m_rhs->value(right, context);
-            if (right.isNum()) {
-                return left.asNum() > right.asNum();
-            }
+        if (left.isNum() && right.isNum()) {
+            return left.asNum() > right.asNum();
         }
         return false;
-    }
-        break;
     case Comparator::GREATER_EQUAL:
-    {
-        Atlas::Message::Element left, right;
-        m_lhs->value(left, context);
-        if (left.isNum()) {
-            m_rhs->value(right, context);
-            if (right.isNum()) {
-                return left.asNum() >= right.asNum();
-            }
+        if (left.isNum() && right.isNum()) {
+            return left.asNum() >= right.asNum();
         }
         return false;
-    }
-        break;
     case Comparator::INSTANCE_OF:
-    {
         //We know that both providers return type node instances, since we checked in the constructor.
-        Atlas::Message::Element left, right;
-        m_lhs->value(left, context);
-        if (left.isPtr()) {
+        if (left.isPtr() && right.isPtr()) {
             const TypeNode* leftType = static_cast<const TypeNode*>(left.Ptr());
-            if (leftType) {
-                m_rhs->value(right, context);
-                if (right.isPtr()) {
-                    const TypeNode* rightType =
-                            static_cast<const TypeNode*>(right.Ptr());
-                    if (rightType) {
-                        return leftType->isTypeOf(rightType);
-                    }
-                }
+            const TypeNode* rightType = static_cast<const TypeNode*>(right.Ptr());
+            if (leftType && rightType) {
+                return leftType->isTypeOf(rightType);
             }
         }
         return false;
-    }
     case Comparator::IN:
-    {
-        Atlas::Message::Element left, right;
-        m_lhs->value(left, context);
-        if (!left.isNone()) {
-            m_rhs->value(right, context);
-            if (right.isList()) {
-                const auto& right_end = right.List().end();
-                const auto& right_begin = right.List().begin();
-                return std::find(right_begin, right_end, left) != right_end;
-            }
+        if (!left.isNone() && right.isList()) {
+            const auto& right_end = right.List().end();
+            const auto& right_begin = right.List().begin();
+            return std::find(right_begin, right_end, left) != right_end;
         }
         return false;
-    }
     case Comparator::CONTAINS:
-    {
-        Atlas::Message::Element left, right;
-        m_lhs->value(left, context);
-        if (left.isList()) {
-            m_rhs->value(right, context);
-            if (!right.isNone()) {
-                const auto& left_end = left.List().end();
-                const auto& left_begin = left.List().begin();
-                return std::find(left_begin, left_end, right) != left_end;
-            }
+        if (left.isList() && !right.isNone()) {
+            const auto& left_end = left.List().end();
+            const auto& left_begin = left.List().begin();
+            return std::find(left_begin, left_end, right) != left_end;
         }
         return false;
-    }
-        break;
     }
     return false;
 }
 
+int ComparePredicate::cost() const
+{
+    if (m_folded) {
+        return 0;
+    }
+    return m_lhs->cost() + m_rhs->cost();
+}
+
+bool ComparePredicate::isConstant(bool& result) const
+{
+    result = m_result;
+    return m_folded;
+}
+
 AndPredicate::AndPredicate(const Predicate* lhs, const Predicate* rhs) :
         m_lhs(lhs), m_rhs(rhs)
 {
+    //Predicates have no side effects, so the cheaper one can go first
+    if (m_rhs->cost() < m_lhs->cost()) {
+        std::swap(m_lhs, m_rhs);
+    }
 }
+
 bool AndPredicate::isMatch(const QueryContext& context) const
 {
     return m_lhs->isMatch(context) && m_rhs->isMatch(context);
 
 }
 
+int AndPredicate::cost() const
+{
+    bool result;
+    if (isConstant(result)) {
+        return 0;
+    }
+    return m_lhs->cost() + m_rhs->cost();
+}
+
+bool AndPredicate::isConstant(bool& result) const
+{
+    bool lhs_result, rhs_result;
+    bool lhs_constant = m_lhs->isConstant(lhs_result);
+    bool rhs_constant = m_rhs->isConstant(rhs_result);
+    if ((lhs_constant && !lhs_result) || (rhs_constant && !rhs_result)) {
+        result = false;
+        return true;
+    }
+    result = true;
+    return lhs_constant && rhs_constant;
+}
+
 OrPredicate::OrPredicate(const Predicate* lhs, const Predicate* rhs) :
         m_lhs(lhs), m_rhs(rhs)
 {
+    if (m_rhs->cost() < m_lhs->cost()) {
+        std::swap(m_lhs, m_rhs);
+    }
 }
+
 bool OrPredicate::isMatch(const QueryContext& context) const
 {
     return m_lhs->isMatch(context) || m_rhs->isMatch(context);
 
 }
 
+int OrPredicate::cost() const
+{
+    bool result;
+    if (isConstant(result)) {
+        return 0;
+    }
+    return m_lhs->cost() + m_rhs->cost();
+}
+
+bool OrPredicate::isConstant(bool& result) const
+{
+    bool lhs_result, rhs_result;
+    bool lhs_constant = m_lhs->isConstant(lhs_result);
+    bool rhs_constant = m_rhs->isConstant(rhs_result);
+    if ((lhs_constant && lhs_result) || (rhs_constant && rhs_result)) {
+        result = true;
+        return true;
+    }
+    result = false;
+    return lhs_constant && rhs_constant;
+}
+
 NotPredicate::NotPredicate(const Predicate* pred) :
         m_pred(pred)
 {
@@ -194,4 +232,19 @@ bool NotPredicate::isMatch(const QueryContext& context) const
 {
     return !m_pred->isMatch(context);
 }
+
+int NotPredicate::cost() const
+{
+    return m_pred->cost();
+}
+
+bool NotPredicate::isConstant(bool& result) const
+{
+    bool pred_result;
+    if (m_pred->isConstant(pred_result)) {
+        result = !pred_result;
+        return true;
+    }
+    return false;
+}
 }
@@ -14,6 +14,15 @@ class Predicate {
     public:
         virtual ~Predicate(){}
         virtual bool isMatch(const QueryContext& context) const = 0;
+
+        ///\brief Rough cost of calling isMatch, used to test cheap
+        ///predicates before expensive ones. Zero if the result is constant.
+        virtual int cost() const = 0;
+
+        ///\brief Check whether the result is the same for every context.
+        ///@param result set to the result if it is constant
+        ///@return true if the result is constant
+        virtual bool isConstant(bool& result) const;
 };
 
 
@@ -25,11 +34,23 @@ class ComparePredicate : public Predicate {
         };
         ComparePredicate(const Consumer<QueryContext>* lhs, const Consumer<QueryContext>* rhs, Comparator comparator);
         virtual bool isMatch(const QueryContext& context) const;
+        virtual int cost() const;
+        virtual bool isConstant(bool& result) const;
     protected:
         const Consumer<QueryContext>* m_lhs;
         const Consumer<QueryContext>* m_rhs;
         Comparator m_comparator;
 
+        //Values of the sides which are fixed, so they needn't be copied
+        //for each match. Null if the side depends on the context.
+        const Atlas::Message::Element* m_lhs_fixed;
+        const Atlas::Message::Element* m_rhs_fixed;
+
+        //Set if both sides are fixed, in which case m_result is the result.
+        bool m_folded;
+        bool m_result;
+
+        bool compare(const Atlas::Message::Element& left, const Atlas::Message::Element& right) const;
 
 };
 
@@ -37,6 +58,8 @@ class AndPredicate : public Predicate {
     public:
         AndPredicate(const Predicate* lhs, const Predicate* rhs);
         virtual bool isMatch(const QueryContext& context) const;
+        virtual int cost() const;
+        virtual bool isConstant(bool& result) const;
     protected:
         const Predicate* m_lhs;
         const Predicate* m_rhs;
@@ -46,6 +69,8 @@ class OrPredicate : public Predicate {
     public:
         OrPredicate(const Predicate* lhs, const Predicate* rhs);
         virtual bool isMatch(const QueryContext& context) const;
+        virtual int cost() const;
+        virtual bool isConstant(bool& result) const;
    protected:
         const Predicate* m_lhs;
         const Predicate* m_rhs;
@@ -55,6 +80,8 @@ class NotPredicate : public Predicate {
     public:
         NotPredicate(const Predicate* pred);
         virtual bool isMatch(const QueryContext& context) const;
+        virtual int cost() const;
+        virtual bool isConstant(bool& result) const;
     protected:
         const Predicate* m_pred;
 };
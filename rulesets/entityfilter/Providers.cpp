@@ -46,6 +46,16 @@ void FixedElementProvider::value(Atlas::Message::Element& value, const QueryCont
     value = m_element;
 }
 
+int FixedElementProvider::cost() const
+{
+    return 0;
+}
+
+const Atlas::Message::Element& FixedElementProvider::element() const
+{
+    return m_element;
+}
+
 FixedTypeNodeProvider::FixedTypeNodeProvider(Consumer<TypeNode>* consumer, const TypeNode& type)
 : ConsumingProviderBase<TypeNode, QueryContext>(consumer), m_type(type)
 {
@@ -69,6 +79,14 @@ const std::type_info* FixedTypeNodeProvider::getType() const
     }
 }
 
+int FixedTypeNodeProvider::cost() const
+{
+    if (m_consumer) {
+        return m_consumer->cost();
+    }
+    return 0;
+}
+
 MemoryProvider::MemoryProvider(Consumer<Atlas::Message::Element>* consumer)
 :ConsumingProviderBase<Atlas::Message::Element, QueryContext>(consumer){
 
@@ -88,6 +106,14 @@ void MemoryProvider::value(Atlas::Message::Element& value, const QueryContext& c
     value = Atlas::Message::Element();
 }
 
+int MemoryProvider::cost() const
+{
+    if (m_consumer) {
+        return 8 + m_consumer->cost();
+    }
+    return 8;
+}
+
 EntityProvider::EntityProvider(Consumer<LocatedEntity>* consumer)
 : ConsumingProviderBase<LocatedEntity, QueryContext>(consumer)
 {
@@ -235,13 +261,13 @@ void BBoxProvider::value(Atlas::Message::Element& value, const BBoxProperty& pro
 
 
 SoftPropertyProvider::SoftPropertyProvider(Consumer<Atlas::Message::Element>* consumer, const std::string& attribute_name) :
-    ConsumingNamedAttributeProviderBase<Atlas::Message::Element, LocatedEntity>(consumer, attribute_name)
+    ConsumingPropertyProviderBase<Atlas::Message::Element>(consumer, attribute_name)
 {
 }
 
 void SoftPropertyProvider::value(Atlas::Message::Element& value, const LocatedEntity& entity) const
 {
-    auto prop = entity.getProperty(m_attribute_name);
+    auto prop = entity.getPropertyById(m_property_id);
     if (!prop) {
         return;
     }
@@ -276,14 +302,14 @@ void MapProvider::value(Atlas::Message::Element& value, const Atlas::Message::El
 }
 
 EntityRefProvider::EntityRefProvider(Consumer<LocatedEntity>* consumer, const std::string& attribute_name):
-        ConsumingNamedAttributeProviderBase<LocatedEntity, LocatedEntity>(consumer, attribute_name)
+        ConsumingPropertyProviderBase<LocatedEntity>(consumer, attribute_name)
 {
 
 }
 
 void EntityRefProvider::value(Atlas::Message::Element& value, const LocatedEntity& entity) const
 {
-    const EntityProperty* prop = entity.getPropertyClass<EntityProperty>(m_attribute_name);
+    const EntityProperty* prop = dynamic_cast<const EntityProperty*>(entity.getPropertyById(m_property_id));
     if (!prop) {
         return;
     }
@@ -345,6 +371,13 @@ void ContainsRecursiveFunctionProvider::value(Atlas::Message::Element& value,
     }
 }
 
+int ContainsRecursiveFunctionProvider::cost() const
+{
+    //The condition is tested against every entity in the container, and
+    //their contents, so assume there are quite a few of them.
+    return m_consumer->cost() + 16 * m_condition->cost();
+}
+
 bool ContainsRecursiveFunctionProvider::checkContainer(LocatedEntitySet* container) const
 {
     auto iter = container->begin();
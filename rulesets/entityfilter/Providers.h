@@ -55,8 +55,22 @@ class TypedProvider {
          * @return Null, or a type info instance defining the type returned as a pointer Element.
          */
         virtual const std::type_info* getType() const = 0;
+
+        /**
+         * @brief Gets a rough cost of providing a value, including the cost of any consumer.
+         *
+         * Used to test cheap predicates before expensive ones. A fixed value
+         * costs 0, reading a field of an object already at hand costs 1,
+         * looking up a property by id costs 4 and looking up a memory costs 8.
+         */
+        virtual int cost() const;
 };
 
+inline int TypedProvider::cost() const
+{
+    return 1;
+}
+
 
 template <typename T>
 class Consumer : public TypedProvider
@@ -102,6 +116,7 @@ class ConsumingProviderBase : public ProviderBase<TProviding>, public Consumer<T
         ConsumingProviderBase(Consumer<TProviding>* consumer);
         virtual ~ConsumingProviderBase(){};
         virtual const std::type_info* getType() const;
+        virtual int cost() const;
 };
 
 template <typename TProviding, typename TConsuming>
@@ -119,6 +134,15 @@ inline const std::type_info* ConsumingProviderBase<TProviding, TConsuming>::getT
     return nullptr;
 }
 
+template <typename TProviding, typename TConsuming>
+inline int ConsumingProviderBase<TProviding, TConsuming>::cost() const
+{
+    if (this->m_consumer) {
+        return 1 + this->m_consumer->cost();
+    }
+    return 1;
+}
+
 
 template <typename T>
 class NamedAttributeProviderBase : public ProviderBase<T> {
@@ -141,6 +165,7 @@ class ConsumingNamedAttributeProviderBase : public NamedAttributeProviderBase<TP
         ConsumingNamedAttributeProviderBase(Consumer<TProviding>* consumer, const std::string& attribute_name);
         virtual ~ConsumingNamedAttributeProviderBase(){};
         virtual const std::type_info* getType() const;
+        virtual int cost() const;
 };
 
 template <typename TProviding, typename TConsuming>
@@ -158,11 +183,55 @@ inline const std::type_info* ConsumingNamedAttributeProviderBase<TProviding, TCo
     return nullptr;
 }
 
+template <typename TProviding, typename TConsuming>
+inline int ConsumingNamedAttributeProviderBase<TProviding, TConsuming>::cost() const
+{
+    if (this->m_consumer) {
+        return 1 + this->m_consumer->cost();
+    }
+    return 1;
+}
+
+
+///\brief Base for providers which look up a property of an entity.
+///
+///The name of the property is interned when the provider is created, so
+///each lookup is a search by integer id rather than by name.
+template <typename TProviding>
+class ConsumingPropertyProviderBase : public ConsumingNamedAttributeProviderBase<TProviding, LocatedEntity>
+{
+    public:
+        ConsumingPropertyProviderBase(Consumer<TProviding>* consumer, const std::string& attribute_name);
+        virtual ~ConsumingPropertyProviderBase(){};
+        virtual int cost() const;
+    protected:
+        const int m_property_id;
+};
+
+template <typename TProviding>
+inline ConsumingPropertyProviderBase<TProviding>::ConsumingPropertyProviderBase(Consumer<TProviding>* consumer, const std::string& attribute_name)
+: ConsumingNamedAttributeProviderBase<TProviding, LocatedEntity>(consumer, attribute_name),
+  m_property_id(PropertyDict::intern(attribute_name))
+{
+}
+
+template <typename TProviding>
+inline int ConsumingPropertyProviderBase<TProviding>::cost() const
+{
+    if (this->m_consumer) {
+        return 4 + this->m_consumer->cost();
+    }
+    return 4;
+}
+
 
 class FixedElementProvider : public Consumer<QueryContext> {
     public:
         FixedElementProvider(const Atlas::Message::Element& element);
         virtual void value(Atlas::Message::Element& value, const QueryContext& context) const;
+        virtual int cost() const;
+        ///\brief Gets the value, which is the same for every context.
+        const Atlas::Message::Element& element() const;
     protected:
         const Atlas::Message::Element m_element;
 };
@@ -172,6 +241,7 @@ class FixedTypeNodeProvider : public ConsumingProviderBase<TypeNode, QueryContex
         FixedTypeNodeProvider(Consumer<TypeNode>* consumer, const TypeNode& type);
         virtual void value(Atlas::Message::Element& value, const QueryContext& context) const;
         virtual const std::type_info* getType() const;
+        virtual int cost() const;
     protected:
         const TypeNode& m_type;
 };
@@ -179,6 +249,7 @@ class MemoryProvider: public ConsumingProviderBase<Atlas::Message::Element, Quer
     public:
         MemoryProvider(Consumer<Atlas::Message::Element>* consumer);
         virtual void value(Atlas::Message::Element& value, const QueryContext&) const;
+        virtual int cost() const;
 };
 
 class EntityProvider : public ConsumingProviderBase<LocatedEntity, QueryContext> {
@@ -238,7 +309,7 @@ class BBoxProvider : public ConsumingProviderBase<Atlas::Message::Element, BBoxP
 };
 
 template <typename TProperty>
-class PropertyProvider : public ConsumingNamedAttributeProviderBase<TProperty, LocatedEntity>
+class PropertyProvider : public ConsumingPropertyProviderBase<TProperty>
 {
     public:
         PropertyProvider(Consumer<TProperty>* consumer, const std::string& attribute_name);
@@ -248,14 +319,14 @@ class PropertyProvider : public ConsumingNamedAttributeProviderBase<TProperty, L
 
 template <typename TProperty>
 inline PropertyProvider<TProperty>::PropertyProvider(Consumer<TProperty>* consumer, const std::string& attribute_name)
-: ConsumingNamedAttributeProviderBase<TProperty, LocatedEntity>(consumer, attribute_name)
+: ConsumingPropertyProviderBase<TProperty>(consumer, attribute_name)
 {
 }
 
 template <typename TProperty>
 inline void PropertyProvider<TProperty>::value(Atlas::Message::Element& value, const LocatedEntity& entity) const
 {
-    const TProperty* prop = entity.getPropertyClass<TProperty>(this->m_attribute_name);
+    const TProperty* prop = dynamic_cast<const TProperty*>(entity.getPropertyById(this->m_property_id));
     if (!prop) {
         return;
     }
@@ -268,7 +339,7 @@ inline void PropertyProvider<TProperty>::value(Atlas::Message::Element& value, c
 }
 
 
-class SoftPropertyProvider : public ConsumingNamedAttributeProviderBase<Atlas::Message::Element, LocatedEntity>
+class SoftPropertyProvider : public ConsumingPropertyProviderBase<Atlas::Message::Element>
 {
     public:
         SoftPropertyProvider(Consumer<Atlas::Message::Element>* consumer, const std::string& attribute_name);
@@ -282,7 +353,7 @@ class MapProvider : public ConsumingNamedAttributeProviderBase<Atlas::Message::E
         virtual void value(Atlas::Message::Element& value, const Atlas::Message::Element& parent_element) const;
 };
 
-class EntityRefProvider : public ConsumingNamedAttributeProviderBase<LocatedEntity, LocatedEntity>
+class EntityRefProvider : public ConsumingPropertyProviderBase<LocatedEntity>
 {
     public:
         EntityRefProvider(Consumer<LocatedEntity>* consumer, const std::string& attribute_name);
@@ -305,6 +376,7 @@ class ContainsRecursiveFunctionProvider : public Consumer<QueryContext> {
                                           Predicate* condition);
         virtual void value(Atlas::Message::Element& value,
                            const QueryContext& context) const;
+        virtual int cost() const;
     private:
         ///\brief Condition used to match entities within the container
         Predicate* m_condition;
@@ -86,7 +86,7 @@ Account::~Account()
 void Account::characterDestroyed(long id)
 {
     m_charactersDict.erase(id);
-    if (database_flag && isPersisted()) {
+    if (isPersisted()) {
         Persistence::instance()->delCharacter(String::compose("%1", id));
     }
 }
@@ -111,7 +111,7 @@ int Account::connectCharacter(LocatedEntity *chr)
         m_charactersDict[chr->getIntId()] = chr;
         chr->destroyed.connect(sigc::bind(sigc::mem_fun(this, &Account::characterDestroyed), chr->getIntId()));
         m_connection->addEntity(chr);
-        if (database_flag && isPersisted()) {
+        if (isPersisted()) {
             Persistence::instance()->addCharacter(*this, *chr);
         }
         return 0;
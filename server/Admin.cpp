@@ -38,6 +38,7 @@
 
 #include "common/Connect.h"
 #include "common/Monitor.h"
+#include "common/ScriptProfiler.h"
 
 #include <Atlas/Objects/SmartPtr.h>
 #include <Atlas/Objects/Operation.h>
@@ -269,6 +270,12 @@ void Admin::GetOperation(const Operation & op, OpVector & res)
             return;
         }
         info->setArgs1(o);
+    } else if (objtype == "profile") {
+        Anonymous info_arg;
+        info_arg->setId(id);
+        info_arg->setObjtype(objtype);
+        addProfileToEntity(arg, info_arg);
+        info->setArgs1(info_arg);
     } else {
         error(op, compose("Unknown object type \"%1\" requested for \"%2\"",
                           objtype, id), res, getId());
@@ -326,6 +333,21 @@ void Admin::SetOperation(const Operation & op, OpVector & res)
         error(op, "Client attempting to use obsolete Set to install new type",
               res, getId());
         return;
+    } else if (objtype == "profile") {
+        Element enabled;
+        if (arg->copyAttr("enabled", enabled) != 0 || !enabled.isInt()) {
+            error(op, "Set profile has no enabled flag", res, getId());
+            return;
+        }
+        ScriptProfiler::instance()->setEnabled(enabled.Int() != 0);
+        Anonymous info_arg;
+        info_arg->setId(id);
+        info_arg->setObjtype(objtype);
+        info_arg->setAttr("enabled", enabled.Int() != 0 ? 1 : 0);
+        Info info;
+        info->setTo(getId());
+        info->setArgs1(info_arg);
+        res.push_back(info);
     } else {
         error(op, "Unknow object type set", res, getId());
         return;
@@ -415,6 +437,37 @@ void Admin::setAttribute(const Root& args) {
 }
 
 
+/// \brief Describe the script handlers which have used the most CPU time
+///
+/// @param arg the argument of the Get, which may give the number of
+/// handlers to describe as "count"
+/// @param ent the description is added to this entity
+void Admin::addProfileToEntity(const Root & arg, const RootEntity & ent) const
+{
+    std::size_t count = 20;
+    Element count_attr;
+    if (arg->copyAttr("count", count_attr) == 0 && count_attr.isInt() &&
+        count_attr.Int() > 0) {
+        count = count_attr.Int();
+    }
+
+    ScriptProfiler::TotalsList totals;
+    ScriptProfiler::instance()->top(count, totals);
+
+    ListType handlers;
+    for (auto & entry : totals) {
+        MapType handler;
+        handler["class"] = entry.first.first;
+        handler["handler"] = entry.first.second;
+        handler["calls"] = entry.second.calls;
+        handler["wall"] = entry.second.wallTime;
+        handler["cpu"] = entry.second.cpuTime;
+        handlers.push_back(handler);
+    }
+    ent->setAttr("enabled", ScriptProfiler::instance()->enabled() ? 1 : 0);
+    ent->setAttr("handlers", handlers);
+}
+
 /// \brief Process a Monitor operation
 ///
 /// @param op The operation to be processed.
@@ -42,6 +42,9 @@ class Admin : public Account {
     /// \brief Sets an attribute on the admin instance itself.
     void setAttribute(const Atlas::Objects::Root& arg);
 
+    void addProfileToEntity(const Atlas::Objects::Root &,
+                            const Atlas::Objects::Entity::RootEntity &) const;
+
     /// \brief Connection used to monitor the in-game operations
     sigc::connection m_monitorConnection;
   public:
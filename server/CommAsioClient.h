@@ -21,6 +21,7 @@
 
 #include "common/Link.h"
 #include "common/CommSocket.h"
+#include "common/OpBroadcast.h"
 
 #include <Atlas/Objects/Decoder.h>
 #include <Atlas/Objects/ObjectsFwd.h>
@@ -34,6 +35,7 @@
 #include <memory>
 #include <sstream>
 #include <deque>
+#include <vector>
 
 template<typename ProtocolT>
 class CommAsioClient: public Atlas::Objects::ObjectsDecoder,
@@ -58,6 +60,31 @@ class CommAsioClient: public Atlas::Objects::ObjectsDecoder,
 
         virtual int flush();
 
+        virtual int sendBroadcast(const Atlas::Objects::Operation::RootOperation &,
+                OpBroadcast & broadcast);
+
+        virtual int checkBacklog(const Atlas::Objects::Operation::RootOperation &);
+
+        /// \brief What to do when a client doesn't keep up with the data sent to it.
+        enum OverflowPolicy
+        {
+            /// \brief Drop perception of movement and property changes, which will soon be stale.
+            overflow_drop,
+            /// \brief Disconnect the client.
+            overflow_disconnect
+        };
+
+        /**
+         * @brief Sets the limit of how much outgoing data can be queued.
+         *
+         * When more than this is queued, the policy decides what happens to
+         * further operations. With the drop policy the client is still
+         * disconnected if the queue grows beyond twice the limit.
+         * @param highWaterMark Size in bytes; zero means no limit.
+         * @param policy What to do when the limit is reached.
+         */
+        void setHighWaterMark(std::size_t highWaterMark, OverflowPolicy policy);
+
     protected:
         typename ProtocolT::socket mSocket;
 
@@ -68,9 +95,43 @@ class CommAsioClient: public Atlas::Objects::ObjectsDecoder,
 
         enum
         {
-            read_buffer_size = 16384
+            read_buffer_size = 16384,
+            /// \brief The max number of unused write buffers kept for reuse.
+            write_buffer_pool_size = 4
+        };
+
+        /**
+         * @brief A piece of outgoing data.
+         *
+         * Either a buffer encoded by this client, or the shared encoding of a
+         * broadcast operation together with the TO value of this client.
+         */
+        struct WriteChunk
+        {
+            boost::asio::streambuf* buffer;
+            OpBroadcast::EncodingPtr encoding;
+            std::string to;
+
+            std::size_t size() const;
         };
 
+        /// \brief Data waiting for the current write to complete.
+        std::deque<WriteChunk> mPendingChunks;
+        /// \brief Data being written.
+        std::vector<WriteChunk> mWritingChunks;
+        /// \brief Unused write buffers, kept to avoid allocating new ones.
+        std::vector<boost::asio::streambuf*> mBufferPool;
+        /// \brief Bytes in mPendingChunks and mWritingChunks.
+        std::size_t mQueuedBytes;
+        /// \brief True if a write is in progress.
+        bool mWriting;
+        /// \brief True if a write has been posted to the io service.
+        bool mWriteScheduled;
+        /// \brief Limit on queued bytes; zero if there's no limit.
+        std::size_t mHighWaterMark;
+        /// \brief What to do when the limit is reached.
+        OverflowPolicy mOverflowPolicy;
+
 /// \brief Queue of operations that have been decoded by not dispatched.
         DispatchQueue m_opQueue;
         /// \brief Atlas codec that handles encoding and decoding traffic.
@@ -88,6 +149,16 @@ class CommAsioClient: public Atlas::Objects::ObjectsDecoder,
 
         void write();
 
+        void scheduleWrite();
+
+        void queueWriteBuffer();
+
+        boost::asio::streambuf* takeBuffer();
+
+        void releaseBuffer(boost::asio::streambuf* buffer);
+
+        static bool isStaleUpdate(const Atlas::Objects::Operation::RootOperation &);
+
         void dispatch();
 
         void startNegotiation();
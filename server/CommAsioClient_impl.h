@@ -30,16 +30,21 @@
 
 #include <Atlas/Objects/Encoder.h>
 #include <Atlas/Objects/RootOperation.h>
+#include <Atlas/Objects/Operation.h>
 #include <Atlas/Objects/SmartPtr.h>
 #include <Atlas/Net/Stream.h>
 
+#include <typeinfo>
+
 template<class ProtocolT>
 CommAsioClient<ProtocolT>::CommAsioClient(const std::string & name,
         boost::asio::io_service& io_service) :
         CommSocket(io_service), mSocket(io_service), mWriteBuffer(
                 new boost::asio::streambuf()), mStream(mWriteBuffer), mNegotiateTimer(
-                io_service, boost::posix_time::seconds(1)), m_codec(nullptr), m_encoder(
-                nullptr), m_negotiate(nullptr), m_link(nullptr), mName(name)
+                io_service, boost::posix_time::seconds(1)), mQueuedBytes(0), mWriting(
+                false), mWriteScheduled(false), mHighWaterMark(0), mOverflowPolicy(
+                overflow_drop), m_codec(nullptr), m_encoder(nullptr), m_negotiate(
+                nullptr), m_link(nullptr), mName(name)
 {
 }
 
@@ -51,6 +56,15 @@ CommAsioClient<ProtocolT>::~CommAsioClient()
     delete m_encoder;
     delete m_codec;
     delete mWriteBuffer;
+    for (auto& chunk : mPendingChunks) {
+        delete chunk.buffer;
+    }
+    for (auto& chunk : mWritingChunks) {
+        delete chunk.buffer;
+    }
+    for (auto buffer : mBufferPool) {
+        delete buffer;
+    }
     try {
         mSocket.shutdown(ProtocolT::socket::shutdown_both);
     } catch (const std::exception& e) {
@@ -91,45 +105,171 @@ void CommAsioClient<ProtocolT>::do_read()
 }
 
 template<class ProtocolT>
-void CommAsioClient<ProtocolT>::write()
+std::size_t CommAsioClient<ProtocolT>::WriteChunk::size() const
+{
+    if (buffer) {
+        return buffer->size();
+    }
+    return encoding->m_prefix.size() + to.size() + encoding->m_suffix.size();
+}
+
+template<class ProtocolT>
+boost::asio::streambuf* CommAsioClient<ProtocolT>::takeBuffer()
+{
+    if (mBufferPool.empty()) {
+        return new boost::asio::streambuf();
+    }
+    boost::asio::streambuf* buffer = mBufferPool.back();
+    mBufferPool.pop_back();
+    return buffer;
+}
+
+template<class ProtocolT>
+void CommAsioClient<ProtocolT>::releaseBuffer(boost::asio::streambuf* buffer)
+{
+    //Buffers keep the memory they have allocated when consumed, so reusing
+    //them avoids allocating memory for each write.
+    if (mBufferPool.size() < write_buffer_pool_size) {
+        buffer->consume(buffer->size());
+        mBufferPool.push_back(buffer);
+    } else {
+        delete buffer;
+    }
+}
+
+template<class ProtocolT>
+void CommAsioClient<ProtocolT>::queueWriteBuffer()
 {
+    //Move anything encoded so far to the queue, and start writing to a fresh buffer.
+    if (mWriteBuffer->size() != 0) {
+        WriteChunk chunk;
+        chunk.buffer = mWriteBuffer;
+        mQueuedBytes += chunk.buffer->size();
+        mPendingChunks.push_back(chunk);
+        mWriteBuffer = takeBuffer();
+        mStream.rdbuf(mWriteBuffer);
+    }
+}
+
+template<class ProtocolT>
+void CommAsioClient<ProtocolT>::scheduleWrite()
+{
+    //Rather than writing each operation as soon as it's sent we post the write to the io service,
+    //which means that everything sent until control returns to it is sent in one go.
+    if (mWriting || mWriteScheduled) {
+        return;
+    }
+    mWriteScheduled = true;
     auto self(this->shared_from_this());
+    m_io_service.post([this, self]()
+    {
+        mWriteScheduled = false;
+        this->write();
+    });
+}
+
+template<class ProtocolT>
+void CommAsioClient<ProtocolT>::write()
+{
+    //Only one write can be in progress at a time; the completion handler
+    //will start a new one if more data has been queued meanwhile.
+    if (mWriting) {
+        return;
+    }
 
-    //When sending data we need to make sure that nothing else writes to the streambuf (mWriteBuffer).
-    //We do this by creating a new streambuf instance. The one containing the data to be sent is
-    //then contained in a shared_ptr. When the async write operation is done the shared_ptr will
-    //be deleted. However, in order to make this a bit more efficient we'll use a custom deletor
-    //in which we'll check if the new buffer has had anything written to it. If not, we'll reuse
-    //the buffer just used for writing, as this will already have had memory allocated.
-    std::function<void(boost::asio::streambuf*)> bufferDeleter =
-            [&, self](boost::asio::streambuf* p) {
-                //Check if the existing writebuffer has had anything written to it.
-                if (this->mWriteBuffer->size() > 0) {
-                    delete p;
-                } else {
-                    //If the existing writebuffer hasn't had anything written to it we'll reuse the previous
-                    //one instead since it already have had memory allocated. This prevents unnecessary release
-                    //and re-allocation of memory.
-                    delete this->mWriteBuffer;
-                    this->mWriteBuffer = p;
-                    this->mStream.rdbuf(this->mWriteBuffer);
+    queueWriteBuffer();
 
+    if (mPendingChunks.empty()) {
+        return;
+    }
+
+    std::vector<boost::asio::const_buffer> buffers;
+    buffers.reserve(mPendingChunks.size() * 3);
+    for (auto& chunk : mPendingChunks) {
+        if (chunk.buffer) {
+            buffers.push_back(chunk.buffer->data());
+        } else {
+            buffers.push_back(boost::asio::buffer(chunk.encoding->m_prefix));
+            buffers.push_back(boost::asio::buffer(chunk.to));
+            buffers.push_back(boost::asio::buffer(chunk.encoding->m_suffix));
+        }
+    }
+    //The chunks must not move while being written, since the buffers point into them.
+    mWritingChunks.assign(mPendingChunks.begin(), mPendingChunks.end());
+    mPendingChunks.clear();
+    mWriting = true;
+
+    auto self(this->shared_from_this());
+    boost::asio::async_write(mSocket, buffers,
+            [this, self](boost::system::error_code ec, std::size_t length)
+            {
+                mWriting = false;
+                for (auto& chunk : mWritingChunks) {
+                    mQueuedBytes -= chunk.size();
+                    if (chunk.buffer) {
+                        this->releaseBuffer(chunk.buffer);
+                    }
                 }
-            };
-    std::shared_ptr<boost::asio::streambuf> buffer(mWriteBuffer, bufferDeleter);
-    mWriteBuffer = new boost::asio::streambuf();
-    mStream.rdbuf(mWriteBuffer);
-
-    if (buffer->size() != 0) {
-        boost::asio::async_write(mSocket, buffer->data(),
-                [this, self, buffer](boost::system::error_code ec, std::size_t length)
+                mWritingChunks.clear();
+                if (!ec)
                 {
-                    if (!ec)
-                    {
-                        buffer->consume(length);
+                    if (!mPendingChunks.empty() || mWriteBuffer->size() != 0) {
+                        this->write();
                     }
-                });
+                }
+            });
+}
+
+template<class ProtocolT>
+void CommAsioClient<ProtocolT>::setHighWaterMark(std::size_t highWaterMark,
+        OverflowPolicy policy)
+{
+    mHighWaterMark = highWaterMark;
+    mOverflowPolicy = policy;
+}
+
+template<class ProtocolT>
+bool CommAsioClient<ProtocolT>::isStaleUpdate(
+        const Atlas::Objects::Operation::RootOperation & op)
+{
+    //Perception of movement and of changed properties are superseded by later ones.
+    if (op->getClassNo() != Atlas::Objects::Operation::SIGHT_NO) {
+        return false;
+    }
+    const std::vector<Atlas::Objects::Root> & args = op->getArgs();
+    if (args.empty()) {
+        return false;
     }
+    int argClass = args.front()->getClassNo();
+    return argClass == Atlas::Objects::Operation::MOVE_NO
+            || argClass == Atlas::Objects::Operation::SET_NO;
+}
+
+template<class ProtocolT>
+int CommAsioClient<ProtocolT>::checkBacklog(
+        const Atlas::Objects::Operation::RootOperation & op)
+{
+    if (mHighWaterMark == 0) {
+        return 0;
+    }
+    std::size_t backlog = mQueuedBytes + mWriteBuffer->size();
+    if (backlog < mHighWaterMark) {
+        return 0;
+    }
+    if (mOverflowPolicy == overflow_drop) {
+        if (isStaleUpdate(op)) {
+            return -1;
+        }
+        if (backlog < mHighWaterMark * 2) {
+            return 0;
+        }
+    }
+    if (mSocket.is_open()) {
+        log(NOTICE, String::compose("Disconnecting client which has %1 bytes "
+                "of data waiting to be sent.", backlog));
+        disconnect();
+    }
+    return -1;
 }
 
 template<class ProtocolT>
@@ -322,10 +462,61 @@ int CommAsioClient<ProtocolT>::send(
 //        log(ERROR, "Encoder not initialized");
 //        return -1;
 //    }
+    if (checkBacklog(op) != 0) {
+        return 0;
+    }
     m_encoder->streamObjectsMessage(op);
     return flush();
 }
 
+template<class ProtocolT>
+int CommAsioClient<ProtocolT>::sendBroadcast(
+        const Atlas::Objects::Operation::RootOperation & op,
+        OpBroadcast & broadcast)
+{
+    if (!mSocket.is_open() || m_codec == nullptr) {
+        return -1;
+    }
+    //The recipient is written into the shared data as is, so it must be something the codec wouldn't escape.
+    const std::string to = op->getTo();
+    if (!OpBroadcast::isVerbatim(to)) {
+        return -1;
+    }
+
+    //Codecs don't carry any state between messages, so what one instance of a codec writes
+    //for the operation is the same as what any other instance of the same type would.
+    std::type_index codecType(typeid(*m_codec));
+    OpBroadcast::EncodingPtr encoding = broadcast.getEncoding(codecType);
+    if (!encoding) {
+        boost::asio::streambuf encodeBuffer;
+        mStream.rdbuf(&encodeBuffer);
+        op->setTo(broadcast.placeholder());
+        m_encoder->streamObjectsMessage(op);
+        op->setTo(to);
+        mStream.rdbuf(mWriteBuffer);
+
+        auto data = encodeBuffer.data();
+        encoding = broadcast.addEncoding(codecType,
+                std::string(boost::asio::buffers_begin(data),
+                        boost::asio::buffers_end(data)));
+    }
+    if (!encoding->m_valid) {
+        return -1;
+    }
+
+    //Anything already encoded must be sent first.
+    queueWriteBuffer();
+
+    WriteChunk chunk;
+    chunk.buffer = nullptr;
+    chunk.encoding = encoding;
+    chunk.to = to;
+    mQueuedBytes += chunk.size();
+    mPendingChunks.push_back(chunk);
+    scheduleWrite();
+    return 0;
+}
+
 template<class ProtocolT>
 void CommAsioClient<ProtocolT>::disconnect()
 {
@@ -335,7 +526,7 @@ void CommAsioClient<ProtocolT>::disconnect()
 template<class ProtocolT>
 int CommAsioClient<ProtocolT>::flush()
 {
-    write();
+    scheduleWrite();
     return 0;
 }
 
@@ -142,7 +142,7 @@ int CommPSQLSocket::read()
     PGresult * res;
     while (PQisBusy(con) == 0) {
         if ((res = PQgetResult(con)) != 0) {
-            m_db.queryResult(PQresultStatus(res));
+            m_db.queryResult(res);
             PQclear(res);
         } else {
             m_db.queryComplete();
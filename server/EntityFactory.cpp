@@ -101,7 +101,7 @@ void EntityFactoryBase::initializeEntity(LocatedEntity& thing,
         // Apply the attribute values
         thing.merge(attrs);
         // Then set up the default class properties
-        for (auto& propIter : m_type->defaults()) {
+        for (const auto & propIter : m_type->defaults()) {
             PropertyBase * prop = propIter.second;
             // If a property is in the class it won't have been installed
             // as setAttr() checks
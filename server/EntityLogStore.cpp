@@ -0,0 +1,654 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2015 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#include "EntityLogStore.h"
+
+#include "common/DatabaseBatch.h"
+#include "common/compose.hpp"
+#include "common/const.h"
+#include "common/log.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using String::compose;
+
+/// \brief Record kinds, the first byte of each record.
+static const char record_insert = 'I';
+static const char record_update = 'U';
+static const char record_property = 'P';
+static const char record_drop = 'D';
+static const char record_thoughts = 'T';
+static const char record_relation = 'R';
+static const char record_unrelate = 'X';
+static const char record_last_id = 'H';
+
+/// \brief Each record starts with its length and checksum.
+static const std::size_t header_size = 8;
+
+/// \brief The log is never compacted while it is smaller than this.
+static const std::size_t min_compact_size = 1 << 20;
+
+static std::uint32_t checksum(const char * data, std::size_t len)
+{
+    // FNV-1a
+    std::uint32_t hash = 2166136261u;
+    for (std::size_t i = 0; i < len; ++i) {
+        hash ^= (unsigned char)data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void putWord(std::uint32_t n, std::string & out)
+{
+    for (int i = 0; i < 4; ++i) {
+        out.push_back((char)(n >> (i * 8)));
+    }
+}
+
+static std::uint32_t getWord(const char * data)
+{
+    std::uint32_t n = 0;
+    for (int i = 0; i < 4; ++i) {
+        n |= (std::uint32_t)(unsigned char)data[i] << (i * 8);
+    }
+    return n;
+}
+
+static void putNumber(std::uint64_t n, std::string & out)
+{
+    while (n >= 0x80) {
+        out.push_back((char)((n & 0x7f) | 0x80));
+        n >>= 7;
+    }
+    out.push_back((char)n);
+}
+
+static void putString(const std::string & s, std::string & out)
+{
+    putNumber(s.size(), out);
+    out.append(s);
+}
+
+/// \brief Add the header to a record, and add it to the end of out.
+static void finishRecord(const std::string & payload, std::string & out)
+{
+    putWord(payload.size(), out);
+    putWord(checksum(payload.data(), payload.size()), out);
+    out.append(payload);
+}
+
+static long toId(const std::string & id)
+{
+    return std::strtol(id.c_str(), nullptr, 10);
+}
+
+namespace {
+
+/// \brief Reads the fields of one record
+class RecordReader {
+  protected:
+    const char * m_data;
+    std::size_t m_len;
+    std::size_t m_pos;
+  public:
+    RecordReader(const char * data, std::size_t len) :
+        m_data(data), m_len(len), m_pos(0) { }
+
+    bool done() const {
+        return m_pos == m_len;
+    }
+
+    bool kind(char & k) {
+        if (m_pos >= m_len) {
+            return false;
+        }
+        k = m_data[m_pos++];
+        return true;
+    }
+
+    bool number(std::uint64_t & n) {
+        n = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (m_pos >= m_len) {
+                return false;
+            }
+            unsigned char c = m_data[m_pos++];
+            n |= (std::uint64_t)(c & 0x7f) << shift;
+            if ((c & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool id(long & i) {
+        std::uint64_t n;
+        if (!number(n)) {
+            return false;
+        }
+        i = (long)n;
+        return true;
+    }
+
+    bool string(std::string & s) {
+        std::uint64_t len;
+        if (!number(len) || len > m_len - m_pos) {
+            return false;
+        }
+        s.assign(m_data + m_pos, len);
+        m_pos += len;
+        return true;
+    }
+};
+
+}
+
+EntityLogStore::EntityLogStore(const std::string & path) :
+      m_logPath(path + ".log"), m_snapshotPath(path + ".snapshot"),
+      m_logFd(-1), m_logSize(0), m_snapshotSize(0), m_lastId(0)
+{
+}
+
+EntityLogStore::~EntityLogStore()
+{
+    if (m_logFd != -1) {
+        flush();
+        ::fdatasync(m_logFd);
+        ::close(m_logFd);
+    }
+}
+
+/// \brief Apply a record to the stored state, and queue it for the log.
+void EntityLogStore::append(const std::string & record)
+{
+    apply(record.data(), record.size());
+    finishRecord(record, m_pending);
+}
+
+/// \brief Apply one record to the stored state.
+///
+/// Records have the same effect as the database queries they replace, so
+/// changes to entities which are not stored are ignored.
+/// @return false if the record is not valid.
+bool EntityLogStore::apply(const char * data, std::size_t len)
+{
+    RecordReader reader(data, len);
+    char kind;
+    long id;
+    if (!reader.kind(kind) || !reader.id(id)) {
+        return false;
+    }
+    switch (kind) {
+        case record_insert:
+            {
+                StoredEntity & ent = m_entities[id];
+                std::uint64_t seq;
+                if (!reader.string(ent.loc) || !reader.string(ent.type) ||
+                    !reader.number(seq) || !reader.string(ent.location)) {
+                    return false;
+                }
+                ent.seq = (int)seq;
+                if (id > m_lastId) {
+                    m_lastId = id;
+                }
+            }
+            break;
+        case record_update:
+            {
+                std::string loc, location;
+                std::uint64_t seq;
+                if (!reader.string(loc) || !reader.number(seq) ||
+                    !reader.string(location)) {
+                    return false;
+                }
+                StoredEntityDict::iterator I = m_entities.find(id);
+                if (I == m_entities.end()) {
+                    break;
+                }
+                // An empty loc leaves the existing one in place.
+                if (!loc.empty()) {
+                    I->second.loc = loc;
+                }
+                I->second.seq = (int)seq;
+                I->second.location = location;
+            }
+            break;
+        case record_property:
+            {
+                std::string name, value;
+                if (!reader.string(name) || !reader.string(value)) {
+                    return false;
+                }
+                StoredEntityDict::iterator I = m_entities.find(id);
+                if (I != m_entities.end()) {
+                    I->second.properties[name] = value;
+                }
+            }
+            break;
+        case record_drop:
+            m_entities.erase(id);
+            // The id must not be handed out again, even once the record
+            // of the entity has been compacted away.
+            if (id > m_lastId) {
+                m_lastId = id;
+            }
+            break;
+        case record_last_id:
+            if (id > m_lastId) {
+                m_lastId = id;
+            }
+            break;
+        case record_relation:
+            {
+                std::string account;
+                if (!reader.string(account)) {
+                    return false;
+                }
+                StoredEntityDict::iterator I = m_entities.find(id);
+                if (I != m_entities.end()) {
+                    I->second.account = account;
+                }
+            }
+            break;
+        case record_unrelate:
+            {
+                StoredEntityDict::iterator I = m_entities.find(id);
+                if (I != m_entities.end()) {
+                    I->second.account.clear();
+                }
+            }
+            break;
+        case record_thoughts:
+            {
+                std::uint64_t count;
+                if (!reader.number(count) || count > len) {
+                    return false;
+                }
+                std::vector<std::string> thoughts(count);
+                for (auto & thought : thoughts) {
+                    if (!reader.string(thought)) {
+                        return false;
+                    }
+                }
+                StoredEntityDict::iterator I = m_entities.find(id);
+                if (I != m_entities.end()) {
+                    I->second.thoughts.swap(thoughts);
+                }
+            }
+            break;
+        default:
+            return false;
+    }
+    return reader.done();
+}
+
+/// \brief Apply all the valid records in a file to the stored state.
+///
+/// @param valid set to the length of the file up to the first record
+/// which is not valid.
+/// @return 0 on success, or -1 if the file could not be read.
+int EntityLogStore::replay(const std::string & path, std::size_t & valid)
+{
+    valid = 0;
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        if (errno == ENOENT) {
+            return 0;
+        }
+        log(ERROR, compose("Unable to open %1: %2", path, strerror(errno)));
+        return -1;
+    }
+    struct stat file_stat;
+    if (::fstat(fd, &file_stat) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    std::size_t size = file_stat.st_size;
+    if (size == 0) {
+        ::close(fd);
+        return 0;
+    }
+    void * map = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        log(ERROR, compose("Unable to map %1: %2", path, strerror(errno)));
+        return -1;
+    }
+    ::madvise(map, size, MADV_SEQUENTIAL);
+
+    const char * data = static_cast<const char *>(map);
+    std::size_t pos = 0;
+    while (size - pos >= header_size) {
+        std::uint32_t len = getWord(data + pos);
+        std::uint32_t sum = getWord(data + pos + 4);
+        if (len > size - pos - header_size) {
+            break;
+        }
+        const char * record = data + pos + header_size;
+        if (checksum(record, len) != sum || !apply(record, len)) {
+            break;
+        }
+        pos += header_size + len;
+    }
+    ::munmap(map, size);
+    valid = pos;
+    if (valid != size) {
+        log(WARNING, compose("Ignoring %1 bytes of incomplete records at the "
+                             "end of %2", size - valid, path));
+    }
+    return 0;
+}
+
+/// \brief Read the stored world, and open the log for writing.
+int EntityLogStore::open()
+{
+    // The database creates the row for the world itself when the table is
+    // created, and nothing else inserts it, so changes to the world would
+    // otherwise be ignored. A stored row replaces this one.
+    m_entities[consts::rootWorldIntId].type = "world";
+
+    std::size_t valid;
+    if (replay(m_snapshotPath, valid) != 0) {
+        return -1;
+    }
+    m_snapshotSize = valid;
+    if (replay(m_logPath, valid) != 0) {
+        return -1;
+    }
+    m_logFd = ::open(m_logPath.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0600);
+    if (m_logFd == -1) {
+        log(ERROR, compose("Unable to open %1: %2", m_logPath,
+                           strerror(errno)));
+        return -1;
+    }
+    // Anything after the last complete record would hide records
+    // written after it.
+    if (::ftruncate(m_logFd, valid) != 0) {
+        log(ERROR, compose("Unable to truncate %1: %2", m_logPath,
+                           strerror(errno)));
+        return -1;
+    }
+    m_logSize = valid;
+    return 0;
+}
+
+void EntityLogStore::write(const DatabaseBatch & batch)
+{
+    // Entities are written before properties, as properties of entities
+    // not yet stored are ignored.
+    for (auto & row : batch.entityInserts()) {
+        std::string record(1, record_insert);
+        putNumber(toId(row.id), record);
+        putString(row.loc, record);
+        putString(row.type, record);
+        putNumber((std::uint32_t)row.seq, record);
+        putString(row.location, record);
+        append(record);
+    }
+    for (auto & row : batch.entityUpdates()) {
+        std::string record(1, record_update);
+        putNumber(toId(row.id), record);
+        putString(row.loc, record);
+        putNumber((std::uint32_t)row.seq, record);
+        putString(row.location, record);
+        append(record);
+    }
+    for (auto * rows : { &batch.propertyInserts(), &batch.propertyUpdates() }) {
+        for (auto & row : *rows) {
+            std::string record(1, record_property);
+            putNumber(toId(row.id), record);
+            putString(row.name, record);
+            putString(row.value, record);
+            append(record);
+        }
+    }
+}
+
+void EntityLogStore::dropEntity(long id)
+{
+    std::string record(1, record_drop);
+    putNumber(id, record);
+    append(record);
+}
+
+void EntityLogStore::replaceThoughts(const std::string & id,
+                                     const std::vector<std::string> & thoughts)
+{
+    std::string record(1, record_thoughts);
+    putNumber(toId(id), record);
+    putNumber(thoughts.size(), record);
+    for (auto & thought : thoughts) {
+        putString(thought, record);
+    }
+    append(record);
+}
+
+void EntityLogStore::createRelation(const std::string & account_id,
+                                    const std::string & entity_id)
+{
+    std::string record(1, record_relation);
+    putNumber(toId(entity_id), record);
+    putString(account_id, record);
+    append(record);
+}
+
+void EntityLogStore::removeRelationByOther(const std::string & entity_id)
+{
+    std::string record(1, record_unrelate);
+    putNumber(toId(entity_id), record);
+    append(record);
+}
+
+/// \brief Write queued records to the end of the log.
+///
+/// The log is compacted afterwards if it has grown too large.
+int EntityLogStore::flush()
+{
+    if (m_logFd == -1) {
+        return -1;
+    }
+    std::size_t written = 0;
+    while (written < m_pending.size()) {
+        ssize_t n = ::write(m_logFd, m_pending.data() + written,
+                            m_pending.size() - written);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            log(ERROR, compose("Unable to write to %1: %2", m_logPath,
+                               strerror(errno)));
+            // Keep what was not written, to try again next time.
+            m_pending.erase(0, written);
+            m_logSize += written;
+            return -1;
+        }
+        written += n;
+    }
+    m_pending.clear();
+    m_logSize += written;
+
+    if (m_logSize > min_compact_size && m_logSize > m_snapshotSize) {
+        return compact();
+    }
+    return 0;
+}
+
+/// \brief Write the stored records of one entity.
+void EntityLogStore::encodeEntity(long id, const StoredEntity & ent,
+                                  std::string & out)
+{
+    std::string record(1, record_insert);
+    putNumber(id, record);
+    putString(ent.loc, record);
+    putString(ent.type, record);
+    putNumber((std::uint32_t)ent.seq, record);
+    putString(ent.location, record);
+    finishRecord(record, out);
+
+    for (auto & property : ent.properties) {
+        record.assign(1, record_property);
+        putNumber(id, record);
+        putString(property.first, record);
+        putString(property.second, record);
+        finishRecord(record, out);
+    }
+
+    if (!ent.thoughts.empty()) {
+        record.assign(1, record_thoughts);
+        putNumber(id, record);
+        putNumber(ent.thoughts.size(), record);
+        for (auto & thought : ent.thoughts) {
+            putString(thought, record);
+        }
+        finishRecord(record, out);
+    }
+
+    if (!ent.account.empty()) {
+        record.assign(1, record_relation);
+        putNumber(id, record);
+        putString(ent.account, record);
+        finishRecord(record, out);
+    }
+}
+
+/// \brief Replace the snapshot with the current state, and empty the log.
+///
+/// The new snapshot is written beside the old one and renamed over it, so
+/// a crash part way through leaves the old snapshot and the log, which
+/// still describe the world.
+int EntityLogStore::compact()
+{
+    if (m_logFd == -1) {
+        return -1;
+    }
+    std::string data;
+    // The highest id is kept even if that entity has been dropped, so it
+    // is not handed out again.
+    std::string record(1, record_last_id);
+    putNumber(m_lastId, record);
+    finishRecord(record, data);
+    for (auto & entry : m_entities) {
+        encodeEntity(entry.first, entry.second, data);
+    }
+
+    std::string tmp_path = m_snapshotPath + ".new";
+    int fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd == -1) {
+        log(ERROR, compose("Unable to open %1: %2", tmp_path,
+                           strerror(errno)));
+        return -1;
+    }
+    std::size_t written = 0;
+    while (written < data.size()) {
+        ssize_t n = ::write(fd, data.data() + written, data.size() - written);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            log(ERROR, compose("Unable to write to %1: %2", tmp_path,
+                               strerror(errno)));
+            ::close(fd);
+            ::unlink(tmp_path.c_str());
+            return -1;
+        }
+        written += n;
+    }
+    if (::fdatasync(fd) != 0 || ::close(fd) != 0 ||
+        ::rename(tmp_path.c_str(), m_snapshotPath.c_str()) != 0) {
+        log(ERROR, compose("Unable to replace %1: %2", m_snapshotPath,
+                           strerror(errno)));
+        ::unlink(tmp_path.c_str());
+        return -1;
+    }
+    m_snapshotSize = data.size();
+
+    // Everything in the log, and everything still queued for it, is now
+    // in the snapshot.
+    m_pending.clear();
+    if (::ftruncate(m_logFd, 0) != 0) {
+        // Replaying the log over the new snapshot still gives the same
+        // state, so this only costs time at startup.
+        log(WARNING, compose("Unable to truncate %1: %2", m_logPath,
+                             strerror(errno)));
+        return 0;
+    }
+    m_logSize = 0;
+    return 0;
+}
+
+/// \brief Get every stored entity.
+///
+/// The columns are id, loc, type, seq and location, as in
+/// Database::selectAllEntities().
+void EntityLogStore::selectAllEntities(StoredRows & rows) const
+{
+    for (auto & entry : m_entities) {
+        const StoredEntity & ent = entry.second;
+        rows.push_back({ std::to_string(entry.first), ent.loc, ent.type,
+                         std::to_string(ent.seq), ent.location });
+    }
+}
+
+/// \brief Get every stored property.
+///
+/// The columns are id, name and value.
+void EntityLogStore::selectAllProperties(StoredRows & rows) const
+{
+    for (auto & entry : m_entities) {
+        std::string id = std::to_string(entry.first);
+        for (auto & property : entry.second.properties) {
+            rows.push_back({ id, property.first, property.second });
+        }
+    }
+}
+
+/// \brief Get every stored thought.
+///
+/// The columns are id and thought.
+void EntityLogStore::selectAllThoughts(StoredRows & rows) const
+{
+    for (auto & entry : m_entities) {
+        std::string id = std::to_string(entry.first);
+        for (auto & thought : entry.second.thoughts) {
+            rows.push_back({ id, thought });
+        }
+    }
+}
+
+/// \brief Get the characters of an account.
+///
+/// The column is the id of the character, as in Database::selectRelation().
+void EntityLogStore::selectRelation(const std::string & account_id,
+                                    StoredRows & rows) const
+{
+    for (auto & entry : m_entities) {
+        if (entry.second.account == account_id) {
+            rows.push_back({ std::to_string(entry.first) });
+        }
+    }
+}
@@ -0,0 +1,130 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2015 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifndef SERVER_ENTITY_LOG_STORE_H
+#define SERVER_ENTITY_LOG_STORE_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+class DatabaseBatch;
+
+/// \brief Rows read from an EntityLogStore
+///
+/// Has the same columns as the rows selected from the database when the
+/// world is restored, so either can be used to restore it.
+class StoredRows {
+  protected:
+    std::vector<std::vector<std::string> > m_rows;
+  public:
+    int size() const { return m_rows.size(); }
+    bool error() const { return false; }
+
+    const char * field(int column, int row = 0) const {
+        return m_rows[row][column].c_str();
+    }
+
+    void push_back(std::vector<std::string> row) {
+        m_rows.push_back(std::move(row));
+    }
+};
+
+/// \brief World storage in local files, for servers without a database
+///
+/// Each change to the world is appended to a log file, and the log is
+/// replayed over a snapshot of the world when the server starts. The
+/// files are read by mapping them into memory. When the log has grown
+/// larger than the snapshot, the snapshot is written again from the
+/// current state and the log is emptied, so the time taken to start does
+/// not grow with the time the server has been running.
+///
+/// A record cut short when the server stopped is found by its length and
+/// checksum, and is dropped along with anything after it.
+class EntityLogStore {
+  protected:
+    /// \brief The stored state of one entity
+    struct StoredEntity {
+        std::string loc;
+        std::string type;
+        int seq;
+        std::string location;
+        std::map<std::string, std::string> properties;
+        std::vector<std::string> thoughts;
+        /// \brief Id of the account the entity is a character of, if any.
+        std::string account;
+    };
+    typedef std::map<long, StoredEntity> StoredEntityDict;
+
+    const std::string m_logPath;
+    const std::string m_snapshotPath;
+
+    StoredEntityDict m_entities;
+
+    /// \brief Records not yet written to the log.
+    std::string m_pending;
+
+    int m_logFd;
+    std::size_t m_logSize;
+    std::size_t m_snapshotSize;
+
+    /// \brief Highest entity id ever stored, including those which
+    /// have since been dropped.
+    long m_lastId;
+
+    void append(const std::string & record);
+    bool apply(const char * data, std::size_t len);
+    int replay(const std::string & path, std::size_t & valid);
+    void encodeEntity(long id, const StoredEntity & ent, std::string & out);
+  public:
+    explicit EntityLogStore(const std::string & path);
+    ~EntityLogStore();
+
+    int open();
+
+    void write(const DatabaseBatch & batch);
+    void dropEntity(long id);
+    void replaceThoughts(const std::string & id,
+                         const std::vector<std::string> & thoughts);
+    void createRelation(const std::string & account_id,
+                        const std::string & entity_id);
+    void removeRelationByOther(const std::string & entity_id);
+
+    int flush();
+    int compact();
+
+    void selectAllEntities(StoredRows & rows) const;
+    void selectAllProperties(StoredRows & rows) const;
+    void selectAllThoughts(StoredRows & rows) const;
+    void selectRelation(const std::string & account_id,
+                        StoredRows & rows) const;
+
+    long lastId() const {
+        return m_lastId;
+    }
+
+    std::size_t logSize() const {
+        return m_logSize;
+    }
+
+    std::size_t snapshotSize() const {
+        return m_snapshotSize;
+    }
+};
+
+#endif // SERVER_ENTITY_LOG_STORE_H
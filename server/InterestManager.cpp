@@ -0,0 +1,171 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2015 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#include "InterestManager.h"
+
+#include "rulesets/Domain.h"
+#include "rulesets/LocatedEntity.h"
+
+#include "common/debug.h"
+#include "common/Monitors.h"
+
+#include <sigc++/functors/mem_fun.h>
+#include <sigc++/adaptors/bind.h>
+
+#include <algorithm>
+
+static const bool debug_flag = false;
+
+InterestManager::InterestManager() :
+    m_broadcastCount(Monitors::instance()->counter("broadcasts")),
+    m_candidateCount(Monitors::instance()->counter("broadcast_candidates")),
+    m_observerCount(Monitors::instance()->counter("broadcast_deliveries"))
+{
+}
+
+/// \brief Put a perceptive entity in the group matching its container.
+void InterestManager::attach(LocatedEntity * perceptive,
+                             Registration & registration)
+{
+    LocatedEntity * container = perceptive->m_location.m_loc;
+    if (container != 0 && container->getFlags() & entity_domain) {
+        registration.m_domainEntity = container;
+        m_attached[container].insert(perceptive);
+    } else {
+        registration.m_domainEntity = 0;
+        m_detached.insert(perceptive);
+    }
+}
+
+/// \brief Remove a perceptive entity from the group it is in.
+void InterestManager::detach(LocatedEntity * perceptive,
+                             Registration & registration)
+{
+    if (registration.m_domainEntity == 0) {
+        m_detached.erase(perceptive);
+        return;
+    }
+    auto I = m_attached.find(registration.m_domainEntity);
+    if (I != m_attached.end()) {
+        I->second.erase(perceptive);
+        if (I->second.empty()) {
+            m_attached.erase(I);
+        }
+    }
+    registration.m_domainEntity = 0;
+}
+
+void InterestManager::perceptiveContainered(const LocatedEntity * oldLocation,
+                                            LocatedEntity * perceptive)
+{
+    auto I = m_perceptives.find(perceptive);
+    if (I == m_perceptives.end()) {
+        return;
+    }
+    detach(perceptive, I->second);
+    attach(perceptive, I->second);
+}
+
+/// \brief Add an entity to the set of perceptive entities.
+///
+/// This is called often for entities which are already registered,
+/// in which case it does nothing.
+void InterestManager::addPerceptive(LocatedEntity * perceptive)
+{
+    auto I = m_perceptives.find(perceptive);
+    if (I != m_perceptives.end()) {
+        return;
+    }
+    debug(std::cout << "InterestManager::addPerceptive "
+                    << perceptive->getId() << std::endl << std::flush;);
+    Registration & registration = m_perceptives[perceptive];
+    attach(perceptive, registration);
+    registration.m_containered = perceptive->containered.connect(
+          sigc::bind(sigc::mem_fun(this,
+                                   &InterestManager::perceptiveContainered),
+                     perceptive));
+}
+
+/// \brief Remove an entity from the set of perceptive entities.
+void InterestManager::removePerceptive(LocatedEntity * perceptive)
+{
+    auto I = m_perceptives.find(perceptive);
+    if (I == m_perceptives.end()) {
+        return;
+    }
+    I->second.m_containered.disconnect();
+    detach(perceptive, I->second);
+    m_perceptives.erase(I);
+}
+
+/// \brief Find the perceptive entities which can observe an entity.
+///
+/// The domain is asked which of its direct children are near enough to
+/// possibly see the observed entity. Of the perceptive entities which are
+/// direct children of the domain entity, only those need to be checked.
+/// All other perceptive entities are always checked.
+/// The observers are added to the vector in a stable order.
+/// @param observed the entity which is being observed
+/// @param domain the movement domain of the observed entity
+/// @param observers vector to which the observers are added
+void InterestManager::findObservers(const LocatedEntity & observed,
+                                    Domain & domain,
+                                    std::vector<LocatedEntity *> & observers)
+{
+    m_broadcastCount.increment();
+
+    std::vector<LocatedEntity *> candidates;
+    const LocatedEntity * domainEntity = &domain.getEntity();
+    if (domain.findObserverCandidates(observed, candidates)) {
+        auto I = m_attached.find(domainEntity);
+        if (I == m_attached.end()) {
+            candidates.clear();
+        } else {
+            const PerceptiveSet & local = I->second;
+            candidates.erase(std::remove_if(candidates.begin(),
+                                            candidates.end(),
+                                            [&](LocatedEntity * e) {
+                return local.find(e) == local.end();
+            }), candidates.end());
+        }
+        for (auto& group : m_attached) {
+            if (group.first != domainEntity) {
+                candidates.insert(candidates.end(), group.second.begin(),
+                                  group.second.end());
+            }
+        }
+        candidates.insert(candidates.end(), m_detached.begin(),
+                          m_detached.end());
+        // Deliver in the same order regardless of how they were found
+        std::sort(candidates.begin(), candidates.end());
+    } else {
+        candidates.reserve(m_perceptives.size());
+        for (auto& entry : m_perceptives) {
+            candidates.push_back(entry.first);
+        }
+    }
+
+    m_candidateCount.increment(candidates.size());
+
+    for (LocatedEntity * candidate : candidates) {
+        if (domain.isEntityVisibleFor(*candidate, observed)) {
+            observers.push_back(candidate);
+            m_observerCount.increment();
+        }
+    }
+}
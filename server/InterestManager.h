@@ -0,0 +1,108 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2015 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifndef SERVER_INTEREST_MANAGER_H
+#define SERVER_INTEREST_MANAGER_H
+
+#include "common/Metrics.h"
+
+#include <sigc++/connection.h>
+#include <sigc++/trackable.h>
+
+#include <map>
+#include <set>
+#include <vector>
+
+class Domain;
+class LocatedEntity;
+
+/// \brief Keeps track of which perceptive entities might observe a broadcast.
+///
+/// Perceptive entities which are direct children of an entity with a domain
+/// are grouped by that entity. When an entity broadcasts a perception, the
+/// domain it belongs to is asked for the children which are near enough to
+/// see it, which means that only those perceptive entities, and perceptive
+/// entities which aren't direct children of the domain entity, need to be
+/// checked for visibility.
+///
+/// The grouping is updated incrementally as perceptive entities change
+/// container, while the spatial part is maintained by the domain itself
+/// as entities move.
+class InterestManager : public sigc::trackable {
+  protected:
+    /// \brief Registration details of a perceptive entity.
+    struct Registration {
+        /// \brief The domain entity this is a direct child of, or null.
+        LocatedEntity * m_domainEntity;
+        /// \brief Connection to the containered signal of the entity.
+        sigc::connection m_containered;
+    };
+
+    typedef std::set<LocatedEntity *> PerceptiveSet;
+
+    /// \brief All perceptive entities.
+    std::map<LocatedEntity *, Registration> m_perceptives;
+    /// \brief Perceptive entities which are direct children of a domain
+    /// entity, keyed by that entity.
+    std::map<const LocatedEntity *, PerceptiveSet> m_attached;
+    /// \brief Perceptive entities which are not direct children of a
+    /// domain entity, and so always need to be checked.
+    PerceptiveSet m_detached;
+
+    /// \brief Count of broadcasts handled.
+    Counter m_broadcastCount;
+    /// \brief Count of perceptive entities checked for visibility.
+    Counter m_candidateCount;
+    /// \brief Count of perceptive entities which could see the broadcast.
+    Counter m_observerCount;
+
+    void attach(LocatedEntity * perceptive, Registration & registration);
+    void detach(LocatedEntity * perceptive, Registration & registration);
+    void perceptiveContainered(const LocatedEntity * oldLocation,
+                               LocatedEntity * perceptive);
+  public:
+    InterestManager();
+
+    void addPerceptive(LocatedEntity * perceptive);
+    void removePerceptive(LocatedEntity * perceptive);
+
+    void findObservers(const LocatedEntity & observed,
+                       Domain & domain,
+                       std::vector<LocatedEntity *> & observers);
+
+    /// \brief Check if an entity is registered as perceptive
+    bool isPerceptive(LocatedEntity * entity) const {
+        return m_perceptives.find(entity) != m_perceptives.end();
+    }
+
+    /// \brief Count of registered perceptive entities
+    std::size_t perceptiveCount() const {
+        return m_perceptives.size();
+    }
+
+    /// \brief Count of broadcasts handled
+    long broadcastCount() const { return m_broadcastCount.value(); }
+    /// \brief Count of perceptive entities checked for visibility
+    long candidateCount() const { return m_candidateCount.value(); }
+    /// \brief Count of perceptive entities which could see a broadcast
+    long observerCount() const { return m_observerCount.value(); }
+
+    friend class InterestManagertest;
+};
+
+#endif // SERVER_INTEREST_MANAGER_H
@@ -254,6 +254,10 @@ void Persistence::addCharacter(const Account & ac, const LocatedEntity & e)
 {
     //We can't insert the connection directly into the database, since the entity row
     //might not have been created. We'll instead emit a signal and rely on the StorageManager doing this for us.
+    if (characterAdded.empty()) {
+        // The world is not being stored.
+        return;
+    }
     AddCharacterData data;
     data.account_id = ac.getId();
     data.entity_id = e.getId();
@@ -267,6 +271,9 @@ void Persistence::addCharacter(const Account & ac, const LocatedEntity & e)
 
 void Persistence::delCharacter(const std::string & id)
 {
+    if (characterDeleted.empty()) {
+        return;
+    }
     bool handled = characterDeleted(id);
     if (!handled) {
         log(WARNING, String::compose("Nothing handled the character with id %1 being deleted.", id));
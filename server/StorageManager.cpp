@@ -18,6 +18,7 @@
 
 #include "StorageManager.h"
 
+#include "EntityLogStore.h"
 #include "WorldRouter.h"
 #include "EntityBuilder.h"
 #include "MindInspector.h"
@@ -27,6 +28,8 @@
 #include "rulesets/MindProperty.h"
 
 #include "common/Database.h"
+#include "common/DatabaseBatch.h"
+#include "common/Histogram.h"
 #include "common/TypeNode.h"
 #include "common/Property.h"
 #include "common/debug.h"
@@ -52,6 +55,7 @@
 #include <sigc++/functors/mem_fun.h>
 
 #include <iostream>
+#include <memory>
 #include <unordered_set>
 
 using Atlas::Message::MapType;
@@ -63,16 +67,44 @@ typedef Database::KeyValues KeyValues;
 
 static const bool debug_flag = false;
 
-StorageManager:: StorageManager(WorldRouter & world) :
+/// \brief Group the rows of a result by the entity id in one column.
+template <typename Rows>
+static void indexRows(const Rows & res, int column,
+                      std::unordered_map<std::string, std::vector<int> > & index)
+{
+    int rows = res.error() ? 0 : res.size();
+    for (int row = 0; row < rows; ++row) {
+        index[res.field(column, row)].push_back(row);
+    }
+}
+
+/// \brief Most rows written in one transaction.
+static const std::size_t max_batch_rows = 1000;
+
+/// \brief Most queries waiting before dirty entities are left for later.
+static const std::size_t max_pending_queries = 32;
+
+/// \brief Most times an entity is written again after its batch fails.
+static const int max_write_attempts = 3;
+
+StorageManager:: StorageManager(WorldRouter & world,
+                                EntityLogStore * logStore) :
         m_mindInspector(nullptr),
       m_insertEntityCount(0), m_updateEntityCount(0),
       m_insertPropertyCount(0), m_updatePropertyCount(0),
       m_insertQps(0), m_updateQps(0),
       m_insertQpsNow(0), m_updateQpsNow(0),
       m_insertQpsAvg(0), m_updateQpsAvg(0),
-      m_insertQpsIndex(0), m_updateQpsIndex(0)
+      m_insertQpsIndex(0), m_updateQpsIndex(0),
+      m_batchCount(0), m_batchRowCount(0), m_rowsPerSecond(0),
+      m_rowsSinceSample(0),
+      m_rowsSampleTime(std::chrono::steady_clock::now()),
+      m_batchLatency(Monitors::instance()->histogram(
+            "storage_batch_latency_seconds",
+            Histogram::exponentialBounds(0.001, 2., 14))),
+      m_logStore(logStore)
 {
-    if (database_flag) {
+    if (database_flag || m_logStore) {
 
         m_mindInspector = new MindInspector();
         m_mindInspector->ThoughtsReceived.connect(sigc::mem_fun(*this, &StorageManager::thoughtsReceived));
@@ -99,13 +131,22 @@ StorageManager:: StorageManager(WorldRouter & world) :
         Monitors::instance()->watch("storage_qps{qtype=\"updates\",t=\"32\"}",
                                     new Variable<int>(m_updateQpsAvg));
 
+        Monitors::instance()->watch("storage_batches",
+                                    new Variable<int>(m_batchCount));
+        Monitors::instance()->watch("storage_batch_rows",
+                                    new Variable<int>(m_batchRowCount));
+        Monitors::instance()->watch("storage_rows_per_second",
+                                    new Variable<int>(m_rowsPerSecond));
+
         for (int i = 0; i < 32; ++i) {
             m_insertQpsRing[i] = 0;
             m_updateQpsRing[i] = 0;
         }
 
-        Persistence::instance()->characterAdded.connect(sigc::mem_fun(*this, &StorageManager::persistance_characterAdded));
-        Persistence::instance()->characterDeleted.connect(sigc::mem_fun(*this, &StorageManager::persistance_characterDeleted));
+        if (database_flag || m_logStore) {
+            Persistence::instance()->characterAdded.connect(sigc::mem_fun(*this, &StorageManager::persistance_characterAdded));
+            Persistence::instance()->characterDeleted.connect(sigc::mem_fun(*this, &StorageManager::persistance_characterDeleted));
+        }
     }
 }
 
@@ -124,16 +165,17 @@ void StorageManager::entityInserted(LocatedEntity * ent)
     if (ent->getFlags() & (entity_clean)) {
         // This entity has just been restored from the database, so does
         // not need to be inserted, but will need to be updated.
-        // For non-restored entities that have been newly created this
-        // signal will be connected later once the initial database insert
-        // has been done.
         ent->updated.connect(sigc::bind(sigc::mem_fun(this, &StorageManager::entityUpdated), ent));
         ent->containered.connect(sigc::bind(sigc::mem_fun(this, &StorageManager::entityContainered), ent));
         return;
     }
-    // Queue the entity to be inserted into the persistence tables.
+    // Queue the entity to be inserted into the persistence tables. Changes
+    // made before it is inserted are ignored, as it is queued, and the
+    // insert writes them anyway.
     m_unstoredEntities.push_back(EntityRef(ent));
     ent->setFlags(entity_queued);
+    ent->updated.connect(sigc::bind(sigc::mem_fun(this, &StorageManager::entityUpdated), ent));
+    ent->containered.connect(sigc::bind(sigc::mem_fun(this, &StorageManager::entityContainered), ent));
 }
 
 /// \brief Called when an Entity is modified
@@ -157,6 +199,8 @@ void StorageManager::entityUpdated(LocatedEntity * ent)
 
 void StorageManager::entityContainered(const LocatedEntity *oldLocation, LocatedEntity *entity)
 {
+    // The new loc is written with the location.
+    entity->resetFlags(entity_pos_clean | entity_clean);
     entityUpdated(entity);
 }
 
@@ -176,29 +220,44 @@ void StorageManager::encodeProperty(PropertyBase * prop, std::string & store)
 {
     Atlas::Message::MapType map;
     prop->get(map["val"]);
-    Database::instance()->encodeObject(map, store);
+    Database::instance()->encodeMessage(map, store);
+}
+
+void StorageManager::replaceThoughts(const std::string & id,
+                                     const std::vector<std::string> & thoughts)
+{
+    if (m_logStore) {
+        m_logStore->replaceThoughts(id, thoughts);
+    } else {
+        Database::instance()->replaceThoughts(id, thoughts);
+    }
 }
 
-void StorageManager::restorePropertiesRecursively(LocatedEntity * ent)
+template <typename Rows>
+void StorageManager::restorePropertiesRecursively(LocatedEntity * ent,
+                                                  const Rows & properties,
+                                                  const RowIndex & propertyRows,
+                                                  const Rows & thoughts,
+                                                  const RowIndex & thoughtRows)
 {
     Database * db = Database::instance();
     PropertyManager * pm = PropertyManager::instance();
-    DatabaseResult res = db->selectProperties(ent->getId());
 
     //Keep track of those properties that have been set on the instance, so we'll know what
     //type properties we should ignore.
     std::unordered_set<std::string> instanceProperties;
 
-    DatabaseResult::const_iterator I = res.begin();
-    DatabaseResult::const_iterator Iend = res.end();
-    for (; I != Iend; ++I) {
-        const std::string name = I.column("name");
+    static const std::vector<int> no_rows;
+    RowIndex::const_iterator rows = propertyRows.find(ent->getId());
+    const std::vector<int> & entityRows = rows == propertyRows.end() ? no_rows : rows->second;
+    for (int row : entityRows) {
+        const std::string name = properties.field(1, row);
         if (name.empty()) {
             log(ERROR, compose("No name column in property row for %1",
                                ent->getId()));
             continue;
         }
-        const std::string val_string = I.column("value");
+        const std::string val_string = properties.field(2, row);
         if (name.empty()) {
             log(ERROR, compose("No value column in property row for %1,%2",
                                ent->getId(), name));
@@ -238,9 +297,11 @@ void StorageManager::restorePropertiesRecursively(LocatedEntity * ent)
         prop->apply(ent);
         instanceProperties.insert(name);
     }
+    // Everything set so far is what was stored.
+    ent->clearDirtyProperties();
 
     if (ent->getType()) {
-        for (auto& propIter : ent->getType()->defaults()) {
+        for (const auto & propIter : ent->getType()->defaults()) {
             if (!instanceProperties.count(propIter.first)) {
                 PropertyBase * prop = propIter.second;
                 // If a property is in the class it won't have been installed
@@ -257,7 +318,8 @@ void StorageManager::restorePropertiesRecursively(LocatedEntity * ent)
     //Now restore all properties of the child entities.
     if (ent->m_contains) {
         for (auto& childEntity : *ent->m_contains) {
-            restorePropertiesRecursively(childEntity);
+            restorePropertiesRecursively(childEntity, properties, propertyRows,
+                                         thoughts, thoughtRows);
         }
     }
 
@@ -282,20 +344,24 @@ void StorageManager::restorePropertiesRecursively(LocatedEntity * ent)
         ent->m_location.m_loc->sendWorld(sight);
     }
 
-    restoreThoughts(ent);
+    restoreThoughts(ent, thoughts, thoughtRows);
 
 }
 
-void StorageManager::restoreThoughts(LocatedEntity * ent)
+template <typename Rows>
+void StorageManager::restoreThoughts(LocatedEntity * ent,
+                                     const Rows & thoughts,
+                                     const RowIndex & thoughtRows)
 {
+    RowIndex::const_iterator rows = thoughtRows.find(ent->getId());
+    if (rows == thoughtRows.end()) {
+        return;
+    }
     Database * db = Database::instance();
-    const DatabaseResult res = db->selectThoughts(ent->getId());
     Atlas::Message::ListType thoughts_data;
 
-    DatabaseResult::const_iterator I = res.begin();
-    DatabaseResult::const_iterator Iend = res.end();
-    for (; I != Iend; ++I) {
-        const std::string thought = I.column("thought");
+    for (int row : rows->second) {
+        const std::string thought = thoughts.field(1, row);
         if (thought.empty()) {
             log(ERROR,
                     compose("No thought column in property row for %1",
@@ -349,7 +415,7 @@ bool StorageManager::storeThoughts(LocatedEntity * ent)
 }
 
 
-void StorageManager::insertEntity(LocatedEntity * ent)
+void StorageManager::insertEntity(LocatedEntity * ent, DatabaseBatch & batch)
 {
     std::string location;
     Atlas::Message::MapType map;
@@ -357,13 +423,13 @@ void StorageManager::insertEntity(LocatedEntity * ent)
     if (ent->m_location.orientation().isValid()) {
         map["orientation"] = ent->m_location.orientation().toAtlas();
     }
-    Database::instance()->encodeObject(map, location);
+    Database::instance()->encodeMessage(map, location);
 
-    Database::instance()->insertEntity(ent->getId(),
-                                       ent->m_location.m_loc->getId(),
-                                       ent->getType()->name(),
-                                       ent->getSeq(),
-                                       location);
+    batch.insertEntity(ent->getId(),
+                       ent->m_location.m_loc->getId(),
+                       ent->getType()->name(),
+                       ent->getSeq(),
+                       location);
     ++m_insertEntityCount;
     KeyValues property_tuples;
     const PropertyDict & properties = ent->getProperties();
@@ -378,14 +444,14 @@ void StorageManager::insertEntity(LocatedEntity * ent)
         prop->setFlags(per_clean | per_seen);
     }
     if (!property_tuples.empty()) {
-        Database::instance()->insertProperties(ent->getId(), property_tuples);
+        batch.insertProperties(ent->getId(), property_tuples);
         ++m_insertPropertyCount;
     }
+    ent->clearDirtyProperties();
     ent->resetFlags(entity_queued);
     ent->setFlags(entity_clean | entity_pos_clean | entity_orient_clean);
-    ent->updated.connect(sigc::bind(sigc::mem_fun(this, &StorageManager::entityUpdated), ent));
-    ent->containered.connect(sigc::bind(sigc::mem_fun(this, &StorageManager::entityContainered), ent));
-
+    m_batchedEntities.push_back(BatchedEntity{EntityRef(ent), true,
+                                              entity_clean_mask, {}});
 }
 
 void StorageManager::updateEntityThoughts(LocatedEntity * ent)
@@ -397,42 +463,53 @@ void StorageManager::updateEntityThoughts(LocatedEntity * ent)
         Atlas::Message::MapType map;
         thoughtOp->addToMessage(map);
         std::string value;
-        db->encodeObject(map, value);
+        db->encodeMessage(map, value);
         thoughtsList.push_back(value);
     }
-    db->replaceThoughts(ent->getId(), thoughtsList);
+    replaceThoughts(ent->getId(), thoughtsList);
 
     ent->resetFlags(entity_dirty_thoughts);
 }
 
-void StorageManager::updateEntity(LocatedEntity * ent)
+/// \brief Write the changes to an entity to the batch.
+///
+/// The location is only written if it has changed, and only properties
+/// recorded as changed by the entity are checked, rather than all of them.
+void StorageManager::updateEntity(LocatedEntity * ent, DatabaseBatch & batch)
 {
-    std::string location;
-    Atlas::Message::MapType map;
-    map["pos"] = ent->m_location.pos().toAtlas();
-    if (ent->m_location.orientation().isValid()) {
-        map["orientation"] = ent->m_location.orientation().toAtlas();
-    }
-    Database::instance()->encodeObject(map, location);
-
-    //Under normal circumstances only the top world won't have a location.
-    if (ent->m_location.m_loc) {
-        Database::instance()->updateEntity(ent->getId(),
-                                       ent->getSeq(),
-                                       location,
-                                       ent->m_location.m_loc->getId());
-    } else {
-        Database::instance()->updateEntityWithoutLoc(ent->getId(),
-                                       ent->getSeq(),
-                                       location);
+    BatchedEntity batched{EntityRef(ent), false, entity_clean, {}};
+    if ((ent->getFlags() & entity_location_clean) != entity_location_clean) {
+        std::string location;
+        Atlas::Message::MapType map;
+        map["pos"] = ent->m_location.pos().toAtlas();
+        if (ent->m_location.orientation().isValid()) {
+            map["orientation"] = ent->m_location.orientation().toAtlas();
+        }
+        Database::instance()->encodeMessage(map, location);
+
+        //Under normal circumstances only the top world won't have a location.
+        if (ent->m_location.m_loc) {
+            batch.updateEntity(ent->getId(),
+                               ent->getSeq(),
+                               location,
+                               ent->m_location.m_loc->getId());
+        } else {
+            batch.updateEntityWithoutLoc(ent->getId(),
+                                         ent->getSeq(),
+                                         location);
+        }
+        ++m_updateEntityCount;
+        batched.flags |= entity_location_clean;
     }
-    ++m_updateEntityCount;
     KeyValues new_property_tuples;
     KeyValues upd_property_tuples;
     const PropertyDict & properties = ent->getProperties();
-    PropertyDict::const_iterator I = properties.begin();
-    PropertyDict::const_iterator Iend = properties.end();
-    for (; I != Iend; ++I) {
+    for (int id : ent->getDirtyProperties()) {
+        PropertyDict::const_iterator I = properties.find(id);
+        if (I == properties.end()) {
+            // Removed since it changed
+            continue;
+        }
         PropertyBase * prop = I->second;
         if (prop->flags() & per_mask) {
             continue;
@@ -441,37 +518,139 @@ void StorageManager::updateEntity(LocatedEntity * ent)
         if (prop->flags() & per_seen) {
             encodeProperty(prop, upd_property_tuples[I->first]);
             ++m_updatePropertyCount;
+            batched.properties.push_back(std::make_pair(id, per_clean));
         } else {
             encodeProperty(prop, new_property_tuples[I->first]);
             ++m_insertPropertyCount;
+            batched.properties.push_back(std::make_pair(id, per_clean | per_seen));
         }
         prop->setFlags(per_clean | per_seen);
     }
+    ent->clearDirtyProperties();
     if (!new_property_tuples.empty()) {
-        Database::instance()->insertProperties(ent->getId(),
-                                               new_property_tuples);
+        batch.insertProperties(ent->getId(), new_property_tuples);
     }
     if (!upd_property_tuples.empty()) {
-        Database::instance()->updateProperties(ent->getId(),
-                                               upd_property_tuples);
+        batch.updateProperties(ent->getId(), upd_property_tuples);
+    }
+    ent->setFlags(entity_clean_mask);
+    if ((batched.flags & entity_location_clean) || !batched.properties.empty()) {
+        m_batchedEntities.push_back(std::move(batched));
+    }
+}
+
+/// \brief Send the rows collected in a batch to storage, and empty it.
+void StorageManager::scheduleBatch(DatabaseBatch & batch)
+{
+    if (batch.empty()) {
+        return;
+    }
+    typedef std::chrono::steady_clock clock;
+    clock::time_point start = clock::now();
+    int rows = (int)batch.rows();
+    auto batched = std::make_shared<BatchedEntities>();
+    batched->swap(m_batchedEntities);
+    auto done = [this, start, rows, batched]() {
+        m_batchLatency->observe(std::chrono::duration<double>(clock::now() - start).count());
+        ++m_batchCount;
+        m_batchRowCount += rows;
+        m_rowsSinceSample += rows;
+        batchWritten(*batched);
+    };
+    if (m_logStore) {
+        m_logStore->write(batch);
+        done();
+    } else {
+        auto error = [this, batched]() {
+            batchFailed(*batched);
+        };
+        Database::instance()->scheduleBatch(batch, done, error);
+    }
+    batch.clear();
+}
+
+/// \brief Mark the entities in a batch which failed dirty again.
+///
+/// None of the rows in a failed batch were written, so entities it
+/// inserted are queued to be inserted again, and the location and
+/// properties of entities it updated are queued to be written again.
+/// Each entity is then written in a batch of its own, so the row which
+/// caused the failure can be found, and it is given up on once it has
+/// been written again max_write_attempts times.
+void StorageManager::batchFailed(const BatchedEntities & batched)
+{
+    log(ERROR, compose("Writing a batch of %1 entities failed. "
+                       "They will be written again one at a time.",
+                       batched.size()));
+    for (const BatchedEntity & b : batched) {
+        LocatedEntity * ent = b.entity.get();
+        if (ent == 0 || ent->isDestroyed()) {
+            continue;
+        }
+        int attempts = ++m_failedEntities[ent->getIntId()];
+        if (attempts > max_write_attempts) {
+            log(ERROR, compose("Giving up writing entity %1 after %2 "
+                               "failed attempts.", ent->getId(), attempts));
+            m_failedEntities.erase(ent->getIntId());
+            continue;
+        }
+        ent->resetFlags(b.flags);
+        if (b.inserted) {
+            m_unstoredEntities.push_back(b.entity);
+            ent->setFlags(entity_queued);
+            continue;
+        }
+        const PropertyDict & properties = ent->getProperties();
+        for (auto & p : b.properties) {
+            PropertyDict::const_iterator I = properties.find(p.first);
+            if (I == properties.end()) {
+                continue;
+            }
+            I->second->resetFlags(p.second);
+            ent->markPropertyDirty(p.first);
+        }
+        entityUpdated(ent);
+    }
+}
+
+/// \brief Stop writing entities from a batch which succeeded on their own.
+void StorageManager::batchWritten(const BatchedEntities & batched)
+{
+    if (m_failedEntities.empty()) {
+        return;
+    }
+    for (const BatchedEntity & b : batched) {
+        if (b.entity.get() != 0) {
+            m_failedEntities.erase(b.entity->getIntId());
+        }
     }
-    ent->setFlags(entity_clean);
 }
 
-void StorageManager::restoreChildren(LocatedEntity * parent)
+/// \brief Check if an entity must be written in a batch of its own.
+bool StorageManager::writeAlone(LocatedEntity * ent) const
 {
+    return !m_failedEntities.empty() &&
+           m_failedEntities.find(ent->getIntId()) != m_failedEntities.end();
+}
+
+template <typename Rows>
+void StorageManager::restoreChildren(LocatedEntity * parent,
+                                     const Rows & entities,
+                                     const RowIndex & childRows)
+{
+    RowIndex::const_iterator rows = childRows.find(parent->getId());
+    if (rows == childRows.end()) {
+        return;
+    }
     Database * db = Database::instance();
-    DatabaseResult res = db->selectEntities(parent->getId());
     EntityBuilder * eb = EntityBuilder::instance();
 
-    // Iterate over res creating entities, and sorting out position, location
+    // Iterate over the rows creating entities, and sorting out position, location
     // and orientation. Restore children, but don't restore any properties yet.
-    DatabaseResult::const_iterator I = res.begin();
-    DatabaseResult::const_iterator Iend = res.end();
-    for (; I != Iend; ++I) {
-        const std::string id = I.column("id");
+    for (int row : rows->second) {
+        const std::string id = entities.field(0, row);
         const int int_id = forceIntegerId(id);
-        const std::string type = I.column("type");
+        const std::string type = entities.field(2, row);
         //By sending an empty attributes pointer we're telling the builder not to apply any default
         //attributes. We will instead apply all attributes ourselves when we later on restore attributes.
         Atlas::Objects::SmartPtr<Atlas::Objects::Entity::RootEntityData> attrs(nullptr);
@@ -483,7 +662,7 @@ void StorageManager::restoreChildren(LocatedEntity * parent)
             continue;
         }
         
-        const std::string location_string = I.column("location");
+        const std::string location_string = entities.field(4, row);
         MapType loc_data;
         db->decodeMessage(location_string, loc_data);
         child->m_location.readFromMessage(loc_data);
@@ -497,19 +676,26 @@ void StorageManager::restoreChildren(LocatedEntity * parent)
         child->m_location.m_loc = parent;
         child->setFlags(entity_clean | entity_pos_clean | entity_orient_clean);
         BaseWorld::instance().addEntity(child);
-        restoreChildren(child);
+        restoreChildren(child, entities, childRows);
     }
 }
 
 void StorageManager::tick()
 {
+    typedef std::chrono::steady_clock clock;
+
     int inserts = 0, updates = 0;
+    DatabaseBatch batch;
     int old_insert_queries = m_insertEntityCount + m_insertPropertyCount;
     int old_update_queries = m_updateEntityCount + m_updatePropertyCount;
 
     while (!m_destroyedEntities.empty()) {
         long id = m_destroyedEntities.front();
-        Database::instance()->dropEntity(id);
+        if (m_logStore) {
+            m_logStore->dropEntity(id);
+        } else {
+            Database::instance()->dropEntity(id);
+        }
         m_destroyedEntities.pop_front();
     }
 
@@ -517,37 +703,62 @@ void StorageManager::tick()
         const EntityRef & ent = m_unstoredEntities.front();
         if (ent.get() != 0) {
             debug( std::cout << "storing " << ent->getId() << std::endl << std::flush; );
-            insertEntity(ent.get());
+            bool alone = writeAlone(ent.get());
+            if (alone) {
+                scheduleBatch(batch);
+            }
+            insertEntity(ent.get(), batch);
             ++inserts;
+            if (alone || batch.rows() >= max_batch_rows) {
+                scheduleBatch(batch);
+            }
         } else {
             debug( std::cout << "deleted" << std::endl << std::flush; );
         }
         m_unstoredEntities.pop_front();
     }
 
+    // New entities go first, as other rows refer to them.
+    scheduleBatch(batch);
+
     while (!m_addedCharacters.empty()) {
         auto& data = m_addedCharacters.front();
-        Database::instance()->createRelationRow(Persistence::instance()->getCharacterAccountRelationName(), data.account_id, data.entity_id);
+        if (m_logStore) {
+            m_logStore->createRelation(data.account_id, data.entity_id);
+        } else {
+            Database::instance()->createRelationRow(Persistence::instance()->getCharacterAccountRelationName(), data.account_id, data.entity_id);
+        }
         m_addedCharacters.pop_front();
     }
 
     while (!m_deletedCharacters.empty()) {
         auto& entity_id = m_deletedCharacters.front();
-        Database::instance()->removeRelationRowByOther(Persistence::instance()->getCharacterAccountRelationName(), entity_id);
+        if (m_logStore) {
+            m_logStore->removeRelationByOther(entity_id);
+        } else {
+            Database::instance()->removeRelationRowByOther(Persistence::instance()->getCharacterAccountRelationName(), entity_id);
+        }
         m_deletedCharacters.pop_front();
     }
 
     while (!m_dirtyEntities.empty()) {
-        if (Database::instance()->queryQueueSize() > 200) {
+        if (Database::instance()->queryQueueSize() > max_pending_queries) {
             debug(std::cout << "Too many" << std::endl << std::flush;);
             break;
         }
         const EntityRef & ent = m_dirtyEntities.front();
         if (ent.get() != 0) {
-            if ((ent->getFlags() & entity_clean_mask) == 0) {
+            if ((ent->getFlags() & entity_clean_mask) != entity_clean_mask) {
                 debug( std::cout << "updating " << ent->getId() << std::endl << std::flush; );
-                updateEntity(ent.get());
+                bool alone = writeAlone(ent.get());
+                if (alone) {
+                    scheduleBatch(batch);
+                }
+                updateEntity(ent.get(), batch);
                 ++updates;
+                if (alone || batch.rows() >= max_batch_rows) {
+                    scheduleBatch(batch);
+                }
             }
             if ((ent->getFlags() & entity_dirty_thoughts) != 0) {
                 debug( std::cout << "updating thoughts " << ent->getId() << std::endl << std::flush; );
@@ -561,6 +772,20 @@ void StorageManager::tick()
         m_dirtyEntities.pop_front();
     }
 
+    scheduleBatch(batch);
+
+    if (m_logStore) {
+        m_logStore->flush();
+    }
+
+    clock::time_point now = clock::now();
+    double elapsed = std::chrono::duration<double>(now - m_rowsSampleTime).count();
+    if (elapsed >= 1.) {
+        m_rowsPerSecond = (int)(m_rowsSinceSample / elapsed);
+        m_rowsSinceSample = 0;
+        m_rowsSampleTime = now;
+    }
+
     if (inserts > 0 || updates > 0) {
         debug(std::cout << "I: " << inserts << " U: " << updates
                         << std::endl << std::flush;);
@@ -617,11 +842,11 @@ void StorageManager::thoughtsReceived(const std::string& entityId, const Operati
             for (auto& thoughtElement : thoughts) {
                 if (thoughtElement.isMap()) {
                     std::string value;
-                    db->encodeObject(thoughtElement.asMap(), value);
+                    db->encodeMessage(thoughtElement.asMap(), value);
                     thoughtsList.push_back(value);
                 }
             }
-            db->replaceThoughts(entityId, thoughtsList);
+            replaceThoughts(entityId, thoughtsList);
         }
 
     } else if (op->getClassNo()
@@ -646,21 +871,73 @@ int StorageManager::initWorld()
     return 0;
 }
 
-int StorageManager::restoreWorld()
+template <typename Rows>
+void StorageManager::restoreRows(const Rows & entities,
+                                 const Rows & properties,
+                                 const Rows & thoughts,
+                                 double readSeconds)
 {
-    log(INFO, "Starting restoring world from storage.");
+    typedef std::chrono::steady_clock clock;
+
     LocatedEntity * ent = &BaseWorld::instance().getRootEntity();
 
+    clock::time_point fetched = clock::now();
+    RowIndex childRows;
+    RowIndex propertyRows;
+    RowIndex thoughtRows;
+    indexRows(entities, 1, childRows);
+    indexRows(properties, 0, propertyRows);
+    indexRows(thoughts, 0, thoughtRows);
+    clock::time_point indexed = clock::now();
+
     //The order here is important. We want to restore the children before we restore the properties.
     //The reason for this is that some properties (such as "outfit") refer to child entities; if
     //the child isn't present when the property is installed there will be issues.
     //We do this by first restoring the children, without any properties, and the assigning the properties to
     //all entities in order.
-    restoreChildren(ent);
-
-    restorePropertiesRecursively(ent);
+    restoreChildren(ent, entities, childRows);
+    clock::time_point created = clock::now();
+
+    restorePropertiesRecursively(ent, properties, propertyRows,
+                                 thoughts, thoughtRows);
+    clock::time_point done = clock::now();
+
+    typedef std::chrono::duration<double> seconds;
+    log(INFO, compose("Completed restoring world from storage: %1 entities, "
+                      "%2 properties and %3 thoughts.",
+                      entities.size(), properties.size(), thoughts.size()));
+    log(INFO, compose("Restore took %1s reading, %2s indexing, "
+                      "%3s creating entities and %4s applying properties.",
+                      readSeconds,
+                      seconds(indexed - fetched).count(),
+                      seconds(created - indexed).count(),
+                      seconds(done - created).count()));
+}
 
-    log(INFO, "Completed restoring world from storage.");
+int StorageManager::restoreWorld()
+{
+    log(INFO, "Starting restoring world from storage.");
+    typedef std::chrono::steady_clock clock;
+    typedef std::chrono::duration<double> seconds;
+
+    // Read the whole world with one query per table, rather than one
+    // query per entity.
+    clock::time_point start = clock::now();
+    if (m_logStore) {
+        StoredRows entities, properties, thoughts;
+        m_logStore->selectAllEntities(entities);
+        m_logStore->selectAllProperties(properties);
+        m_logStore->selectAllThoughts(thoughts);
+        restoreRows(entities, properties, thoughts,
+                    seconds(clock::now() - start).count());
+    } else {
+        Database * db = Database::instance();
+        DatabaseResult entities = db->selectAllEntities();
+        DatabaseResult properties = db->selectAllProperties();
+        DatabaseResult thoughts = db->selectAllThoughts();
+        restoreRows(entities, properties, thoughts,
+                    seconds(clock::now() - start).count());
+    }
     return 0;
 }
 
@@ -699,3 +976,12 @@ size_t StorageManager::numberOfOutstandingThoughtRequests() const
     return m_outstandingThoughtRequests.size();
 }
 
+// Restoring from database results is also tested on its own.
+template void StorageManager::restoreChildren(LocatedEntity *,
+                                              const DatabaseResult &,
+                                              const RowIndex &);
+template void StorageManager::restorePropertiesRecursively(LocatedEntity *,
+                                                           const DatabaseResult &,
+                                                           const RowIndex &,
+                                                           const DatabaseResult &,
+                                                           const RowIndex &);
@@ -26,12 +26,18 @@
 
 #include <sigc++/trackable.h>
 
+#include <chrono>
 #include <deque>
 #include <string>
 #include <map>
 #include <set>
+#include <unordered_map>
+#include <vector>
 
+class DatabaseBatch;
 class Entity;
+class EntityLogStore;
+class Histogram;
 class WorldRouter;
 class PropertyBase;
 class MindInspector;
@@ -45,6 +51,9 @@ class StorageManager : public sigc::trackable {
     typedef std::deque<EntityRef> Entitystore;
     typedef std::deque<long> Idstore;
 
+    /// \brief Rows of a restore result, keyed by the id of an entity.
+    typedef std::unordered_map<std::string, std::vector<int> > RowIndex;
+
     /// \brief Queue of references to entities yet to be stored.
     Entitystore m_unstoredEntities;
 
@@ -87,23 +96,86 @@ class StorageManager : public sigc::trackable {
     int m_insertQpsRing[32];
     int m_updateQpsRing[32];
 
+    /// \brief Number of batches of rows written.
+    int m_batchCount;
+    /// \brief Number of rows written in batches.
+    int m_batchRowCount;
+    /// \brief Rows written per second, over the last sample period.
+    int m_rowsPerSecond;
+
+    int m_rowsSinceSample;
+    std::chrono::steady_clock::time_point m_rowsSampleTime;
+
+    /// \brief Seconds from a batch being scheduled to it being written.
+    Histogram * m_batchLatency;
+
+    /// \brief Local file storage used instead of the database, if set.
+    EntityLogStore * m_logStore;
+
+    /// \brief An entity with rows in a batch, and what to mark dirty
+    /// again if the batch fails.
+    struct BatchedEntity {
+        EntityRef entity;
+        /// \brief Set if the entity row is inserted rather than updated.
+        bool inserted;
+        /// \brief Entity flags to clear if the batch fails.
+        unsigned int flags;
+        /// \brief Properties written, with the flags to clear on each.
+        std::vector<std::pair<int, unsigned int> > properties;
+    };
+    typedef std::vector<BatchedEntity> BatchedEntities;
+
+    /// \brief Entities with rows in the batch currently being built.
+    BatchedEntities m_batchedEntities;
+
+    /// \brief Entities in batches which failed, with the number of failures.
+    ///
+    /// These are written in batches of their own until they succeed, so
+    /// one bad row can only hold back its own entity.
+    std::map<long, int> m_failedEntities;
+
+    void scheduleBatch(DatabaseBatch &);
+    void batchFailed(const BatchedEntities &);
+    void batchWritten(const BatchedEntities &);
+    bool writeAlone(LocatedEntity *) const;
+
     void entityInserted(LocatedEntity *);
     void entityUpdated(LocatedEntity *);
     void entityContainered(const LocatedEntity *oldLocation, LocatedEntity *entity);
 
     void encodeProperty(PropertyBase *, std::string &);
-    void restorePropertiesRecursively(LocatedEntity *);
-
-    void restoreThoughts(LocatedEntity *);
+    void replaceThoughts(const std::string & id,
+                         const std::vector<std::string> & thoughts);
+
+    template <typename Rows>
+    void restoreRows(const Rows & entities,
+                     const Rows & properties,
+                     const Rows & thoughts,
+                     double readSeconds);
+
+    template <typename Rows>
+    void restorePropertiesRecursively(LocatedEntity *,
+                                      const Rows & properties,
+                                      const RowIndex & propertyRows,
+                                      const Rows & thoughts,
+                                      const RowIndex & thoughtRows);
+
+    template <typename Rows>
+    void restoreThoughts(LocatedEntity *,
+                         const Rows & thoughts,
+                         const RowIndex & thoughtRows);
     /// \brief Requests thoughts from the entity, if it has a mind.
     ///
     /// \return True if a thoughts query was sent.
     bool storeThoughts(LocatedEntity *);
 
-    void insertEntity(LocatedEntity *);
-    void updateEntity(LocatedEntity *);
+    void insertEntity(LocatedEntity *, DatabaseBatch &);
+    void updateEntity(LocatedEntity *, DatabaseBatch &);
     void updateEntityThoughts(LocatedEntity *);
-    void restoreChildren(LocatedEntity *);
+    template <typename Rows>
+    void restoreChildren(LocatedEntity *,
+                         const Rows & entities,
+                         const RowIndex & childRows);
 
     /// \brief Callback for m_mindInspector when thoughts arrive.
     void thoughtsReceived(const std::string& entityId, const Operation& thoughts);
@@ -112,7 +184,7 @@ class StorageManager : public sigc::trackable {
     bool persistance_characterDeleted(const std::string& entityId);
 
   public:
-    StorageManager(WorldRouter &);
+    StorageManager(WorldRouter &, EntityLogStore * logStore = nullptr);
     virtual ~StorageManager();
 
     void tick();
@@ -24,6 +24,7 @@
 
 #include "rulesets/World.h"
 #include "rulesets/Domain.h"
+#include "rulesets/DomainSimulation.h"
 
 #include "common/id.h"
 #include "common/log.h"
@@ -36,7 +37,9 @@
 #include "common/serialno.h"
 #include "common/compose.hpp"
 #include "common/Inheritance.h"
+#include "common/Histogram.h"
 #include "common/Monitors.h"
+#include "common/OpBroadcast.h"
 #include "common/SystemTime.h"
 #include "common/Variable.h"
 #include "common/Tick.h"
@@ -46,6 +49,7 @@
 
 #include <sstream>
 #include <algorithm>
+#include <chrono>
 
 using Atlas::Message::Element;
 using Atlas::Message::MapType;
@@ -84,6 +88,7 @@ inline EntityScopedRef::~EntityScopedRef()
 WorldRouter::WorldRouter(const SystemTime & time) :
       BaseWorld(*new World(consts::rootWorldId, consts::rootWorldIntId)),
       m_operationsDispatcher([&](const Operation & op, LocatedEntity & from){this->operation(op, from);}, [&]()->double {return getTime();}),
+      m_domainSimulation(nullptr),
       m_entityCount(1)
           
 {
@@ -92,7 +97,7 @@ WorldRouter::WorldRouter(const SystemTime & time) :
     EntityBuilder::init();
     m_gameWorld.setType(Inheritance::instance().getType("world"));
     m_eobjects[m_gameWorld.getIntId()] = &m_gameWorld;
-    m_perceptives.insert(&m_gameWorld);
+    m_interestManager.addPerceptive(&m_gameWorld);
     //WorldTime tmp_date("612-1-1 08:57:00");
     Monitors::instance()->watch("entities", new Variable<int>(m_entityCount));
 }
@@ -108,6 +113,10 @@ WorldRouter::~WorldRouter()
                         << " entities" << std::endl << std::flush;);
     }
 
+    //Domains check for it when they are destroyed.
+    delete m_domainSimulation;
+    m_domainSimulation = nullptr;
+
     //Make sure to clear the queues first so that there's nothing referencing entities
     //in them.
     m_operationsDispatcher.clearQueues();
@@ -183,6 +192,12 @@ LocatedEntity * WorldRouter::addEntity(LocatedEntity * ent)
     //check that the child wasn't already present
     if (child_inserted) {
         ent->m_location.m_loc->incRef();
+        if (ent->m_location.m_loc->getFlags() & entity_domain) {
+            Domain* parentDomain = ent->m_location.m_loc->getMovementDomain();
+            if (parentDomain) {
+                parentDomain->addEntity(*ent);
+            }
+        }
     }
     // FIXME Should we call this every time a new child is inserted (now it's just called if the container is empty first
     if (cont_change) {
@@ -378,7 +393,7 @@ void WorldRouter::delEntity(LocatedEntity * ent)
         return;
     }
     assert(ent->getIntId() != 0);
-    m_perceptives.erase(ent);
+    m_interestManager.removePerceptive(ent);
     m_eobjects.erase(ent->getIntId());
     --m_entityCount;
     ent->destroy();
@@ -433,6 +448,42 @@ bool WorldRouter::broadcastPerception(const Operation & op) const
     return false;
 }
 
+/// \brief Get the latency histogram monitored with the given name,
+/// registering it if required.
+///
+/// Buckets step linearly within each power of ten from a microsecond
+/// to ten seconds, which keeps the error small for both cheap and
+/// expensive operations.
+Histogram * WorldRouter::latencyHistogram(const std::string & name)
+{
+    return Monitors::instance()->histogram(name,
+          Histogram::logLinearBounds(0.000001, 7));
+}
+
+/// \brief Get the histogram of time taken to route operations of the
+/// same class as the given operation.
+Histogram * WorldRouter::opLatency(const Operation & op)
+{
+    Histogram *& histogram = m_opLatency[op->getClassNo()];
+    if (histogram == nullptr) {
+        histogram = latencyHistogram(String::compose("op_seconds{op=\"%1\"}",
+                                                     op->getParents().front()));
+    }
+    return histogram;
+}
+
+/// \brief Get the histogram of time taken by entities of the given type
+/// to handle operations.
+Histogram * WorldRouter::typeLatency(const TypeNode * type)
+{
+    Histogram *& histogram = m_typeLatency[type];
+    if (histogram == nullptr) {
+        histogram = latencyHistogram(String::compose("entity_op_seconds{type=\"%1\"}",
+                                                     type ? type->name() : ""));
+    }
+    return histogram;
+}
+
 /// \brief Deliver an operation to its target.
 ///
 /// Pass the operation to the target entity. The resulting operations
@@ -456,7 +507,10 @@ void WorldRouter::deliverTo(const Operation & op, LocatedEntity & ent)
                         << op->getParents().front() << ":"
                         << op->getFrom() << ":" << op->getTo() << "}" << std::endl
                         << std::flush;);
+    auto start = std::chrono::steady_clock::now();
     ent.operation(op, res);
+    typeLatency(ent.getType())->observe(std::chrono::duration<double>(
+          std::chrono::steady_clock::now() - start).count());
     debug(std::cout << "WorldRouter::deliverTo done {"
                         << op->getParents().front() << ":"
                         << op->getFrom() << ":" << op->getTo() << "}" << std::endl
@@ -473,7 +527,21 @@ void WorldRouter::deliverTo(const Operation & op, LocatedEntity & ent)
 
 /// \brief Main in-game operation dispatch function.
 ///
-/// Operations are passed here when they are due for dispatch.
+/// Operations are passed here when they are due for dispatch. The time
+/// taken to route each operation is recorded by operation class, for the
+/// monitoring subsystem.
+/// @param op operation to be dispatched to the world.
+/// @param from entity the operation to be dispatched was send from.
+void WorldRouter::operation(const Operation & op, LocatedEntity & from)
+{
+    auto start = std::chrono::steady_clock::now();
+    routeOperation(op, from);
+    opLatency(op)->observe(std::chrono::duration<double>(
+          std::chrono::steady_clock::now() - start).count());
+}
+
+/// \brief Route an operation to the entities which should get it.
+///
 /// Determine the target of the operation and deliver it directly,
 /// or broadcast if broadcast is required. This function implements
 /// sight ranges for perception operations.
@@ -483,7 +551,7 @@ void WorldRouter::deliverTo(const Operation & op, LocatedEntity & ent)
 /// that it is possible that this entity has been destroyed, but it
 /// should still have a valid location, so can be used for range
 /// calculations.
-void WorldRouter::operation(const Operation & op, LocatedEntity & from)
+void WorldRouter::routeOperation(const Operation & op, LocatedEntity & from)
 {
     debug(std::cout << "WorldRouter::operation {"
                     << op->getParents().front() << ":"
@@ -523,12 +591,14 @@ void WorldRouter::operation(const Operation & op, LocatedEntity & from)
     } else if (broadcastPerception(op)) {
         auto fromDomain = from.getMovementDomain();
         if (fromDomain) {
-            // Where broadcasts go depends on type of op
-            for (auto& entity : m_perceptives) {
-                if (fromDomain->isEntityVisibleFor(*entity, from)) {
-                    op->setTo(entity->getId());
-                    deliverTo(op, *entity);
-                }
+            // Only perceptive entities which can see the sender get it
+            std::vector<LocatedEntity *> observers;
+            m_interestManager.findObservers(from, *fromDomain, observers);
+            // Lets connections share the encoded op, as only TO differs
+            OpBroadcast broadcast(op);
+            for (auto& entity : observers) {
+                op->setTo(entity->getId());
+                deliverTo(op, *entity);
             }
         }
     } else {
@@ -549,7 +619,7 @@ void WorldRouter::operation(const Operation & op, LocatedEntity & from)
 void WorldRouter::addPerceptive(LocatedEntity * perceptive)
 {
     debug(std::cout << "WorldRouter::addPerceptive" << std::endl << std::flush;);
-    m_perceptives.insert(perceptive);
+    m_interestManager.addPerceptive(perceptive);
 }
 
 /// Main world loop function.
@@ -564,12 +634,29 @@ void WorldRouter::addPerceptive(LocatedEntity * perceptive)
 /// without becoming unresponsive to client communications traffic.
 bool WorldRouter::idle()
 {
+    //Like Tick operations, movement stops while the world is suspended.
+    if (m_domainSimulation != nullptr && !m_isSuspended) {
+        m_domainSimulation->idle(getTime());
+    }
     return m_operationsDispatcher.idle();
 }
 
 
 double WorldRouter::secondsUntilNextOp() const {
-    return m_operationsDispatcher.secondsUntilNextOp();
+    double seconds = m_operationsDispatcher.secondsUntilNextOp();
+    if (m_domainSimulation != nullptr) {
+        seconds = std::min(seconds, m_domainSimulation->secondsUntilTick(getTime()));
+    }
+    return seconds;
+}
+
+void WorldRouter::setDomainThreads(int threads)
+{
+    delete m_domainSimulation;
+    m_domainSimulation = nullptr;
+    if (threads > 0) {
+        m_domainSimulation = new DomainSimulation(threads);
+    }
 }
 
 /// Find an entity of the given name. This is provided to allow administrators
@@ -22,12 +22,18 @@
 #include "common/BaseWorld.h"
 #include "common/OperationsDispatcher.h"
 
+#include "InterestManager.h"
+
 #include <list>
 #include <set>
 #include <queue>
+#include <unordered_map>
 
 
+class DomainSimulation;
+class Histogram;
 class Spawn;
+class TypeNode;
 
 typedef std::set<LocatedEntity *> EntitySet;
 typedef std::map<std::string, std::pair<Spawn *, std::string>> SpawnDict;
@@ -44,13 +50,25 @@ class WorldRouter : public BaseWorld {
     OperationsDispatcher m_operationsDispatcher;
     /// An ordered queue of suspended operations to be dispatched when resumed.
     OpQueue m_suspendedQueue;
-    /// List of perceptive entities.
-    EntitySet m_perceptives;
+    /// Moves the entities of all domains on worker threads, if enabled.
+    DomainSimulation * m_domainSimulation;
+    /// Perceptive entities, and which of them might see a broadcast.
+    InterestManager m_interestManager;
     /// Count of in world entities
     int m_entityCount;
     /// Map of spawns
     SpawnDict m_spawns;
+    /// Wall clock time taken by operation() for each class of operation.
+    std::unordered_map<int, Histogram *> m_opLatency;
+    /// Wall clock time taken by entities of each type to handle operations.
+    std::unordered_map<const TypeNode *, Histogram *> m_typeLatency;
+
+    Histogram * latencyHistogram(const std::string & name);
+    Histogram * opLatency(const Atlas::Objects::Operation::RootOperation &);
+    Histogram * typeLatency(const TypeNode *);
   protected:
+    void routeOperation(const Atlas::Objects::Operation::RootOperation &,
+                        LocatedEntity &);
     bool broadcastPerception(const Atlas::Objects::Operation::RootOperation &) const;
     void deliverTo(const Atlas::Objects::Operation::RootOperation &,
                    LocatedEntity &);
@@ -66,6 +84,19 @@ class WorldRouter : public BaseWorld {
      * @return Seconds.
      */
     double secondsUntilNextOp() const;
+
+    /// \brief Set the wall clock time each call to idle() may spend
+    /// dispatching operations.
+    void setDispatchBudget(double seconds) {
+        m_operationsDispatcher.setTimeBudget(seconds);
+    }
+
+    /// \brief Set the number of threads moving the entities of domains.
+    ///
+    /// With no threads each domain moves its own entities when its
+    /// entity gets a Tick operation.
+    void setDomainThreads(int threads);
+
     LocatedEntity * addEntity(LocatedEntity * obj);
     LocatedEntity * addNewEntity(const std::string & type,
                                  const Atlas::Objects::Entity::RootEntity &);
@@ -34,6 +34,7 @@
 #include "WorldRouter.h"
 #include "Ruleset.h"
 #include "StorageManager.h"
+#include "EntityLogStore.h"
 #include "IdleConnector.h"
 #include "Admin.h"
 #include "PossessionAuthenticator.h"
@@ -57,6 +58,7 @@
 #include "common/serialno.h"
 #include "common/SystemTime.h"
 #include "common/Monitors.h"
+#include "common/ScriptProfiler.h"
 
 #include <varconf/config.h>
 
@@ -203,6 +205,17 @@ int main(int argc, char ** argv)
 
     readConfigItem(instance, "usedatabase", database_flag);
 
+    std::string storage = "database";
+    readConfigItem(instance, "storage", storage);
+    if (storage == "log") {
+        // The world is stored in local files, and nothing else is stored.
+        database_flag = false;
+    } else if (storage != "database") {
+        log(ERROR, compose("Unknown storage \"%1\". Using the database.",
+                           storage));
+        storage = "database";
+    }
+
     // If we are a daemon logging to syslog, we need to set it up.
     initLogger();
 
@@ -232,6 +245,20 @@ int main(int argc, char ** argv)
         }
     }
 
+    EntityLogStore * log_store = nullptr;
+    if (storage == "log") {
+        std::string storage_file = var_directory + "/" + instance + "_world";
+        readConfigItem(instance, "storagefile", storage_file);
+        log_store = new EntityLogStore(storage_file);
+        if (log_store->open() != 0) {
+            log(CRITICAL, compose("Unable to open world storage in %1",
+                                  storage_file));
+            return EXIT_DATABASE_ERROR;
+        }
+        // Ids of stored entities must not be handed out again.
+        skipIds(log_store->lastId());
+    }
+
     // If the restricted flag is set in the config file, then we
     // don't allow connecting users to create accounts. Accounts must
     // be created manually by the server administrator.
@@ -280,11 +307,26 @@ int main(int argc, char ** argv)
 
     WorldRouter * world = new WorldRouter(time);
 
+    int dispatch_budget = 2000;
+    readConfigItem(instance, "dispatch_budget", dispatch_budget);
+    if (dispatch_budget < 0) {
+        dispatch_budget = 0;
+    }
+    world->setDispatchBudget(dispatch_budget / 1000000.);
+
+    int domain_threads = 0;
+    readConfigItem(instance, "domain_threads", domain_threads);
+    if (domain_threads > 0) {
+        log(INFO, compose("Moving entities in domains on %1 threads.",
+                          domain_threads));
+        world->setDomainThreads(domain_threads);
+    }
+
     Ruleset::init(ruleset_name);
 
     PossessionAuthenticator::init();
 
-    StorageManager * store = new StorageManager(*world);
+    StorageManager * store = new StorageManager(*world, log_store);
 
     // This ID is currently generated every time, but should perhaps be
     // persistent in future.
@@ -311,7 +353,7 @@ int main(int argc, char ** argv)
     IdleConnector* storage_idle = nullptr;
 
     CommPSQLSocket * dbsocket = nullptr;
-    if (database_flag) {
+    if (database_flag || log_store) {
         // log(INFO, _("Restoring world from database..."));
 
         store->restoreWorld();
@@ -323,13 +365,17 @@ int main(int argc, char ** argv)
 
         // log(INFO, _("Restored world."));
 
-        dbsocket = new CommPSQLSocket(*io_service,
-                Persistence::instance()->m_db);
+        if (database_flag) {
+            dbsocket = new CommPSQLSocket(*io_service,
+                    Persistence::instance()->m_db);
+        }
 
         storage_idle = new IdleConnector(*io_service);
         storage_idle->idling.connect(
                 sigc::mem_fun(store, &StorageManager::tick));
-    } else {
+    }
+
+    if (!database_flag) {
         std::string adminId;
         long intId = newId(adminId);
         assert(intId >= 0);
@@ -338,6 +384,22 @@ int main(int argc, char ** argv)
         server->addAccount(admin);
     }
 
+    int client_highwater = 4 * 1024 * 1024;
+    readConfigItem(instance, "client_highwater", client_highwater);
+    if (client_highwater < 0) {
+        client_highwater = 0;
+    }
+    std::string client_overflow = "drop";
+    readConfigItem(instance, "client_overflow", client_overflow);
+    CommAsioClient<ip::tcp>::OverflowPolicy overflowPolicy =
+            CommAsioClient<ip::tcp>::overflow_drop;
+    if (client_overflow == "disconnect") {
+        overflowPolicy = CommAsioClient<ip::tcp>::overflow_disconnect;
+    } else if (client_overflow != "drop") {
+        log(WARNING, String::compose("Unknown client overflow policy \"%1\". "
+                                     "Using \"drop\".", client_overflow));
+    }
+
     std::function<void(CommAsioClient<ip::tcp>&)> tcpAtlasStarter =
             [&](CommAsioClient<ip::tcp>& client) {
 
@@ -345,6 +407,7 @@ int main(int argc, char ** argv)
                 long c_iid = newId(connection_id);
                 //Turn off Nagle's algorithm to increase responsiveness.
                 client.getSocket().set_option(ip::tcp::no_delay(true));
+                client.setHighWaterMark(client_highwater, overflowPolicy);
                 client.startAccept(
                         new Connection(client, *server, "", connection_id, c_iid));
             };
@@ -663,6 +726,8 @@ int main(int argc, char ** argv)
 
     delete store;
 
+    delete log_store;
+
     delete world;
 
     delete dbsocket;
@@ -686,6 +751,7 @@ int main(int argc, char ** argv)
     delete global_conf;
 
     Monitors::cleanup();
+    ScriptProfiler::cleanup();
 
     log(INFO, "Clean shutdown complete.");
     logEvent(STOP, "- - - Standalone server shutdown");
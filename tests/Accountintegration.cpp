@@ -418,6 +418,7 @@ LocatedEntity * TestWorld::addNewEntity(const std::string &,
 #include "stubs/rulesets/stubDefaultLocationProperty.h"
 #include "stubs/rulesets/stubLimboProperty.h"
 #include "stubs/rulesets/stubDomainProperty.h"
+#include "stubs/rulesets/stubDomainSimulation.h"
 #include "stubs/rulesets/stubSuspendedProperty.h"
 #include "stubs/rulesets/stubProxyMind.h"
 #include "stubs/rulesets/stubBaseMind.h"
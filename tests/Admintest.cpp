@@ -39,6 +39,7 @@
 #include "common/debug.h"
 #include "common/Inheritance.h"
 #include "common/Monitor.h"
+#include "common/ScriptProfiler.h"
 
 #include <Atlas/Objects/Anonymous.h>
 #include <Atlas/Objects/Operation.h>
@@ -160,6 +161,7 @@ class Admintest : public Cyphesis::TestBase
     void test_GetOperation_rule_found();
     void test_GetOperation_rule_not_found();
     void test_GetOperation_unknown();
+    void test_GetOperation_profile();
     void test_SetOperation_no_args();
     void test_SetOperation_no_objtype();
     void test_SetOperation_no_id();
@@ -169,6 +171,7 @@ class Admintest : public Cyphesis::TestBase
     void test_SetOperation_rule_fail();
     void test_SetOperation_rule_success();
     void test_SetOperation_unknown();
+    void test_SetOperation_profile();
     void test_OtherOperation_known();
     void test_OtherOperation_monitor();
     void test_customMonitorOperation_succeed();
@@ -286,6 +289,7 @@ Admintest::Admintest() : m_server(0),
     ADD_TEST(Admintest::test_GetOperation_rule_found);
     ADD_TEST(Admintest::test_GetOperation_rule_not_found);
     ADD_TEST(Admintest::test_GetOperation_unknown);
+    ADD_TEST(Admintest::test_GetOperation_profile);
     ADD_TEST(Admintest::test_SetOperation_no_args);
     ADD_TEST(Admintest::test_SetOperation_no_objtype);
     ADD_TEST(Admintest::test_SetOperation_no_id);
@@ -295,6 +299,7 @@ Admintest::Admintest() : m_server(0),
     ADD_TEST(Admintest::test_SetOperation_rule_fail);
     ADD_TEST(Admintest::test_SetOperation_rule_success);
     ADD_TEST(Admintest::test_SetOperation_unknown);
+    ADD_TEST(Admintest::test_SetOperation_profile);
     ADD_TEST(Admintest::test_OtherOperation_known);
     ADD_TEST(Admintest::test_OtherOperation_monitor);
     ADD_TEST(Admintest::test_customMonitorOperation_succeed);
@@ -874,6 +879,39 @@ void Admintest::test_GetOperation_unknown()
                  Atlas::Objects::Operation::ERROR_NO);
 }
 
+void Admintest::test_GetOperation_profile()
+{
+    ScriptProfiler::instance()->record("Thing", "tick_operation", 0.2, 0.1);
+    ScriptProfiler::instance()->record("Thing", "move_operation", 0.2, 0.3);
+
+    Atlas::Objects::Operation::Get op;
+    OpVector res;
+
+    Anonymous arg;
+    arg->setObjtype("profile");
+    arg->setId("scripts");
+    arg->setAttr("count", 1);
+    op->setArgs1(arg);
+
+    m_account->GetOperation(op, res);
+
+    ASSERT_EQUAL(res.size(), 1u);
+
+    const Operation & reply = res.front();
+
+    ASSERT_EQUAL(reply->getClassNo(),
+                 Atlas::Objects::Operation::INFO_NO);
+    ASSERT_EQUAL(reply->getArgs().size(), 1u);
+
+    Element handlers;
+    ASSERT_EQUAL(reply->getArgs().front()->copyAttr("handlers", handlers), 0);
+    ASSERT_TRUE(handlers.isList());
+    ASSERT_EQUAL(handlers.List().size(), 1u);
+    ASSERT_TRUE(handlers.List().front().isMap());
+    ASSERT_EQUAL(handlers.List().front().Map().find("handler")->second.String(),
+                 "move_operation");
+}
+
 void Admintest::test_SetOperation_no_args()
 {
     Atlas::Objects::Operation::Set op;
@@ -1046,6 +1084,27 @@ void Admintest::test_SetOperation_unknown()
                  Atlas::Objects::Operation::ERROR_NO);
 }
 
+void Admintest::test_SetOperation_profile()
+{
+    Atlas::Objects::Operation::Set op;
+    OpVector res;
+
+    Anonymous arg;
+    arg->setObjtype("profile");
+    arg->setId("scripts");
+    arg->setAttr("enabled", 1);
+    op->setArgs1(arg);
+
+    m_account->SetOperation(op, res);
+
+    ASSERT_EQUAL(res.size(), 1u);
+    ASSERT_EQUAL(res.front()->getClassNo(),
+                 Atlas::Objects::Operation::INFO_NO);
+    ASSERT_TRUE(ScriptProfiler::instance()->enabled());
+
+    ScriptProfiler::instance()->setEnabled(false);
+}
+
 void Admintest::test_OtherOperation_known()
 {
     Operation op;
@@ -1848,6 +1907,8 @@ void Entity::setType(const TypeNode* t)
 }
 
 #include "stubs/rulesets/stubLocatedEntity.h"
+#include "stubs/common/stubMonitors.h"
+#include "stubs/common/stubVariable.h"
 
 
 Link::Link(CommSocket & socket, const std::string & id, long iid) :
@@ -186,6 +186,17 @@ int main()
         tw.getTime();
     }
 
+    {
+        // Test setting a simulated time, and going back to the clock
+        LocatedEntity wrld("1", 1);
+        TestWorld tw(wrld);
+
+        tw.setSimulatedTime(100.);
+        assert(tw.getTime() == 100.);
+        tw.setSimulatedTime(-1.);
+        assert(tw.getTime() != 100.);
+    }
+
     {
         // Test getting the uptime
         LocatedEntity wrld("1", 1);
@@ -0,0 +1,163 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2015 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "TestBase.h"
+
+#include "common/BinaryElement.h"
+
+using Atlas::Message::Element;
+using Atlas::Message::ListType;
+using Atlas::Message::MapType;
+
+class BinaryElementtest : public Cyphesis::TestBase
+{
+  public:
+    BinaryElementtest();
+
+    void setup();
+    void teardown();
+
+    void test_roundTrip();
+    void test_extremes();
+    void test_sharedKeys();
+    void test_textSafe();
+    void test_legacy();
+    void test_truncated();
+};
+
+BinaryElementtest::BinaryElementtest()
+{
+    ADD_TEST(BinaryElementtest::test_roundTrip);
+    ADD_TEST(BinaryElementtest::test_extremes);
+    ADD_TEST(BinaryElementtest::test_sharedKeys);
+    ADD_TEST(BinaryElementtest::test_textSafe);
+    ADD_TEST(BinaryElementtest::test_legacy);
+    ADD_TEST(BinaryElementtest::test_truncated);
+}
+
+void BinaryElementtest::setup()
+{
+}
+
+void BinaryElementtest::teardown()
+{
+}
+
+void BinaryElementtest::test_roundTrip()
+{
+    MapType pos;
+    pos["x"] = 1.5;
+    pos["y"] = -2.;
+    MapType val;
+    val["val"] = ListType(1, pos);
+    val["name"] = "it's";
+    val["count"] = -3;
+    val["empty"] = Element();
+
+    std::string data;
+    encodeBinaryElement(val, data);
+    ASSERT_TRUE(isBinaryElement(data));
+
+    MapType result;
+    ASSERT_EQUAL(decodeBinaryElement(data, result), 0);
+    ASSERT_TRUE(result == val);
+}
+
+void BinaryElementtest::test_extremes()
+{
+    MapType val;
+    val["max"] = (Atlas::Message::IntType)0x7fffffffffffffffL;
+    val["min"] = (Atlas::Message::IntType)(-0x7fffffffffffffffL - 1);
+    val["big"] = 1e300;
+    val["string"] = std::string(1000, 'x');
+
+    std::string data;
+    encodeBinaryElement(val, data);
+
+    MapType result;
+    ASSERT_EQUAL(decodeBinaryElement(data, result), 0);
+    ASSERT_TRUE(result == val);
+}
+
+void BinaryElementtest::test_sharedKeys()
+{
+    MapType pos;
+    pos["orientation"] = 1;
+    MapType one;
+    one["a"] = pos;
+    MapType two;
+    two["a"] = pos;
+    two["b"] = pos;
+
+    std::string data_one, data_two;
+    encodeBinaryElement(one, data_one);
+    encodeBinaryElement(two, data_two);
+    // The second use of a key is much shorter than the first
+    ASSERT_TRUE(data_two.size() < data_one.size() + 12);
+
+    MapType result;
+    ASSERT_EQUAL(decodeBinaryElement(data_two, result), 0);
+    ASSERT_TRUE(result == two);
+}
+
+void BinaryElementtest::test_textSafe()
+{
+    MapType val;
+    val["val"] = std::string("a'\\\0b", 5);
+
+    std::string data;
+    encodeBinaryElement(val, data);
+    ASSERT_EQUAL(data.find_first_of(std::string("'\\\0", 3)),
+                 std::string::npos);
+}
+
+void BinaryElementtest::test_legacy()
+{
+    std::string xml = "<atlas><map><int name=\"val\">1</int></map></atlas>";
+    ASSERT_TRUE(!isBinaryElement(xml));
+
+    MapType result;
+    ASSERT_EQUAL(decodeBinaryElement(xml, result), -1);
+}
+
+void BinaryElementtest::test_truncated()
+{
+    MapType val;
+    val["val"] = "some text";
+
+    std::string data;
+    encodeBinaryElement(val, data);
+
+    MapType result;
+    ASSERT_EQUAL(decodeBinaryElement(data.substr(0, data.size() - 4), result),
+                 -1);
+    ASSERT_EQUAL(decodeBinaryElement(data + "AAAA", result), -1);
+}
+
+int main()
+{
+    BinaryElementtest t;
+
+    return t.run();
+}
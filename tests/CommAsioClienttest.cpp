@@ -0,0 +1,322 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2015 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "TestBase.h"
+
+#include "server/CommAsioClient_impl.h"
+
+#include "common/OpBroadcast.h"
+
+#include <Atlas/Codecs/Bach.h>
+#include <Atlas/Objects/Operation.h>
+
+#include <boost/asio/local/connect_pair.hpp>
+#include <boost/asio/local/stream_protocol.hpp>
+
+using boost::asio::local::stream_protocol;
+
+class TestCommAsioClient : public CommAsioClient<stream_protocol>
+{
+  public:
+    TestCommAsioClient(boost::asio::io_service & io_service) :
+        CommAsioClient<stream_protocol>("test", io_service)
+    {
+        // Skip negotiation, and encode with a codec straight away
+        m_codec = new Atlas::Codecs::Bach(mStream, *this);
+        m_encoder = new Atlas::Objects::ObjectsEncoder(*m_codec);
+    }
+
+    bool test_writing() const { return mWriting; }
+    bool test_writeScheduled() const { return mWriteScheduled; }
+    std::size_t test_writingChunks() const { return mWritingChunks.size(); }
+    std::size_t test_pendingChunks() const { return mPendingChunks.size(); }
+    std::size_t test_queuedBytes() const { return mQueuedBytes; }
+    std::size_t test_bufferPool() const { return mBufferPool.size(); }
+    boost::asio::streambuf * test_writeBuffer() const { return mWriteBuffer; }
+
+    std::size_t test_backlog() const
+    {
+        return mQueuedBytes + mWriteBuffer->size();
+    }
+};
+
+class CommAsioClienttest : public Cyphesis::TestBase
+{
+  private:
+    boost::asio::io_service * m_io_service;
+    stream_protocol::socket * m_peer;
+    std::shared_ptr<TestCommAsioClient> m_client;
+
+    /// \brief Read everything the client has written so far
+    std::size_t readPeer();
+  public:
+    CommAsioClienttest();
+
+    void setup();
+    void teardown();
+
+    void test_coalesce();
+    void test_bufferReuse();
+    void test_dropStale();
+    void test_dropDisconnect();
+    void test_disconnect();
+    void test_noLimit();
+};
+
+CommAsioClienttest::CommAsioClienttest()
+{
+    ADD_TEST(CommAsioClienttest::test_coalesce);
+    ADD_TEST(CommAsioClienttest::test_bufferReuse);
+    ADD_TEST(CommAsioClienttest::test_dropStale);
+    ADD_TEST(CommAsioClienttest::test_dropDisconnect);
+    ADD_TEST(CommAsioClienttest::test_disconnect);
+    ADD_TEST(CommAsioClienttest::test_noLimit);
+}
+
+void CommAsioClienttest::setup()
+{
+    m_io_service = new boost::asio::io_service;
+    m_peer = new stream_protocol::socket(*m_io_service);
+    m_client = std::make_shared<TestCommAsioClient>(*m_io_service);
+    boost::asio::local::connect_pair(m_client->getSocket(), *m_peer);
+}
+
+void CommAsioClienttest::teardown()
+{
+    // Let any write still posted finish, so it releases the client
+    m_io_service->poll();
+    m_client.reset();
+    delete m_peer;
+    delete m_io_service;
+}
+
+std::size_t CommAsioClienttest::readPeer()
+{
+    std::size_t total = 0;
+    std::size_t available;
+    while ((available = m_peer->available()) != 0) {
+        std::vector<char> data(available);
+        total += boost::asio::read(*m_peer, boost::asio::buffer(data));
+    }
+    return total;
+}
+
+void CommAsioClienttest::test_coalesce()
+{
+    Atlas::Objects::Operation::Talk op;
+    op->setTo("1");
+
+    // Operations sent before control returns to the io service are
+    // written together.
+    ASSERT_EQUAL(m_client->send(op), 0);
+    ASSERT_EQUAL(m_client->send(op), 0);
+    ASSERT_TRUE(m_client->test_writeScheduled());
+    ASSERT_TRUE(!m_client->test_writing());
+
+    // A broadcast is queued behind what was encoded before it
+    Atlas::Objects::Operation::Sight sight;
+    sight->setTo("1");
+    {
+        OpBroadcast broadcast(sight);
+        ASSERT_EQUAL(m_client->sendBroadcast(sight, broadcast), 0);
+    }
+    ASSERT_EQUAL(m_client->test_pendingChunks(), 2u);
+    std::size_t queued = m_client->test_queuedBytes();
+
+    m_io_service->poll_one();
+
+    ASSERT_TRUE(!m_client->test_writeScheduled());
+    ASSERT_TRUE(m_client->test_writing());
+    ASSERT_EQUAL(m_client->test_writingChunks(), 2u);
+    ASSERT_EQUAL(m_client->test_pendingChunks(), 0u);
+
+    // While a write is in progress more data waits for it
+    ASSERT_EQUAL(m_client->send(op), 0);
+    ASSERT_TRUE(!m_client->test_writeScheduled());
+    std::size_t more = m_client->test_writeBuffer()->size();
+    ASSERT_NOT_EQUAL(more, 0u);
+
+    m_io_service->poll();
+
+    ASSERT_TRUE(!m_client->test_writing());
+    ASSERT_EQUAL(m_client->test_queuedBytes(), 0u);
+    ASSERT_EQUAL(m_client->test_writeBuffer()->size(), 0u);
+    ASSERT_EQUAL(readPeer(), queued + more);
+}
+
+void CommAsioClienttest::test_bufferReuse()
+{
+    Atlas::Objects::Operation::Talk op;
+    op->setTo("1");
+
+    boost::asio::streambuf * first = m_client->test_writeBuffer();
+    ASSERT_EQUAL(m_client->test_bufferPool(), 0u);
+
+    ASSERT_EQUAL(m_client->send(op), 0);
+    m_io_service->poll();
+
+    // The buffer written is kept once the write completes
+    ASSERT_EQUAL(m_client->test_bufferPool(), 1u);
+    boost::asio::streambuf * second = m_client->test_writeBuffer();
+    ASSERT_NOT_EQUAL(second, first);
+
+    ASSERT_EQUAL(m_client->send(op), 0);
+    m_io_service->poll_one();
+
+    // and used again for the next data to be encoded
+    ASSERT_EQUAL(m_client->test_writeBuffer(), first);
+    ASSERT_EQUAL(m_client->test_bufferPool(), 0u);
+
+    m_io_service->poll();
+
+    ASSERT_EQUAL(m_client->test_bufferPool(), 1u);
+    ASSERT_EQUAL(m_client->test_writeBuffer(), first);
+    readPeer();
+}
+
+void CommAsioClienttest::test_dropStale()
+{
+    Atlas::Objects::Operation::Talk op;
+    op->setTo("1");
+
+    m_client->setHighWaterMark(256, TestCommAsioClient::overflow_drop);
+
+    // Nothing is written while the io service doesn't run, so the
+    // backlog grows until it reaches the mark.
+    while (m_client->test_backlog() < 256) {
+        ASSERT_EQUAL(m_client->send(op), 0);
+    }
+    std::size_t backlog = m_client->test_backlog();
+    ASSERT_LESS(backlog, 512u);
+
+    // Perception of movement and changes is dropped
+    Atlas::Objects::Operation::Sight sight_move;
+    sight_move->setTo("1");
+    sight_move->setArgs1(Atlas::Objects::Operation::Move());
+    ASSERT_EQUAL(m_client->send(sight_move), 0);
+    ASSERT_EQUAL(m_client->test_backlog(), backlog);
+
+    Atlas::Objects::Operation::Sight sight_set;
+    sight_set->setTo("1");
+    sight_set->setArgs1(Atlas::Objects::Operation::Set());
+    ASSERT_EQUAL(m_client->send(sight_set), 0);
+    ASSERT_EQUAL(m_client->test_backlog(), backlog);
+
+    // Anything else is still sent
+    Atlas::Objects::Operation::Sight sight_talk;
+    sight_talk->setTo("1");
+    sight_talk->setArgs1(Atlas::Objects::Operation::Talk());
+    ASSERT_EQUAL(m_client->send(sight_talk), 0);
+    ASSERT_GREATER(m_client->test_backlog(), backlog);
+    ASSERT_TRUE(m_client->getSocket().is_open());
+
+    // Once the backlog is written, nothing is dropped
+    m_io_service->poll();
+    readPeer();
+    ASSERT_EQUAL(m_client->test_backlog(), 0u);
+    ASSERT_EQUAL(m_client->send(sight_move), 0);
+    ASSERT_GREATER(m_client->test_backlog(), 0u);
+}
+
+void CommAsioClienttest::test_dropDisconnect()
+{
+    Atlas::Objects::Operation::Talk op;
+    op->setTo("1");
+
+    m_client->setHighWaterMark(256, TestCommAsioClient::overflow_drop);
+
+    while (m_client->test_backlog() < 512) {
+        ASSERT_TRUE(m_client->getSocket().is_open());
+        ASSERT_EQUAL(m_client->send(op), 0);
+    }
+    ASSERT_TRUE(m_client->getSocket().is_open());
+
+    // At twice the mark the client is disconnected
+    std::size_t backlog = m_client->test_backlog();
+    ASSERT_EQUAL(m_client->send(op), 0);
+    ASSERT_EQUAL(m_client->test_backlog(), backlog);
+    ASSERT_TRUE(!m_client->getSocket().is_open());
+}
+
+void CommAsioClienttest::test_disconnect()
+{
+    Atlas::Objects::Operation::Talk op;
+    op->setTo("1");
+
+    m_client->setHighWaterMark(256, TestCommAsioClient::overflow_disconnect);
+
+    while (m_client->test_backlog() < 256) {
+        ASSERT_TRUE(m_client->getSocket().is_open());
+        ASSERT_EQUAL(m_client->send(op), 0);
+    }
+    ASSERT_TRUE(m_client->getSocket().is_open());
+
+    // At the mark the client is disconnected
+    std::size_t backlog = m_client->test_backlog();
+    ASSERT_EQUAL(m_client->send(op), 0);
+    ASSERT_EQUAL(m_client->test_backlog(), backlog);
+    ASSERT_TRUE(!m_client->getSocket().is_open());
+}
+
+void CommAsioClienttest::test_noLimit()
+{
+    Atlas::Objects::Operation::Sight sight_move;
+    sight_move->setTo("1");
+    sight_move->setArgs1(Atlas::Objects::Operation::Move());
+
+    // Without a mark nothing is dropped however big the backlog is
+    while (m_client->test_backlog() < 4096) {
+        std::size_t backlog = m_client->test_backlog();
+        ASSERT_EQUAL(m_client->send(sight_move), 0);
+        ASSERT_GREATER(m_client->test_backlog(), backlog);
+    }
+    ASSERT_TRUE(m_client->getSocket().is_open());
+}
+
+int main()
+{
+    CommAsioClienttest t;
+
+    return t.run();
+}
+
+// stubs
+
+#include "common/log.h"
+
+CommSocket::CommSocket(boost::asio::io_service & svr) : m_io_service(svr) { }
+
+CommSocket::~CommSocket()
+{
+}
+
+int CommSocket::flush()
+{
+    return 0;
+}
+
+void log(LogLevel, const std::string & msg)
+{
+}
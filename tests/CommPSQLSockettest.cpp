@@ -67,7 +67,7 @@ int Database::initConnection()
 {
 }
 
-void Database::queryResult(ExecStatusType status)
+void Database::queryResult(PGresult * res)
 {
 }
 
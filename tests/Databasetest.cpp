@@ -24,15 +24,57 @@
 #endif
 
 #include "common/Database.h"
+#include "common/DatabaseBatch.h"
 
 #include "common/const.h"
 #include "common/compose.hpp"
 #include "common/log.h"
 
 #include <cstdlib>
+#include <cstring>
 
 #include <cassert>
 
+class TestDatabase : public Database
+{
+  public:
+    void test_setIdBlock(int size, long next)
+    {
+        m_idBlockSize = size;
+        m_nextId = next;
+        m_idBlockEnd = next + size;
+    }
+
+    long test_spareIdBlock() const { return m_spareIdBlock; }
+    bool test_idBlockPending() const { return m_idBlockPending; }
+
+    /// \brief Complete the oldest query as if it returned one value
+    void test_completeQuery(const char * value)
+    {
+        DatabaseQuery q = pendingQueries.front();
+        pendingQueries.pop_front();
+        PGresult * res = PQmakeEmptyPGresult(0, PGRES_TUPLES_OK);
+        PGresAttDesc attr = { (char *)"setval", 0, 0, 0, 20, 8, -1 };
+        PQsetResultAttrs(res, 1, &attr);
+        PQsetvalue(res, 0, 0, (char *)value, strlen(value));
+        q.result(res);
+        PQclear(res);
+        q.done();
+    }
+
+    /// \brief Make the oldest query the one in progress
+    ///
+    /// Once cleared it reserves the block starting at start.
+    void test_startQuery(long start)
+    {
+        m_queryInProgress = true;
+        pendingQueries.front().done = [this, start]() {
+            m_spareIdBlock = start;
+            m_idBlockPending = false;
+        };
+    }
+};
+
 int main()
 {
     {
@@ -71,6 +113,96 @@ int main()
         Database::cleanup();
     }
 
+    {
+        DatabaseBatch batch;
+
+        assert(batch.empty());
+        assert(batch.statementCount() == 0);
+        assert(batch.query().empty());
+    }
+
+    {
+        DatabaseBatch batch;
+        DatabaseBatch::KeyValues tuples;
+        tuples["mass"] = "m";
+        tuples["status"] = "s";
+
+        batch.insertEntity("2", "0", "thing", 1, "l");
+        batch.insertProperties("2", tuples);
+        batch.updateEntity("3", 4, "l", "2");
+        batch.updateEntityWithoutLoc("0", 5, "l");
+        batch.updateProperties("3", tuples);
+
+        assert(batch.rows() == 7);
+        assert(batch.statementCount() == 4);
+        assert(batch.query() ==
+               "INSERT INTO entities VALUES (2, 0, 'thing', 1, 'l'); "
+               "UPDATE entities AS e SET seq = v.seq, "
+               "location = v.location, loc = COALESCE(v.loc, e.loc) "
+               "FROM (VALUES (3, 4, 'l', 2), (0, 5, 'l', NULL::integer)) "
+               "AS v(id, seq, location, loc) WHERE e.id = v.id; "
+               "INSERT INTO properties VALUES "
+               "(2, 'mass', 'm'), (2, 'status', 's'); "
+               "UPDATE properties AS p SET value = v.value FROM (VALUES "
+               "(3, 'mass', 'm'), (3, 'status', 's')) "
+               "AS v(id, name, value) "
+               "WHERE p.id = v.id AND p.name = v.name; ");
+
+        batch.clear();
+        assert(batch.empty());
+    }
+
+    {
+        TestDatabase db;
+        db.test_setIdBlock(10, 100);
+        std::string id;
+
+        // The next block is reserved once half of this one is used
+        for (long i = 100; i < 105; ++i) {
+            assert(db.newId(id) == i);
+            assert(!db.test_idBlockPending());
+        }
+        assert(db.newId(id) == 105);
+        assert(id == "105");
+        assert(db.test_idBlockPending());
+        assert(db.queryQueueSize() == 1);
+
+        // Only once
+        assert(db.newId(id) == 106);
+        assert(db.queryQueueSize() == 1);
+
+        db.test_completeQuery("209");
+        assert(!db.test_idBlockPending());
+        assert(db.test_spareIdBlock() == 200);
+
+        // Ids carry on from the reserved block once this one is used up
+        assert(db.newId(id) == 107);
+        assert(db.newId(id) == 108);
+        assert(db.newId(id) == 109);
+        assert(db.newId(id) == 200);
+        assert(db.test_spareIdBlock() == -1);
+        assert(db.queryQueueSize() == 0);
+    }
+
+    {
+        TestDatabase db;
+        db.test_setIdBlock(2, 100);
+        std::string id;
+
+        assert(db.newId(id) == 100);
+        assert(!db.test_idBlockPending());
+        assert(db.newId(id) == 101);
+        assert(db.test_idBlockPending());
+
+        // The block runs out while it is still being reserved. It is
+        // waited for rather than reserving another, which would need a
+        // connection.
+        db.test_startQuery(300);
+        assert(db.newId(id) == 300);
+        assert(!db.queryInProgress());
+        assert(db.queryQueueSize() == 0);
+    }
+
 
     return 0;
 }
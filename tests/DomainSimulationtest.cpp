@@ -0,0 +1,371 @@
+/*
+ Copyright (C) 2015 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "TestBase.h"
+#include "TestWorld.h"
+
+#include "rulesets/DomainSimulation.h"
+#include "rulesets/PhysicalDomain.h"
+#include "rulesets/LocatedEntity.h"
+
+#include "common/const.h"
+
+#include <Atlas/Objects/Operation.h>
+
+#include <wfmath/stream.h>
+
+#include <iomanip>
+#include <limits>
+#include <random>
+#include <sstream>
+
+static std::ostringstream world_trace;
+
+class TestLocatedEntity : public LocatedEntity {
+  public:
+    TestLocatedEntity(const std::string & id, long intId) :
+                      LocatedEntity(id, intId) { }
+
+    virtual void externalOperation(const Operation &, Link &) { }
+    virtual void operation(const Operation &, OpVector &) { }
+
+    virtual void destroy() { }
+};
+
+class DomainSimulationtest : public Cyphesis::TestBase
+{
+  protected:
+    TestLocatedEntity * m_root;
+    TestWorld * m_world;
+
+    std::string runWorld(int threads);
+  public:
+    DomainSimulationtest();
+
+    void setup();
+    void teardown();
+
+    void test_idle();
+    void test_removeDomain();
+    void test_nested();
+    void test_deterministic();
+};
+
+DomainSimulationtest::DomainSimulationtest()
+{
+    ADD_TEST(DomainSimulationtest::test_idle);
+    ADD_TEST(DomainSimulationtest::test_removeDomain);
+    ADD_TEST(DomainSimulationtest::test_nested);
+    ADD_TEST(DomainSimulationtest::test_deterministic);
+}
+
+void DomainSimulationtest::setup()
+{
+    m_root = new TestLocatedEntity("0", 0);
+    m_world = new TestWorld(*m_root);
+    world_trace.str("");
+}
+
+void DomainSimulationtest::teardown()
+{
+    delete m_world;
+    delete m_root;
+}
+
+void DomainSimulationtest::test_idle()
+{
+    DomainSimulation simulation(0);
+    ASSERT_EQUAL(DomainSimulation::instance(), &simulation);
+    ASSERT_EQUAL(simulation.secondsUntilTick(0.),
+                 std::numeric_limits<double>::infinity());
+
+    TestLocatedEntity domain_entity("1", 1);
+    domain_entity.makeContainer();
+    PhysicalDomain domain(domain_entity);
+
+    TestLocatedEntity mover("2", 2);
+    mover.m_location.m_loc = &domain_entity;
+    mover.m_location.m_pos = Point3D(0, 0, 0);
+    mover.m_location.m_velocity = Vector3D(1, 0, 0);
+    mover.m_location.update(0.);
+    domain_entity.m_contains->insert(&mover);
+
+    simulation.idle(0.);
+    ASSERT_TRUE(domain.addMovingEntity(mover, 1));
+    // Domains don't send Tick operations when the simulation moves them
+    ASSERT_TRUE(world_trace.str().empty());
+    ASSERT_EQUAL(simulation.secondsUntilTick(0.5), 0.);
+
+    simulation.idle(1.);
+    ASSERT_EQUAL(mover.m_location.pos(), Point3D(1, 0, 0));
+
+    // Nothing happens until the next tick is due
+    simulation.idle(2.);
+    ASSERT_EQUAL(mover.m_location.pos(), Point3D(1, 0, 0));
+    ASSERT_EQUAL(simulation.secondsUntilTick(2.), consts::move_tick - 1.);
+
+    simulation.idle(1. + consts::move_tick);
+    ASSERT_EQUAL(mover.m_location.pos(), Point3D(1 + consts::move_tick, 0, 0));
+
+    domain.removeMovingEntity(mover);
+    mover.m_location.m_loc = 0;
+}
+
+void DomainSimulationtest::test_removeDomain()
+{
+    DomainSimulation simulation(2);
+
+    TestLocatedEntity domain_entity("1", 1);
+    domain_entity.makeContainer();
+    PhysicalDomain* domain = new PhysicalDomain(domain_entity);
+
+    TestLocatedEntity mover("2", 2);
+    mover.m_location.m_loc = &domain_entity;
+    mover.m_location.m_pos = Point3D(0, 0, 0);
+    mover.m_location.m_velocity = Vector3D(1, 0, 0);
+    mover.m_location.update(0.);
+    domain_entity.m_contains->insert(&mover);
+
+    ASSERT_TRUE(domain->addMovingEntity(mover, 1));
+    simulation.tick(1.);
+    ASSERT_EQUAL(mover.m_location.pos(), Point3D(1, 0, 0));
+
+    // Once the domain has nothing to move it's dropped
+    domain->removeMovingEntity(mover);
+    simulation.tick(2.);
+    ASSERT_EQUAL(simulation.secondsUntilTick(2.),
+                 std::numeric_limits<double>::infinity());
+
+    // Entities are handed back to their own Update operations when the
+    // domain is removed from an entity which stays
+    ASSERT_TRUE(domain->addMovingEntity(mover, 2));
+    world_trace.str("");
+    domain->releaseMovingEntities();
+    ASSERT_TRUE(!domain->hasMovingEntities());
+    ASSERT_EQUAL(world_trace.str(), "update 2 2 2\n");
+
+    // Destroyed domains are removed straight away, and don't send
+    // operations to entities which may be going away too
+    ASSERT_TRUE(domain->addMovingEntity(mover, 3));
+    world_trace.str("");
+    delete domain;
+    ASSERT_TRUE(world_trace.str().empty());
+    simulation.tick(3.);
+    ASSERT_EQUAL(mover.m_location.pos(), Point3D(1, 0, 0));
+
+    mover.m_location.m_loc = 0;
+}
+
+void DomainSimulationtest::test_nested()
+{
+    DomainSimulation simulation(2);
+
+    TestLocatedEntity outer_entity("1", 1);
+    outer_entity.makeContainer();
+    PhysicalDomain outer(outer_entity);
+
+    TestLocatedEntity inner_entity("2", 2);
+    inner_entity.makeContainer();
+    inner_entity.m_location.m_loc = &outer_entity;
+    inner_entity.m_location.m_pos = Point3D(0, 0, 0);
+    inner_entity.m_location.m_velocity = Vector3D(1, 0, 0);
+    inner_entity.m_location.update(0.);
+    outer_entity.m_contains->insert(&inner_entity);
+    PhysicalDomain inner(inner_entity);
+
+    TestLocatedEntity mover("3", 3);
+    mover.m_location.m_loc = &inner_entity;
+    mover.m_location.m_pos = Point3D(0, 0, 0);
+    mover.m_location.m_velocity = Vector3D(1, 0, 0);
+    mover.m_location.update(0.);
+    inner_entity.m_contains->insert(&mover);
+
+    ASSERT_TRUE(inner.addMovingEntity(mover, 1));
+    // Only the inner domain is being moved, so it can be moved on its own
+    ASSERT_TRUE(!simulation.isInsideSimulatedDomain(inner));
+
+    ASSERT_TRUE(outer.addMovingEntity(inner_entity, 1));
+    // Now it has to wait for the domain it's in
+    ASSERT_TRUE(simulation.isInsideSimulatedDomain(inner));
+    ASSERT_TRUE(!simulation.isInsideSimulatedDomain(outer));
+
+    simulation.tick(1.);
+    ASSERT_EQUAL(inner_entity.m_location.pos(), Point3D(1, 0, 0));
+    ASSERT_EQUAL(mover.m_location.pos(), Point3D(1, 0, 0));
+
+    outer.removeMovingEntity(inner_entity);
+    inner.removeMovingEntity(mover);
+    mover.m_location.m_loc = 0;
+    inner_entity.m_location.m_loc = 0;
+}
+
+/// \brief Moves entities in a few domains for a while, and records what
+/// happened.
+///
+/// The result is the operations which were sent, and the positions of all
+/// entities after each tick.
+std::string DomainSimulationtest::runWorld(int threads)
+{
+    static const int domain_count = 6;
+    static const int entity_count = 300;
+    static const int ticks = 30;
+
+    world_trace.str("");
+    world_trace << std::setprecision(9);
+
+    std::mt19937 generator(4711);
+    std::uniform_real_distribution<float> position(0.f, 200.f);
+    std::uniform_real_distribution<float> speed(-2.f, 2.f);
+
+    DomainSimulation simulation(threads);
+
+    std::vector<TestLocatedEntity*> entities;
+    std::vector<PhysicalDomain*> domains;
+    for (int d = 0; d < domain_count; ++d) {
+        long id = 100 + d;
+        TestLocatedEntity* domain_entity = new TestLocatedEntity(std::to_string(id), id);
+        domain_entity->makeContainer();
+        // The last one is inside the first, so it isn't isolated and is
+        // moved on the calling thread.
+        if (d == domain_count - 1) {
+            domain_entity->m_location.m_loc = entities.front();
+            domain_entity->m_location.m_pos = Point3D(50, 50, 0);
+        }
+        entities.push_back(domain_entity);
+        domains.push_back(new PhysicalDomain(*domain_entity));
+    }
+    ASSERT_TRUE(domains.front()->isIsolated());
+    ASSERT_TRUE(!domains.back()->isIsolated());
+
+    std::vector<TestLocatedEntity*> movers;
+    for (int d = 0; d < domain_count; ++d) {
+        for (int i = 0; i < entity_count; ++i) {
+            long id = 1000 + d * entity_count + i;
+            TestLocatedEntity* mover = new TestLocatedEntity(std::to_string(id), id);
+            Location& location = mover->m_location;
+            location.m_loc = entities[d];
+            location.m_pos = Point3D(position(generator), position(generator), 0);
+            location.m_velocity = Vector3D(speed(generator), speed(generator), 0);
+            if (i % 3 != 0) {
+                location.m_bBox = BBox(Point3D(-.5f, -.5f, 0), Point3D(.5f, .5f, 2));
+            }
+            location.update(0.);
+            entities[d]->m_contains->insert(mover);
+            movers.push_back(mover);
+        }
+    }
+    for (int d = 0; d < domain_count; ++d) {
+        for (LocatedEntity* child : *entities[d]->m_contains) {
+            ASSERT_TRUE(domains[d]->addMovingEntity(*child, child->getIntId()));
+        }
+    }
+
+    for (int tick = 1; tick <= ticks; ++tick) {
+        simulation.tick(tick * consts::move_tick);
+        for (auto mover : movers) {
+            const Point3D& pos = mover->m_location.pos();
+            world_trace << mover->getId() << " " << pos.x() << " "
+                        << pos.y() << " " << pos.z() << "\n";
+        }
+    }
+
+    std::string trace = world_trace.str();
+
+    for (auto domain : domains) {
+        delete domain;
+    }
+    for (auto mover : movers) {
+        mover->m_location.m_loc = 0;
+        delete mover;
+    }
+    for (auto entity : entities) {
+        entity->m_location.m_loc = 0;
+        delete entity;
+    }
+    return trace;
+}
+
+void DomainSimulationtest::test_deterministic()
+{
+    std::string single = runWorld(0);
+    std::string threaded = runWorld(4);
+
+    // Entities were both moved and handed back because of collisions
+    ASSERT_NOT_EQUAL(single.find("sight"), std::string::npos);
+    ASSERT_NOT_EQUAL(single.find("update"), std::string::npos);
+
+    // Everything happened in the same order, with the same results
+    ASSERT_EQUAL(single.size(), threaded.size());
+    ASSERT_TRUE(single == threaded);
+
+    ASSERT_TRUE(runWorld(3) == single);
+}
+
+int main()
+{
+    DomainSimulationtest t;
+
+    return t.run();
+}
+
+// stubs
+
+#include "common/log.h"
+#include "common/Property_impl.h"
+
+#include "stubs/rulesets/stubLocatedEntity.h"
+#include "stubs/rulesets/stubDomain.h"
+#include "stubs/rulesets/stubTerrainProperty.h"
+#include "stubs/rulesets/stubOutfitProperty.h"
+#include "stubs/common/stubCustom.h"
+#include "stubs/common/stubBaseWorld.h"
+#include "stubs/common/stubRouter.h"
+#include "stubs/modules/stubLocation.h"
+#include "stubs/common/stubTypeNode.h"
+#include "stubs/common/stubProperty.h"
+#include "stubs/common/stubMonitors.h"
+#include "rulesets/EntityProperty.h"
+#include "stubs/rulesets/stubEntityProperty.h"
+
+void TestWorld::message(const Operation & op, LocatedEntity & ent)
+{
+    world_trace << op->getParents().front() << " " << ent.getId() << " "
+                << op->getTo() << " " << op->getRefno() << "\n";
+}
+
+LocatedEntity * TestWorld::addNewEntity(const std::string &,
+                                 const Atlas::Objects::Entity::RootEntity &)
+{
+    return 0;
+}
+
+void log(LogLevel lvl, const std::string & msg)
+{
+}
+
+WFMath::CoordType squareDistance(const Point3D & u, const Point3D & v)
+{
+    return 0.0f;
+}
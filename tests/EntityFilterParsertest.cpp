@@ -54,6 +54,8 @@ class ParserTest : public Cyphesis::TestBase {
         void test_ComparisonOperators();
         void test_LogicalOperators();
         void test_Literals();
+        void test_Ordering();
+        void test_Folding();
 
 };
 
@@ -62,6 +64,8 @@ ParserTest::ParserTest()
     ADD_TEST(ParserTest::test_ComparisonOperators);
     ADD_TEST(ParserTest::test_LogicalOperators);
     ADD_TEST(ParserTest::test_Literals);
+    ADD_TEST(ParserTest::test_Ordering);
+    ADD_TEST(ParserTest::test_Folding);
 }
 
 void ParserTest::setup()
@@ -183,6 +187,80 @@ void ParserTest::test_Literals()
 
 }
 
+void ParserTest::test_Ordering()
+{
+    AndPredicate *pred;
+
+    //The id comparison is cheaper than the property lookup, so goes first
+    pred = (AndPredicate*)ConstructPredicate(
+            "entity.burn_speed = 0.3 and entity.id = 1");
+    ComparePredicate *lhs = (ComparePredicate*)pred->m_lhs;
+    EntityProvider *provider = (EntityProvider*)lhs->m_lhs;
+    ASSERT_TRUE(typeid(*provider->m_consumer) == typeid(EntityIdProvider));
+    ASSERT_TRUE(pred->cost() < 10);
+    delete pred;
+
+    //Already in order
+    pred = (AndPredicate*)ConstructPredicate(
+            "entity.id = 1 and entity.burn_speed = 0.3");
+    lhs = (ComparePredicate*)pred->m_lhs;
+    provider = (EntityProvider*)lhs->m_lhs;
+    ASSERT_TRUE(typeid(*provider->m_consumer) == typeid(EntityIdProvider));
+    delete pred;
+
+    //Same for "or"
+    OrPredicate *or_pred = (OrPredicate*)ConstructPredicate(
+            "entity.burn_speed = 0.3 or entity.id = 1");
+    lhs = (ComparePredicate*)or_pred->m_lhs;
+    provider = (EntityProvider*)lhs->m_lhs;
+    ASSERT_TRUE(typeid(*provider->m_consumer) == typeid(EntityIdProvider));
+    delete or_pred;
+}
+
+void ParserTest::test_Folding()
+{
+    Predicate *pred;
+    bool result;
+
+    pred = ConstructPredicate("1 = 1");
+    ASSERT_TRUE(pred->isConstant(result));
+    ASSERT_TRUE(result);
+    ASSERT_EQUAL(pred->cost(), 0);
+    delete pred;
+
+    pred = ConstructPredicate("2 in [1, 3]");
+    ASSERT_TRUE(pred->isConstant(result));
+    ASSERT_TRUE(!result);
+    delete pred;
+
+    pred = ConstructPredicate("entity.id = 1");
+    ASSERT_TRUE(!pred->isConstant(result));
+    ASSERT_GREATER(pred->cost(), 0);
+    delete pred;
+
+    //A constant false side of "and" decides the result
+    pred = ConstructPredicate("entity.id = 1 and 1 = 2");
+    ASSERT_TRUE(pred->isConstant(result));
+    ASSERT_TRUE(!result);
+    delete pred;
+
+    //A constant true side of "and" doesn't
+    pred = ConstructPredicate("entity.id = 1 and 1 = 1");
+    ASSERT_TRUE(!pred->isConstant(result));
+    delete pred;
+
+    //A constant true side of "or" does
+    pred = ConstructPredicate("entity.id = 1 or 1 = 1");
+    ASSERT_TRUE(pred->isConstant(result));
+    ASSERT_TRUE(result);
+    delete pred;
+
+    pred = ConstructPredicate("not 1 = 2");
+    ASSERT_TRUE(pred->isConstant(result));
+    ASSERT_TRUE(result);
+    delete pred;
+}
+
 Predicate* ParserTest::ConstructPredicate(const std::string &query)
 {
     auto iter_begin = query.begin();
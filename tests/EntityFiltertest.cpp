@@ -104,6 +104,12 @@ class EntityFilterTest : public Cyphesis::TestBase {
         //Test contains_recursive function
         void test_ContainsRecursive();
 
+        //Test filtering a vector of entities in one call
+        void test_Filter();
+
+        //Test queries which give the same result for every entity
+        void test_Constant();
+
 };
 
 void EntityFilterTest::test_SoftProperty()
@@ -326,6 +332,50 @@ void EntityFilterTest::test_ContainsRecursive()
             { m_b1, m_bl1 }, { m_b2 });
 }
 
+void EntityFilterTest::test_Filter()
+{
+    EntityFilter::ProviderFactory factory;
+
+    EntityFilter::Filter f1("entity.type=types.barrel&&entity.burn_speed<0.3",
+                            &factory);
+    std::vector<LocatedEntity*> entities { m_b1, m_b2, m_bl1, m_b3 };
+    f1.filter(entities);
+    ASSERT_EQUAL(entities.size(), 2u);
+    ASSERT_EQUAL(entities[0], m_b2);
+    ASSERT_EQUAL(entities[1], m_b3);
+
+    EntityFilter::Filter f2("entity.mass=25", &factory);
+    entities = { m_b1, m_b2 };
+    f2.filter(entities);
+    ASSERT_TRUE(entities.empty());
+}
+
+void EntityFilterTest::test_Constant()
+{
+    EntityFilter::ProviderFactory factory;
+
+    //A constant false side means no entity can match
+    TestQuery("1 = 2 and entity.burn_speed=0.3", { }, { m_b1, m_b2 });
+    TestQuery("entity.burn_speed=0.3 and 1 = 2", { }, { m_b1, m_b2 });
+    EntityFilter::Filter f1("entity.burn_speed=0.3 and 1 = 2", &factory);
+    std::vector<LocatedEntity*> entities { m_b1, m_b2 };
+    f1.filter(entities);
+    ASSERT_TRUE(entities.empty());
+
+    //A constant true side means every entity matches
+    TestQuery("entity.burn_speed=0.3 or 'a' in ['a', 'b']", { m_b1, m_b2 },
+              { });
+    EntityFilter::Filter f2("entity.burn_speed=0.3 or 'a' in ['a', 'b']",
+                            &factory);
+    entities = { m_b1, m_b2 };
+    f2.filter(entities);
+    ASSERT_EQUAL(entities.size(), 2u);
+
+    //A constant side which doesn't decide the result
+    TestQuery("1 = 1 and entity.burn_speed=0.3", { m_b1 }, { m_b2 });
+    TestQuery("not 1 = 1 or entity.burn_speed=0.3", { m_b1 }, { m_b2 });
+}
+
 void EntityFilterTest::setup()
 {
 //Set up testing environment for Type/Soft properties
@@ -447,6 +497,8 @@ EntityFilterTest::EntityFilterTest()
     ADD_TEST(EntityFilterTest::test_Outfit);
     ADD_TEST(EntityFilterTest::test_BBox);
     ADD_TEST(EntityFilterTest::test_ContainsRecursive);
+    ADD_TEST(EntityFilterTest::test_Filter);
+    ADD_TEST(EntityFilterTest::test_Constant);
 }
 
 int main()
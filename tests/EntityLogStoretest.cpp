@@ -0,0 +1,374 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2015 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "TestBase.h"
+
+#include "server/EntityLogStore.h"
+
+#include "common/DatabaseBatch.h"
+
+#include <fstream>
+
+#include <cstdio>
+
+#include <unistd.h>
+
+class EntityLogStoretest : public Cyphesis::TestBase
+{
+  private:
+    std::string m_path;
+  public:
+    EntityLogStoretest();
+
+    void setup();
+    void teardown();
+
+    void test_replay();
+    void test_update();
+    void test_drop();
+    void test_thoughts();
+    void test_compact();
+    void test_truncated();
+    void test_root();
+    void test_lastId();
+    void test_relation();
+};
+
+EntityLogStoretest::EntityLogStoretest()
+{
+    ADD_TEST(EntityLogStoretest::test_replay);
+    ADD_TEST(EntityLogStoretest::test_update);
+    ADD_TEST(EntityLogStoretest::test_drop);
+    ADD_TEST(EntityLogStoretest::test_thoughts);
+    ADD_TEST(EntityLogStoretest::test_compact);
+    ADD_TEST(EntityLogStoretest::test_truncated);
+    ADD_TEST(EntityLogStoretest::test_root);
+    ADD_TEST(EntityLogStoretest::test_lastId);
+    ADD_TEST(EntityLogStoretest::test_relation);
+}
+
+void EntityLogStoretest::setup()
+{
+    m_path = "EntityLogStoretest_" + std::to_string(::getpid());
+    std::remove((m_path + ".log").c_str());
+    std::remove((m_path + ".snapshot").c_str());
+}
+
+void EntityLogStoretest::teardown()
+{
+    std::remove((m_path + ".log").c_str());
+    std::remove((m_path + ".snapshot").c_str());
+}
+
+void EntityLogStoretest::test_replay()
+{
+    {
+        EntityLogStore store(m_path);
+        ASSERT_EQUAL(store.open(), 0);
+
+        DatabaseBatch batch;
+        batch.insertEntity("3", "0", "thing", 1, "loc data");
+        DatabaseBatch::KeyValues tuples;
+        tuples["mass"] = "mass data";
+        batch.insertProperties("3", tuples);
+        store.write(batch);
+        ASSERT_EQUAL(store.flush(), 0);
+        ASSERT_NOT_EQUAL(store.logSize(), 0u);
+    }
+
+    EntityLogStore store(m_path);
+    ASSERT_EQUAL(store.open(), 0);
+    ASSERT_EQUAL(store.lastId(), 3);
+
+    // The world itself is always stored, as it is in the database
+    StoredRows entities;
+    store.selectAllEntities(entities);
+    ASSERT_EQUAL(entities.size(), 2);
+    ASSERT_EQUAL(std::string(entities.field(0, 0)), "0");
+    ASSERT_EQUAL(std::string(entities.field(2, 0)), "world");
+    ASSERT_EQUAL(std::string(entities.field(0, 1)), "3");
+    ASSERT_EQUAL(std::string(entities.field(1, 1)), "0");
+    ASSERT_EQUAL(std::string(entities.field(2, 1)), "thing");
+    ASSERT_EQUAL(std::string(entities.field(3, 1)), "1");
+    ASSERT_EQUAL(std::string(entities.field(4, 1)), "loc data");
+
+    StoredRows properties;
+    store.selectAllProperties(properties);
+    ASSERT_EQUAL(properties.size(), 1);
+    ASSERT_EQUAL(std::string(properties.field(1, 0)), "mass");
+    ASSERT_EQUAL(std::string(properties.field(2, 0)), "mass data");
+}
+
+void EntityLogStoretest::test_update()
+{
+    EntityLogStore store(m_path);
+    ASSERT_EQUAL(store.open(), 0);
+
+    DatabaseBatch batch;
+    batch.insertEntity("3", "0", "thing", 1, "old");
+    store.write(batch);
+    batch.clear();
+    batch.updateEntityWithoutLoc("3", 2, "new");
+    // Updates to entities which are not stored are ignored
+    batch.updateEntity("4", 2, "new", "3");
+    store.write(batch);
+
+    StoredRows entities;
+    store.selectAllEntities(entities);
+    ASSERT_EQUAL(entities.size(), 2);
+    ASSERT_EQUAL(std::string(entities.field(1, 1)), "0");
+    ASSERT_EQUAL(std::string(entities.field(3, 1)), "2");
+    ASSERT_EQUAL(std::string(entities.field(4, 1)), "new");
+}
+
+void EntityLogStoretest::test_drop()
+{
+    {
+        EntityLogStore store(m_path);
+        ASSERT_EQUAL(store.open(), 0);
+
+        DatabaseBatch batch;
+        batch.insertEntity("3", "0", "thing", 1, "");
+        batch.insertEntity("4", "0", "thing", 1, "");
+        store.write(batch);
+        store.dropEntity(3);
+        ASSERT_EQUAL(store.flush(), 0);
+    }
+
+    EntityLogStore store(m_path);
+    ASSERT_EQUAL(store.open(), 0);
+    ASSERT_EQUAL(store.lastId(), 4);
+
+    StoredRows entities;
+    store.selectAllEntities(entities);
+    ASSERT_EQUAL(entities.size(), 2);
+    ASSERT_EQUAL(std::string(entities.field(0, 1)), "4");
+}
+
+void EntityLogStoretest::test_thoughts()
+{
+    EntityLogStore store(m_path);
+    ASSERT_EQUAL(store.open(), 0);
+
+    DatabaseBatch batch;
+    batch.insertEntity("3", "0", "thing", 1, "");
+    store.write(batch);
+    store.replaceThoughts("3", std::vector<std::string>(2, "thought"));
+    store.replaceThoughts("3", std::vector<std::string>(1, "other"));
+
+    StoredRows thoughts;
+    store.selectAllThoughts(thoughts);
+    ASSERT_EQUAL(thoughts.size(), 1);
+    ASSERT_EQUAL(std::string(thoughts.field(1, 0)), "other");
+}
+
+void EntityLogStoretest::test_compact()
+{
+    {
+        EntityLogStore store(m_path);
+        ASSERT_EQUAL(store.open(), 0);
+
+        DatabaseBatch batch;
+        DatabaseBatch::KeyValues tuples;
+        tuples["mass"] = "1";
+        for (int i = 1; i < 10; ++i) {
+            batch.insertEntity(std::to_string(i), "0", "thing", 1, "");
+            batch.insertProperties(std::to_string(i), tuples);
+            batch.updateProperties(std::to_string(i), tuples);
+        }
+        store.write(batch);
+        store.dropEntity(9);
+        ASSERT_EQUAL(store.flush(), 0);
+
+        ASSERT_EQUAL(store.compact(), 0);
+        ASSERT_EQUAL(store.logSize(), 0u);
+        ASSERT_NOT_EQUAL(store.snapshotSize(), 0u);
+
+        store.replaceThoughts("1", std::vector<std::string>(1, "thought"));
+        ASSERT_EQUAL(store.flush(), 0);
+    }
+
+    EntityLogStore store(m_path);
+    ASSERT_EQUAL(store.open(), 0);
+
+    StoredRows entities;
+    store.selectAllEntities(entities);
+    ASSERT_EQUAL(entities.size(), 9);
+
+    StoredRows properties;
+    store.selectAllProperties(properties);
+    ASSERT_EQUAL(properties.size(), 8);
+
+    StoredRows thoughts;
+    store.selectAllThoughts(thoughts);
+    ASSERT_EQUAL(thoughts.size(), 1);
+}
+
+void EntityLogStoretest::test_truncated()
+{
+    {
+        EntityLogStore store(m_path);
+        ASSERT_EQUAL(store.open(), 0);
+
+        DatabaseBatch batch;
+        batch.insertEntity("3", "0", "thing", 1, "");
+        store.write(batch);
+        ASSERT_EQUAL(store.flush(), 0);
+    }
+
+    std::size_t good_size;
+    {
+        // Half a record, as if the server stopped while writing it
+        std::ofstream log(m_path + ".log",
+                          std::ios::binary | std::ios::app | std::ios::ate);
+        good_size = log.tellp();
+        log.write("\x20\0\0\0\x01", 5);
+    }
+
+    {
+        EntityLogStore store(m_path);
+        ASSERT_EQUAL(store.open(), 0);
+        ASSERT_EQUAL(store.logSize(), good_size);
+
+        DatabaseBatch batch;
+        batch.insertEntity("4", "0", "thing", 1, "");
+        store.write(batch);
+        ASSERT_EQUAL(store.flush(), 0);
+    }
+
+    EntityLogStore store(m_path);
+    ASSERT_EQUAL(store.open(), 0);
+
+    StoredRows entities;
+    store.selectAllEntities(entities);
+    ASSERT_EQUAL(entities.size(), 3);
+}
+
+void EntityLogStoretest::test_root()
+{
+    {
+        EntityLogStore store(m_path);
+        ASSERT_EQUAL(store.open(), 0);
+
+        DatabaseBatch batch;
+        DatabaseBatch::KeyValues tuples;
+        tuples["terrain"] = "terrain data";
+        batch.updateEntityWithoutLoc("0", 2, "world loc");
+        batch.insertProperties("0", tuples);
+        store.write(batch);
+        ASSERT_EQUAL(store.flush(), 0);
+    }
+
+    EntityLogStore store(m_path);
+    ASSERT_EQUAL(store.open(), 0);
+
+    StoredRows entities;
+    store.selectAllEntities(entities);
+    ASSERT_EQUAL(entities.size(), 1);
+    ASSERT_EQUAL(std::string(entities.field(0, 0)), "0");
+    ASSERT_EQUAL(std::string(entities.field(4, 0)), "world loc");
+
+    StoredRows properties;
+    store.selectAllProperties(properties);
+    ASSERT_EQUAL(properties.size(), 1);
+    ASSERT_EQUAL(std::string(properties.field(0, 0)), "0");
+    ASSERT_EQUAL(std::string(properties.field(1, 0)), "terrain");
+    ASSERT_EQUAL(std::string(properties.field(2, 0)), "terrain data");
+}
+
+void EntityLogStoretest::test_lastId()
+{
+    {
+        EntityLogStore store(m_path);
+        ASSERT_EQUAL(store.open(), 0);
+
+        DatabaseBatch batch;
+        batch.insertEntity("3", "0", "thing", 1, "");
+        batch.insertEntity("7", "0", "thing", 1, "");
+        store.write(batch);
+        store.dropEntity(7);
+        ASSERT_EQUAL(store.flush(), 0);
+        // The record of entity 7 is gone once the log is compacted
+        ASSERT_EQUAL(store.compact(), 0);
+    }
+
+    EntityLogStore store(m_path);
+    ASSERT_EQUAL(store.open(), 0);
+    ASSERT_EQUAL(store.lastId(), 7);
+}
+
+void EntityLogStoretest::test_relation()
+{
+    {
+        EntityLogStore store(m_path);
+        ASSERT_EQUAL(store.open(), 0);
+
+        DatabaseBatch batch;
+        batch.insertEntity("3", "0", "character", 1, "");
+        batch.insertEntity("4", "0", "character", 1, "");
+        batch.insertEntity("5", "0", "character", 1, "");
+        store.write(batch);
+        store.createRelation("2", "3");
+        store.createRelation("2", "4");
+        store.createRelation("6", "5");
+        store.removeRelationByOther("4");
+        ASSERT_EQUAL(store.flush(), 0);
+        ASSERT_EQUAL(store.compact(), 0);
+        store.createRelation("2", "5");
+        ASSERT_EQUAL(store.flush(), 0);
+    }
+
+    EntityLogStore store(m_path);
+    ASSERT_EQUAL(store.open(), 0);
+
+    StoredRows characters;
+    store.selectRelation("2", characters);
+    ASSERT_EQUAL(characters.size(), 2);
+    ASSERT_EQUAL(std::string(characters.field(0, 0)), "3");
+    ASSERT_EQUAL(std::string(characters.field(0, 1)), "5");
+
+    StoredRows none;
+    store.selectRelation("6", none);
+    ASSERT_EQUAL(none.size(), 0);
+}
+
+int main()
+{
+    EntityLogStoretest t;
+
+    return t.run();
+}
+
+// stubs
+
+#include "common/const.h"
+#include "common/log.h"
+
+namespace consts {
+  const long rootWorldIntId = 0L;
+}
+
+void log(LogLevel lvl, const std::string & msg)
+{
+}
@@ -0,0 +1,280 @@
+/*
+ Copyright (C) 2015 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+// Measures how long it takes to pass Tick, Move and Sight operations to
+// entities which have delegate properties for them. The entities either
+// use the class properties, which are reached through the table in the
+// TypeNode, or have their own copies, which are found through the
+// delegates of each entity. Not run as part of the test suite, as it
+// takes a while.
+
+#include "rulesets/Entity.h"
+#include "rulesets/Script.h"
+
+#include "common/BaseWorld.h"
+#include "common/Property_impl.h"
+#include "common/PropertyFactory.h"
+#include "common/PropertyManager.h"
+#include "common/Tick.h"
+#include "common/TypeNode.h"
+#include "common/id.h"
+
+#include <Atlas/Objects/Operation.h>
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include <cstdlib>
+#include <cassert>
+
+using Atlas::Objects::Operation::Move;
+using Atlas::Objects::Operation::Sight;
+using Atlas::Objects::Operation::Tick;
+
+/// \brief Property which handles one class of operation
+class DelegateProperty : public Property<int>
+{
+  protected:
+    int m_classNo;
+  public:
+    long m_operations;
+
+    explicit DelegateProperty(int class_no) : m_classNo(class_no),
+                                              m_operations(0) { }
+
+    virtual void install(LocatedEntity * owner, const std::string & name)
+    {
+        if (m_classNo >= 0) {
+            owner->installDelegate(m_classNo, name);
+        }
+    }
+
+    virtual HandlerResult operation(LocatedEntity *,
+                                    const Operation &,
+                                    OpVector &)
+    {
+        ++m_operations;
+        return OPERATION_IGNORED;
+    }
+
+    virtual DelegateProperty * copy() const
+    {
+        return new DelegateProperty(*this);
+    }
+};
+
+static const std::size_t entity_count = 100000;
+
+static const char * delegate_names[] = { "tick_delegate",
+                                         "move_delegate",
+                                         "sight_delegate" };
+
+/// \brief Create entities with the class properties of a type installed.
+///
+/// @param instance if true each entity is given its own copy of the
+/// delegate properties
+static std::vector<Entity *> createEntities(TypeNode & type, bool instance)
+{
+    std::vector<Entity *> entities;
+    entities.reserve(entity_count);
+    for (std::size_t i = 0; i < entity_count; ++i) {
+        Entity * entity = new Entity(std::to_string(i + 1), i + 1);
+        entity->setType(&type);
+        for (const auto & entry : type.defaults()) {
+            entry.second->install(entity, entry.first);
+        }
+        if (instance) {
+            for (const char * name : delegate_names) {
+                entity->modProperty(name);
+            }
+        }
+        entities.push_back(entity);
+    }
+    return entities;
+}
+
+/// \brief Time passing each operation to every entity.
+///
+/// @return nanoseconds per operation
+static double run(const std::vector<Entity *> & entities)
+{
+    typedef std::chrono::steady_clock clock;
+    std::vector<Operation> ops;
+    ops.push_back(Tick());
+    ops.push_back(Move());
+    ops.push_back(Sight());
+
+    OpVector res;
+    clock::time_point start = clock::now();
+    for (const Operation & op : ops) {
+        for (Entity * entity : entities) {
+            entity->operation(op, res);
+        }
+    }
+    clock::time_point end = clock::now();
+    return std::chrono::duration<double>(end - start).count() * 1e9 /
+           (ops.size() * entities.size());
+}
+
+static void report(const char * name, double ns)
+{
+    std::cout << name << " " << entity_count << " entities: "
+              << ns << " ns/op" << std::endl;
+}
+
+int main()
+{
+    Atlas::Objects::Operation::TICK_NO = 100;
+
+    TypeNode type("bench_type");
+    type.addProperty(delegate_names[0],
+                     new DelegateProperty(Atlas::Objects::Operation::TICK_NO));
+    type.addProperty(delegate_names[1],
+                     new DelegateProperty(Atlas::Objects::Operation::MOVE_NO));
+    type.addProperty(delegate_names[2],
+                     new DelegateProperty(Atlas::Objects::Operation::SIGHT_NO));
+    // Other properties, as a typical type has a couple of dozen
+    for (int i = 0; i < 20; ++i) {
+        type.addProperty("bench_property_" + std::to_string(i),
+                         new DelegateProperty(-1));
+    }
+
+    for (bool instance : { false, true }) {
+        std::vector<Entity *> entities = createEntities(type, instance);
+        // Once to warm up, and once to measure
+        run(entities);
+        report(instance ? "instance delegates" : "class delegates   ",
+               run(entities));
+        for (Entity * entity : entities) {
+            delete entity;
+        }
+    }
+
+    return 0;
+}
+
+// stubs
+
+#include "stubs/common/stubRouter.h"
+#include "stubs/common/stubCustom.h"
+#include "stubs/modules/stubLocation.h"
+#include "stubs/rulesets/stubContainsProperty.h"
+#include "stubs/rulesets/stubSoftProperty.h"
+#include "stubs/rulesets/stubDomain.h"
+#include "stubs/common/stubProperty.h"
+#include "stubs/common/stubMonitors.h"
+#include "stubs/common/stubVariable.h"
+#include "stubs/rulesets/stubLocatedEntity.h"
+#include "stubs/rulesets/stubDomainProperty.h"
+
+TypeNode::TypeNode(const std::string & name) : m_name(name), m_parent(0)
+{
+}
+
+TypeNode::~TypeNode()
+{
+    for (const auto & entry : m_defaults) {
+        delete entry.second;
+    }
+}
+
+void TypeNode::addProperty(const std::string & name,
+                           PropertyBase * p)
+{
+    m_defaults[name] = p;
+}
+
+BaseWorld * BaseWorld::m_instance = 0;
+
+BaseWorld::BaseWorld(LocatedEntity & gw) : m_gameWorld(gw)
+{
+    m_instance = this;
+}
+
+BaseWorld::~BaseWorld()
+{
+    m_instance = 0;
+}
+
+LocatedEntity * BaseWorld::getEntity(const std::string & id) const
+{
+    return 0;
+}
+
+LocatedEntity * BaseWorld::getEntity(long id) const
+{
+    return 0;
+}
+
+Script::Script()
+{
+}
+
+Script::~Script()
+{
+}
+
+bool Script::operation(const std::string & opname,
+                       const Atlas::Objects::Operation::RootOperation & op,
+                       OpVector & res)
+{
+   return false;
+}
+
+void Script::hook(const std::string & function, LocatedEntity * entity)
+{
+}
+
+PropertyKit::~PropertyKit()
+{
+}
+
+PropertyManager * PropertyManager::m_instance = 0;
+
+PropertyManager::PropertyManager()
+{
+    assert(m_instance == 0);
+    m_instance = this;
+}
+
+PropertyManager::~PropertyManager()
+{
+   m_instance = 0;
+}
+
+int PropertyManager::installFactory(const std::string & type_name,
+                                    const Atlas::Objects::Root & type_desc,
+                                    PropertyKit * factory)
+{
+    return 0;
+}
+
+long integerId(const std::string & id)
+{
+    long intId = strtol(id.c_str(), 0, 10);
+    if (intId == 0 && id != "0") {
+        intId = -1L;
+    }
+
+    return intId;
+}
+
+void log(LogLevel lvl, const std::string & msg)
+{
+}
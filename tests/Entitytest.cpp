@@ -79,6 +79,9 @@ class Entitytest : public Cyphesis::TestBase
     void test_setAttr_existing();
     void test_setAttr_type();
     void test_sequence();
+    void test_delegate_class();
+    void test_delegate_instance();
+    void test_class_property_copies();
 
     class TestProperty : public Property<int>
     {
@@ -88,6 +91,20 @@ class Entitytest : public Cyphesis::TestBase
         virtual TestProperty * copy() const;
     };
 
+    class DelegateProperty : public Property<int>
+    {
+      public:
+        int m_operations;
+
+        DelegateProperty() : m_operations(0) { }
+
+        virtual void install(LocatedEntity *, const std::string &);
+        virtual HandlerResult operation(LocatedEntity *,
+                                        const Operation &,
+                                        OpVector &);
+        virtual DelegateProperty * copy() const;
+    };
+
     static void TestProperty_install_called()
     {
         m_TestProperty_install_called = true;
@@ -117,12 +134,34 @@ Entitytest::TestProperty * Entitytest::TestProperty::copy() const
     return new Entitytest::TestProperty(*this);
 }
 
+void Entitytest::DelegateProperty::install(LocatedEntity * owner,
+                                           const std::string & name)
+{
+    owner->installDelegate(Atlas::Objects::Operation::SET_NO, name);
+}
+
+HandlerResult Entitytest::DelegateProperty::operation(LocatedEntity *,
+                                                      const Operation &,
+                                                      OpVector &)
+{
+    ++m_operations;
+    return OPERATION_IGNORED;
+}
+
+Entitytest::DelegateProperty * Entitytest::DelegateProperty::copy() const
+{
+    return new Entitytest::DelegateProperty(*this);
+}
+
 Entitytest::Entitytest()
 {
     ADD_TEST(Entitytest::test_setAttr_new);
     ADD_TEST(Entitytest::test_setAttr_existing);
     ADD_TEST(Entitytest::test_setAttr_type);
     ADD_TEST(Entitytest::test_sequence);
+    ADD_TEST(Entitytest::test_delegate_class);
+    ADD_TEST(Entitytest::test_delegate_instance);
+    ADD_TEST(Entitytest::test_class_property_copies);
 }
 
 void Entitytest::setup()
@@ -157,12 +196,18 @@ void Entitytest::test_setAttr_new()
     ASSERT_EQUAL(int_property->data(), 24);
     ASSERT_TRUE(m_TestProperty_install_called);
     ASSERT_TRUE(m_TestProperty_apply_called);
+
+    ASSERT_EQUAL(m_entity->getDirtyProperties().size(), 1u);
+    ASSERT_EQUAL(m_entity->getDirtyProperties().front(),
+                 PropertyDict::lookup("test_int_property"));
 }
 
 void Entitytest::test_setAttr_existing()
 {
     PropertyBase * initial_property = m_entity->setProperty("test_int_property",
                                                             new TestProperty);
+    initial_property->setFlags(per_clean);
+    m_entity->clearDirtyProperties();
 
     PropertyBase * pb = m_entity->setAttr("test_int_property", 24);
     ASSERT_NOT_NULL(pb);
@@ -175,6 +220,9 @@ void Entitytest::test_setAttr_existing()
     ASSERT_EQUAL(int_property->data(), 24);
     ASSERT_TRUE(!m_TestProperty_install_called);
     ASSERT_TRUE(m_TestProperty_apply_called);
+
+    ASSERT_TRUE((pb->flags() & per_clean) == 0);
+    ASSERT_EQUAL(m_entity->getDirtyProperties().size(), 1u);
 }
 
 void Entitytest::test_setAttr_type()
@@ -273,6 +321,105 @@ void Entitytest::test_sequence()
     }
 }
 
+void Entitytest::test_delegate_class()
+{
+    DelegateProperty * type_property = new DelegateProperty;
+    m_type->addProperty("test_delegate", type_property);
+    type_property->install(m_entity, "test_delegate");
+
+    // The class property is put in the table of the type
+    ASSERT_EQUAL(m_type->delegateCount(), 1u);
+    const std::vector<PropertyBase *> * delegates =
+          m_type->delegates(Atlas::Objects::Operation::SET_NO);
+    ASSERT_NOT_NULL(delegates);
+    ASSERT_EQUAL(delegates->size(), 1u);
+
+    OpVector res;
+    m_entity->operation(Atlas::Objects::Operation::Set(), res);
+    ASSERT_EQUAL(type_property->m_operations, 1);
+
+    // Other operations don't reach it
+    m_entity->operation(Atlas::Objects::Operation::Move(), res);
+    ASSERT_EQUAL(type_property->m_operations, 1);
+
+    // Once the entity has its own copy, operations go to that instead
+    PropertyBase * pb = m_entity->setAttr("test_delegate", 24);
+    DelegateProperty * instance_property = dynamic_cast<DelegateProperty *>(pb);
+    ASSERT_NOT_NULL(instance_property);
+    ASSERT_NOT_EQUAL(instance_property, type_property);
+    m_entity->operation(Atlas::Objects::Operation::Set(), res);
+    ASSERT_EQUAL(type_property->m_operations, 1);
+    ASSERT_EQUAL(instance_property->m_operations, 2);
+}
+
+void Entitytest::test_delegate_instance()
+{
+    DelegateProperty * type_property = new DelegateProperty;
+    m_type->addProperty("test_delegate", type_property);
+
+    // The instance property is installed, so the type isn't involved
+    PropertyBase * pb = m_entity->modProperty("test_delegate");
+    DelegateProperty * instance_property = dynamic_cast<DelegateProperty *>(pb);
+    ASSERT_NOT_NULL(instance_property);
+    ASSERT_EQUAL(m_type->delegateCount(), 0u);
+
+    OpVector res;
+    m_entity->operation(Atlas::Objects::Operation::Set(), res);
+    ASSERT_EQUAL(instance_property->m_operations, 1);
+    ASSERT_EQUAL(type_property->m_operations, 0);
+
+    // Removing the delegate stops the operations
+    m_entity->removeDelegate(Atlas::Objects::Operation::SET_NO,
+                             "test_delegate");
+    m_entity->operation(Atlas::Objects::Operation::Set(), res);
+    ASSERT_EQUAL(instance_property->m_operations, 1);
+}
+
+void Entitytest::test_class_property_copies()
+{
+    TypeNode * type = new TypeNode("copy_test_type");
+    TestProperty * type_property = new TestProperty;
+    type_property->flags() |= flag_class;
+    type->addProperty("test_int_property", type_property);
+
+    Entity * entity = new Entity("2", 2);
+    entity->setType(type);
+
+    Gauge properties = Monitors::instance()->gauge(
+          "class_properties{type=\"copy_test_type\"}");
+    Gauge copies = Monitors::instance()->gauge(
+          "class_property_copies{type=\"copy_test_type\"}");
+    ASSERT_EQUAL(properties.value(), 1);
+    ASSERT_EQUAL(copies.value(), 0);
+
+    // Reading the property doesn't copy it
+    ASSERT_EQUAL(entity->getProperty("test_int_property"), type_property);
+    ASSERT_EQUAL(entity->getPropertyById(
+          PropertyDict::intern("test_int_property")), type_property);
+    ASSERT_EQUAL(copies.value(), 0);
+
+    // Getting it to modify does, once
+    ASSERT_NOT_EQUAL(entity->modProperty("test_int_property"), type_property);
+    ASSERT_EQUAL(copies.value(), 1);
+    entity->modProperty("test_int_property");
+    ASSERT_EQUAL(copies.value(), 1);
+
+    Entity * other = new Entity("3", 3);
+    other->setType(type);
+    other->setAttr("test_int_property", 3);
+    ASSERT_EQUAL(copies.value(), 2);
+
+    // A property which isn't a class property isn't counted
+    other->setAttr("other_int_property", 3);
+    ASSERT_EQUAL(copies.value(), 2);
+
+    delete other;
+    ASSERT_EQUAL(copies.value(), 1);
+    delete entity;
+    ASSERT_EQUAL(copies.value(), 0);
+    delete type;
+}
+
 int main()
 {
     Entitytest t;
@@ -0,0 +1,150 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2015 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "TestBase.h"
+
+#include "common/Histogram.h"
+
+#include <sstream>
+
+class Histogramtest : public Cyphesis::TestBase
+{
+  protected:
+    Histogram * m_histogram;
+  public:
+    Histogramtest();
+
+    void setup();
+    void teardown();
+
+    void test_observe();
+    void test_send();
+    void test_sendLabels();
+    void test_exponentialBounds();
+    void test_logLinearBounds();
+};
+
+Histogramtest::Histogramtest()
+{
+    ADD_TEST(Histogramtest::test_observe);
+    ADD_TEST(Histogramtest::test_send);
+    ADD_TEST(Histogramtest::test_sendLabels);
+    ADD_TEST(Histogramtest::test_exponentialBounds);
+    ADD_TEST(Histogramtest::test_logLinearBounds);
+}
+
+void Histogramtest::setup()
+{
+    std::vector<double> bounds;
+    bounds.push_back(1.);
+    bounds.push_back(10.);
+    m_histogram = new Histogram(bounds);
+}
+
+void Histogramtest::teardown()
+{
+    delete m_histogram;
+}
+
+void Histogramtest::test_observe()
+{
+    m_histogram->observe(0.5);
+    // Bounds are inclusive
+    m_histogram->observe(1.);
+    m_histogram->observe(5.);
+    m_histogram->observe(50.);
+
+    ASSERT_EQUAL(m_histogram->count(), 4);
+    ASSERT_EQUAL(m_histogram->sum(), 56.5);
+    ASSERT_EQUAL(m_histogram->bucketCount(0), 2);
+    ASSERT_EQUAL(m_histogram->bucketCount(1), 1);
+    ASSERT_EQUAL(m_histogram->bucketCount(2), 1);
+}
+
+void Histogramtest::test_send()
+{
+    m_histogram->observe(0.5);
+    m_histogram->observe(5.);
+    m_histogram->observe(50.);
+
+    std::stringstream ss;
+    m_histogram->send("foo", ss);
+
+    ASSERT_EQUAL(ss.str(), "foo_bucket{le=\"1\"} 1\n"
+                           "foo_bucket{le=\"10\"} 2\n"
+                           "foo_bucket{le=\"+Inf\"} 3\n"
+                           "foo_sum 55.5\n"
+                           "foo_count 3\n");
+}
+
+void Histogramtest::test_sendLabels()
+{
+    m_histogram->observe(2.);
+
+    std::stringstream ss;
+    m_histogram->send("foo{type=\"bar\"}", ss);
+
+    ASSERT_EQUAL(ss.str(), "foo_bucket{type=\"bar\",le=\"1\"} 0\n"
+                           "foo_bucket{type=\"bar\",le=\"10\"} 1\n"
+                           "foo_bucket{type=\"bar\",le=\"+Inf\"} 1\n"
+                           "foo_sum{type=\"bar\"} 2\n"
+                           "foo_count{type=\"bar\"} 1\n");
+}
+
+void Histogramtest::test_exponentialBounds()
+{
+    std::vector<double> bounds = Histogram::exponentialBounds(1., 2., 4);
+
+    ASSERT_EQUAL(bounds.size(), 4u);
+    ASSERT_EQUAL(bounds[0], 1.);
+    ASSERT_EQUAL(bounds[3], 8.);
+}
+
+void Histogramtest::test_logLinearBounds()
+{
+    std::vector<double> bounds = Histogram::logLinearBounds(1., 2);
+
+    ASSERT_EQUAL(bounds.size(), 19u);
+    ASSERT_EQUAL(bounds[0], 1.);
+    ASSERT_EQUAL(bounds[8], 9.);
+    ASSERT_EQUAL(bounds[9], 10.);
+    ASSERT_EQUAL(bounds[17], 90.);
+    ASSERT_EQUAL(bounds[18], 100.);
+
+    Histogram histogram(bounds);
+    histogram.observe(20.);
+    histogram.observe(25.);
+    histogram.observe(1000.);
+
+    ASSERT_EQUAL(histogram.bucketCount(10), 1);
+    ASSERT_EQUAL(histogram.bucketCount(11), 1);
+    ASSERT_EQUAL(histogram.bucketCount(19), 1);
+}
+
+int main()
+{
+    Histogramtest t;
+
+    return t.run();
+}
@@ -0,0 +1,291 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2015 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "TestBase.h"
+#include "TestDomain.h"
+
+#include "server/InterestManager.h"
+
+#include "rulesets/LocatedEntity.h"
+
+#include <algorithm>
+#include <set>
+
+class TestLocatedEntity : public LocatedEntity {
+  public:
+    TestLocatedEntity(const std::string & id, long intId) :
+                      LocatedEntity(id, intId) { }
+
+    virtual void externalOperation(const Operation &, Link &) { }
+    virtual void operation(const Operation &, OpVector &) { }
+
+    virtual void destroy() { }
+};
+
+/// \brief Domain which reports a fixed set of nearby children, and
+/// considers a fixed set of entities able to see anything.
+class NearbyTestDomain : public TestDomain
+{
+  public:
+    bool m_narrow;
+    std::vector<LocatedEntity *> m_nearby;
+    std::set<const LocatedEntity *> m_seeing;
+
+    NearbyTestDomain(LocatedEntity & entity) : TestDomain(entity),
+                                               m_narrow(true)
+    {
+    }
+
+    bool isEntityVisibleFor(const LocatedEntity & observingEntity,
+                            const LocatedEntity & observedEntity) const
+    {
+        return m_seeing.find(&observingEntity) != m_seeing.end();
+    }
+
+    bool findObserverCandidates(const LocatedEntity & observedEntity,
+                                std::vector<LocatedEntity *> & candidates)
+    {
+        if (!m_narrow) {
+            return false;
+        }
+        candidates.insert(candidates.end(), m_nearby.begin(), m_nearby.end());
+        std::sort(candidates.begin(), candidates.end());
+        return true;
+    }
+};
+
+static bool found(const std::vector<LocatedEntity *> & result,
+                  LocatedEntity * entity)
+{
+    return std::find(result.begin(), result.end(), entity) != result.end();
+}
+
+class InterestManagertest : public Cyphesis::TestBase
+{
+  protected:
+    InterestManager * m_manager;
+    LocatedEntity * m_world;
+    LocatedEntity * m_near;
+    LocatedEntity * m_far;
+    LocatedEntity * m_inside;
+    LocatedEntity * m_observed;
+    NearbyTestDomain * m_domain;
+  public:
+    InterestManagertest();
+
+    void setup();
+    void teardown();
+
+    void test_addPerceptive();
+    void test_removePerceptive();
+    void test_grouping();
+    void test_findObservers_narrowed();
+    void test_findObservers_unnarrowed();
+    void test_containered();
+};
+
+InterestManagertest::InterestManagertest()
+{
+    ADD_TEST(InterestManagertest::test_addPerceptive);
+    ADD_TEST(InterestManagertest::test_removePerceptive);
+    ADD_TEST(InterestManagertest::test_grouping);
+    ADD_TEST(InterestManagertest::test_findObservers_narrowed);
+    ADD_TEST(InterestManagertest::test_findObservers_unnarrowed);
+    ADD_TEST(InterestManagertest::test_containered);
+}
+
+void InterestManagertest::setup()
+{
+    m_manager = new InterestManager;
+
+    m_world = new TestLocatedEntity("0", 0);
+    m_world->setFlags(entity_domain);
+    m_domain = new NearbyTestDomain(*m_world);
+
+    m_near = new TestLocatedEntity("1", 1);
+    m_near->m_location.m_loc = m_world;
+    m_far = new TestLocatedEntity("2", 2);
+    m_far->m_location.m_loc = m_world;
+    m_inside = new TestLocatedEntity("3", 3);
+    m_inside->m_location.m_loc = m_near;
+    m_observed = new TestLocatedEntity("4", 4);
+    m_observed->m_location.m_loc = m_world;
+}
+
+void InterestManagertest::teardown()
+{
+    delete m_manager;
+    delete m_domain;
+    delete m_observed;
+    delete m_inside;
+    delete m_far;
+    delete m_near;
+    delete m_world;
+}
+
+void InterestManagertest::test_addPerceptive()
+{
+    m_manager->addPerceptive(m_near);
+    m_manager->addPerceptive(m_near);
+
+    ASSERT_EQUAL(m_manager->perceptiveCount(), 1u);
+    ASSERT_TRUE(m_manager->isPerceptive(m_near));
+    ASSERT_TRUE(!m_manager->isPerceptive(m_far));
+}
+
+void InterestManagertest::test_removePerceptive()
+{
+    m_manager->addPerceptive(m_near);
+    m_manager->addPerceptive(m_inside);
+
+    m_manager->removePerceptive(m_near);
+    m_manager->removePerceptive(m_inside);
+    // Removing an unregistered entity should be harmless
+    m_manager->removePerceptive(m_far);
+
+    ASSERT_EQUAL(m_manager->perceptiveCount(), 0u);
+    ASSERT_TRUE(m_manager->m_attached.empty());
+    ASSERT_TRUE(m_manager->m_detached.empty());
+}
+
+void InterestManagertest::test_grouping()
+{
+    m_manager->addPerceptive(m_world);
+    m_manager->addPerceptive(m_near);
+    m_manager->addPerceptive(m_inside);
+
+    ASSERT_EQUAL(m_manager->m_attached.size(), 1u);
+    ASSERT_EQUAL(m_manager->m_attached[m_world].size(), 1u);
+    ASSERT_EQUAL(m_manager->m_attached[m_world].count(m_near), 1u);
+    // Neither the world, nor an entity in a container without a domain,
+    // are direct children of a domain entity
+    ASSERT_EQUAL(m_manager->m_detached.size(), 2u);
+    ASSERT_EQUAL(m_manager->m_detached.count(m_world), 1u);
+    ASSERT_EQUAL(m_manager->m_detached.count(m_inside), 1u);
+}
+
+void InterestManagertest::test_findObservers_narrowed()
+{
+    m_manager->addPerceptive(m_world);
+    m_manager->addPerceptive(m_near);
+    m_manager->addPerceptive(m_far);
+    m_manager->addPerceptive(m_inside);
+
+    // The observed entity is nearby, but not perceptive.
+    m_domain->m_nearby.push_back(m_near);
+    m_domain->m_nearby.push_back(m_observed);
+    m_domain->m_seeing.insert(m_near);
+    m_domain->m_seeing.insert(m_far);
+    m_domain->m_seeing.insert(m_inside);
+
+    // The counters are shared by all instances, so only the change is
+    // checked.
+    long broadcasts = m_manager->broadcastCount();
+    long candidates = m_manager->candidateCount();
+    long deliveries = m_manager->observerCount();
+
+    std::vector<LocatedEntity *> observers;
+    m_manager->findObservers(*m_observed, *m_domain, observers);
+
+    // m_far isn't nearby, so it's never checked even though the
+    // domain would say it can see.
+    ASSERT_EQUAL(observers.size(), 2u);
+    ASSERT_TRUE(found(observers, m_near));
+    ASSERT_TRUE(found(observers, m_inside));
+    ASSERT_TRUE(std::is_sorted(observers.begin(), observers.end()));
+
+    ASSERT_EQUAL(m_manager->broadcastCount() - broadcasts, 1);
+    // m_near, m_world and m_inside
+    ASSERT_EQUAL(m_manager->candidateCount() - candidates, 3);
+    ASSERT_EQUAL(m_manager->observerCount() - deliveries, 2);
+}
+
+void InterestManagertest::test_findObservers_unnarrowed()
+{
+    m_manager->addPerceptive(m_world);
+    m_manager->addPerceptive(m_near);
+    m_manager->addPerceptive(m_far);
+    m_manager->addPerceptive(m_inside);
+
+    m_domain->m_narrow = false;
+    m_domain->m_seeing.insert(m_near);
+    m_domain->m_seeing.insert(m_far);
+
+    long candidates = m_manager->candidateCount();
+    long deliveries = m_manager->observerCount();
+
+    std::vector<LocatedEntity *> observers;
+    m_manager->findObservers(*m_observed, *m_domain, observers);
+
+    ASSERT_EQUAL(observers.size(), 2u);
+    ASSERT_TRUE(found(observers, m_near));
+    ASSERT_TRUE(found(observers, m_far));
+
+    ASSERT_EQUAL(m_manager->candidateCount() - candidates, 4);
+    ASSERT_EQUAL(m_manager->observerCount() - deliveries, 2);
+}
+
+void InterestManagertest::test_containered()
+{
+    m_manager->addPerceptive(m_inside);
+    ASSERT_EQUAL(m_manager->m_detached.count(m_inside), 1u);
+
+    // Moving into the domain entity makes it part of the attached group
+    m_inside->m_location.m_loc = m_world;
+    m_inside->containered.emit(m_near);
+
+    ASSERT_EQUAL(m_manager->m_detached.count(m_inside), 0u);
+    ASSERT_EQUAL(m_manager->m_attached[m_world].count(m_inside), 1u);
+
+    // Now that it's attached it's only checked when nearby
+    m_domain->m_seeing.insert(m_inside);
+    std::vector<LocatedEntity *> observers;
+    m_manager->findObservers(*m_observed, *m_domain, observers);
+    ASSERT_TRUE(observers.empty());
+
+    m_domain->m_nearby.push_back(m_inside);
+    m_manager->findObservers(*m_observed, *m_domain, observers);
+    ASSERT_EQUAL(observers.size(), 1u);
+
+    // And moving out again detaches it
+    m_inside->m_location.m_loc = m_near;
+    m_inside->containered.emit(m_world);
+    ASSERT_EQUAL(m_manager->m_detached.count(m_inside), 1u);
+    ASSERT_TRUE(m_manager->m_attached.empty());
+}
+
+int main()
+{
+    InterestManagertest t;
+
+    return t.run();
+}
+
+// stubs
+
+#include "stubs/common/stubMonitors.h"
+#include "stubs/rulesets/stubDomain.h"
+#include "stubs/rulesets/stubLocatedEntity.h"
+#include "stubs/common/stubRouter.h"
+#include "stubs/modules/stubLocation.h"
@@ -31,6 +31,8 @@
 #include "rulesets/AtlasProperties.h"
 #include "rulesets/Script.h"
 
+#include "common/TypeNode.h"
+
 #include <cassert>
 
 using Atlas::Message::Element;
@@ -50,6 +52,7 @@ class LocatedEntitytest : public Cyphesis::TestBase
 
     void test_setProperty();
     void test_removeAttr();
+    void test_getPropertyById();
     void test_coverage();
 
     class TestProperty : public PropertyBase
@@ -94,6 +97,7 @@ LocatedEntitytest::LocatedEntitytest()
 {
     ADD_TEST(LocatedEntitytest::test_setProperty);
     ADD_TEST(LocatedEntitytest::test_removeAttr);
+    ADD_TEST(LocatedEntitytest::test_getPropertyById);
     ADD_TEST(LocatedEntitytest::test_coverage);
 }
 
@@ -137,6 +141,38 @@ void LocatedEntitytest::test_removeAttr()
     ASSERT_TRUE(m_TestProperty_remove_called);
 }
 
+class TestTypeNode : public TypeNode
+{
+  public:
+    explicit TestTypeNode(const std::string & name) : TypeNode(name) { }
+
+    void addDefault(const std::string & name, PropertyBase * prop) {
+        m_defaults[name] = prop;
+    }
+};
+
+void LocatedEntitytest::test_getPropertyById()
+{
+    TestTypeNode * type = new TestTypeNode("test_type");
+    PropertyBase * default_property = new SoftProperty;
+    type->addDefault("default_property", default_property);
+    m_entity->setType(type);
+
+    PropertyBase * instance_property = new SoftProperty;
+    m_entity->setProperty("instance_property", instance_property);
+
+    int instance_id = PropertyDict::intern("instance_property");
+    int default_id = PropertyDict::intern("default_property");
+
+    // Only the entity's own properties are found, as with getProperty()
+    ASSERT_EQUAL(m_entity->getPropertyById(instance_id), instance_property);
+    ASSERT_NULL(m_entity->getPropertyById(default_id));
+    ASSERT_EQUAL(m_entity->getPropertyById(default_id),
+                 m_entity->getProperty("default_property"));
+
+    m_entity->setType(0);
+}
+
 void LocatedEntitytest::test_coverage()
 {
     m_entity->setScript(new Script());
@@ -76,6 +76,9 @@ class MemMaptest : public Cyphesis::TestBase
     void test_findByLoc_results();
     void test_findByLoc_invalid();
     void test_findByLoc_consistency_check();
+    void test_findByType();
+    void test_findByType_subtypes();
+    void test_findNear_grid();
 
     static void Script_hook_called(const std::string &, LocatedEntity *);
 };
@@ -119,6 +122,9 @@ MemMaptest::MemMaptest()
     ADD_TEST(MemMaptest::test_findByLoc_results);
     ADD_TEST(MemMaptest::test_findByLoc_invalid);
     ADD_TEST(MemMaptest::test_findByLoc_consistency_check);
+    ADD_TEST(MemMaptest::test_findByType);
+    ADD_TEST(MemMaptest::test_findByType_subtypes);
+    ADD_TEST(MemMaptest::test_findNear_grid);
 }
 
 void MemMaptest::setup()
@@ -433,6 +439,117 @@ void MemMaptest::test_findByLoc_consistency_check()
     ASSERT_TRUE(res.empty());
 }
 
+void MemMaptest::test_findByType()
+{
+    MemEntity * e4 = new MemEntity("4", 4);
+    e4->setVisible();
+    e4->setType(m_sampleType);
+    m_memMap->addEntity(e4);
+
+    MemEntity * e5 = new MemEntity("5", 5);
+    e5->setVisible();
+    e5->setType(MemMap::m_entity_type);
+    m_memMap->addEntity(e5);
+
+    // Not visible, so not found
+    MemEntity * e6 = new MemEntity("6", 6);
+    e6->setType(m_sampleType);
+    m_memMap->addEntity(e6);
+
+    EntityVector res = m_memMap->findByType("sample_type");
+    ASSERT_EQUAL(res.size(), 1u);
+    ASSERT_EQUAL(res.front(), e4);
+
+    // The index follows the type set when the entity is updated
+    e5->setType(m_sampleType);
+    m_memMap->updateEntity(e5, Anonymous());
+    res = m_memMap->findByType("sample_type");
+    ASSERT_EQUAL(res.size(), 2u);
+
+    m_memMap->del("4");
+    res = m_memMap->findByType("sample_type");
+    ASSERT_EQUAL(res.size(), 1u);
+    ASSERT_EQUAL(res.front(), e5);
+}
+
+void MemMaptest::test_findByType_subtypes()
+{
+    Root type_desc;
+    type_desc->setId("sample_subtype");
+    TypeNode * subtype = Inheritance::instance().addChild(type_desc);
+    subtype->setParent(m_sampleType);
+
+    MemEntity * e4 = new MemEntity("4", 4);
+    e4->setVisible();
+    e4->setType(m_sampleType);
+    m_memMap->addEntity(e4);
+
+    MemEntity * e5 = new MemEntity("5", 5);
+    e5->setVisible();
+    e5->setType(subtype);
+    m_memMap->addEntity(e5);
+
+    EntityVector res = m_memMap->findByType(m_sampleType);
+    ASSERT_EQUAL(res.size(), 1u);
+    ASSERT_EQUAL(res.front(), e4);
+
+    res = m_memMap->findByType(m_sampleType, true);
+    ASSERT_EQUAL(res.size(), 2u);
+
+    res = m_memMap->findByType(subtype, true);
+    ASSERT_EQUAL(res.size(), 1u);
+    ASSERT_EQUAL(res.front(), e5);
+}
+
+void MemMaptest::test_findNear_grid()
+{
+    MemEntity * tlve = new MemEntity("3", 3);
+    tlve->setVisible();
+    tlve->setType(m_sampleType);
+    tlve->m_contains = new LocatedEntitySet;
+    m_memMap->addEntity(tlve);
+
+    MemEntity * e4 = new MemEntity("4", 4);
+    e4->setVisible();
+    e4->setType(m_sampleType);
+    e4->m_location.m_loc = tlve;
+    e4->m_location.m_pos = Point3D(1,1,0);
+    tlve->m_contains->insert(e4);
+    m_memMap->addEntity(e4);
+
+    MemEntity * e5 = new MemEntity("5", 5);
+    e5->setVisible();
+    e5->setType(m_sampleType);
+    e5->m_location.m_loc = tlve;
+    e5->m_location.m_pos = Point3D(100,100,0);
+    tlve->m_contains->insert(e5);
+    m_memMap->addEntity(e5);
+
+    // Only entities in the cells around the point are checked, so the
+    // one far away isn't found, even though distances here are always 1
+    Location find_here(tlve, Point3D(8,8,0));
+    EntityVector res;
+    m_memMap->findNear(find_here, 2.f, res);
+    ASSERT_EQUAL(res.size(), 1u);
+    ASSERT_EQUAL(res.front(), e4);
+
+    // Moving it moves it in the grid once the entity is updated
+    e5->m_location.m_pos = Point3D(2,2,0);
+    m_memMap->updateEntity(e5, Anonymous());
+    res.clear();
+    m_memMap->findNear(find_here, 2.f, res);
+    ASSERT_EQUAL(res.size(), 2u);
+
+    res = m_memMap->findByLocation(find_here, 2.f, "sample_type");
+    ASSERT_EQUAL(res.size(), 2u);
+
+    m_memMap->del("4");
+    res.clear();
+    m_memMap->findNear(find_here, 2.f, res);
+    ASSERT_EQUAL(res.size(), 1u);
+    ASSERT_EQUAL(res.front(), e5);
+}
+
 int main()
 {
     MemMaptest t;
@@ -495,6 +612,18 @@ TypeNode::TypeNode(const std::string & name) : m_name(name), m_parent(0)
 {
 }
 
+bool TypeNode::isTypeOf(const TypeNode * base_type) const
+{
+    const TypeNode * node = this;
+    do {
+        if (node == base_type) {
+            return true;
+        }
+        node = node->parent();
+    } while (node != 0);
+    return false;
+}
+
 float squareDistance(const Point3D & u, const Point3D & v)
 {
     return 1.f;
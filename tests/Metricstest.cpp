@@ -0,0 +1,112 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2015 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "TestBase.h"
+
+#include "common/Metrics.h"
+
+#include <thread>
+#include <vector>
+
+class Metricstest : public Cyphesis::TestBase
+{
+  public:
+    Metricstest();
+
+    void setup();
+    void teardown();
+
+    void test_counter();
+    void test_shardedCounter();
+    void test_gauge();
+};
+
+Metricstest::Metricstest()
+{
+    ADD_TEST(Metricstest::test_counter);
+    ADD_TEST(Metricstest::test_shardedCounter);
+    ADD_TEST(Metricstest::test_gauge);
+}
+
+void Metricstest::setup()
+{
+}
+
+void Metricstest::teardown()
+{
+}
+
+void Metricstest::test_counter()
+{
+    MetricSlot slot;
+    Counter counter(&slot, 1);
+
+    ASSERT_EQUAL(counter.value(), 0);
+    counter.increment();
+    counter.increment(4);
+    ASSERT_EQUAL(counter.value(), 5);
+
+    // Handles share the slot
+    Counter copy(counter);
+    copy.increment();
+    ASSERT_EQUAL(counter.value(), 6);
+}
+
+void Metricstest::test_shardedCounter()
+{
+    MetricSlot slots[4];
+    Counter counter(slots, 4);
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 6; ++i) {
+        threads.emplace_back([counter]() mutable {
+            for (int j = 0; j < 1000; ++j) {
+                counter.increment();
+            }
+        });
+    }
+    for (auto & thread : threads) {
+        thread.join();
+    }
+
+    ASSERT_EQUAL(counter.value(), 6000);
+}
+
+void Metricstest::test_gauge()
+{
+    MetricSlot slot;
+    Gauge gauge(&slot);
+
+    gauge.set(7);
+    ASSERT_EQUAL(gauge.value(), 7);
+    gauge.add(-2);
+    ASSERT_EQUAL(gauge.value(), 5);
+}
+
+int main()
+{
+    Metricstest t;
+
+    return t.run();
+}
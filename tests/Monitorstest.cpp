@@ -24,6 +24,7 @@
 #endif
 
 #include "common/Monitors.h"
+#include "common/Histogram.h"
 #include "common/Variable.h"
 
 #include <iostream>
@@ -54,6 +55,28 @@ int main()
     ss.clear();
     assert(m->readVariable("nonexistent",ss) != 0);
 
+    // counters and gauges are registered once, and updated by handle
+    Counter counter = m->counter("baz", 4);
+    counter.increment(3);
+    Gauge gauge = m->gauge("quux");
+    gauge.set(5);
+    // registering the same name again gives the same slots
+    m->counter("baz").increment();
+
+    std::stringstream metrics;
+    assert(m->readVariable("baz", metrics) == 0);
+    assert(metrics.str() == "4");
+
+    // histograms are owned by monitors, and registered the same way
+    Histogram * histogram = m->histogram("latency", {1., 2.});
+    histogram->observe(1.5);
+    assert(m->histogram("latency", {}) == histogram);
+
+    std::stringstream numerics;
+    m->sendNumerics(numerics);
+    assert(numerics.str().find("quux 5\n") != std::string::npos);
+    assert(numerics.str().find("latency_count 1\n") != std::string::npos);
+
     m->send(std::cout);
 
     Monitors::cleanup();
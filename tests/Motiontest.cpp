@@ -24,6 +24,7 @@
 #endif
 
 #include "TestBase.h"
+#include "TestWorld.h"
 
 #include "rulesets/Motion.h"
 
@@ -33,6 +34,12 @@
 
 #include "common/TypeNode.h"
 
+#include <Atlas/Objects/Operation.h>
+
+#include <wfmath/stream.h>
+
+static std::vector<Operation> world_messages;
+
 class Motiontest : public Cyphesis::TestBase
 {
   protected:
@@ -42,6 +49,7 @@ class Motiontest : public Cyphesis::TestBase
     TypeNode * type;
     Motion * motion;
     Domain* domain;
+    TestWorld * world;
   public:
     Motiontest();
 
@@ -61,6 +69,9 @@ class Motiontest : public Cyphesis::TestBase
     void test_checkCollision_inner2();
     void test_checkCollision_inner3();
     void test_checkCollision_inner4();
+    void test_tick_moves();
+    void test_tick_collision();
+    void test_addMovingEntity_not_child();
 };
 
 void Motiontest::setup()
@@ -68,6 +79,8 @@ void Motiontest::setup()
     type = new TypeNode("test_type");
 
     tlve = new Entity("0", 0);
+    world = new TestWorld(*tlve);
+    world_messages.clear();
     domain = new PhysicalDomain(*tlve);
     ent = new Entity("1", 1);
     other = new Entity("2", 2);
@@ -112,6 +125,9 @@ Motiontest::Motiontest()
     ADD_TEST(Motiontest::test_checkCollision_inner2);
     ADD_TEST(Motiontest::test_checkCollision_inner3);
     ADD_TEST(Motiontest::test_checkCollision_inner4);
+    ADD_TEST(Motiontest::test_tick_moves);
+    ADD_TEST(Motiontest::test_tick_collision);
+    ADD_TEST(Motiontest::test_addMovingEntity_not_child);
 }
 
 void Motiontest::teardown()
@@ -120,6 +136,7 @@ void Motiontest::teardown()
     other->m_location.m_loc = 0;
 
     delete motion;
+    delete world;
     delete tlve;
     delete ent;
     delete other;
@@ -362,6 +379,66 @@ void Motiontest::test_checkCollision_inner4()
     inner.m_location.m_loc = 0;
 }
 
+void Motiontest::test_tick_moves()
+{
+    ent->m_location.update(0.);
+
+    ASSERT_TRUE(domain->addMovingEntity(*ent, 5));
+    // The domain starts ticking
+    ASSERT_EQUAL(world_messages.size(), 1u);
+    ASSERT_EQUAL(world_messages[0]->getParents().front(), "tick");
+    ASSERT_EQUAL(world_messages[0]->getTo(), tlve->getId());
+
+    domain->tick(1.);
+    ASSERT_EQUAL(ent->m_location.pos(), Point3D(2, 1, 0));
+    ASSERT_EQUAL(ent->m_location.timeStamp(), 1.);
+
+    // The move is seen, and the next tick is scheduled
+    ASSERT_EQUAL(world_messages.size(), 3u);
+    ASSERT_EQUAL(world_messages[1]->getParents().front(), "sight");
+    ASSERT_EQUAL(world_messages[2]->getParents().front(), "tick");
+
+    domain->removeMovingEntity(*ent);
+    domain->tick(2.);
+    ASSERT_EQUAL(ent->m_location.pos(), Point3D(2, 1, 0));
+    ASSERT_EQUAL(world_messages.size(), 3u);
+}
+
+void Motiontest::test_tick_collision()
+{
+    ent->m_location.update(0.);
+    ent->m_location.m_bBox = BBox(Point3D(-1,-1,-1), Point3D(1,1,1));
+    other->m_location.m_bBox = BBox(Point3D(-1,-1,-1), Point3D(5,1,1));
+    other->m_location.m_pos = Point3D(4, 0, 0);
+
+    ASSERT_TRUE(domain->addMovingEntity(*ent, 5));
+    domain->tick(1.);
+    ASSERT_EQUAL(ent->m_location.pos(), Point3D(2, 1, 0));
+
+    // A collision is due, so the entity is handed back to its own Update
+    // operations, and no longer moved by the domain.
+    ASSERT_EQUAL(world_messages.size(), 2u);
+    ASSERT_EQUAL(world_messages[1]->getParents().front(), "update");
+    ASSERT_EQUAL(world_messages[1]->getTo(), ent->getId());
+    ASSERT_EQUAL(world_messages[1]->getRefno(), 5);
+
+    domain->tick(2.);
+    ASSERT_EQUAL(ent->m_location.pos(), Point3D(2, 1, 0));
+}
+
+void Motiontest::test_addMovingEntity_not_child()
+{
+    Entity inner("3", 3);
+    inner.m_location.m_loc = other;
+    inner.m_location.m_pos = Point3D(0, 0, 0);
+    inner.m_location.m_velocity = Vector3D(1, 0, 0);
+
+    ASSERT_TRUE(!domain->addMovingEntity(inner, 1));
+    ASSERT_TRUE(world_messages.empty());
+
+    inner.m_location.m_loc = 0;
+}
+
 int main()
 {
     Motiontest t;
@@ -377,9 +454,22 @@ int main()
 
 #include "stubs/rulesets/stubEntity.h"
 #include "stubs/rulesets/stubDomain.h"
+#include "stubs/rulesets/stubDomainSimulation.h"
 #include "stubs/rulesets/stubTerrainProperty.h"
 #include "stubs/rulesets/stubOutfitProperty.h"
 #include "stubs/common/stubCustom.h"
+#include "stubs/common/stubBaseWorld.h"
+
+void TestWorld::message(const Operation & op, LocatedEntity & ent)
+{
+    world_messages.push_back(op);
+}
+
+LocatedEntity * TestWorld::addNewEntity(const std::string &,
+                                 const Atlas::Objects::Entity::RootEntity &)
+{
+    return 0;
+}
 
 
 LocatedEntity::LocatedEntity(const std::string & id, long intId) :
@@ -0,0 +1,151 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2015 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "TestBase.h"
+
+#include "common/OpBroadcast.h"
+
+#include <Atlas/Objects/Operation.h>
+
+class OpBroadcasttest : public Cyphesis::TestBase
+{
+  public:
+    OpBroadcasttest();
+
+    void setup();
+    void teardown();
+
+    void test_active();
+    void test_nested();
+    void test_encoding();
+    void test_split();
+    void test_split_repeated();
+    void test_isVerbatim();
+};
+
+OpBroadcasttest::OpBroadcasttest()
+{
+    ADD_TEST(OpBroadcasttest::test_active);
+    ADD_TEST(OpBroadcasttest::test_nested);
+    ADD_TEST(OpBroadcasttest::test_encoding);
+    ADD_TEST(OpBroadcasttest::test_split);
+    ADD_TEST(OpBroadcasttest::test_split_repeated);
+    ADD_TEST(OpBroadcasttest::test_isVerbatim);
+}
+
+void OpBroadcasttest::setup()
+{
+}
+
+void OpBroadcasttest::teardown()
+{
+}
+
+void OpBroadcasttest::test_active()
+{
+    Atlas::Objects::Operation::Sight op;
+    Atlas::Objects::Operation::Sight other;
+
+    ASSERT_NULL(OpBroadcast::active(op));
+    {
+        OpBroadcast broadcast(op);
+        ASSERT_EQUAL(OpBroadcast::active(op), &broadcast);
+        ASSERT_NULL(OpBroadcast::active(other));
+    }
+    ASSERT_NULL(OpBroadcast::active(op));
+}
+
+void OpBroadcasttest::test_nested()
+{
+    Atlas::Objects::Operation::Sight op;
+    Atlas::Objects::Operation::Sound other;
+
+    OpBroadcast broadcast(op);
+    {
+        OpBroadcast inner(other);
+        ASSERT_EQUAL(OpBroadcast::active(other), &inner);
+        ASSERT_NULL(OpBroadcast::active(op));
+        ASSERT_TRUE(inner.placeholder() != broadcast.placeholder());
+    }
+    ASSERT_EQUAL(OpBroadcast::active(op), &broadcast);
+}
+
+void OpBroadcasttest::test_encoding()
+{
+    Atlas::Objects::Operation::Sight op;
+    OpBroadcast broadcast(op);
+
+    std::type_index codec(typeid(int));
+
+    ASSERT_NULL(broadcast.getEncoding(codec).get());
+
+    std::string encoded = "{to:" + broadcast.placeholder() + ",args:[]}";
+    OpBroadcast::EncodingPtr encoding = broadcast.addEncoding(codec, encoded);
+    ASSERT_NOT_NULL(encoding.get());
+    ASSERT_TRUE(encoding->m_valid);
+    ASSERT_EQUAL(encoding->m_prefix, "{to:");
+    ASSERT_EQUAL(encoding->m_suffix, ",args:[]}");
+
+    ASSERT_EQUAL(broadcast.getEncoding(codec).get(), encoding.get());
+    ASSERT_NULL(broadcast.getEncoding(std::type_index(typeid(long))).get());
+}
+
+void OpBroadcasttest::test_split()
+{
+    OpBroadcast::Encoding encoding;
+
+    OpBroadcast::split("abcPLACEdef", "PLACE", encoding);
+    ASSERT_TRUE(encoding.m_valid);
+    ASSERT_EQUAL(encoding.m_prefix, "abc");
+    ASSERT_EQUAL(encoding.m_suffix, "def");
+
+    OpBroadcast::split("abcdef", "PLACE", encoding);
+    ASSERT_TRUE(!encoding.m_valid);
+}
+
+void OpBroadcasttest::test_split_repeated()
+{
+    OpBroadcast::Encoding encoding;
+
+    // If the placeholder occurs elsewhere we can't know which one is TO
+    OpBroadcast::split("PLACEabcPLACE", "PLACE", encoding);
+    ASSERT_TRUE(!encoding.m_valid);
+}
+
+void OpBroadcasttest::test_isVerbatim()
+{
+    ASSERT_TRUE(OpBroadcast::isVerbatim("12345"));
+    ASSERT_TRUE(OpBroadcast::isVerbatim("abc_DEF_1"));
+    ASSERT_TRUE(!OpBroadcast::isVerbatim(""));
+    ASSERT_TRUE(!OpBroadcast::isVerbatim("a b"));
+    ASSERT_TRUE(!OpBroadcast::isVerbatim("a<b"));
+    ASSERT_TRUE(!OpBroadcast::isVerbatim("\"1\""));
+}
+
+int main()
+{
+    OpBroadcasttest t;
+
+    return t.run();
+}
@@ -0,0 +1,181 @@
+/*
+ Copyright (C) 2015 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+// Compares the timing wheel used for future operations with the
+// std::priority_queue it replaced. The queue is filled with operations
+// due a fraction of a second to a few minutes ahead, like the Tick and
+// Update ops which make up most of the queue in a running server, and
+// then operations are taken off and new ones added as the dispatcher
+// does. Not run as part of the test suite, as it takes a while.
+
+#include "common/OpTimingWheel.h"
+
+#include "rulesets/LocatedEntity.h"
+
+#include <Atlas/Objects/Operation.h>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using Atlas::Objects::Operation::Set;
+
+class TestLocatedEntity : public LocatedEntity {
+  public:
+    TestLocatedEntity(const std::string & id, long intId) :
+                      LocatedEntity(id, intId) { }
+
+    virtual void externalOperation(const Operation &, Link &) { }
+    virtual void operation(const Operation &, OpVector &) { }
+
+    virtual void destroy() { }
+};
+
+/// \brief Produces the times operations are due, the same for each queue.
+class Schedule
+{
+  protected:
+    std::mt19937 m_generator;
+    std::uniform_real_distribution<double> m_choice;
+    std::uniform_real_distribution<double> m_near;
+    std::uniform_real_distribution<double> m_far;
+  public:
+    Schedule() : m_choice(0., 1.), m_near(0., 5.), m_far(5., 300.) { }
+
+    double delay()
+    {
+        if (m_choice(m_generator) < .9) {
+            return m_near(m_generator);
+        }
+        return m_far(m_generator);
+    }
+};
+
+static Operation makeOp(double seconds)
+{
+    Set op;
+    op->setSeconds(seconds);
+    return op;
+}
+
+static double topSeconds(const OpPriorityQueue & queue)
+{
+    return queue.top()->getSeconds();
+}
+
+static double topSeconds(const OpTimingWheel & queue)
+{
+    return queue.topSeconds();
+}
+
+struct Timings {
+    double fill;
+    double churn;
+    double drain;
+};
+
+/// \brief Time filling the queue, replacing each operation once, and
+/// emptying it again.
+template <typename Queue>
+static Timings run(Queue & queue, LocatedEntity & entity, std::size_t count)
+{
+    typedef std::chrono::steady_clock clock;
+    Schedule schedule;
+    std::vector<Operation> ops;
+    ops.reserve(count * 2);
+    double now = 0.;
+    for (std::size_t i = 0; i < count * 2; ++i) {
+        ops.push_back(makeOp(0.));
+    }
+    Timings timings;
+
+    clock::time_point start = clock::now();
+    for (std::size_t i = 0; i < count; ++i) {
+        ops[i]->setSeconds(now + schedule.delay());
+        queue.push(OpQueEntry(ops[i], entity));
+    }
+    clock::time_point filled = clock::now();
+    for (std::size_t i = count; i < count * 2; ++i) {
+        now = topSeconds(queue);
+        queue.pop();
+        ops[i]->setSeconds(now + schedule.delay());
+        queue.push(OpQueEntry(ops[i], entity));
+    }
+    clock::time_point churned = clock::now();
+    while (!queue.empty()) {
+        queue.pop();
+    }
+    clock::time_point drained = clock::now();
+
+    timings.fill = std::chrono::duration<double>(filled - start).count();
+    timings.churn = std::chrono::duration<double>(churned - filled).count();
+    timings.drain = std::chrono::duration<double>(drained - churned).count();
+    return timings;
+}
+
+static void report(const char * name, std::size_t count,
+                   const Timings & timings)
+{
+    std::cout << name << " " << count << " ops:"
+              << " fill " << timings.fill * 1e9 / count << " ns/op,"
+              << " churn " << timings.churn * 1e9 / count << " ns/op,"
+              << " drain " << timings.drain * 1e9 / count << " ns/op"
+              << std::endl;
+}
+
+int main()
+{
+    TestLocatedEntity entity("1", 1);
+
+    std::size_t counts[] = { 100000, 1000000 };
+    for (std::size_t count : counts) {
+        OpPriorityQueue heap;
+        report("priority_queue", count, run(heap, entity, count));
+
+        OpTimingWheel wheel;
+        report("timing wheel  ", count, run(wheel, entity, count));
+    }
+
+    return 0;
+}
+
+// stubs
+
+// The same as the real ones, as copying entries is part of the cost
+OpQueEntry::OpQueEntry(const Operation & o, LocatedEntity & f) : op(o),
+                                                                 from(&f)
+{
+    from->incRef();
+}
+
+OpQueEntry::OpQueEntry(const OpQueEntry & o) : op(o.op), from(o.from)
+{
+    from->incRef();
+}
+
+OpQueEntry::~OpQueEntry()
+{
+    if (from != nullptr) {
+        from->decRef();
+    }
+}
+
+#include "stubs/rulesets/stubLocatedEntity.h"
+#include "stubs/common/stubRouter.h"
+#include "stubs/modules/stubLocation.h"
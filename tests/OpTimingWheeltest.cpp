@@ -0,0 +1,283 @@
+/*
+ Copyright (C) 2015 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "TestBase.h"
+
+#include "common/OpTimingWheel.h"
+
+#include "rulesets/LocatedEntity.h"
+
+#include <Atlas/Objects/Operation.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+using Atlas::Objects::Operation::Set;
+
+class TestLocatedEntity : public LocatedEntity {
+  public:
+    TestLocatedEntity(const std::string & id, long intId) :
+                      LocatedEntity(id, intId) { }
+
+    virtual void externalOperation(const Operation &, Link &) { }
+    virtual void operation(const Operation &, OpVector &) { }
+
+    virtual void destroy() { }
+};
+
+class OpTimingWheeltest : public Cyphesis::TestBase
+{
+  protected:
+    OpTimingWheel * m_wheel;
+    LocatedEntity * m_entity;
+
+    void push(double seconds, long serialno);
+    long popSerialno();
+  public:
+    OpTimingWheeltest();
+
+    void setup();
+    void teardown();
+
+    void test_empty();
+    void test_order();
+    void test_sameTime();
+    void test_levels();
+    void test_overflow();
+    void test_pastTime();
+    void test_restart();
+    void test_clear();
+    void test_random();
+};
+
+OpTimingWheeltest::OpTimingWheeltest()
+{
+    ADD_TEST(OpTimingWheeltest::test_empty);
+    ADD_TEST(OpTimingWheeltest::test_order);
+    ADD_TEST(OpTimingWheeltest::test_sameTime);
+    ADD_TEST(OpTimingWheeltest::test_levels);
+    ADD_TEST(OpTimingWheeltest::test_overflow);
+    ADD_TEST(OpTimingWheeltest::test_pastTime);
+    ADD_TEST(OpTimingWheeltest::test_restart);
+    ADD_TEST(OpTimingWheeltest::test_clear);
+    ADD_TEST(OpTimingWheeltest::test_random);
+}
+
+void OpTimingWheeltest::setup()
+{
+    m_wheel = new OpTimingWheel;
+    m_entity = new TestLocatedEntity("1", 1);
+}
+
+void OpTimingWheeltest::teardown()
+{
+    delete m_wheel;
+    delete m_entity;
+}
+
+void OpTimingWheeltest::push(double seconds, long serialno)
+{
+    Set op;
+    op->setSeconds(seconds);
+    op->setSerialno(serialno);
+    m_wheel->push(OpQueEntry(op, *m_entity));
+}
+
+long OpTimingWheeltest::popSerialno()
+{
+    long serialno = m_wheel->top()->getSerialno();
+    m_wheel->pop();
+    return serialno;
+}
+
+void OpTimingWheeltest::test_empty()
+{
+    ASSERT_TRUE(m_wheel->empty());
+    ASSERT_EQUAL(m_wheel->size(), 0u);
+
+    push(1., 1);
+    ASSERT_TRUE(!m_wheel->empty());
+    ASSERT_EQUAL(m_wheel->size(), 1u);
+    ASSERT_EQUAL(m_wheel->topSeconds(), 1.);
+
+    m_wheel->pop();
+    ASSERT_TRUE(m_wheel->empty());
+}
+
+void OpTimingWheeltest::test_order()
+{
+    push(3., 3);
+    push(1., 1);
+    push(2.5, 2);
+    push(0.5, 0);
+
+    ASSERT_EQUAL(m_wheel->size(), 4u);
+    ASSERT_EQUAL(popSerialno(), 0);
+    ASSERT_EQUAL(popSerialno(), 1);
+    ASSERT_EQUAL(popSerialno(), 2);
+    ASSERT_EQUAL(popSerialno(), 3);
+    ASSERT_TRUE(m_wheel->empty());
+}
+
+void OpTimingWheeltest::test_sameTime()
+{
+    // Ops due at the same time, or in the same slot, come out in the
+    // order they were added.
+    push(1., 1);
+    push(5., 3);
+    push(1., 2);
+    push(5., 4);
+    push(5., 5);
+
+    ASSERT_EQUAL(popSerialno(), 1);
+    ASSERT_EQUAL(popSerialno(), 2);
+    ASSERT_EQUAL(popSerialno(), 3);
+    ASSERT_EQUAL(popSerialno(), 4);
+    ASSERT_EQUAL(popSerialno(), 5);
+}
+
+void OpTimingWheeltest::test_levels()
+{
+    // One op for each level of the wheel, which all have to be cascaded
+    // down to the lowest level before they come out.
+    push(0., 0);
+    push(5000., 3);
+    push(60., 2);
+    push(2., 1);
+
+    ASSERT_EQUAL(popSerialno(), 0);
+    ASSERT_EQUAL(m_wheel->topSeconds(), 2.);
+    ASSERT_EQUAL(popSerialno(), 1);
+    ASSERT_EQUAL(m_wheel->topSeconds(), 60.);
+    ASSERT_EQUAL(popSerialno(), 2);
+    ASSERT_EQUAL(m_wheel->topSeconds(), 5000.);
+    ASSERT_EQUAL(popSerialno(), 3);
+    ASSERT_TRUE(m_wheel->empty());
+}
+
+void OpTimingWheeltest::test_overflow()
+{
+    push(0., 0);
+    // Too far ahead to fit in the wheel
+    push(1000000., 3);
+    push(100000., 2);
+    push(1., 1);
+
+    ASSERT_EQUAL(m_wheel->m_overflow.size(), 2u);
+
+    ASSERT_EQUAL(popSerialno(), 0);
+    ASSERT_EQUAL(popSerialno(), 1);
+    ASSERT_EQUAL(popSerialno(), 2);
+    ASSERT_EQUAL(popSerialno(), 3);
+    ASSERT_TRUE(m_wheel->empty());
+}
+
+void OpTimingWheeltest::test_pastTime()
+{
+    push(10., 3);
+    push(20., 4);
+    ASSERT_EQUAL(popSerialno(), 3);
+
+    // Before where the wheel has got to, but still has to come first
+    push(5., 1);
+    push(15., 2);
+    ASSERT_EQUAL(popSerialno(), 1);
+    ASSERT_EQUAL(popSerialno(), 2);
+    ASSERT_EQUAL(popSerialno(), 4);
+}
+
+void OpTimingWheeltest::test_restart()
+{
+    push(100000., 1);
+    ASSERT_EQUAL(popSerialno(), 1);
+
+    // Once empty, the wheel starts again from the next op
+    push(1., 2);
+    push(2., 3);
+    ASSERT_EQUAL(m_wheel->m_cursor, m_wheel->toTick(1.));
+    ASSERT_EQUAL(m_wheel->m_ready.size(), 1u);
+    ASSERT_EQUAL(popSerialno(), 2);
+    ASSERT_EQUAL(popSerialno(), 3);
+}
+
+void OpTimingWheeltest::test_clear()
+{
+    push(1., 1);
+    push(60., 2);
+    push(1000000., 3);
+
+    m_wheel->clear();
+    ASSERT_TRUE(m_wheel->empty());
+    ASSERT_TRUE(m_wheel->m_ready.empty());
+    ASSERT_TRUE(m_wheel->m_overflow.empty());
+
+    push(2., 4);
+    ASSERT_EQUAL(popSerialno(), 4);
+    ASSERT_TRUE(m_wheel->empty());
+}
+
+void OpTimingWheeltest::test_random()
+{
+    // Compare with a simple sorted list, adding ops relative to the time
+    // of the last one taken, as the dispatcher does.
+    std::vector<std::pair<double, long> > expected;
+    srand(42);
+    double now = 0.;
+    long serialno = 0;
+    for (int i = 0; i < 10000; ++i) {
+        if (rand() % 3 != 0 || expected.empty()) {
+            double delay = (rand() % 1000) / 100.;
+            if (rand() % 10 == 0) {
+                delay = rand() % 200000;
+            }
+            push(now + delay, serialno);
+            expected.push_back(std::make_pair(now + delay, serialno));
+            ++serialno;
+        } else {
+            auto I = std::min_element(expected.begin(), expected.end());
+            ASSERT_EQUAL(m_wheel->topSeconds(), I->first);
+            ASSERT_EQUAL(popSerialno(), I->second);
+            now = I->first;
+            expected.erase(I);
+        }
+        ASSERT_EQUAL(m_wheel->size(), expected.size());
+    }
+}
+
+int main()
+{
+    OpTimingWheeltest t;
+
+    return t.run();
+}
+
+// stubs
+
+#include "stubs/common/stubOperationsDispatcher.h"
+#include "stubs/rulesets/stubLocatedEntity.h"
+#include "stubs/common/stubRouter.h"
+#include "stubs/modules/stubLocation.h"
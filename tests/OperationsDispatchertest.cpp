@@ -0,0 +1,329 @@
+/*
+ Copyright (C) 2015 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "TestBase.h"
+
+#include "common/OperationsDispatcher.h"
+#include "common/Histogram.h"
+#include "common/Monitors.h"
+#include "common/Update.h"
+#include "common/log.h"
+
+#include "rulesets/LocatedEntity.h"
+
+#include <Atlas/Objects/Operation.h>
+
+#include <vector>
+
+using Atlas::Objects::Operation::Set;
+using Atlas::Objects::Operation::Update;
+
+class TestLocatedEntity : public LocatedEntity {
+  public:
+    TestLocatedEntity(const std::string & id, long intId) :
+                      LocatedEntity(id, intId) { }
+
+    virtual void externalOperation(const Operation &, Link &) { }
+    virtual void operation(const Operation &, OpVector &) { }
+
+    virtual void destroy() { }
+};
+
+class TestOperationsDispatcher : public OperationsDispatcher
+{
+  public:
+    TestOperationsDispatcher(const std::function<void(const Operation&, LocatedEntity&)>& operationProcessor, const std::function<double()>& timeProviderFn) :
+        OperationsDispatcher(operationProcessor, timeProviderFn)
+    {
+    }
+
+    int supersededUpdates() const
+    {
+        return m_supersededUpdates.value();
+    }
+
+    std::size_t trackedUpdates() const
+    {
+        return m_movementUpdates.size();
+    }
+
+    const Histogram & sliceOps() const
+    {
+        return *m_sliceOps;
+    }
+
+    const Histogram & backlogAge() const
+    {
+        return *m_backlogAge;
+    }
+};
+
+class OperationsDispatchertest : public Cyphesis::TestBase
+{
+  protected:
+    double m_time;
+    std::vector<Operation> m_dispatched;
+    TestOperationsDispatcher * m_dispatcher;
+    LocatedEntity * m_entity;
+
+    Operation movementUpdate(long refno, double futureSeconds);
+  public:
+    OperationsDispatchertest();
+
+    void setup();
+    void teardown();
+
+    void test_immediate();
+    void test_future();
+    void test_supersededUpdate();
+    void test_latestUpdateEarlier();
+    void test_immediateUpdate();
+    void test_updateWithoutRefno();
+    void test_clearQueues();
+    void test_timeBudget();
+    void test_sliceHistograms();
+};
+
+OperationsDispatchertest::OperationsDispatchertest()
+{
+    ADD_TEST(OperationsDispatchertest::test_immediate);
+    ADD_TEST(OperationsDispatchertest::test_future);
+    ADD_TEST(OperationsDispatchertest::test_supersededUpdate);
+    ADD_TEST(OperationsDispatchertest::test_latestUpdateEarlier);
+    ADD_TEST(OperationsDispatchertest::test_immediateUpdate);
+    ADD_TEST(OperationsDispatchertest::test_updateWithoutRefno);
+    ADD_TEST(OperationsDispatchertest::test_clearQueues);
+    ADD_TEST(OperationsDispatchertest::test_timeBudget);
+    ADD_TEST(OperationsDispatchertest::test_sliceHistograms);
+}
+
+void OperationsDispatchertest::setup()
+{
+    m_time = 100.;
+    m_dispatched.clear();
+    m_dispatcher = new TestOperationsDispatcher(
+          [&](const Operation & op, LocatedEntity &) {
+              m_dispatched.push_back(op);
+          },
+          [&]()->double { return m_time; });
+    m_entity = new TestLocatedEntity("1", 1);
+}
+
+void OperationsDispatchertest::teardown()
+{
+    delete m_dispatcher;
+    delete m_entity;
+    // Metrics live as long as Monitors, so this starts each test from zero
+    Monitors::cleanup();
+}
+
+Operation OperationsDispatchertest::movementUpdate(long refno,
+                                                   double futureSeconds)
+{
+    Update u;
+    u->setTo(m_entity->getId());
+    u->setRefno(refno);
+    u->setFutureSeconds(futureSeconds);
+    return u;
+}
+
+void OperationsDispatchertest::test_immediate()
+{
+    Set t;
+    m_dispatcher->addOperationToQueue(t, *m_entity);
+
+    ASSERT_TRUE(m_dispatcher->isQueueDirty());
+    ASSERT_EQUAL(t->getFrom(), m_entity->getId());
+    ASSERT_EQUAL(t->getSeconds(), m_time);
+
+    m_dispatcher->idle();
+    ASSERT_EQUAL(m_dispatched.size(), 1u);
+}
+
+void OperationsDispatchertest::test_future()
+{
+    Set later;
+    later->setFutureSeconds(10.);
+    m_dispatcher->addOperationToQueue(later, *m_entity);
+    Set sooner;
+    sooner->setFutureSeconds(5.);
+    m_dispatcher->addOperationToQueue(sooner, *m_entity);
+
+    ASSERT_EQUAL(m_dispatcher->secondsUntilNextOp(), 5.);
+
+    m_dispatcher->idle();
+    ASSERT_TRUE(m_dispatched.empty());
+
+    m_time += 20.;
+    m_dispatcher->idle();
+    ASSERT_EQUAL(m_dispatched.size(), 2u);
+    ASSERT_TRUE(m_dispatched[0].get() == sooner.get());
+    ASSERT_TRUE(m_dispatched[1].get() == later.get());
+    ASSERT_EQUAL(m_dispatcher->secondsUntilNextOp(), 600.);
+}
+
+void OperationsDispatchertest::test_supersededUpdate()
+{
+    m_dispatcher->addOperationToQueue(movementUpdate(1, 1.), *m_entity);
+    Operation latest = movementUpdate(2, 2.);
+    m_dispatcher->addOperationToQueue(latest, *m_entity);
+
+    m_time += 5.;
+    m_dispatcher->idle();
+
+    ASSERT_EQUAL(m_dispatched.size(), 1u);
+    ASSERT_TRUE(m_dispatched[0].get() == latest.get());
+    ASSERT_EQUAL(m_dispatcher->supersededUpdates(), 1);
+    ASSERT_EQUAL(m_dispatcher->trackedUpdates(), 0u);
+}
+
+void OperationsDispatchertest::test_latestUpdateEarlier()
+{
+    m_dispatcher->addOperationToQueue(movementUpdate(1, 2.), *m_entity);
+    m_dispatcher->addOperationToQueue(movementUpdate(2, 1.), *m_entity);
+
+    m_time += 5.;
+    m_dispatcher->idle();
+
+    // Once the latest one has been dispatched nothing is dropped, and
+    // it's left to the entity to ignore the old one.
+    ASSERT_EQUAL(m_dispatched.size(), 2u);
+    ASSERT_EQUAL(m_dispatcher->supersededUpdates(), 0);
+}
+
+void OperationsDispatchertest::test_immediateUpdate()
+{
+    m_dispatcher->addOperationToQueue(movementUpdate(1, 1.), *m_entity);
+
+    Update u;
+    u->setTo(m_entity->getId());
+    u->setRefno(2);
+    m_dispatcher->addOperationToQueue(u, *m_entity);
+    ASSERT_EQUAL(m_dispatcher->trackedUpdates(), 0u);
+
+    m_time += 5.;
+    m_dispatcher->idle();
+
+    ASSERT_EQUAL(m_dispatched.size(), 2u);
+    ASSERT_EQUAL(m_dispatcher->supersededUpdates(), 0);
+}
+
+void OperationsDispatchertest::test_updateWithoutRefno()
+{
+    Update first;
+    first->setTo(m_entity->getId());
+    first->setFutureSeconds(1.);
+    m_dispatcher->addOperationToQueue(first, *m_entity);
+    Update second;
+    second->setTo(m_entity->getId());
+    second->setFutureSeconds(2.);
+    m_dispatcher->addOperationToQueue(second, *m_entity);
+
+    ASSERT_EQUAL(m_dispatcher->trackedUpdates(), 0u);
+
+    m_time += 5.;
+    m_dispatcher->idle();
+
+    ASSERT_EQUAL(m_dispatched.size(), 2u);
+}
+
+void OperationsDispatchertest::test_clearQueues()
+{
+    m_dispatcher->addOperationToQueue(movementUpdate(1, 1.), *m_entity);
+    Set t;
+    m_dispatcher->addOperationToQueue(t, *m_entity);
+
+    m_dispatcher->clearQueues();
+    ASSERT_EQUAL(m_dispatcher->trackedUpdates(), 0u);
+
+    m_time += 5.;
+    m_dispatcher->idle();
+    ASSERT_TRUE(m_dispatched.empty());
+}
+
+void OperationsDispatchertest::test_timeBudget()
+{
+    for (int i = 0; i < 3; ++i) {
+        Set t;
+        m_dispatcher->addOperationToQueue(t, *m_entity);
+    }
+
+    // With no budget only one op is dispatched at a time, and idle()
+    // says if there are more.
+    m_dispatcher->setTimeBudget(0.);
+    ASSERT_TRUE(m_dispatcher->idle());
+    ASSERT_EQUAL(m_dispatched.size(), 1u);
+    ASSERT_EQUAL(Monitors::instance()->gauge("immediate_operations_queue").value(), 2);
+    ASSERT_TRUE(m_dispatcher->idle());
+    ASSERT_EQUAL(m_dispatched.size(), 2u);
+    ASSERT_TRUE(!m_dispatcher->idle());
+    ASSERT_EQUAL(m_dispatched.size(), 3u);
+
+    // Nothing to do
+    ASSERT_TRUE(!m_dispatcher->idle());
+}
+
+void OperationsDispatchertest::test_sliceHistograms()
+{
+    Set t1;
+    m_dispatcher->addOperationToQueue(t1, *m_entity);
+    Set t2;
+    m_dispatcher->addOperationToQueue(t2, *m_entity);
+
+    m_time += 0.5;
+    m_dispatcher->idle();
+    ASSERT_EQUAL(m_dispatched.size(), 2u);
+
+    ASSERT_EQUAL(m_dispatcher->sliceOps().count(), 1);
+    ASSERT_EQUAL(m_dispatcher->sliceOps().sum(), 2.);
+    ASSERT_EQUAL(m_dispatcher->backlogAge().sum(), 0.5);
+
+    // Calls which dispatch nothing aren't recorded
+    m_dispatcher->idle();
+    ASSERT_EQUAL(m_dispatcher->sliceOps().count(), 1);
+}
+
+int main()
+{
+    Atlas::Objects::Operation::UPDATE_NO = 100;
+
+    OperationsDispatchertest t;
+
+    return t.run();
+}
+
+// stubs
+
+namespace Atlas { namespace Objects { namespace Operation {
+int UPDATE_NO = -1;
+} } }
+
+void log(LogLevel lvl, const std::string & msg)
+{
+}
+
+#include "stubs/rulesets/stubLocatedEntity.h"
+#include "stubs/common/stubRouter.h"
+#include "stubs/modules/stubLocation.h"
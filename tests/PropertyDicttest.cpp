@@ -0,0 +1,173 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2015 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "TestBase.h"
+
+#include "common/PropertyDict.h"
+
+class PropertyDicttest : public Cyphesis::TestBase
+{
+  protected:
+    PropertyDict * m_dict;
+    PropertyBase * m_prop1;
+    PropertyBase * m_prop2;
+  public:
+    PropertyDicttest();
+
+    void setup();
+    void teardown();
+
+    void test_intern();
+    void test_insert();
+    void test_find();
+    void test_erase();
+    void test_iterate();
+};
+
+PropertyDicttest::PropertyDicttest()
+{
+    ADD_TEST(PropertyDicttest::test_intern);
+    ADD_TEST(PropertyDicttest::test_insert);
+    ADD_TEST(PropertyDicttest::test_find);
+    ADD_TEST(PropertyDicttest::test_erase);
+    ADD_TEST(PropertyDicttest::test_iterate);
+}
+
+void PropertyDicttest::setup()
+{
+    m_dict = new PropertyDict;
+    // Only the pointers are used
+    m_prop1 = reinterpret_cast<PropertyBase *>(0x10);
+    m_prop2 = reinterpret_cast<PropertyBase *>(0x20);
+}
+
+void PropertyDicttest::teardown()
+{
+    delete m_dict;
+}
+
+void PropertyDicttest::test_intern()
+{
+    ASSERT_EQUAL(PropertyDict::lookup("test_intern"), -1);
+
+    int id = PropertyDict::intern("test_intern");
+    ASSERT_TRUE(id >= 0);
+    ASSERT_EQUAL(PropertyDict::intern("test_intern"), id);
+    ASSERT_EQUAL(PropertyDict::lookup("test_intern"), id);
+    ASSERT_EQUAL(PropertyDict::name(id), "test_intern");
+    ASSERT_NOT_EQUAL(PropertyDict::intern("test_intern_other"), id);
+}
+
+void PropertyDicttest::test_insert()
+{
+    // Inserted in the reverse order of their ids
+    int id2 = PropertyDict::intern("test_insert_2");
+    int id1 = PropertyDict::intern("test_insert_1");
+    (*m_dict)["test_insert_1"] = m_prop1;
+    (*m_dict)["test_insert_2"] = m_prop2;
+
+    ASSERT_EQUAL(m_dict->size(), 2u);
+    ASSERT_TRUE(id2 < id1);
+    ASSERT_EQUAL(m_dict->begin()->first, "test_insert_2");
+    ASSERT_TRUE(m_dict->begin()->second == m_prop2);
+
+    // Setting an existing entry replaces it
+    (*m_dict)["test_insert_2"] = m_prop1;
+    ASSERT_EQUAL(m_dict->size(), 2u);
+    ASSERT_TRUE(m_dict->begin()->second == m_prop1);
+}
+
+void PropertyDicttest::test_find()
+{
+    (*m_dict)["test_find"] = m_prop1;
+
+    PropertyDict::const_iterator I = m_dict->find("test_find");
+    ASSERT_TRUE(I != m_dict->end());
+    ASSERT_TRUE(I->second == m_prop1);
+    ASSERT_TRUE(m_dict->find(PropertyDict::lookup("test_find")) == I);
+
+    // Names which have never been seen aren't added by a lookup
+    ASSERT_TRUE(m_dict->find("test_find_missing") == m_dict->end());
+    ASSERT_EQUAL(PropertyDict::lookup("test_find_missing"), -1);
+
+    // Names known elsewhere aren't necessarily in this one
+    PropertyDict::intern("test_find_other");
+    ASSERT_TRUE(m_dict->find("test_find_other") == m_dict->end());
+}
+
+void PropertyDicttest::test_erase()
+{
+    (*m_dict)["test_erase_1"] = m_prop1;
+    (*m_dict)["test_erase_2"] = m_prop2;
+
+    PropertyDict::iterator I = m_dict->erase(m_dict->find("test_erase_1"));
+    ASSERT_TRUE(I == m_dict->find("test_erase_2"));
+    ASSERT_EQUAL(m_dict->size(), 1u);
+    ASSERT_TRUE(m_dict->find("test_erase_1") == m_dict->end());
+
+    m_dict->clear();
+    ASSERT_TRUE(m_dict->empty());
+    ASSERT_TRUE(m_dict->find("test_erase_2") == m_dict->end());
+}
+
+void PropertyDicttest::test_iterate()
+{
+    int id1 = PropertyDict::intern("test_iterate_1");
+    int id2 = PropertyDict::intern("test_iterate_2");
+    (*m_dict)["test_iterate_2"] = m_prop2;
+    (*m_dict)["test_iterate_1"] = m_prop1;
+
+    // Names are read from the interned names, so refer to the same string
+    PropertyDict::iterator I = m_dict->begin();
+    ASSERT_TRUE(&I->first == &PropertyDict::name(id1));
+    ASSERT_TRUE(&(*++I).first == &PropertyDict::name(id2));
+
+    // Properties can be replaced through an iterator
+    for (auto entry : *m_dict) {
+        entry.second = m_prop1;
+    }
+    ASSERT_TRUE(I->second == m_prop1);
+
+    // Iterators convert to, and compare with, const iterators
+    const PropertyDict & dict = *m_dict;
+    PropertyDict::const_iterator J = m_dict->find(id2);
+    ASSERT_TRUE(I == J);
+    ASSERT_TRUE(J == I);
+    ASSERT_TRUE(++J == dict.end());
+    ASSERT_TRUE(m_dict->end() == J);
+
+    int count = 0;
+    for (const auto & entry : dict) {
+        ASSERT_TRUE(entry.first == PropertyDict::name(count == 0 ? id1 : id2));
+        ++count;
+    }
+    ASSERT_EQUAL(count, 2);
+}
+
+int main()
+{
+    PropertyDicttest t;
+
+    return t.run();
+}
@@ -13,13 +13,33 @@
 
 #include "rulesets/Python_API.h"
 #include "rulesets/Py_Filter.h"
+#include "rulesets/Py_Thing.h"
 
 #include <cassert>
 
+static PyObject * null_wrapper(PyObject * self, PyEntity * o)
+{
+    if (PyLocatedEntity_Check(o)) {
+        o->m_entity.l = NULL;
+    } else {
+        PyErr_SetString(PyExc_TypeError, "Unknown Object type");
+        return NULL;
+    }
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+static PyMethodDef sabotage_methods[] = {
+    {"null", (PyCFunction)null_wrapper,                 METH_O},
+    {NULL,          NULL}                       /* Sentinel */
+};
+
 int main()
 {
     init_python_api("");
 
+    Py_InitModule("sabotage", sabotage_methods);
+
     run_python_string("import entity_filter");
 
     //Try creating a filter with a valid query
@@ -43,6 +63,14 @@ int main()
     run_python_string("assert(f.match_entity(le1))");
     run_python_string("assert(not f.match_entity(le2))");
 
+    //An entity which has been destroyed can't be matched or searched
+    run_python_string("import sabotage");
+    run_python_string("sabotage.null(le2)");
+    expect_python_error("f.match_entity(le2)", PyExc_RuntimeError);
+    run_python_string("t = Thing('3')");
+    run_python_string("sabotage.null(t)");
+    expect_python_error("f.search_contains(t)", PyExc_RuntimeError);
+
     shutdown_python_api();
     return 0;
 }
@@ -18,8 +18,6 @@
 
 #ifdef NDEBUG
 #undef NDEBUG
-#else
-#define CYPHESIS_DEBUG
 #endif
 #ifndef DEBUG
 #define DEBUG
@@ -37,6 +35,9 @@
 #include "rulesets/Entity.h"
 #include "rulesets/Character.h"
 
+#include "common/Property.h"
+#include "common/TypeNode.h"
+
 #include <cassert>
 
 void check_union()
@@ -76,9 +77,7 @@ void check_union()
 static PyObject * null_wrapper(PyObject * self, PyEntity * o)
 {
     if (PyLocatedEntity_Check(o)) {
-#ifdef CYPHESIS_DEBUG
         o->m_entity.l = NULL;
-#endif // NDEBUG
     } else {
         PyErr_SetString(PyExc_TypeError, "Unknown Object type");
         return NULL;
@@ -152,7 +151,44 @@ int main()
     assert(le != 0);
     PyObject * wrap_le = wrapEntity(le);
     assert(wrap_le != 0);
-    
+
+    // Each class of entity gets the right kind of wrapper, including when
+    // the class has been seen before.
+    assert(Py_TYPE(wrap_e) == &PyEntity_Type);
+    assert(Py_TYPE(wrap_c) == &PyCharacter_Type);
+    assert(Py_TYPE(wrap_le) == &PyLocatedEntity_Type);
+    Character * c2 = new Character("5", 5);
+    PyObject * wrap_c2 = wrapEntity(c2);
+    assert(Py_TYPE(wrap_c2) == &PyCharacter_Type);
+    assert(((PyEntity *)wrap_c2)->m_entity.c == c2);
+
+    // A wrapper kept by a script no longer refers to the entity once the
+    // entity has gone.
+    Entity * e2 = new Entity("6", 6);
+    PyObject * wrap_e2 = wrapEntity(e2);
+    assert(((PyEntity *)wrap_e2)->m_entity.e == e2);
+    delete e2;
+    assert(((PyEntity *)wrap_e2)->m_entity.e == 0);
+    Py_DECREF(wrap_e2);
+
+    // Reading a class property from a script doesn't give the entity its
+    // own copy of it, but setting it does.
+    TypeNode * default_type = new TypeNode("default_test_type");
+    Property<int> * default_prop = new Property<int>;
+    default_prop->data() = 23;
+    default_prop->flags() |= flag_class;
+    default_type->addProperty("default_attr", default_prop);
+    Entity * de = new Entity("4", 4);
+    de->setType(default_type);
+    PyObject * wrap_de = wrapEntity(de);
+    assert(wrap_de != 0);
+    PyObject_SetAttrString(PyImport_AddModule("__main__"), "de", wrap_de);
+    run_python_string("assert(de.default_attr == 23)");
+    assert(de->getProperties().find("default_attr") == de->getProperties().end());
+    run_python_string("de.default_attr = 24");
+    assert(de->getProperties().find("default_attr") != de->getProperties().end());
+    run_python_string("assert(de.default_attr == 24)");
+    assert(default_prop->data() == 23);
 
     run_python_string("from server import *");
     run_python_string("from atlas import Operation");
@@ -261,39 +297,50 @@ int main()
     expect_python_error("m.non_atlas=set([1,2])", PyExc_AttributeError);
     expect_python_error("m.non_atlas", PyExc_AttributeError);
 
-#ifdef CYPHESIS_DEBUG
     run_python_string("import sabotage");
-    // Hit the assert checks.
+    // Hit the checks for a destroyed entity.
 
     run_python_string("t4=Thing('4')");
     run_python_string("sabotage.null(t4)");
-    expect_python_error("Thing(t4)", PyExc_AssertionError);
+    expect_python_error("Thing(t4)", PyExc_RuntimeError);
     
     run_python_string("c5=Character('5')");
     run_python_string("sabotage.null(c5)");
-    expect_python_error("Character(c5)", PyExc_AssertionError);
+    expect_python_error("Character(c5)", PyExc_RuntimeError);
 
     run_python_string("sabotage.null(le)");
-    expect_python_error("le.location", PyExc_AssertionError);
-    expect_python_error("le.foo=1", PyExc_AssertionError);
-    expect_python_error("le == t", PyExc_AssertionError);
+    expect_python_error("le.location", PyExc_RuntimeError);
+    expect_python_error("le.foo=1", PyExc_RuntimeError);
+    expect_python_error("le == t", PyExc_RuntimeError);
 
     run_python_string("as_entity_method=t.as_entity");
     run_python_string("send_world_method=t.send_world");
     run_python_string("sabotage.null(t)");
-    expect_python_error("as_entity_method()", PyExc_AssertionError);
+    expect_python_error("as_entity_method()", PyExc_RuntimeError);
     expect_python_error("send_world_method(Operation('get'))",
-                        PyExc_AssertionError);
+                        PyExc_RuntimeError);
 
     run_python_string("start_task_method=c.start_task");
     run_python_string("mind2body_method=c.mind2body");
     run_python_string("sabotage.null(c)");
     expect_python_error("start_task_method(Task(Character('3')),Operation('cut'),Oplist())",
-                        PyExc_AssertionError);
+                        PyExc_RuntimeError);
     expect_python_error("mind2body_method(Operation('update'))",
-                        PyExc_AssertionError);
-
-#endif // NDEBUG
+                        PyExc_RuntimeError);
+
+    // Methods called on a wrapper kept by a script after its entity has
+    // been deleted raise an error rather than touching the entity.
+    Entity * e7 = new Entity("7", 7);
+    PyObject * wrap_e7 = wrapEntity(e7);
+    PyObject_SetAttrString(PyImport_AddModule("__main__"), "e7", wrap_e7);
+    run_python_string("e7_send_world = e7.send_world");
+    run_python_string("e7_as_entity = e7.as_entity");
+    delete e7;
+    expect_python_error("e7_send_world(Operation('get'))", PyExc_RuntimeError);
+    expect_python_error("e7_as_entity()", PyExc_RuntimeError);
+    expect_python_error("e7.location", PyExc_RuntimeError);
+    expect_python_error("e7.foo=1", PyExc_RuntimeError);
+    Py_DECREF(wrap_e7);
 
     shutdown_python_api();
     return 0;
@@ -30,6 +30,7 @@
 #include "rulesets/Entity.h"
 #include "rulesets/PythonArithmeticFactory.h"
 #include "rulesets/PythonArithmeticScript.h"
+#include "rulesets/PythonEntityScript.h"
 #include "rulesets/Python_API.h"
 #include "rulesets/Script.h"
 
@@ -295,6 +296,10 @@ void log(LogLevel lvl, const std::string & msg)
 {
 }
 
+void PythonEntityScript::flushHandlers()
+{
+}
+
 PyObject * Get_PyClass(PyObject * module,
                        const std::string & package,
                        const std::string & type)
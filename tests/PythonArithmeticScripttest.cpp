@@ -31,6 +31,7 @@
 
 #include "common/compose.hpp"
 #include "common/log.h"
+#include "common/ScriptProfiler.h"
 
 #include <cassert>
 
@@ -71,6 +72,8 @@ int main()
 
         PythonArithmeticScript pas(instance);
 
+        ScriptProfiler::instance()->setEnabled(true);
+
         float val;
         pas.attribute("foo", val);
         pas.attribute("bar", val);
@@ -78,6 +81,14 @@ int main()
         pas.attribute("qux", val);
         pas.attribute("nonexistent", val);
 
+        // Each attribute read is timed separately
+        const ScriptProfiler::TotalsDict & totals =
+              ScriptProfiler::instance()->totals();
+        assert(totals.size() == 5);
+        assert(totals.begin()->first.first == "TestArithmeticScript");
+        assert(totals.begin()->second.calls == 1);
+        ScriptProfiler::instance()->setEnabled(false);
+
         pas.set("foo", 1.0f);
         pas.set("mim", 1.0f);
     }
@@ -119,6 +130,9 @@ ArithmeticScript::~ArithmeticScript()
 {
 }
 
+#include "stubs/common/stubMonitors.h"
+#include "stubs/common/stubVariable.h"
+
 void log(LogLevel lvl, const std::string & msg)
 {
 }
@@ -147,11 +147,16 @@ int main()
 #include "common/log.h"
 
 #include "rulesets/Python_Script_Utils.h"
+#include "rulesets/PythonEntityScript.h"
 
 void log(LogLevel lvl, const std::string & msg)
 {
 }
 
+void PythonEntityScript::flushHandlers()
+{
+}
+
 struct _object * Get_PyClass(struct _object * module,
                              const std::string & package,
                              const std::string & type)
@@ -30,6 +30,7 @@
 #include "rulesets/Entity.h"
 #include "rulesets/Py_Thing.h"
 #include "rulesets/Python_API.h"
+#include "rulesets/PythonEntityScript.h"
 #include "rulesets/PythonScriptFactory.h"
 #include "rulesets/Script.h"
 
@@ -146,6 +147,49 @@ int main()
     Script * script = e->script();
     assert(script != 0);
 
+    // Handlers are looked up once for each class, until they are flushed
+    // when rules are reloaded, but one added to the class in the meantime
+    // is still found.
+    res.clear();
+    assert(!script->operation("create", op2, res));
+    run_python_string("TestEntity.create_operation = "
+                      "lambda self, op: Operation('sight')");
+    assert(script->operation("create", op2, res));
+    assert(res.size() == 1);
+    PythonEntityScript::flushHandlers();
+    assert(script->operation("create", op2, res));
+    assert(res.size() == 2);
+    assert(script->operation("look", op1, res));
+
+    // A handler replaced on the class is called instead of the one looked
+    // up before.
+    res.clear();
+    run_python_string("TestEntity.look_operation = "
+                      "lambda self, op: Operation('sight')");
+    assert(script->operation("look", op1, res));
+    assert(res.size() == 1);
+
+    // Handlers set on the script itself, or provided by __getattr__, are
+    // found as well, and one on the script overrides the class.
+    PyObject * wrapper = static_cast<PythonEntityScript *>(script)->wrapper();
+    PyObject_SetAttrString(PyImport_AddModule("__main__"), "te", wrapper);
+    res.clear();
+    assert(!script->operation("sight", op1, res));
+    run_python_string("te.sight_operation = lambda op: Operation('sound')");
+    assert(script->operation("sight", op1, res));
+    assert(res.size() == 1);
+    run_python_string("te.look_operation = lambda op: Operation('sound')");
+    assert(script->operation("look", op1, res));
+    assert(res.size() == 2);
+    run_python_string("def touch_getattr(self, name):\n"
+                      " if name == 'touch_operation':\n"
+                      "  return lambda op: Operation('sound')\n"
+                      " raise AttributeError(name)\n"
+                      "TestEntity.__getattr__ = touch_getattr");
+    assert(script->operation("touch", op1, res));
+    assert(res.size() == 3);
+    run_python_string("del te");
+
     script->hook("nohookfunction", e);
     script->hook("test_hook", e);
 
@@ -42,8 +42,16 @@ int main()
 
 // stubs
 
+#include "rulesets/Py_Thing.h"
+
 #include "common/log.h"
 
+PyTypeObject PyLocatedEntity_Type = {
+        PyObject_HEAD_INIT(&PyType_Type)
+        0,                              /*ob_size*/
+        "server.LocatedEntity",         /*tp_name*/
+};
+
 Script::Script()
 {
 }
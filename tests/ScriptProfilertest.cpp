@@ -0,0 +1,140 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2015 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "TestBase.h"
+
+#include "common/ScriptProfiler.h"
+
+class ScriptProfilertest : public Cyphesis::TestBase
+{
+  public:
+    ScriptProfilertest();
+
+    void setup();
+    void teardown();
+
+    void test_disabled();
+    void test_profile();
+    void test_record();
+    void test_top();
+};
+
+ScriptProfilertest::ScriptProfilertest()
+{
+    ADD_TEST(ScriptProfilertest::test_disabled);
+    ADD_TEST(ScriptProfilertest::test_profile);
+    ADD_TEST(ScriptProfilertest::test_record);
+    ADD_TEST(ScriptProfilertest::test_top);
+}
+
+void ScriptProfilertest::setup()
+{
+}
+
+void ScriptProfilertest::teardown()
+{
+    ScriptProfiler::cleanup();
+}
+
+void ScriptProfilertest::test_disabled()
+{
+    std::string handler("tick_operation");
+    {
+        ScriptProfile profile("Thing", handler);
+    }
+
+    ASSERT_TRUE(ScriptProfiler::instance()->totals().empty());
+}
+
+void ScriptProfilertest::test_profile()
+{
+    ScriptProfiler::instance()->setEnabled(true);
+
+    std::string handler("tick_operation");
+    {
+        ScriptProfile profile("Thing", handler);
+    }
+    {
+        ScriptProfile profile("Thing", handler);
+    }
+
+    const ScriptProfiler::TotalsDict & totals =
+          ScriptProfiler::instance()->totals();
+    ASSERT_EQUAL(totals.size(), 1u);
+    ASSERT_EQUAL(totals.begin()->first.first, "Thing");
+    ASSERT_EQUAL(totals.begin()->first.second, "tick_operation");
+    ASSERT_EQUAL(totals.begin()->second.calls, 2);
+    ASSERT_TRUE(totals.begin()->second.wallTime >= 0.);
+    ASSERT_TRUE(totals.begin()->second.cpuTime >= 0.);
+}
+
+void ScriptProfilertest::test_record()
+{
+    ScriptProfiler::instance()->record("Thing", "tick_operation", 2., 1.);
+    ScriptProfiler::instance()->record("Thing", "tick_operation", 2., 1.);
+    ScriptProfiler::instance()->record("Plant", "tick_operation", 1., 1.);
+
+    const ScriptProfiler::TotalsDict & totals =
+          ScriptProfiler::instance()->totals();
+    ASSERT_EQUAL(totals.size(), 2u);
+
+    ScriptProfiler::TotalsDict::const_iterator I =
+          totals.find(ScriptProfiler::Key("Thing", "tick_operation"));
+    ASSERT_TRUE(I != totals.end());
+    ASSERT_EQUAL(I->second.calls, 2);
+    ASSERT_EQUAL(I->second.wallTime, 4.);
+    ASSERT_EQUAL(I->second.cpuTime, 2.);
+}
+
+void ScriptProfilertest::test_top()
+{
+    ScriptProfiler::instance()->record("Thing", "tick_operation", 1., 1.);
+    ScriptProfiler::instance()->record("Thing", "move_operation", 1., 3.);
+    ScriptProfiler::instance()->record("Plant", "tick_operation", 1., 2.);
+
+    ScriptProfiler::TotalsList list;
+    ScriptProfiler::instance()->top(2, list);
+    ASSERT_EQUAL(list.size(), 2u);
+    ASSERT_EQUAL(list[0].first.second, "move_operation");
+    ASSERT_EQUAL(list[1].first.first, "Plant");
+
+    ScriptProfiler::instance()->top(10, list);
+    ASSERT_EQUAL(list.size(), 3u);
+    ASSERT_EQUAL(list[2].second.cpuTime, 1.);
+}
+
+int main()
+{
+    ScriptProfilertest t;
+
+    return t.run();
+}
+
+// stubs
+
+#include "common/Monitors.h"
+#include "common/Variable.h"
+
+#include "stubs/common/stubMonitors.h"
+#include "stubs/common/stubVariable.h"
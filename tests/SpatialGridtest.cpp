@@ -0,0 +1,250 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2015 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "TestBase.h"
+
+#include "rulesets/SpatialGrid.h"
+
+#include <algorithm>
+#include <limits>
+
+// The grid never dereferences the entities, so any distinct address will do.
+static char entity_storage[4];
+
+static LocatedEntity * const ent1 = (LocatedEntity *)&entity_storage[0];
+static LocatedEntity * const ent2 = (LocatedEntity *)&entity_storage[1];
+static LocatedEntity * const ent3 = (LocatedEntity *)&entity_storage[2];
+static LocatedEntity * const ent4 = (LocatedEntity *)&entity_storage[3];
+
+static bool found(const std::vector<LocatedEntity *> & result,
+                  LocatedEntity * entity)
+{
+    return std::find(result.begin(), result.end(), entity) != result.end();
+}
+
+class SpatialGridtest : public Cyphesis::TestBase
+{
+  protected:
+    SpatialGrid * m_grid;
+  public:
+    SpatialGridtest();
+
+    void setup();
+    void teardown();
+
+    void test_insert();
+    void test_query_near();
+    void test_query_far();
+    void test_query_reach();
+    void test_unbounded();
+    void test_move();
+    void test_remove();
+    void test_negative_coords();
+    void test_large_radius();
+};
+
+SpatialGridtest::SpatialGridtest()
+{
+    ADD_TEST(SpatialGridtest::test_insert);
+    ADD_TEST(SpatialGridtest::test_query_near);
+    ADD_TEST(SpatialGridtest::test_query_far);
+    ADD_TEST(SpatialGridtest::test_query_reach);
+    ADD_TEST(SpatialGridtest::test_unbounded);
+    ADD_TEST(SpatialGridtest::test_move);
+    ADD_TEST(SpatialGridtest::test_remove);
+    ADD_TEST(SpatialGridtest::test_negative_coords);
+    ADD_TEST(SpatialGridtest::test_large_radius);
+}
+
+void SpatialGridtest::setup()
+{
+    m_grid = new SpatialGrid(10.f, 20.f);
+}
+
+void SpatialGridtest::teardown()
+{
+    delete m_grid;
+}
+
+void SpatialGridtest::test_insert()
+{
+    m_grid->insert(ent1, 1, 1, 1);
+    m_grid->insert(ent2, 2, 2, 1);
+
+    ASSERT_EQUAL(m_grid->size(), 2u);
+    ASSERT_EQUAL(m_grid->cellCount(), 1u);
+    ASSERT_TRUE(m_grid->contains(ent1));
+    ASSERT_TRUE(m_grid->contains(ent2));
+    ASSERT_TRUE(!m_grid->contains(ent3));
+
+    // Inserting again should not duplicate
+    m_grid->insert(ent1, 1, 1, 1);
+    ASSERT_EQUAL(m_grid->size(), 2u);
+}
+
+void SpatialGridtest::test_query_near()
+{
+    m_grid->insert(ent1, 1, 1, 1);
+    m_grid->insert(ent2, 15, 15, 1);
+
+    std::vector<LocatedEntity *> result;
+    m_grid->query(0, 0, 1, result);
+
+    ASSERT_TRUE(found(result, ent1));
+    ASSERT_TRUE(found(result, ent2));
+}
+
+void SpatialGridtest::test_query_far()
+{
+    m_grid->insert(ent1, 1, 1, 1);
+    m_grid->insert(ent2, 1000, 1000, 1);
+
+    std::vector<LocatedEntity *> result;
+    m_grid->query(0, 0, 1, result);
+
+    ASSERT_TRUE(found(result, ent1));
+    ASSERT_TRUE(!found(result, ent2));
+}
+
+void SpatialGridtest::test_query_reach()
+{
+    // An entity with a reach of 20 at 25 units away must be found even
+    // when querying with a tiny radius.
+    m_grid->insert(ent1, 25, 0, 20);
+
+    std::vector<LocatedEntity *> result;
+    m_grid->query(0, 0, 0, result);
+
+    ASSERT_TRUE(found(result, ent1));
+}
+
+void SpatialGridtest::test_unbounded()
+{
+    m_grid->insert(ent1, 1000, 1000, 100);
+    m_grid->insert(ent2, 1000, 1000, std::numeric_limits<float>::infinity());
+    m_grid->insert(ent3, std::numeric_limits<float>::quiet_NaN(), 0, 1);
+
+    ASSERT_EQUAL(m_grid->cellCount(), 0u);
+
+    std::vector<LocatedEntity *> result;
+    m_grid->query(0, 0, 1, result);
+
+    ASSERT_EQUAL(result.size(), 3u);
+    ASSERT_TRUE(found(result, ent1));
+    ASSERT_TRUE(found(result, ent2));
+    ASSERT_TRUE(found(result, ent3));
+}
+
+void SpatialGridtest::test_move()
+{
+    m_grid->insert(ent1, 1, 1, 1);
+    m_grid->insert(ent2, 2, 2, 1);
+    m_grid->insert(ent3, 3, 3, 1);
+
+    m_grid->insert(ent1, 1000, 1000, 1);
+
+    ASSERT_EQUAL(m_grid->size(), 3u);
+    ASSERT_EQUAL(m_grid->cellCount(), 2u);
+
+    std::vector<LocatedEntity *> result;
+    m_grid->query(0, 0, 1, result);
+    ASSERT_TRUE(!found(result, ent1));
+    ASSERT_TRUE(found(result, ent2));
+    ASSERT_TRUE(found(result, ent3));
+
+    result.clear();
+    m_grid->query(1000, 1000, 1, result);
+    ASSERT_TRUE(found(result, ent1));
+    ASSERT_TRUE(!found(result, ent2));
+
+    // Growing beyond the max reach moves it to the unbounded list.
+    m_grid->insert(ent1, 1000, 1000, 100);
+    ASSERT_EQUAL(m_grid->cellCount(), 1u);
+    result.clear();
+    m_grid->query(0, 0, 1, result);
+    ASSERT_TRUE(found(result, ent1));
+}
+
+void SpatialGridtest::test_remove()
+{
+    m_grid->insert(ent1, 1, 1, 1);
+    m_grid->insert(ent2, 2, 2, 1);
+    m_grid->insert(ent3, 3, 3, 1);
+    m_grid->insert(ent4, 4, 4, 100);
+
+    m_grid->remove(ent1);
+    m_grid->remove(ent4);
+    // Removing something not indexed should be harmless.
+    m_grid->remove(ent1);
+
+    ASSERT_EQUAL(m_grid->size(), 2u);
+
+    std::vector<LocatedEntity *> result;
+    m_grid->query(0, 0, 1, result);
+    ASSERT_EQUAL(result.size(), 2u);
+    ASSERT_TRUE(found(result, ent2));
+    ASSERT_TRUE(found(result, ent3));
+
+    m_grid->remove(ent2);
+    m_grid->remove(ent3);
+    ASSERT_EQUAL(m_grid->size(), 0u);
+    ASSERT_EQUAL(m_grid->cellCount(), 0u);
+}
+
+void SpatialGridtest::test_negative_coords()
+{
+    m_grid->insert(ent1, -1, -1, 1);
+    m_grid->insert(ent2, -1000, 1000, 1);
+
+    std::vector<LocatedEntity *> result;
+    m_grid->query(1, 1, 1, result);
+    ASSERT_TRUE(found(result, ent1));
+    ASSERT_TRUE(!found(result, ent2));
+
+    result.clear();
+    m_grid->query(-1000, 1000, 1, result);
+    ASSERT_TRUE(found(result, ent2));
+    ASSERT_TRUE(!found(result, ent1));
+}
+
+void SpatialGridtest::test_large_radius()
+{
+    m_grid->insert(ent1, 1, 1, 1);
+    m_grid->insert(ent2, 5000, 5000, 1);
+
+    std::vector<LocatedEntity *> result;
+    m_grid->query(0, 0, 100000, result);
+    ASSERT_EQUAL(result.size(), 2u);
+
+    result.clear();
+    m_grid->query(0, 0, std::numeric_limits<float>::infinity(), result);
+    ASSERT_EQUAL(result.size(), 2u);
+}
+
+int main()
+{
+    SpatialGridtest t;
+
+    return t.run();
+}
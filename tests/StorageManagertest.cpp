@@ -32,10 +32,23 @@
 #include "rulesets/Character.h"
 #include "rulesets/MindProperty.h"
 
+#include "common/Database.h"
+#include "common/DatabaseBatch.h"
 #include "common/SystemTime.h"
 
 #include <cassert>
 using Atlas::Message::Element;
+using Atlas::Message::MapType;
+
+class TestEntity : public Entity
+{
+  public:
+    TestEntity(const std::string & id, long intId) : Entity(id, intId) { }
+
+    PropertyBase * test_addProperty(const std::string & name) {
+        return m_properties[name] = new Property<MapType>;
+    }
+};
 
 class TestStorageManager : public StorageManager
 {
@@ -54,17 +67,44 @@ class TestStorageManager : public StorageManager
         encodeProperty(p, s);
     }
     void test_restoreProperties(LocatedEntity * e) {
-        restorePropertiesRecursively(e);
+        DatabaseResult properties(0);
+        DatabaseResult thoughts(0);
+        restorePropertiesRecursively(e, properties, RowIndex(),
+                                     thoughts, RowIndex());
     }
 
     void test_insertEntity(LocatedEntity * e) {
-        insertEntity(e);
+        DatabaseBatch batch;
+        insertEntity(e, batch);
     }
     void test_updateEntity(LocatedEntity * e) {
-        updateEntity(e);
+        DatabaseBatch batch;
+        updateEntity(e, batch);
+    }
+    std::size_t test_updateEntityRows(LocatedEntity * e) {
+        DatabaseBatch batch;
+        updateEntity(e, batch);
+        return batch.rows();
+    }
+    void test_batchFailed() {
+        BatchedEntities batched;
+        batched.swap(m_batchedEntities);
+        batchFailed(batched);
+    }
+    void test_batchWritten() {
+        BatchedEntities batched;
+        batched.swap(m_batchedEntities);
+        batchWritten(batched);
+    }
+    bool test_writeAlone(LocatedEntity * e) const {
+        return writeAlone(e);
+    }
+    std::size_t test_dirtyEntities() const {
+        return m_dirtyEntities.size();
     }
     void test_restoreChildren(LocatedEntity * e) {
-        restoreChildren(e);
+        DatabaseResult entities(0);
+        restoreChildren(e, entities, RowIndex());
     }
 
 
@@ -162,6 +202,90 @@ int main()
         store.test_updateEntity(new Entity("1", 1));
     }
 
+    {
+        SystemTime time;
+        WorldRouter world(time);
+
+        TestStorageManager store(world);
+
+        TestEntity * e = new TestEntity("1", 1);
+        PropertyBase * changed = e->test_addProperty("changed");
+        PropertyBase * unchanged = e->test_addProperty("unchanged");
+        changed->setFlags(per_seen);
+        unchanged->setFlags(per_seen);
+        e->markPropertyDirty(PropertyDict::intern("changed"));
+        e->setFlags(entity_location_clean);
+
+        // Only the changed property is written, without the location
+        assert(store.test_updateEntityRows(e) == 1);
+        assert(changed->flags() & per_clean);
+        assert((unchanged->flags() & per_clean) == 0);
+        assert(e->getDirtyProperties().empty());
+        assert(store.test_updateEntityRows(e) == 0);
+    }
+
+    {
+        SystemTime time;
+        WorldRouter world(time);
+
+        TestStorageManager store(world);
+
+        TestEntity * e = new TestEntity("1", 1);
+        PropertyBase * changed = e->test_addProperty("changed");
+        PropertyBase * added = e->test_addProperty("added");
+        changed->setFlags(per_seen);
+        e->markPropertyDirty(PropertyDict::intern("changed"));
+        e->markPropertyDirty(PropertyDict::intern("added"));
+        e->setFlags(entity_location_clean);
+
+        assert(store.test_updateEntityRows(e) == 2);
+
+        // A statement in the batch fails, so none of its rows are written
+        store.test_batchFailed();
+
+        assert((e->getFlags() & entity_clean) == 0);
+        assert((e->getFlags() & entity_location_clean) == entity_location_clean);
+        assert(e->getFlags() & entity_queued);
+        assert(store.test_dirtyEntities() == 1);
+        assert(e->getDirtyProperties().size() == 2);
+        assert((changed->flags() & per_clean) == 0);
+        assert(changed->flags() & per_seen);
+        assert((added->flags() & (per_clean | per_seen)) == 0);
+
+        // Both properties are written again
+        assert(store.test_updateEntityRows(e) == 2);
+        assert(e->getDirtyProperties().empty());
+        assert(changed->flags() & per_clean);
+        assert(added->flags() & per_seen);
+
+        // It is written on its own until a batch with it succeeds
+        assert(store.test_writeAlone(e));
+        store.test_batchWritten();
+        assert(!store.test_writeAlone(e));
+    }
+
+    {
+        SystemTime time;
+        WorldRouter world(time);
+
+        TestStorageManager store(world);
+
+        TestEntity * e = new TestEntity("1", 1);
+        PropertyBase * bad = e->test_addProperty("bad");
+        e->markPropertyDirty(PropertyDict::intern("bad"));
+
+        // A row which always fails is given up on after a few attempts
+        int attempts = 0;
+        while (store.test_updateEntityRows(e) != 0) {
+            store.test_batchFailed();
+            ++attempts;
+            assert(attempts < 10);
+        }
+        assert(attempts > 1);
+        assert(!store.test_writeAlone(e));
+        assert(bad->flags() & per_seen);
+    }
+
     {
         SystemTime time;
         WorldRouter world(time);
@@ -195,6 +319,7 @@ int main()
 #include "common/Variable.h"
 
 #include "stubs/server/stubWorldRouter.h"
+#include "stubs/server/stubInterestManager.h"
 #include "stubs/modules/stubLocation.h"
 #include "stubs/rulesets/stubEntity.h"
 #include "stubs/rulesets/stubCharacter.h"
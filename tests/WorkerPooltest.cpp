@@ -0,0 +1,162 @@
+/*
+ Copyright (C) 2015 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "TestBase.h"
+
+#include "common/WorkerPool.h"
+
+#include <stdexcept>
+#include <thread>
+
+class WorkerPooltest : public Cyphesis::TestBase
+{
+  protected:
+    std::vector<int> m_results;
+    std::vector<std::function<void()>> m_jobs;
+
+    void makeJobs(std::size_t count);
+  public:
+    WorkerPooltest();
+
+    void setup();
+    void teardown();
+
+    void test_noThreads();
+    void test_threads();
+    void test_batches();
+    void test_empty();
+    void test_exception();
+};
+
+WorkerPooltest::WorkerPooltest()
+{
+    ADD_TEST(WorkerPooltest::test_noThreads);
+    ADD_TEST(WorkerPooltest::test_threads);
+    ADD_TEST(WorkerPooltest::test_batches);
+    ADD_TEST(WorkerPooltest::test_empty);
+    ADD_TEST(WorkerPooltest::test_exception);
+}
+
+void WorkerPooltest::setup()
+{
+}
+
+void WorkerPooltest::teardown()
+{
+    m_jobs.clear();
+    m_results.clear();
+}
+
+void WorkerPooltest::makeJobs(std::size_t count)
+{
+    m_jobs.clear();
+    m_results.assign(count, 0);
+    for (std::size_t i = 0; i < count; ++i) {
+        m_jobs.push_back([this, i]() { m_results[i] += (int)i; });
+    }
+}
+
+void WorkerPooltest::test_noThreads()
+{
+    WorkerPool pool(0);
+    ASSERT_EQUAL(pool.threadCount(), 0u);
+
+    std::thread::id caller = std::this_thread::get_id();
+    std::thread::id runner;
+    std::vector<std::function<void()>> jobs;
+    jobs.push_back([&]() { runner = std::this_thread::get_id(); });
+    jobs.push_back([]() { });
+    pool.run(jobs);
+    ASSERT_TRUE(runner == caller);
+}
+
+void WorkerPooltest::test_threads()
+{
+    WorkerPool pool(4);
+    ASSERT_EQUAL(pool.threadCount(), 4u);
+
+    makeJobs(100);
+    pool.run(m_jobs);
+    for (std::size_t i = 0; i < m_results.size(); ++i) {
+        ASSERT_EQUAL(m_results[i], (int)i);
+    }
+}
+
+void WorkerPooltest::test_batches()
+{
+    WorkerPool pool(3);
+
+    makeJobs(10);
+    for (int batch = 0; batch < 1000; ++batch) {
+        pool.run(m_jobs);
+    }
+    // Each job is run exactly once per batch
+    for (std::size_t i = 0; i < m_results.size(); ++i) {
+        ASSERT_EQUAL(m_results[i], (int)i * 1000);
+    }
+}
+
+void WorkerPooltest::test_empty()
+{
+    WorkerPool pool(2);
+
+    pool.run(m_jobs);
+}
+
+void WorkerPooltest::test_exception()
+{
+    WorkerPool pool(2);
+
+    // A job which throws is logged, and the rest of the batch still runs
+    makeJobs(10);
+    m_jobs[3] = []() { throw std::runtime_error("deliberate"); };
+    m_jobs[7] = []() { throw 1; };
+    pool.run(m_jobs);
+    ASSERT_EQUAL(m_results[9], 9);
+    ASSERT_EQUAL(m_results[3], 0);
+
+    WorkerPool inline_pool(0);
+    inline_pool.run(m_jobs);
+    ASSERT_EQUAL(m_results[9], 18);
+}
+
+int main()
+{
+    WorkerPooltest t;
+
+    return t.run();
+}
+
+// stubs
+
+#include "common/Monitors.h"
+
+#include "stubs/common/stubMonitors.h"
+
+#include "common/log.h"
+
+void log(LogLevel lvl, const std::string & msg)
+{
+}
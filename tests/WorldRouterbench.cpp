@@ -0,0 +1,386 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2015 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+// Runs a WorldRouter populated with a synthetic world, without a network
+// or database, and measures how long it takes to run. The entities are
+// children of an area with a PhysicalDomain, which moves the movers in
+// bulk each movement tick, indexes them in its SpatialGrid, checks them
+// for collisions and broadcasts Sight of the Move to the perceptive
+// entities which can see them. The movers send themselves Tick operations
+// to turn back at the edges of the area, and their new positions are
+// encoded as they would be for storage. The world is driven in simulated
+// time, so each run dispatches the same operations.
+//
+// There is no terrain, so heights are not looked up, and movers which
+// collide are handed back to the domain on their next Tick rather than
+// bouncing off each other.
+//
+// Usage: WorldRouterbench [entities [movers [perceptives [ticks [size]]]]]
+// ticks must be at least 1. size is the width of the square area in
+// meters.
+//
+// The results are written to stdout as a single line of JSON, so they can
+// be compared between runs. Not run as part of the test suite, as it takes
+// a while; "make bench" runs it.
+
+#include "server/WorldRouter.h"
+
+#include "rulesets/PhysicalDomain.h"
+#include "rulesets/Thing.h"
+
+#include "common/BinaryElement.h"
+#include "common/DatabaseBatch.h"
+#include "common/globals.h"
+#include "common/id.h"
+#include "common/Inheritance.h"
+#include "common/Monitors.h"
+#include "common/SystemTime.h"
+#include "common/Tick.h"
+
+#include "physics/BBox.h"
+#include "physics/Vector3D.h"
+
+#include <Atlas/Objects/Anonymous.h>
+#include <Atlas/Objects/Operation.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <new>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include <cstdlib>
+
+#include <sys/resource.h>
+
+using Atlas::Objects::Entity::Anonymous;
+using Atlas::Objects::Operation::Move;
+using Atlas::Objects::Operation::Sight;
+using Atlas::Objects::Operation::Tick;
+
+/// \brief Count of calls to operator new, including those made by the
+/// standard library.
+static unsigned long allocation_count = 0;
+
+void * operator new(std::size_t size)
+{
+    ++allocation_count;
+    void * p = std::malloc(size == 0 ? 1 : size);
+    if (p == 0) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void * p) noexcept
+{
+    std::free(p);
+}
+
+/// \brief Length of each step of simulated time.
+static const double tick_length = 0.1;
+/// \brief Time between the moves made by each mover.
+static const double move_interval = 0.5;
+/// \brief Half the width of the square the entities are placed in.
+static double world_size = 200.;
+/// \brief Steps run before measuring starts.
+static const int warmup_ticks = 20;
+
+/// \brief Entity which holds all the others, and has a PhysicalDomain.
+class BenchArea : public Thing
+{
+  protected:
+    PhysicalDomain m_domain;
+  public:
+    BenchArea(const std::string & id, long intId) : Thing(id, intId),
+                                                    m_domain(*this)
+    {
+        setFlags(entity_domain);
+    }
+
+    virtual Domain * getMovementDomain()
+    {
+        return &m_domain;
+    }
+
+    /// \brief Move the entities of the domain, as the domain property does.
+    virtual void TickOperation(const Operation & op, OpVector & res)
+    {
+        if (!op->getArgs().empty() &&
+            op->getArgs().front()->getName() == "movement") {
+            m_domain.tick(BaseWorld::instance().getTime());
+            return;
+        }
+        Thing::TickOperation(op, res);
+    }
+};
+
+/// \brief Entity which is moved in a straight line by the domain, and
+/// turns back at the edges of the area.
+class BenchMover : public Thing
+{
+  public:
+    BenchMover(const std::string & id, long intId) : Thing(id, intId)
+    {
+    }
+
+    virtual void TickOperation(const Operation & op, OpVector & res)
+    {
+        const Point3D & pos = m_location.pos();
+        Vector3D & velocity = m_location.m_velocity;
+        if ((pos.x() < -world_size && velocity.x() < 0) ||
+            (pos.x() > world_size && velocity.x() > 0)) {
+            velocity.x() = -velocity.x();
+        }
+        if ((pos.y() < -world_size && velocity.y() < 0) ||
+            (pos.y() > world_size && velocity.y() > 0)) {
+            velocity.y() = -velocity.y();
+        }
+        // Hands over the new velocity, and takes the mover back if it
+        // was handed back after a collision.
+        m_location.m_loc->getMovementDomain()->addMovingEntity(*this, 0);
+
+        Tick tick;
+        tick->setTo(getId());
+        tick->setFutureSeconds(move_interval);
+        res.push_back(tick);
+    }
+};
+
+/// \brief Encode the positions of the movers which have moved, as the
+/// StorageManager does, and build the query to store them.
+///
+/// @return the size of the query
+static std::size_t persist(const std::vector<BenchMover *> & movers,
+                           DatabaseBatch & batch)
+{
+    for (BenchMover * mover : movers) {
+        if (mover->getFlags() & entity_pos_clean) {
+            continue;
+        }
+        Atlas::Message::MapType map;
+        map["pos"] = mover->m_location.pos().toAtlas();
+        std::string location;
+        encodeBinaryElement(map, location);
+        batch.updateEntity(mover->getId(), mover->getSeq(), location,
+                           mover->m_location.m_loc->getId());
+        mover->setFlags(entity_pos_clean);
+    }
+    std::size_t size = batch.query().size();
+    batch.clear();
+    return size;
+}
+
+static unsigned long dispatched_count = 0;
+
+static void countOperation(Atlas::Objects::Operation::RootOperation)
+{
+    ++dispatched_count;
+}
+
+static long readCount(const std::string & name)
+{
+    std::stringstream value;
+    Monitors::instance()->readVariable(name, value);
+    long count = 0;
+    value >> count;
+    return count;
+}
+
+static double percentile(std::vector<double> & samples, double fraction)
+{
+    if (samples.empty()) {
+        return 0.;
+    }
+    std::sort(samples.begin(), samples.end());
+    std::size_t index = fraction * (samples.size() - 1) + 0.5;
+    return samples[index];
+}
+
+static double argument(int argc, char ** argv, int index, double def)
+{
+    if (argc > index) {
+        return std::atof(argv[index]);
+    }
+    return def;
+}
+
+static int argument(int argc, char ** argv, int index, int def)
+{
+    if (argc > index) {
+        return std::atoi(argv[index]);
+    }
+    return def;
+}
+
+int main(int argc, char ** argv)
+{
+    typedef std::chrono::steady_clock clock;
+
+    int entity_count = argument(argc, argv, 1, 10000);
+    int mover_count = argument(argc, argv, 2, 1000);
+    int perceptive_count = argument(argc, argv, 3, 200);
+    int tick_count = argument(argc, argv, 4, 500);
+    double size = argument(argc, argv, 5, 400.);
+
+    if (entity_count < 0 || mover_count < 0 || perceptive_count < 0 ||
+        tick_count < 1 || size <= 0.) {
+        std::cerr << "usage: " << argv[0]
+                  << " [entities [movers [perceptives [ticks [size]]]]]"
+                  << std::endl << "ticks must be at least 1, and size "
+                  << "more than 0" << std::endl;
+        return 1;
+    }
+    world_size = size / 2.;
+
+    database_flag = false;
+
+    WorldRouter * world = new WorldRouter(SystemTime());
+    double time = 0.;
+    world->setSimulatedTime(time);
+    // Each step runs to completion, so the work done doesn't depend on
+    // how fast the machine is.
+    world->setTimeBudget(3600.);
+    world->Dispatching.connect(sigc::ptr_fun(&countOperation));
+
+    const TypeNode * thing_type = Inheritance::instance().getType("thing");
+
+    std::string id;
+    long int_id = newId(id);
+    BenchArea * area = new BenchArea(id, int_id);
+    area->setType(thing_type);
+    area->m_location.m_loc = &world->getDefaultLocation();
+    area->m_location.m_pos = Point3D(0, 0, 0);
+    world->addEntity(area);
+
+    // A fixed seed, and positions calculated from the raw output, so
+    // every run has the same world.
+    std::minstd_rand generator(1);
+    auto coordinate = [&generator]() {
+        double unit = (double)(generator() - generator.min()) /
+                      (generator.max() - generator.min());
+        return unit * 2. * world_size - world_size;
+    };
+
+    // Big enough to be seen from about 40m away
+    const BBox bbox(Point3D(-0.5, -0.5, 0.), Point3D(0.5, 0.5, 1.8));
+
+    std::vector<BenchMover *> movers;
+    for (int i = 0; i < entity_count; ++i) {
+        int_id = newId(id);
+        Entity * entity;
+        if (i < mover_count) {
+            BenchMover * mover = new BenchMover(id, int_id);
+            double dx = coordinate() / world_size;
+            double dy = coordinate() / world_size;
+            mover->m_location.m_velocity = Vector3D(dx, dy, 0.);
+            movers.push_back(mover);
+            entity = mover;
+        } else {
+            entity = new Thing(id, int_id);
+        }
+        entity->setType(thing_type);
+        entity->m_location.m_loc = area;
+        entity->m_location.m_pos = Point3D(coordinate(), coordinate(), 0);
+        entity->m_location.setBBox(bbox);
+        world->addEntity(entity);
+        if (i >= entity_count - perceptive_count) {
+            world->addPerceptive(entity);
+        }
+    }
+
+    // The domain moves all the movers at once
+    for (BenchMover * mover : movers) {
+        area->getMovementDomain()->addMovingEntity(*mover, 0);
+    }
+
+    // Start the movers at different times, so each step has some
+    for (std::size_t i = 0; i < movers.size(); ++i) {
+        Tick tick;
+        tick->setTo(movers[i]->getId());
+        tick->setFutureSeconds((i % 5) * tick_length);
+        world->message(tick, *movers[i]);
+    }
+
+    DatabaseBatch batch;
+    std::vector<double> tick_times;
+    tick_times.reserve(tick_count);
+    unsigned long ops = 0;
+    unsigned long allocations = 0;
+    long deliveries = 0;
+    std::size_t persisted_bytes = 0;
+    double total_time = 0.;
+
+    for (int i = -warmup_ticks; i < tick_count; ++i) {
+        if (i == 0) {
+            ops = dispatched_count;
+            allocations = allocation_count;
+            deliveries = readCount("broadcast_deliveries");
+        }
+        time += tick_length;
+        world->setSimulatedTime(time);
+
+        clock::time_point start = clock::now();
+        while (world->idle()) {
+        }
+        std::size_t size = persist(movers, batch);
+        double elapsed = std::chrono::duration<double>(clock::now() -
+                                                       start).count();
+
+        if (i >= 0) {
+            tick_times.push_back(elapsed);
+            total_time += elapsed;
+            persisted_bytes += size;
+        }
+    }
+    ops = dispatched_count - ops;
+    allocations = allocation_count - allocations;
+    deliveries = readCount("broadcast_deliveries") - deliveries;
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    std::cout << "{\"benchmark\": \"WorldRouterDispatch\""
+              << ", \"entities\": " << entity_count
+              << ", \"movers\": " << mover_count
+              << ", \"perceptives\": " << perceptive_count
+              << ", \"ticks\": " << tick_count
+              << ", \"size\": " << size
+              << ", \"ops\": " << ops
+              << ", \"ops_per_second\": "
+              << (total_time > 0. ? ops / total_time : 0.)
+              << ", \"broadcast_deliveries\": " << deliveries
+              << ", \"tick_p50_seconds\": " << percentile(tick_times, 0.5)
+              << ", \"tick_p99_seconds\": " << percentile(tick_times, 0.99)
+              << ", \"persisted_bytes\": " << persisted_bytes
+              << ", \"allocations\": " << allocations
+              << ", \"allocations_per_tick\": "
+              << (double)allocations / tick_count
+              << ", \"max_rss_kb\": " << usage.ru_maxrss
+              << "}" << std::endl;
+
+    world->delEntity(&world->getRootEntity());
+    delete world;
+
+    return 0;
+}
+
+// stubs
+
+#include "WorldRouter_stub_impl.h"
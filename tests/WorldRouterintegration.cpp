@@ -217,493 +217,9 @@ int main()
 
 // stubs
 
-#include "server/EntityFactory.h"
-#include "server/ArchetypeFactory.h"
-#include "server/CorePropertyManager.h"
-
-#include "rulesets/AreaProperty.h"
-#include "rulesets/AtlasProperties.h"
-#include "rulesets/BBoxProperty.h"
-#include "rulesets/CalendarProperty.h"
-#include "rulesets/EntityProperty.h"
-#include "rulesets/ExternalProperty.h"
-#include "rulesets/OutfitProperty.h"
-#include "rulesets/StatusProperty.h"
-#include "rulesets/TasksProperty.h"
-#include "rulesets/TerrainProperty.h"
-#include "rulesets/DomainProperty.h"
-
-#include "rulesets/Character.h"
-#include "rulesets/Creator.h"
-#include "rulesets/Plant.h"
-#include "rulesets/Stackable.h"
-#include "rulesets/ExternalMind.h"
-#include "rulesets/Motion.h"
-#include "rulesets/Pedestrian.h"
-#include "rulesets/PythonArithmeticFactory.h"
-#include "rulesets/Task.h"
-
-#include "stubs/rulesets/stubBBoxProperty.h"
-#include "stubs/rulesets/stubTasksProperty.h"
-#include "stubs/rulesets/stubTerrainProperty.h"
-#include "stubs/rulesets/stubDomainProperty.h"
-#include "stubs/rulesets/stubProxyMind.h"
-#include "stubs/rulesets/stubBaseMind.h"
-#include "stubs/rulesets/stubMemEntity.h"
-#include "stubs/rulesets/stubMemMap.h"
-
-#include "stubs/server/stubExternalMindsManager.h"
-#include "stubs/server/stubExternalMindsConnection.h"
 #include "stubs/common/stubOperationsDispatcher.h"
 
-#include <Atlas/Objects/Operation.h>
-
-CorePropertyManager::CorePropertyManager()
-{
-}
-
-CorePropertyManager::~CorePropertyManager()
-{
-}
-
-PropertyBase * CorePropertyManager::addProperty(const std::string & name,
-                                                int type)
-{
-    return 0;
-}
-
-int CorePropertyManager::installFactory(const std::string & type_name,
-                                        const Atlas::Objects::Root & type_desc,
-                                        PropertyKit * factory)
-{
-    return 0;
-}
-
-ArchetypeFactory::ArchetypeFactory()
-{
-}
-
-ArchetypeFactory::ArchetypeFactory(ArchetypeFactory& rhs)
-{
-}
-
-ArchetypeFactory::~ArchetypeFactory()
-{
-}
-
-void ArchetypeFactory::addProperties()
-{
-}
-
-void ArchetypeFactory::updateProperties()
-{
-}
-
-ArchetypeFactory * ArchetypeFactory::duplicateFactory()
-{
-    return 0;
-}
-
-LocatedEntity * ArchetypeFactory::newEntity(const std::string & id, long intId,
-        const Atlas::Objects::Entity::RootEntity & attributes, LocatedEntity* location)
-{
-    return new Entity(id, intId);
-}
-
-
-class World;
-
-Creator::Creator(const std::string& id, long idInt)
-:Character::Character(id, idInt)
-{
-}
-
-Creator::~Creator(){}
-
-void Creator::operation(const Operation & op, OpVector &)
-{
-}
-
-void Creator::externalOperation(const Operation & op, Link &)
-{
-}
-
-void Creator::mindLookOperation(const Operation & op, OpVector &)
-{
-}
-
-Plant::Plant(const std::string& id, long idInt)
-:Thing::Thing(id, idInt)
-{
-}
-
-Plant::~Plant(){}
-
-void Plant::NourishOperation(const Operation & op, OpVector &)
-{
-}
-
-void Plant::TickOperation(const Operation & op, OpVector &)
-{
-}
-
-void Plant::TouchOperation(const Operation & op, OpVector &)
-{
-}
-
-Stackable::Stackable(const std::string& id, long idInt)
-:Thing::Thing(id, idInt)
-{
-}
-
-Stackable::~Stackable(){}
-
-void Stackable::CombineOperation(const Operation & op, OpVector &)
-{
-}
-
-void Stackable::DivideOperation(const Operation & op, OpVector &)
-{
-}
-
-AreaProperty::AreaProperty()
-{
-}
-
-AreaProperty::~AreaProperty()
-{
-}
-
-void AreaProperty::set(const Atlas::Message::Element & ent)
-{
-}
-
-AreaProperty * AreaProperty::copy() const
-{
-    return 0;
-}
-
-void AreaProperty::apply(LocatedEntity * owner)
-{
-}
-
-CalendarProperty::CalendarProperty()
-{
-}
-
-int CalendarProperty::get(Element & ent) const
-{
-    return 0;
-}
-
-void CalendarProperty::set(const Element & ent)
-{
-}
-
-CalendarProperty * CalendarProperty::copy() const
-{
-    return 0;
-}
-
-ExternalProperty::ExternalProperty(ExternalMind * & data) : m_data(data)
-{
-}
-
-int ExternalProperty::get(Element & val) const
-{
-    return 0;
-}
-
-void ExternalProperty::set(const Element & val)
-{
-}
-
-void ExternalProperty::add(const std::string & s,
-                         MapType & map) const
-{
-}
-
-void ExternalProperty::add(const std::string & s,
-                         const Atlas::Objects::Entity::RootEntity & ent) const
-{
-}
-
-ExternalProperty * ExternalProperty::copy() const
-{
-    return 0;
-}
-
-EntityProperty::EntityProperty()
-{
-}
-
-int EntityProperty::get(Element & val) const
-{
-    return 0;
-}
-
-void EntityProperty::set(const Element & val)
-{
-}
-
-void EntityProperty::add(const std::string & s,
-                         MapType & map) const
-{
-}
-
-void EntityProperty::add(const std::string & s,
-                         const Atlas::Objects::Entity::RootEntity & ent) const
-{
-}
-
-EntityProperty * EntityProperty::copy() const
-{
-    return 0;
-}
-
-IdProperty::IdProperty(const std::string & data) : PropertyBase(per_ephem),
-                                                   m_data(data)
-{
-}
-
-int IdProperty::get(Atlas::Message::Element & e) const
-{
-    e = m_data;
-    return 0;
-}
-
-void IdProperty::set(const Atlas::Message::Element & e)
-{
-}
-
-void IdProperty::add(const std::string & key,
-                     Atlas::Message::MapType & ent) const
-{
-}
-
-void IdProperty::add(const std::string & key,
-                     const Atlas::Objects::Entity::RootEntity & ent) const
-{
-}
-
-IdProperty * IdProperty::copy() const
-{
-    return 0;
-}
-
-OutfitProperty::OutfitProperty()
-{
-}
-
-OutfitProperty::~OutfitProperty()
-{
-}
-
-int OutfitProperty::get(Element & val) const
-{
-    return 0;
-}
-
-void OutfitProperty::set(const Element & val)
-{
-}
-
-void OutfitProperty::add(const std::string & key,
-                         MapType & map) const
-{
-}
-
-void OutfitProperty::add(const std::string & key,
-                         const Atlas::Objects::Entity::RootEntity & ent) const
-{
-}
-
-OutfitProperty * OutfitProperty::copy() const
-{
-    return 0;
-}
-
-void OutfitProperty::cleanUp()
-{
-}
-
-void OutfitProperty::wear(LocatedEntity * wearer,
-                          const std::string & location,
-                          LocatedEntity * garment)
-{
-}
-
-void OutfitProperty::itemRemoved(LocatedEntity * garment, LocatedEntity * wearer)
-{
-}
-
-
-Task::Task(LocatedEntity & owner) : m_refCount(0), m_serialno(0),
-                                    m_obsolete(false),
-                                    m_progress(-1), m_rate(-1),
-                                    m_owner(owner), m_script(0)
-{
-}
-
-Task::~Task()
-{
-}
-
-void Task::initTask(const Operation & op, OpVector & res)
-{
-}
-
-void Task::operation(const Operation & op, OpVector & res)
-{
-}
-
-void Task::irrelevant()
-{
-}
-
-
-ContainsProperty::ContainsProperty(LocatedEntitySet & data) :
-      PropertyBase(per_ephem), m_data(data)
-{
-}
-
-int ContainsProperty::get(Element & e) const
-{
-    return 0;
-}
-
-void ContainsProperty::set(const Element & e)
-{
-}
-
-void ContainsProperty::add(const std::string & s,
-                           const Atlas::Objects::Entity::RootEntity & ent) const
-{
-}
-
-ContainsProperty * ContainsProperty::copy() const
-{
-    return 0;
-}
-
-StatusProperty::StatusProperty()
-{
-}
-
-StatusProperty * StatusProperty::copy() const
-{
-    return 0;
-}
-
-void StatusProperty::apply(LocatedEntity * owner)
-{
-}
-
-
-ExternalMind::ExternalMind(LocatedEntity & e) : Router(e.getId(), e.getIntId()),
-                                         m_external(0),
-                                         m_entity(e),
-                                         m_lossTime(0.)
-{
-}
-
-ExternalMind::~ExternalMind()
-{
-}
-
-void ExternalMind::externalOperation(const Operation & op, Link &)
-{
-}
-
-void ExternalMind::linkUp(Link * c)
-{
-    m_external = c;
-}
-
-void ExternalMind::operation(const Operation & op, OpVector & res)
-{
-}
-
-ArithmeticKit::~ArithmeticKit()
-{
-}
-
-#include "stubs/rulesets/stubMotion.h"
-
-Pedestrian::Pedestrian(LocatedEntity & body) : Movement(body)
-{
-}
-
-Pedestrian::~Pedestrian()
-{
-}
-
-double Pedestrian::getTickAddition(const Point3D & coordinates,
-                                   const Vector3D & velocity) const
-{
-    return consts::basic_tick;
-}
-
-int Pedestrian::getUpdatedLocation(Location & return_location)
-{
-    return 1;
-}
-
-Operation Pedestrian::generateMove(const Location & new_location)
-{
-    Atlas::Objects::Operation::Move moveOp;
-    return moveOp;
-}
-
-Movement::Movement(LocatedEntity & body) : m_body(body),
-                                    m_serialno(0)
-{
-}
-
-Movement::~Movement()
-{
-}
-
-bool Movement::updateNeeded(const Location & location) const
-{
-    return true;
-}
-
-void Movement::reset()
-{
-}
-
-PythonArithmeticFactory::PythonArithmeticFactory(const std::string & package,
-                                                 const std::string & name) :
-                                                 PythonClass(package,
-                                                             name,
-                                                             0)
-{
-}
-
-PythonArithmeticFactory::~PythonArithmeticFactory()
-{
-}
-
-int PythonArithmeticFactory::setup()
-{
-    return 0;
-}
-
-ArithmeticScript * PythonArithmeticFactory::newScript(LocatedEntity * owner)
-{
-    return 0;
-}
-
-PythonClass::PythonClass(const std::string & package,
-                         const std::string & type,
-                         struct _typeobject * base)
-{
-}
-
-PythonClass::~PythonClass()
-{
-}
+#include "WorldRouter_stub_impl.h"
 
 #if 0
 
@@ -37,6 +37,7 @@
 #include "common/const.h"
 #include "common/globals.h"
 #include "common/id.h"
+#include "common/Histogram.h"
 #include "common/Inheritance.h"
 #include "common/log.h"
 #include "common/Monitors.h"
@@ -79,6 +80,7 @@ class WorldRoutertest : public Cyphesis::TestBase
     void test_createSpawnPoint();
     void test_delEntity();
     void test_delEntity_world();
+    void test_operation_latency();
 };
 
 WorldRoutertest::WorldRoutertest()
@@ -95,6 +97,7 @@ WorldRoutertest::WorldRoutertest()
     ADD_TEST(WorldRoutertest::test_createSpawnPoint);
     ADD_TEST(WorldRoutertest::test_delEntity);
     ADD_TEST(WorldRoutertest::test_delEntity_world);
+    ADD_TEST(WorldRoutertest::test_operation_latency);
 }
 
 void WorldRoutertest::setup()
@@ -107,6 +110,8 @@ void WorldRoutertest::teardown()
     delete test_world;
 
     EntityBuilder::del();
+    // Histograms live as long as Monitors, so this starts each test from zero
+    Monitors::cleanup();
 }
 
 void WorldRoutertest::test_constructor()
@@ -270,6 +275,37 @@ void WorldRoutertest::test_delEntity_world()
     test_world->delEntity(&test_world->m_gameWorld);
 }
 
+void WorldRoutertest::test_operation_latency()
+{
+    std::string id;
+    long int_id = newId(id);
+
+    Entity * ent2 = new Entity(id, int_id);
+    assert(ent2 != 0);
+    ent2->m_location.m_loc = &test_world->m_gameWorld;
+    ent2->m_location.m_pos = Point3D(0,0,0);
+    test_world->addEntity(ent2);
+
+    Tick tick;
+    tick->setFrom(ent2->getId());
+    tick->setTo(ent2->getId());
+    test_world->operation(tick, *ent2);
+    test_world->operation(tick, *ent2);
+
+    // One histogram for the op class, and one for the entity type, each
+    // registered with Monitors
+    ASSERT_EQUAL(test_world->m_opLatency.size(), 1u);
+    ASSERT_EQUAL(test_world->m_opLatency.begin()->second,
+                 Monitors::instance()->histogram("op_seconds{op=\"tick\"}",
+                                                 {}));
+    ASSERT_EQUAL(test_world->m_opLatency.begin()->second->count(), 2);
+    ASSERT_EQUAL(test_world->m_typeLatency.size(), 1u);
+    ASSERT_EQUAL(test_world->m_typeLatency.begin()->second,
+                 Monitors::instance()->histogram("entity_op_seconds{type=\"\"}",
+                                                 {}));
+    ASSERT_EQUAL(test_world->m_typeLatency.begin()->second->count(), 2);
+}
+
 int main()
 {
     WorldRoutertest t;
@@ -294,7 +330,9 @@ int TICK_NO = -1;
 #include "stubs/rulesets/stubThing.h"
 #include "stubs/rulesets/stubEntity.h"
 #include "stubs/rulesets/stubDomain.h"
+#include "stubs/rulesets/stubDomainSimulation.h"
 #include "stubs/common/stubOperationsDispatcher.h"
+#include "stubs/server/stubInterestManager.h"
 
 LocatedEntity::LocatedEntity(const std::string & id, long intId) :
                Router(id, intId),
@@ -188,17 +188,33 @@ const DatabaseResult Database::selectProperties(const std::string & id)
     return DatabaseResult(0);
 }
 
+const DatabaseResult Database::selectAllProperties()
+{
+    return DatabaseResult(0);
+}
+
 const DatabaseResult Database::selectEntities(const std::string & loc)
 {
     return DatabaseResult(0);
 }
 
+const DatabaseResult Database::selectAllEntities()
+{
+    return DatabaseResult(0);
+}
+
 int Database::encodeObject(const MapType & o,
                            std::string & data)
 {
     return 0;
 }
 
+int Database::encodeMessage(const MapType & o,
+                            std::string & data)
+{
+    return 0;
+}
+
 int Database::decodeMessage(const std::string & data,
                             MapType &o)
 {
@@ -250,6 +266,11 @@ const DatabaseResult Database::selectThoughts(const std::string & loc)
 {
     return DatabaseResult(0);
 }
+
+const DatabaseResult Database::selectAllThoughts()
+{
+    return DatabaseResult(0);
+}
 int Database::replaceThoughts(const std::string & id,
                      const std::vector<std::string>& thoughts)
 {
@@ -261,5 +282,12 @@ int Database::launchNewQuery()
     return 0;
 }
 
+int Database::scheduleBatch(const DatabaseBatch & batch,
+                            const std::function<void()> & done,
+                            const std::function<void()> & error)
+{
+    return 0;
+}
+
 
 #endif /* STUBDATABASE_H_ */
@@ -17,6 +17,7 @@
 
 
 #include "common/Monitors.h"
+#include "common/Histogram.h"
 
 
 using Atlas::Message::Element;
@@ -30,7 +31,11 @@ Monitors::Monitors()
 
 Monitors::~Monitors()
 {
-
+    HistogramDict::const_iterator I = m_histograms.begin();
+    HistogramDict::const_iterator Iend = m_histograms.end();
+    for (; I != Iend; ++I) {
+        delete I->second;
+    }
 }
 
 Monitors * Monitors::instance()
@@ -56,6 +61,38 @@ void Monitors::watch(const::std::string & name, VariableBase * monitor)
 {
 }
 
+Monitors::MetricSlots & Monitors::metricSlots(const std::string & name,
+                                              unsigned int shards)
+{
+    MetricSlots & metric = m_metrics[name];
+    if (metric.slots == 0) {
+        metric.slots = new MetricSlot[1];
+        metric.count = 1;
+    }
+    return metric;
+}
+
+Counter Monitors::counter(const std::string & name, unsigned int shards)
+{
+    MetricSlots & metric = metricSlots(name, shards);
+    return Counter(metric.slots, metric.count);
+}
+
+Gauge Monitors::gauge(const std::string & name)
+{
+    return Gauge(metricSlots(name, 1).slots);
+}
+
+Histogram * Monitors::histogram(const std::string & name,
+                                const std::vector<double> & bounds)
+{
+    Histogram *& histogram = m_histograms[name];
+    if (histogram == 0) {
+        histogram = new Histogram(bounds);
+    }
+    return histogram;
+}
+
 void Monitors::send(std::ostream & io)
 {
 }
@@ -64,6 +101,14 @@ void Monitors::sendNumerics(std::ostream & io)
 {
 }
 
+void Monitors::sendHistograms(std::ostream & io)
+{
+}
+
+void Monitors::sendMetrics(std::ostream & io)
+{
+}
+
 int Monitors::readVariable(const std::string& key, std::ostream& out_stream) const
 {
     return 1;
@@ -34,7 +34,9 @@ OpQueEntry::~OpQueEntry()
 
 
 OperationsDispatcher::OperationsDispatcher(const std::function<void(const Operation&, LocatedEntity&)>& operationProcessor, const std::function<double()>& timeProviderFn)
-: m_operationProcessor(operationProcessor), m_timeProviderFn(timeProviderFn)
+: m_operationProcessor(operationProcessor), m_timeProviderFn(timeProviderFn),
+  m_supersededUpdates(nullptr, 1), m_immediateQueueSize(nullptr),
+  m_operationQueueSize(nullptr)
 {
 }
 
@@ -50,6 +52,11 @@ void OperationsDispatcher::dispatchOperation(const OpQueEntry& oqe)
 {
 }
 
+bool OperationsDispatcher::isSupersededUpdate(const OpQueEntry& oqe)
+{
+    return false;
+}
+
 void OperationsDispatcher::addOperationToQueue(const Operation & op, LocatedEntity & ent)
 {
 
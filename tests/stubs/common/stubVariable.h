@@ -46,6 +46,12 @@ bool Variable<int>::isNumeric() const
     return true;
 }
 
+template <>
+bool Variable<double>::isNumeric() const
+{
+    return true;
+}
+
 template <>
 bool Variable<std::string>::isNumeric() const
 {
@@ -59,6 +65,7 @@ bool Variable<const char *>::isNumeric() const
 }
 
 template class Variable<int>;
+template class Variable<double>;
 template class Variable<std::string>;
 template class Variable<const char *>;
 
@@ -39,5 +39,35 @@ void Domain::tick(double t)
 
 }
 
+void Domain::addEntity(LocatedEntity& entity)
+{
+}
+
+void Domain::removeEntity(LocatedEntity& entity)
+{
+}
+
+void Domain::updatePosition(LocatedEntity& entity)
+{
+}
+
+bool Domain::findObserverCandidates(const LocatedEntity& observedEntity, std::vector<LocatedEntity*>& candidates)
+{
+    return false;
+}
+
+bool Domain::addMovingEntity(LocatedEntity& entity, long refno)
+{
+    return false;
+}
+
+void Domain::removeMovingEntity(LocatedEntity& entity)
+{
+}
+
+void Domain::releaseMovingEntities()
+{
+}
+
 
 #endif /* STUBDOMAIN_H_ */
@@ -45,6 +45,12 @@ DomainProperty * DomainProperty::copy() const
     return nullptr;
 }
 
+HandlerResult DomainProperty::operation(LocatedEntity *,
+        const Operation &, OpVector &)
+{
+    return OPERATION_IGNORED;
+}
+
 Domain* DomainProperty::getDomain(const LocatedEntity *) const {
     return nullptr;
 }
@@ -0,0 +1,54 @@
+/*
+ Copyright (C) 2015 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+#ifndef STUBDOMAINSIMULATION_H_
+#define STUBDOMAINSIMULATION_H_
+
+#include "rulesets/DomainSimulation.h"
+
+DomainSimulation * DomainSimulation::m_instance = nullptr;
+
+DomainSimulation::DomainSimulation(int threads) : m_pool(nullptr), m_nextTick(0.)
+{
+}
+
+DomainSimulation::~DomainSimulation()
+{
+}
+
+void DomainSimulation::addDomain(PhysicalDomain& domain)
+{
+}
+
+void DomainSimulation::removeDomain(PhysicalDomain& domain)
+{
+}
+
+double DomainSimulation::secondsUntilTick(double time) const
+{
+    return 0.;
+}
+
+void DomainSimulation::idle(double time)
+{
+}
+
+void DomainSimulation::tick(double time)
+{
+}
+
+#endif /* STUBDOMAINSIMULATION_H_ */
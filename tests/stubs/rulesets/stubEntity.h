@@ -19,7 +19,7 @@
 #define STUBENTITY_H_
 
 Entity::Entity(const std::string & id, long intId) :
-        LocatedEntity(id, intId), m_motion(0)
+        LocatedEntity(id, intId), m_motion(0), m_classDelegates(0)
 {
 }
 
@@ -159,6 +159,11 @@ const PropertyBase * Entity::getProperty(const std::string & name) const
     return 0;
 }
 
+const PropertyBase * Entity::getPropertyById(int id) const
+{
+    return 0;
+}
+
 PropertyBase * Entity::setProperty(const std::string & name,
                                    PropertyBase * prop)
 {
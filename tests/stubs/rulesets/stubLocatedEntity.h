@@ -61,6 +61,11 @@ const PropertyBase * LocatedEntity::getProperty(const std::string & name) const
     return 0;
 }
 
+const PropertyBase * LocatedEntity::getPropertyById(int id) const
+{
+    return 0;
+}
+
 PropertyBase * LocatedEntity::modProperty(const std::string & name)
 {
     return 0;
@@ -20,6 +20,14 @@
 
 const TypeNode * MemMap::m_entity_type = 0;
 
+void MemMap::index(MemEntity * entity)
+{
+}
+
+void MemMap::unindex(MemEntity * entity)
+{
+}
+
 MemEntity * MemMap::addEntity(MemEntity * entity)
 {
     return nullptr;
@@ -103,6 +111,12 @@ EntityVector MemMap::findByType(const std::string & what)
     return res;
 }
 
+EntityVector MemMap::findByType(const TypeNode * type, bool subtypes)
+{
+    EntityVector res;
+    return res;
+}
+
 EntityVector MemMap::findByLocation(const Location & loc,
                                        WFMath::CoordType radius,
                                        const std::string & what)
@@ -111,6 +125,12 @@ EntityVector MemMap::findByLocation(const Location & loc,
     return res;
 }
 
+void MemMap::findNear(const Location & where,
+                      WFMath::CoordType radius,
+                      EntityVector & res) const
+{
+}
+
 void MemMap::check(const double & time)
 {
 
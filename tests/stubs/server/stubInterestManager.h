@@ -0,0 +1,43 @@
+/*
+ Copyright (C) 2015 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+#ifndef STUBINTERESTMANAGER_H_
+#define STUBINTERESTMANAGER_H_
+
+
+InterestManager::InterestManager() : m_broadcastCount(0, 1),
+                                     m_candidateCount(0, 1),
+                                     m_observerCount(0, 1)
+{
+}
+
+void InterestManager::addPerceptive(LocatedEntity * perceptive)
+{
+}
+
+void InterestManager::removePerceptive(LocatedEntity * perceptive)
+{
+}
+
+void InterestManager::findObservers(const LocatedEntity & observed,
+                                    Domain & domain,
+                                    std::vector<LocatedEntity *> & observers)
+{
+}
+
+
+#endif /* STUBINTERESTMANAGER_H_ */
@@ -142,6 +142,8 @@ struct command commands[] = {
       &Interactive::commandUnknown, CMD_DEFAULT, 0, },
     { "monitor",        "Enable in-game op monitoring",
       &Interactive::commandUnknown, CMD_DEFAULT, 0, },
+    { "profile",        "Show or switch on and off script profiling",
+      &Interactive::commandUnknown, CMD_DEFAULT, 0, },
     { "query",          "Synonym for \"get\" (deprecated)",
       &Interactive::commandUnknown, CMD_DEFAULT, 0, },
     { "reload",         "Reload the script for a type",
@@ -693,6 +695,30 @@ void Interactive::exec(const std::string & cmd, const std::string & arg)
 
             endTask();
         }
+    } else if (cmd == "profile") {
+        Anonymous pmap;
+        pmap->setObjtype("profile");
+        pmap->setId("scripts");
+
+        if (arg == "on" || arg == "off") {
+            Set s;
+
+            pmap->setAttr("enabled", arg == "on" ? 1 : 0);
+            s->setArgs1(pmap);
+            s->setFrom(m_accountId);
+
+            send(s);
+        } else {
+            Get g;
+
+            if (!arg.empty()) {
+                pmap->setAttr("count", strtol(arg.c_str(), 0, 10));
+            }
+            g->setArgs1(pmap);
+            g->setFrom(m_accountId);
+
+            send(g);
+        }
     } else if (cmd == "connect") {
         std::vector<std::string> args;
         tokenize(arg, args);
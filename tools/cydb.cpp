@@ -29,6 +29,7 @@
 #include "config.h"
 #endif
 
+#include "common/BinaryElement.h"
 #include "common/log.h"
 #include "common/globals.h"
 #include "common/system.h"
@@ -38,6 +39,8 @@
 
 #include "common/compose.hpp"
 
+#include <vector>
+
 #ifdef HAVE_GETOPT_H
 #include <getopt.h>
 #endif // HAVE_GETOPT_H
@@ -103,6 +106,90 @@ static int world_purge(Storage & ab, struct dbsys * system,
     return 0;
 }
 
+/// \brief Write a batch of re-encoded rows, keyed by ctid.
+static int migrate_rows(const std::string & table, const std::string & column,
+                        std::vector<std::string> & rows)
+{
+    if (rows.empty()) {
+        return 0;
+    }
+    std::string cmd = String::compose("UPDATE %1 AS t SET %2 = v.data "
+                                      "FROM (VALUES ", table, column);
+    for (std::vector<std::string>::const_iterator I = rows.begin();
+         I != rows.end(); ++I) {
+        if (I != rows.begin()) {
+            cmd += ", ";
+        }
+        cmd += *I;
+    }
+    cmd += ") AS v(ctid, data) WHERE t.ctid = v.ctid";
+    rows.clear();
+    return Database::instance()->runCommandQuery(cmd);
+}
+
+/// \brief Re-encode any XML in a column of a table in the binary format.
+static int migrate_column(const std::string & table, const std::string & column)
+{
+    Database * db = Database::instance();
+    DatabaseResult res = db->runSimpleSelectQuery(
+          String::compose("SELECT ctid, %1 FROM %2", column, table));
+    if (res.error()) {
+        std::cout << "Reading " << table << " failed"
+                  << std::endl << std::flush;
+        return -1;
+    }
+    std::vector<std::string> rows;
+    int migrated = 0;
+    for (int row = 0; row < res.size(); ++row) {
+        const std::string value = res.field(1, row);
+        if (value.empty() || isBinaryElement(value)) {
+            continue;
+        }
+        Atlas::Message::MapType data;
+        if (db->decodeMessage(value, data) != 0) {
+            std::cout << "Skipping undecodable row " << res.field(0, row)
+                      << " in " << table << std::endl << std::flush;
+            continue;
+        }
+        std::string encoded;
+        db->encodeMessage(data, encoded);
+        rows.push_back(String::compose("('%1'::tid, '%2')",
+                                       res.field(0, row), encoded));
+        ++migrated;
+        if (rows.size() >= 1000 && migrate_rows(table, column, rows) != 0) {
+            return -1;
+        }
+    }
+    if (migrate_rows(table, column, rows) != 0) {
+        return -1;
+    }
+    std::cout << "Migrated " << migrated << " of " << res.size()
+              << " rows in " << table << std::endl << std::flush;
+    return 0;
+}
+
+static int world_migrate(Storage & ab, struct dbsys * system,
+                         int argc, char ** argv)
+{
+    Database * db = Database::instance();
+    // Either everything is migrated or nothing is.
+    if (db->runCommandQuery("BEGIN") != 0) {
+        return 1;
+    }
+    if (migrate_column("entities", "location") != 0 ||
+        migrate_column("properties", "value") != 0 ||
+        migrate_column("thoughts", "thought") != 0) {
+        std::cout << "World migrate fail" << std::endl << std::flush;
+        db->runCommandQuery("ROLLBACK");
+        return 1;
+    }
+    if (db->runCommandQuery("COMMIT") != 0) {
+        std::cout << "World migrate fail" << std::endl << std::flush;
+        return 1;
+    }
+    return 0;
+}
+
 static int users_purge(Storage & ab, struct dbsys * system,
                       int argc, char ** argv)
 {
@@ -293,6 +380,7 @@ int dbs_generic(Storage & ab, struct dbsys * system,
 
 struct dbsys world_cmds[] = {
     { "purge", "Purge world data", &world_purge, 0 },
+    { "migrate", "Convert world data to the binary format", &world_migrate, 0 },
     { "help",  "Show world help", &dbs_help, &world_cmds[0] },
     { NULL,    "Guard", }
 };